@@ -0,0 +1,782 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "doc_generator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <stdexcept>
+
+#include <zlib.h>
+
+namespace orcus { namespace bench {
+
+namespace {
+
+/**
+ * splitmix64, which produces the same sequence on all platforms unlike the
+ * standard distributions.
+ */
+std::uint64_t next_random(std::uint64_t& state)
+{
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void append_number(std::string& buf, double v)
+{
+    std::array<char, 32> tmp;
+    auto res = std::to_chars(tmp.data(), tmp.data() + tmp.size(), v);
+    buf.append(tmp.data(), res.ptr);
+}
+
+void append_number(std::string& buf, std::size_t v)
+{
+    std::array<char, 24> tmp;
+    auto res = std::to_chars(tmp.data(), tmp.data() + tmp.size(), v);
+    buf.append(tmp.data(), res.ptr);
+}
+
+std::string to_column_name(std::size_t col)
+{
+    std::string name;
+    ++col;
+
+    while (col > 0)
+    {
+        --col;
+        name.insert(name.begin(), char('A' + col % 26));
+        col /= 26;
+    }
+
+    return name;
+}
+
+std::vector<std::string> generate_unique_strings(const doc_spec& spec)
+{
+    std::vector<std::string> strs;
+    strs.reserve(spec.unique_strings);
+
+    for (std::size_t i = 0; i < spec.unique_strings; ++i)
+        strs.push_back(gen_string(i));
+
+    return strs;
+}
+
+void append_le16(std::string& buf, std::uint16_t v)
+{
+    buf.push_back(char(v & 0xFF));
+    buf.push_back(char((v >> 8) & 0xFF));
+}
+
+void append_le32(std::string& buf, std::uint32_t v)
+{
+    append_le16(buf, std::uint16_t(v & 0xFFFF));
+    append_le16(buf, std::uint16_t((v >> 16) & 0xFFFF));
+}
+
+/**
+ * Deflate the content.
+ *
+ * @param window_bits negative value for a raw deflate stream, or 16 added
+ *                    to the window size for a gzip stream.
+ */
+std::string deflate(std::string_view content, int window_bits)
+{
+    z_stream zs{};
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        throw std::runtime_error("failed to initialize the deflate stream.");
+
+    std::string out(deflateBound(&zs, content.size()) + 32, '\0');
+
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(content.data()));
+    zs.avail_in = content.size();
+    zs.next_out = reinterpret_cast<Bytef*>(out.data());
+    zs.avail_out = out.size();
+
+    int ret = ::deflate(&zs, Z_FINISH);
+    deflateEnd(&zs);
+
+    if (ret != Z_STREAM_END)
+        throw std::runtime_error("failed to deflate the content.");
+
+    out.resize(zs.total_out);
+    return out;
+}
+
+} // anonymous namespace
+
+cell_generator::cell_generator(const doc_spec& spec) :
+    m_spec(spec), m_state(spec.seed) {}
+
+gen_cell cell_generator::next()
+{
+    gen_cell cell;
+
+    double u = double(next_random(m_state) >> 11) / double(1ULL << 53);
+    std::uint64_t r = next_random(m_state);
+
+    if (u < m_spec.formula_ratio)
+        cell.kind = cell_kind_t::formula;
+    else if (u < m_spec.formula_ratio + m_spec.string_ratio && m_spec.unique_strings)
+    {
+        cell.kind = cell_kind_t::string;
+        cell.string_index = r % m_spec.unique_strings;
+    }
+    else
+        cell.value = double(r % 1000000) / 100.0;
+
+    return cell;
+}
+
+std::string gen_string(std::size_t index)
+{
+    static constexpr std::string_view syllables[] = {
+        "ka", "lo", "mi", "nu", "pe", "ra", "si", "tol"
+    };
+
+    std::string s = "s";
+    do
+    {
+        s += syllables[index % 8];
+        index /= 8;
+    }
+    while (index);
+
+    return s;
+}
+
+std::string to_a1(std::size_t row, std::size_t col)
+{
+    std::string s = to_column_name(col);
+    append_number(s, row + 1);
+    return s;
+}
+
+std::string gen_formula_a1(std::size_t row, std::size_t col)
+{
+    if (col > 0)
+        return to_a1(row, col - 1) + "*2";
+
+    if (row > 0)
+        return to_a1(row - 1, col) + "+1";
+
+    return "1+1";
+}
+
+std::vector<std::string> generate_cell_strings(const doc_spec& spec)
+{
+    std::vector<std::string> strs;
+    cell_generator gen(spec);
+
+    for (std::size_t row = 0; row < spec.rows; ++row)
+    {
+        for (std::size_t col = 0; col < spec.columns; ++col)
+        {
+            gen_cell cell = gen.next();
+            if (cell.kind == cell_kind_t::string)
+                strs.push_back(gen_string(cell.string_index));
+        }
+    }
+
+    return strs;
+}
+
+std::string generate_xlsx_sheet_xml(const doc_spec& spec)
+{
+    std::string buf;
+    buf += "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+    buf += "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\">";
+
+    if (spec.rows && spec.columns)
+    {
+        buf += "<dimension ref=\"A1:";
+        buf += to_a1(spec.rows - 1, spec.columns - 1);
+        buf += "\"/>";
+    }
+
+    buf += "<sheetData>\n";
+
+    cell_generator gen(spec);
+
+    for (std::size_t row = 0; row < spec.rows; ++row)
+    {
+        buf += "<row r=\"";
+        append_number(buf, row + 1);
+        buf += "\">";
+
+        for (std::size_t col = 0; col < spec.columns; ++col)
+        {
+            gen_cell cell = gen.next();
+
+            buf += "<c r=\"";
+            buf += to_a1(row, col);
+            buf += '"';
+
+            switch (cell.kind)
+            {
+                case cell_kind_t::number:
+                    buf += "><v>";
+                    append_number(buf, cell.value);
+                    buf += "</v></c>";
+                    break;
+                case cell_kind_t::string:
+                    buf += " t=\"s\"><v>";
+                    append_number(buf, cell.string_index);
+                    buf += "</v></c>";
+                    break;
+                case cell_kind_t::formula:
+                    buf += "><f>";
+                    buf += gen_formula_a1(row, col);
+                    buf += "</f><v>0</v></c>";
+                    break;
+            }
+        }
+
+        buf += "</row>\n";
+    }
+
+    buf += "</sheetData></worksheet>\n";
+    return buf;
+}
+
+std::string generate_json(const doc_spec& spec)
+{
+    std::vector<std::string> col_names;
+    for (std::size_t col = 0; col < spec.columns; ++col)
+        col_names.push_back(to_column_name(col));
+
+    std::string buf = "[\n";
+    cell_generator gen(spec);
+
+    for (std::size_t row = 0; row < spec.rows; ++row)
+    {
+        buf += '{';
+
+        for (std::size_t col = 0; col < spec.columns; ++col)
+        {
+            gen_cell cell = gen.next();
+
+            if (col)
+                buf += ',';
+
+            buf += '"';
+            buf += col_names[col];
+            buf += "\":";
+
+            switch (cell.kind)
+            {
+                case cell_kind_t::number:
+                    append_number(buf, cell.value);
+                    break;
+                case cell_kind_t::string:
+                    buf += '"';
+                    buf += gen_string(cell.string_index);
+                    buf += '"';
+                    break;
+                case cell_kind_t::formula:
+                    buf += "\"=";
+                    buf += gen_formula_a1(row, col);
+                    buf += '"';
+                    break;
+            }
+        }
+
+        buf += '}';
+        if (row + 1 < spec.rows)
+            buf += ',';
+        buf += '\n';
+    }
+
+    buf += "]\n";
+    return buf;
+}
+
+std::string generate_yaml(const doc_spec& spec)
+{
+    std::vector<std::string> col_names;
+    for (std::size_t col = 0; col < spec.columns; ++col)
+        col_names.push_back(to_column_name(col));
+
+    std::string buf;
+    cell_generator gen(spec);
+
+    for (std::size_t row = 0; row < spec.rows; ++row)
+    {
+        for (std::size_t col = 0; col < spec.columns; ++col)
+        {
+            gen_cell cell = gen.next();
+
+            buf += col ? "  " : "- ";
+            buf += col_names[col];
+            buf += ": ";
+
+            switch (cell.kind)
+            {
+                case cell_kind_t::number:
+                    append_number(buf, cell.value);
+                    break;
+                case cell_kind_t::string:
+                    buf += gen_string(cell.string_index);
+                    break;
+                case cell_kind_t::formula:
+                    buf += "\"=";
+                    buf += gen_formula_a1(row, col);
+                    buf += '"';
+                    break;
+            }
+
+            buf += '\n';
+        }
+    }
+
+    return buf;
+}
+
+std::string generate_csv(const doc_spec& spec)
+{
+    std::string buf;
+    cell_generator gen(spec);
+
+    for (std::size_t row = 0; row < spec.rows; ++row)
+    {
+        for (std::size_t col = 0; col < spec.columns; ++col)
+        {
+            gen_cell cell = gen.next();
+
+            if (col)
+                buf += ',';
+
+            switch (cell.kind)
+            {
+                case cell_kind_t::number:
+                    append_number(buf, cell.value);
+                    break;
+                case cell_kind_t::string:
+                    buf += gen_string(cell.string_index);
+                    break;
+                case cell_kind_t::formula:
+                    buf += '=';
+                    buf += gen_formula_a1(row, col);
+                    break;
+            }
+        }
+
+        buf += '\n';
+    }
+
+    return buf;
+}
+
+std::string generate_css(const doc_spec& spec)
+{
+    std::string buf;
+    std::uint64_t state = spec.seed;
+
+    auto append_byte = [&buf, &state]
+    {
+        append_number(buf, std::size_t(next_random(state) % 256));
+    };
+
+    for (std::size_t row = 0; row < spec.rows; ++row)
+    {
+        buf += "table.t";
+        append_number(buf, row % 64);
+        buf += " > tr td.c";
+        append_number(buf, row);
+        buf += ", #r";
+        append_number(buf, row);
+        buf += ":hover {\n";
+
+        for (std::size_t col = 0; col < spec.columns; ++col)
+        {
+            buf += "    ";
+
+            switch (col % 6)
+            {
+                case 0:
+                    buf += "color: rgb(";
+                    append_byte();
+                    buf += ", ";
+                    append_byte();
+                    buf += ", ";
+                    append_byte();
+                    buf += ");";
+                    break;
+                case 1:
+                    buf += "margin: ";
+                    append_byte();
+                    buf += "px 2px 3px ";
+                    append_byte();
+                    buf += "px;";
+                    break;
+                case 2:
+                    buf += "width: ";
+                    append_number(buf, double(next_random(state) % 10000) / 100.0);
+                    buf += "em;";
+                    break;
+                case 3:
+                    buf += "background-color: rgba(";
+                    append_byte();
+                    buf += ", ";
+                    append_byte();
+                    buf += ", ";
+                    append_byte();
+                    buf += ", 0.5);";
+                    break;
+                case 4:
+                    buf += "font-family: \"";
+                    buf += gen_string(next_random(state) % std::max<std::size_t>(spec.unique_strings, 1));
+                    buf += "\", sans-serif;";
+                    break;
+                case 5:
+                    buf += "background-image: url(\"img";
+                    append_byte();
+                    buf += ".png\");";
+                    break;
+            }
+
+            buf += '\n';
+        }
+
+        buf += "}\n";
+    }
+
+    return buf;
+}
+
+std::string generate_xlsx(const doc_spec& spec)
+{
+    zip_writer zw;
+
+    zw.add("[Content_Types].xml",
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+        "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+        "<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+        "<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>"
+        "<Override PartName=\"/xl/worksheets/sheet1.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>"
+        "<Override PartName=\"/xl/sharedStrings.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml\"/>"
+        "<Override PartName=\"/xl/styles.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml\"/>"
+        "</Types>\n");
+
+    zw.add("_rels/.rels",
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+        "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>"
+        "</Relationships>\n");
+
+    zw.add("xl/workbook.xml",
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        "<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\""
+        " xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\">"
+        "<sheets><sheet name=\"Sheet1\" sheetId=\"1\" r:id=\"rId1\"/></sheets>"
+        "</workbook>\n");
+
+    zw.add("xl/_rels/workbook.xml.rels",
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+        "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"worksheets/sheet1.xml\"/>"
+        "<Relationship Id=\"rId2\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings\" Target=\"sharedStrings.xml\"/>"
+        "<Relationship Id=\"rId3\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles\" Target=\"styles.xml\"/>"
+        "</Relationships>\n");
+
+    zw.add("xl/styles.xml",
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        "<styleSheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\">"
+        "<fonts count=\"1\"><font><sz val=\"11\"/><name val=\"Calibri\"/></font></fonts>"
+        "<fills count=\"1\"><fill><patternFill patternType=\"none\"/></fill></fills>"
+        "<borders count=\"1\"><border><left/><right/><top/><bottom/><diagonal/></border></borders>"
+        "<cellStyleXfs count=\"1\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\"/></cellStyleXfs>"
+        "<cellXfs count=\"1\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\"/></cellXfs>"
+        "<cellStyles count=\"1\"><cellStyle name=\"Normal\" xfId=\"0\" builtinId=\"0\"/></cellStyles>"
+        "</styleSheet>\n");
+
+    std::string sst = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+    sst += "<sst xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" uniqueCount=\"";
+    append_number(sst, spec.unique_strings);
+    sst += "\">";
+    for (const std::string& s : generate_unique_strings(spec))
+    {
+        sst += "<si><t>";
+        sst += s;
+        sst += "</t></si>";
+    }
+    sst += "</sst>\n";
+    zw.add("xl/sharedStrings.xml", sst);
+
+    zw.add("xl/worksheets/sheet1.xml", generate_xlsx_sheet_xml(spec));
+
+    return zw.finish();
+}
+
+std::string generate_ods(const doc_spec& spec)
+{
+    zip_writer zw;
+
+    // The mimetype entry must come first, and must not be compressed.
+    zw.add("mimetype", "application/vnd.oasis.opendocument.spreadsheet", false);
+
+    zw.add("META-INF/manifest.xml",
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<manifest:manifest xmlns:manifest=\"urn:oasis:names:tc:opendocument:xmlns:manifest:1.0\" manifest:version=\"1.2\">"
+        "<manifest:file-entry manifest:full-path=\"/\" manifest:media-type=\"application/vnd.oasis.opendocument.spreadsheet\"/>"
+        "<manifest:file-entry manifest:full-path=\"content.xml\" manifest:media-type=\"text/xml\"/>"
+        "<manifest:file-entry manifest:full-path=\"styles.xml\" manifest:media-type=\"text/xml\"/>"
+        "</manifest:manifest>\n");
+
+    zw.add("styles.xml",
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<office:document-styles xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\" office:version=\"1.2\"/>\n");
+
+    std::string buf =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<office:document-content"
+        " xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\""
+        " xmlns:table=\"urn:oasis:names:tc:opendocument:xmlns:table:1.0\""
+        " xmlns:text=\"urn:oasis:names:tc:opendocument:xmlns:text:1.0\""
+        " xmlns:of=\"urn:oasis:names:tc:opendocument:xmlns:of:1.2\""
+        " office:version=\"1.2\">"
+        "<office:body><office:spreadsheet><table:table table:name=\"Sheet1\">\n";
+
+    cell_generator gen(spec);
+
+    for (std::size_t row = 0; row < spec.rows; ++row)
+    {
+        buf += "<table:table-row>";
+
+        for (std::size_t col = 0; col < spec.columns; ++col)
+        {
+            gen_cell cell = gen.next();
+
+            switch (cell.kind)
+            {
+                case cell_kind_t::number:
+                    buf += "<table:table-cell office:value-type=\"float\" office:value=\"";
+                    append_number(buf, cell.value);
+                    buf += "\"><text:p>";
+                    append_number(buf, cell.value);
+                    buf += "</text:p></table:table-cell>";
+                    break;
+                case cell_kind_t::string:
+                    buf += "<table:table-cell office:value-type=\"string\"><text:p>";
+                    buf += gen_string(cell.string_index);
+                    buf += "</text:p></table:table-cell>";
+                    break;
+                case cell_kind_t::formula:
+                {
+                    buf += "<table:table-cell table:formula=\"of:=";
+
+                    if (col > 0)
+                    {
+                        buf += "[.";
+                        buf += to_a1(row, col - 1);
+                        buf += "]*2";
+                    }
+                    else if (row > 0)
+                    {
+                        buf += "[.";
+                        buf += to_a1(row - 1, col);
+                        buf += "]+1";
+                    }
+                    else
+                        buf += "1+1";
+
+                    buf += "\" office:value-type=\"float\" office:value=\"0\"><text:p>0</text:p></table:table-cell>";
+                    break;
+                }
+            }
+        }
+
+        buf += "</table:table-row>\n";
+    }
+
+    buf += "</table:table></office:spreadsheet></office:body></office:document-content>\n";
+    zw.add("content.xml", buf);
+
+    return zw.finish();
+}
+
+std::string generate_xls_xml(const doc_spec& spec)
+{
+    std::string buf =
+        "<?xml version=\"1.0\"?>\n"
+        "<Workbook xmlns=\"urn:schemas-microsoft-com:office:spreadsheet\""
+        " xmlns:ss=\"urn:schemas-microsoft-com:office:spreadsheet\">\n"
+        "<Worksheet ss:Name=\"Sheet1\">\n<Table>\n";
+
+    cell_generator gen(spec);
+
+    for (std::size_t row = 0; row < spec.rows; ++row)
+    {
+        buf += "<Row>";
+
+        for (std::size_t col = 0; col < spec.columns; ++col)
+        {
+            gen_cell cell = gen.next();
+
+            switch (cell.kind)
+            {
+                case cell_kind_t::number:
+                    buf += "<Cell><Data ss:Type=\"Number\">";
+                    append_number(buf, cell.value);
+                    buf += "</Data></Cell>";
+                    break;
+                case cell_kind_t::string:
+                    buf += "<Cell><Data ss:Type=\"String\">";
+                    buf += gen_string(cell.string_index);
+                    buf += "</Data></Cell>";
+                    break;
+                case cell_kind_t::formula:
+                    // Same expressions as gen_formula_a1(), in R1C1 notation.
+                    if (col > 0)
+                        buf += "<Cell ss:Formula=\"=RC[-1]*2\">";
+                    else if (row > 0)
+                        buf += "<Cell ss:Formula=\"=R[-1]C+1\">";
+                    else
+                        buf += "<Cell ss:Formula=\"=1+1\">";
+
+                    buf += "<Data ss:Type=\"Number\">0</Data></Cell>";
+                    break;
+            }
+        }
+
+        buf += "</Row>\n";
+    }
+
+    buf += "</Table>\n</Worksheet>\n</Workbook>\n";
+
+    return buf;
+}
+
+std::string generate_gnumeric(const doc_spec& spec)
+{
+    std::string buf =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<gnm:Workbook xmlns:gnm=\"http://www.gnumeric.org/v10.dtd\">\n"
+        "<gnm:SheetNameIndex><gnm:SheetName>Sheet1</gnm:SheetName></gnm:SheetNameIndex>\n"
+        "<gnm:Sheets>\n<gnm:Sheet>\n<gnm:Name>Sheet1</gnm:Name>\n<gnm:Cells>\n";
+
+    cell_generator gen(spec);
+
+    for (std::size_t row = 0; row < spec.rows; ++row)
+    {
+        for (std::size_t col = 0; col < spec.columns; ++col)
+        {
+            gen_cell cell = gen.next();
+
+            buf += "<gnm:Cell Row=\"";
+            append_number(buf, row);
+            buf += "\" Col=\"";
+            append_number(buf, col);
+            buf += '"';
+
+            switch (cell.kind)
+            {
+                case cell_kind_t::number:
+                    buf += " ValueType=\"40\">";
+                    append_number(buf, cell.value);
+                    break;
+                case cell_kind_t::string:
+                    buf += " ValueType=\"60\">";
+                    buf += gen_string(cell.string_index);
+                    break;
+                case cell_kind_t::formula:
+                    buf += ">=";
+                    buf += gen_formula_a1(row, col);
+                    break;
+            }
+
+            buf += "</gnm:Cell>\n";
+        }
+    }
+
+    buf += "</gnm:Cells>\n</gnm:Sheet>\n</gnm:Sheets>\n</gnm:Workbook>\n";
+
+    return deflate(buf, MAX_WBITS + 16);
+}
+
+void zip_writer::add(std::string_view name, std::string_view content, bool compress)
+{
+    entry e;
+    e.name = name;
+    e.crc32 = ::crc32(0L, reinterpret_cast<const Bytef*>(content.data()), content.size());
+    e.method = compress ? 8 : 0;
+    e.size = content.size();
+    e.offset = m_buffer.size();
+
+    std::string deflated;
+    if (compress)
+        deflated = deflate(content, -MAX_WBITS);
+
+    std::string_view data = compress ? std::string_view{deflated} : content;
+    e.compressed_size = data.size();
+
+    append_le32(m_buffer, 0x04034b50); // local file header signature
+    append_le16(m_buffer, 20); // version needed to extract
+    append_le16(m_buffer, 0); // flags
+    append_le16(m_buffer, e.method);
+    append_le16(m_buffer, 0); // last modified time
+    append_le16(m_buffer, 0x21); // last modified date (1980-01-01)
+    append_le32(m_buffer, e.crc32);
+    append_le32(m_buffer, e.compressed_size);
+    append_le32(m_buffer, e.size);
+    append_le16(m_buffer, e.name.size());
+    append_le16(m_buffer, 0); // extra field length
+    m_buffer += e.name;
+    m_buffer += data;
+
+    m_entries.push_back(std::move(e));
+}
+
+std::string zip_writer::finish()
+{
+    std::uint32_t cd_offset = m_buffer.size();
+
+    for (const entry& e : m_entries)
+    {
+        append_le32(m_buffer, 0x02014b50); // central directory header signature
+        append_le16(m_buffer, 20); // version made by
+        append_le16(m_buffer, 20); // version needed to extract
+        append_le16(m_buffer, 0); // flags
+        append_le16(m_buffer, e.method);
+        append_le16(m_buffer, 0); // last modified time
+        append_le16(m_buffer, 0x21); // last modified date
+        append_le32(m_buffer, e.crc32);
+        append_le32(m_buffer, e.compressed_size);
+        append_le32(m_buffer, e.size);
+        append_le16(m_buffer, e.name.size());
+        append_le16(m_buffer, 0); // extra field length
+        append_le16(m_buffer, 0); // file comment length
+        append_le16(m_buffer, 0); // disk number start
+        append_le16(m_buffer, 0); // internal file attributes
+        append_le32(m_buffer, 0); // external file attributes
+        append_le32(m_buffer, e.offset);
+        m_buffer += e.name;
+    }
+
+    std::uint32_t cd_size = m_buffer.size() - cd_offset;
+
+    append_le32(m_buffer, 0x06054b50); // end of central directory signature
+    append_le16(m_buffer, 0); // number of this disk
+    append_le16(m_buffer, 0); // disk where the central directory starts
+    append_le16(m_buffer, m_entries.size());
+    append_le16(m_buffer, m_entries.size());
+    append_le32(m_buffer, cd_size);
+    append_le32(m_buffer, cd_offset);
+    append_le16(m_buffer, 0); // comment length
+
+    m_entries.clear();
+    return std::move(m_buffer);
+}
+
+}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
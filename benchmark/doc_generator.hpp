@@ -0,0 +1,149 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace orcus { namespace bench {
+
+/**
+ * Parameters of a synthetic document.  The same parameters always produce
+ * the same content, regardless of the platform.
+ */
+struct doc_spec
+{
+    /** Number of rows, or the number of rules for css. */
+    std::size_t rows = 10000;
+    /** Number of columns, or the number of properties per rule for css. */
+    std::size_t columns = 10;
+    /** Ratio of the cells that contain strings, between 0 and 1. */
+    double string_ratio = 0.3;
+    /** Ratio of the cells that contain formulas, between 0 and 1. */
+    double formula_ratio = 0.1;
+    /** Number of distinct string values the string cells draw from. */
+    std::size_t unique_strings = 1000;
+    /** Seed of the pseudo-random sequence that decides the cell content. */
+    std::uint64_t seed = 1;
+};
+
+enum class cell_kind_t { number, string, formula };
+
+/**
+ * Single generated cell.  A formula cell always references its left
+ * neighbor, or the cell above it when in the first column.
+ */
+struct gen_cell
+{
+    cell_kind_t kind = cell_kind_t::number;
+    double value = 0.0;
+    std::size_t string_index = 0;
+};
+
+/**
+ * Produces the cells of a synthetic sheet in row-major order.
+ */
+class cell_generator
+{
+    doc_spec m_spec;
+    std::uint64_t m_state;
+
+public:
+    cell_generator(const doc_spec& spec);
+
+    gen_cell next();
+
+    const doc_spec& spec() const { return m_spec; }
+};
+
+/**
+ * Get the string value for the specified string index.
+ */
+std::string gen_string(std::size_t index);
+
+/**
+ * Get the A1 address of a cell, e.g. "B12" for row 11 and column 1.
+ */
+std::string to_a1(std::size_t row, std::size_t col);
+
+/**
+ * Get the expression of a formula cell without the leading '=' in A1
+ * notation.
+ */
+std::string gen_formula_a1(std::size_t row, std::size_t col);
+
+/**
+ * Get all string values of the string cells, in cell order, including
+ * duplicates.
+ */
+std::vector<std::string> generate_cell_strings(const doc_spec& spec);
+
+/** Worksheet part of an xlsx package, which also serves as generic XML input. */
+std::string generate_xlsx_sheet_xml(const doc_spec& spec);
+
+/** Array of row objects keyed by the column names. */
+std::string generate_json(const doc_spec& spec);
+
+/** Sequence of row maps keyed by the column names. */
+std::string generate_yaml(const doc_spec& spec);
+
+/** Formula cells are written as their expressions. */
+std::string generate_csv(const doc_spec& spec);
+
+/** One rule per row, with one property per column. */
+std::string generate_css(const doc_spec& spec);
+
+std::string generate_xlsx(const doc_spec& spec);
+
+std::string generate_ods(const doc_spec& spec);
+
+/** Excel 2003 XML document, with the formulas in R1C1 notation. */
+std::string generate_xls_xml(const doc_spec& spec);
+
+/** Gzip-compressed gnumeric document. */
+std::string generate_gnumeric(const doc_spec& spec);
+
+/**
+ * Writes a zip package in memory.
+ */
+class zip_writer
+{
+    struct entry
+    {
+        std::string name;
+        std::uint32_t crc32;
+        std::uint16_t method;
+        std::uint32_t compressed_size;
+        std::uint32_t size;
+        std::uint32_t offset;
+    };
+
+    std::string m_buffer;
+    std::vector<entry> m_entries;
+
+public:
+    /**
+     * Add a file entry to the package.
+     *
+     * @param name path of the entry inside the package.
+     * @param content content of the entry.
+     * @param compress whether to deflate the content, or to store it as-is.
+     */
+    void add(std::string_view name, std::string_view content, bool compress = true);
+
+    /**
+     * Write the central directory, and return the whole package.
+     */
+    std::string finish();
+};
+
+}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -8,7 +8,7 @@
 #include <iostream>
 #include <stdio.h>
 #include <string>
-#include <sys/time.h>
+#include <chrono>
 
 #define SIMULATE_PROCESSING_OVERHEAD 0
 
@@ -35,9 +35,7 @@ public:
 private:
     double get_time() const
     {
-        timeval tv;
-        gettimeofday(&tv, NULL);
-        return tv.tv_sec + tv.tv_usec / 1000000.0;
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
     }
 
     ::std::string m_msg;
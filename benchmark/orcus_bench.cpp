@@ -0,0 +1,760 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+ * Runs a set of parser, zip and import benchmarks against synthetic
+ * documents generated in memory, and reports the timings in text, json or
+ * csv format.
+ *
+ * Usage: orcus-bench [options]
+ *
+ * Run with --help for the list of options.
+ */
+
+#include "doc_generator.hpp"
+
+#include <orcus/sax_parser.hpp>
+#include <orcus/sax_token_parser.hpp>
+#include <orcus/threaded_sax_token_parser.hpp>
+#include <orcus/json_parser.hpp>
+#include <orcus/threaded_json_parser.hpp>
+#include <orcus/yaml_parser.hpp>
+#include <orcus/csv_parser.hpp>
+#include <orcus/css_parser.hpp>
+#include <orcus/css_document_tree.hpp>
+#include <orcus/tokens.hpp>
+#include <orcus/xml_namespace.hpp>
+#include <orcus/zip_archive.hpp>
+#include <orcus/zip_archive_stream.hpp>
+#include <orcus/string_pool.hpp>
+
+#include <orcus/orcus_csv.hpp>
+#ifdef __ORCUS_XLSX
+#include <orcus/orcus_xlsx.hpp>
+#endif
+#ifdef __ORCUS_ODS
+#include <orcus/orcus_ods.hpp>
+#endif
+#ifdef __ORCUS_GNUMERIC
+#include <orcus/orcus_gnumeric.hpp>
+#endif
+
+#ifdef __ORCUS_SPREADSHEET_MODEL
+#include <orcus/spreadsheet/document.hpp>
+#include <orcus/spreadsheet/factory.hpp>
+#else
+#include <orcus/spreadsheet/streaming_factory.hpp>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+using namespace orcus;
+namespace ss = orcus::spreadsheet;
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr std::string_view bench_names[] = {
+    "sax_parser",
+    "sax_token_parser",
+    "threaded_sax_token_parser",
+    "json_parser",
+    "threaded_json_parser",
+    "yaml_parser",
+    "csv_parser",
+    "css_parser",
+    "css_document_tree",
+    "css_rule_match",
+    "zip_archive",
+    "string_pool",
+    "import_xlsx",
+    "import_ods",
+    "import_csv",
+    "import_gnumeric",
+};
+
+constexpr const char* help_text =
+    "Usage: orcus-bench [options]\n"
+    "\n"
+    "Options:\n"
+    "  --rows N            number of rows of the generated documents (default: 10000)\n"
+    "  --columns N         number of columns of the generated documents (default: 10)\n"
+    "  --string-ratio R    ratio of string cells between 0 and 1 (default: 0.3)\n"
+    "  --formula-ratio R   ratio of formula cells between 0 and 1 (default: 0.1)\n"
+    "  --unique-strings N  number of distinct string values (default: 1000)\n"
+    "  --seed N            seed of the generated content (default: 1)\n"
+    "  --repeat N          number of timed runs per benchmark (default: 5)\n"
+    "  --warmup N          number of untimed runs per benchmark (default: 1)\n"
+    "  --filter NAME       run only the benchmarks whose names contain NAME; can be\n"
+    "                      specified multiple times\n"
+    "  --format FORMAT     output format: text, json or csv (default: text)\n"
+    "  --output FILE       write the results to FILE instead of stdout\n"
+    "  --list              print the names of all benchmarks and exit\n"
+    "  --help              print this help and exit\n";
+
+struct options
+{
+    bench::doc_spec spec;
+    std::size_t repeat = 5;
+    std::size_t warmup = 1;
+    std::vector<std::string> filters;
+    std::string format = "text";
+    std::string output;
+};
+
+struct bench_result
+{
+    std::string name;
+    std::size_t input_bytes = 0;
+    std::size_t items = 0;
+    std::vector<double> durations; // in seconds
+
+    double min() const
+    {
+        return *std::min_element(durations.begin(), durations.end());
+    }
+
+    double max() const
+    {
+        return *std::max_element(durations.begin(), durations.end());
+    }
+
+    double mean() const
+    {
+        return std::accumulate(durations.begin(), durations.end(), 0.0) / durations.size();
+    }
+
+    double median() const
+    {
+        std::vector<double> sorted = durations;
+        std::sort(sorted.begin(), sorted.end());
+        std::size_t n = sorted.size();
+        return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+    }
+
+    double mb_per_sec() const
+    {
+        double t = median();
+        return t > 0.0 ? input_bytes / t / 1.0e6 : 0.0;
+    }
+
+    double items_per_sec() const
+    {
+        double t = median();
+        return t > 0.0 ? items / t : 0.0;
+    }
+};
+
+/**
+ * Runs the selected benchmarks and keeps their results.  Each benchmark
+ * function returns the number of items it has processed, which gets
+ * reported along with the timings.
+ */
+class bench_runner
+{
+    const options& m_opts;
+    std::vector<bench_result> m_results;
+
+public:
+    bench_runner(const options& opts) : m_opts(opts) {}
+
+    bool selected(std::string_view name) const
+    {
+        if (m_opts.filters.empty())
+            return true;
+
+        return std::any_of(m_opts.filters.begin(), m_opts.filters.end(),
+            [name](const std::string& filter) { return name.find(filter) != std::string_view::npos; });
+    }
+
+    bool any_selected(std::initializer_list<std::string_view> names) const
+    {
+        return std::any_of(names.begin(), names.end(), [this](std::string_view name) { return selected(name); });
+    }
+
+    void run(std::string_view name, std::size_t input_bytes, const std::function<std::size_t()>& func)
+    {
+        if (!selected(name))
+            return;
+
+        bench_result res;
+        res.name = name;
+        res.input_bytes = input_bytes;
+
+        for (std::size_t i = 0; i < m_opts.warmup; ++i)
+            func();
+
+        for (std::size_t i = 0; i < std::max<std::size_t>(m_opts.repeat, 1); ++i)
+        {
+            auto start = clock_type::now();
+            res.items = func();
+            auto end = clock_type::now();
+            res.durations.push_back(std::chrono::duration<double>(end - start).count());
+        }
+
+        std::cerr << name << ": " << res.median() << " s" << std::endl;
+        m_results.push_back(std::move(res));
+    }
+
+    void write(std::ostream& os) const
+    {
+        if (m_opts.format == "json")
+            write_json(os);
+        else if (m_opts.format == "csv")
+            write_csv(os);
+        else
+            write_text(os);
+    }
+
+private:
+    void write_text(std::ostream& os) const
+    {
+        os << std::left << std::setw(28) << "name"
+            << std::right << std::setw(12) << "bytes"
+            << std::setw(12) << "median (s)"
+            << std::setw(12) << "min (s)"
+            << std::setw(12) << "MB/s"
+            << std::setw(14) << "items/s" << std::endl;
+
+        os << std::fixed;
+
+        for (const bench_result& res : m_results)
+        {
+            os << std::left << std::setw(28) << res.name
+                << std::right << std::setw(12) << res.input_bytes
+                << std::setprecision(4)
+                << std::setw(12) << res.median()
+                << std::setw(12) << res.min()
+                << std::setprecision(1)
+                << std::setw(12) << res.mb_per_sec()
+                << std::setprecision(0)
+                << std::setw(14) << res.items_per_sec() << std::endl;
+        }
+    }
+
+    void write_json(std::ostream& os) const
+    {
+        const bench::doc_spec& spec = m_opts.spec;
+
+        os << "{\n";
+        os << "  \"spec\": {"
+            << "\"rows\": " << spec.rows
+            << ", \"columns\": " << spec.columns
+            << ", \"string-ratio\": " << spec.string_ratio
+            << ", \"formula-ratio\": " << spec.formula_ratio
+            << ", \"unique-strings\": " << spec.unique_strings
+            << ", \"seed\": " << spec.seed
+            << ", \"repeat\": " << m_opts.repeat
+            << ", \"warmup\": " << m_opts.warmup << "},\n";
+        os << "  \"results\": [";
+
+        os << std::setprecision(9);
+
+        for (std::size_t i = 0; i < m_results.size(); ++i)
+        {
+            const bench_result& res = m_results[i];
+
+            os << (i ? ",\n" : "\n");
+            os << "    {\"name\": \"" << res.name << "\""
+                << ", \"input-bytes\": " << res.input_bytes
+                << ", \"items\": " << res.items
+                << ", \"min\": " << res.min()
+                << ", \"median\": " << res.median()
+                << ", \"mean\": " << res.mean()
+                << ", \"max\": " << res.max()
+                << ", \"mb-per-sec\": " << res.mb_per_sec()
+                << ", \"items-per-sec\": " << res.items_per_sec() << "}";
+        }
+
+        os << "\n  ]\n}" << std::endl;
+    }
+
+    void write_csv(std::ostream& os) const
+    {
+        os << "name,input-bytes,items,min,median,mean,max,mb-per-sec,items-per-sec" << std::endl;
+        os << std::setprecision(9);
+
+        for (const bench_result& res : m_results)
+        {
+            os << res.name << ',' << res.input_bytes << ',' << res.items
+                << ',' << res.min() << ',' << res.median() << ',' << res.mean() << ',' << res.max()
+                << ',' << res.mb_per_sec() << ',' << res.items_per_sec() << std::endl;
+        }
+    }
+};
+
+// handlers that count the events they receive
+
+class sax_counter : public sax_handler
+{
+public:
+    std::size_t count = 0;
+
+    void start_element(const sax::parser_element&) { ++count; }
+    void attribute(const sax::parser_attribute&) { ++count; }
+    void characters(std::string_view, bool) { ++count; }
+};
+
+class sax_token_counter : public sax_token_handler
+{
+public:
+    std::size_t count = 0;
+
+    void start_element(const xml_token_element_t& elem) { count += 1 + elem.attrs.size(); }
+    void end_element(const xml_token_element_t&) {}
+    void characters(std::string_view, bool) { ++count; }
+};
+
+class json_counter : public json_handler
+{
+public:
+    std::size_t count = 0;
+
+    void object_key(std::string_view, bool) { ++count; }
+    void string(std::string_view, bool) { ++count; }
+    void number(double) { ++count; }
+
+    // threaded_json_parser passes the strings as pointer and size pairs.
+    void object_key(const char*, std::size_t, bool) { ++count; }
+    void string(const char*, std::size_t, bool) { ++count; }
+};
+
+class yaml_counter : public yaml_handler
+{
+public:
+    std::size_t count = 0;
+
+    void string(std::string_view) { ++count; }
+    void number(double) { ++count; }
+};
+
+class csv_counter : public csv_handler
+{
+public:
+    std::size_t count = 0;
+
+    void cell(std::string_view, bool) { ++count; }
+};
+
+class css_counter : public css_handler
+{
+public:
+    std::size_t count = 0;
+
+    void property_name(std::string_view) { ++count; }
+};
+
+/**
+ * Element names of the worksheet part of an xlsx package, used to tokenize
+ * the generated XML.
+ */
+constexpr const char* sheet_token_names[] = {
+    "??", "c", "dimension", "f", "r", "ref", "row", "sheetData", "t", "v", "worksheet"
+};
+
+#ifndef __ORCUS_SPREADSHEET_MODEL
+
+class global_settings : public ss::iface::import_global_settings
+{
+    ss::formula_grammar_t m_grammar = ss::formula_grammar_t::unknown;
+
+public:
+    virtual void set_origin_date(int, int, int) override {}
+
+    virtual void set_default_formula_grammar(ss::formula_grammar_t grammar) override
+    {
+        m_grammar = grammar;
+    }
+
+    virtual ss::formula_grammar_t get_default_formula_grammar() const override
+    {
+        return m_grammar;
+    }
+
+    virtual void set_character_set(character_set_t) override {}
+};
+
+/**
+ * Streaming factory that counts the delivered cells, used when the
+ * spreadsheet model is not available.
+ */
+class counting_factory : public ss::streaming_import_factory
+{
+    global_settings m_gs;
+    std::size_t m_cell_count = 0;
+
+public:
+    counting_factory() :
+        ss::streaming_import_factory([this](const ss::streamed_row_t& row) { m_cell_count += row.cells.size(); })
+    {}
+
+    virtual ss::iface::import_global_settings* get_global_settings() override
+    {
+        return &m_gs;
+    }
+
+    std::size_t cell_count() const { return m_cell_count; }
+};
+
+#endif
+
+/**
+ * Import the stream into a new document, and return the number of the
+ * generated cells.
+ */
+template<typename FilterT>
+std::size_t import_stream(std::string_view stream, const bench::doc_spec& spec)
+{
+#ifdef __ORCUS_SPREADSHEET_MODEL
+    ss::document doc{{1048576, 16384}};
+    ss::import_factory factory(doc);
+#else
+    counting_factory factory;
+#endif
+
+    FilterT app(&factory);
+    app.read_stream(stream);
+
+    return spec.rows * spec.columns;
+}
+
+void run_xml_benchmarks(bench_runner& runner, const bench::doc_spec& spec)
+{
+    if (!runner.any_selected({"sax_parser", "sax_token_parser", "threaded_sax_token_parser"}))
+        return;
+
+    const std::string content = bench::generate_xlsx_sheet_xml(spec);
+
+    runner.run("sax_parser", content.size(), [&content]
+    {
+        sax_counter hdl;
+        sax_parser<sax_counter> parser(content, hdl);
+        parser.parse();
+        return hdl.count;
+    });
+
+    tokens token_map(sheet_token_names, std::size(sheet_token_names));
+    xmlns_repository repo;
+
+    runner.run("sax_token_parser", content.size(), [&]
+    {
+        xmlns_context ns_cxt = repo.create_context();
+        sax_token_counter hdl;
+        sax_token_parser<sax_token_counter> parser(content, token_map, ns_cxt, hdl);
+        parser.parse();
+        return hdl.count;
+    });
+
+    runner.run("threaded_sax_token_parser", content.size(), [&]
+    {
+        xmlns_context ns_cxt = repo.create_context();
+        sax_token_counter hdl;
+        threaded_sax_token_parser<sax_token_counter> parser(
+            content.data(), content.size(), token_map, ns_cxt, hdl, 1000);
+        parser.parse();
+        return hdl.count;
+    });
+}
+
+void run_json_benchmarks(bench_runner& runner, const bench::doc_spec& spec)
+{
+    if (!runner.any_selected({"json_parser", "threaded_json_parser"}))
+        return;
+
+    const std::string content = bench::generate_json(spec);
+
+    runner.run("json_parser", content.size(), [&content]
+    {
+        json_counter hdl;
+        json_parser<json_counter> parser(content, hdl);
+        parser.parse();
+        return hdl.count;
+    });
+
+    runner.run("threaded_json_parser", content.size(), [&content]
+    {
+        json_counter hdl;
+        threaded_json_parser<json_counter> parser(content, hdl, 1000);
+        parser.parse();
+        return hdl.count;
+    });
+}
+
+void run_text_benchmarks(bench_runner& runner, const bench::doc_spec& spec)
+{
+    if (runner.selected("yaml_parser"))
+    {
+        const std::string content = bench::generate_yaml(spec);
+
+        runner.run("yaml_parser", content.size(), [&content]
+        {
+            yaml_counter hdl;
+            yaml_parser<yaml_counter> parser(content, hdl);
+            parser.parse();
+            return hdl.count;
+        });
+    }
+
+    if (runner.any_selected({"csv_parser", "import_csv"}))
+    {
+        const std::string content = bench::generate_csv(spec);
+
+        runner.run("csv_parser", content.size(), [&content]
+        {
+            csv::parser_config config;
+            config.delimiters.push_back(',');
+            config.text_qualifier = '"';
+
+            csv_counter hdl;
+            csv_parser<csv_counter> parser(content, hdl, config);
+            parser.parse();
+            return hdl.count;
+        });
+
+        runner.run("import_csv", content.size(), [&content, &spec]
+        {
+            return import_stream<orcus_csv>(content, spec);
+        });
+    }
+
+    if (runner.selected("css_parser"))
+    {
+        const std::string content = bench::generate_css(spec);
+
+        runner.run("css_parser", content.size(), [&content]
+        {
+            css_counter hdl;
+            css_parser<css_counter> parser(content, hdl);
+            parser.parse();
+            return hdl.count;
+        });
+    }
+
+    if (runner.any_selected({"css_document_tree", "css_rule_match"}))
+    {
+        const std::string content = bench::generate_css(spec);
+
+        runner.run("css_document_tree", content.size(), [&content, &spec]
+        {
+            css_document_tree doc;
+            doc.load(content);
+            return spec.rows;
+        });
+
+        css_document_tree doc;
+        doc.load(content);
+
+        // Elements matched by the generated rules i.e. <table class="tN">
+        // <tr><td class="cN"> for each row, plus a <td> with an id which
+        // matches the rule with the id selector in hover state.
+        std::vector<std::string> names;
+        for (std::size_t row = 0; row < spec.rows; ++row)
+        {
+            names.push_back("t" + std::to_string(row % 64));
+            names.push_back("c" + std::to_string(row));
+            names.push_back("r" + std::to_string(row));
+        }
+
+        runner.run("css_rule_match", content.size(), [&doc, &names, &spec]
+        {
+            std::size_t n = 0;
+            std::vector<css_document_tree::element> path(3);
+            path[0].name = "table";
+            path[1].name = "tr";
+            path[2].name = "td";
+            path[2].pseudo_classes = css::pseudo_class_hover;
+
+            for (std::size_t row = 0; row < spec.rows; ++row)
+            {
+                path[0].classes = { names[row * 3] };
+                path[2].classes = { names[row * 3 + 1] };
+                path[2].id = names[row * 3 + 2];
+                n += doc.resolve_properties(path, 0).size();
+            }
+
+            return n;
+        });
+    }
+
+    if (runner.selected("string_pool"))
+    {
+        const std::vector<std::string> strs = bench::generate_cell_strings(spec);
+        std::size_t n = std::accumulate(
+            strs.begin(), strs.end(), std::size_t(0),
+            [](std::size_t v, const std::string& s) { return v + s.size(); });
+
+        runner.run("string_pool", n, [&strs]
+        {
+            string_pool pool;
+            for (const std::string& s : strs)
+                pool.intern(s);
+            return strs.size();
+        });
+    }
+}
+
+void run_package_benchmarks(bench_runner& runner, const bench::doc_spec& spec)
+{
+    if (runner.any_selected({"zip_archive", "import_xlsx"}))
+    {
+        const std::string content = bench::generate_xlsx(spec);
+
+        runner.run("zip_archive", content.size(), [&content]
+        {
+            zip_archive_stream_blob stream(content);
+            zip_archive archive(&stream);
+            archive.load();
+
+            std::size_t n = 0;
+            for (std::size_t i = 0; i < archive.get_file_entry_count(); ++i)
+                n += archive.read_file_entry(archive.get_file_entry_name(i)).size();
+
+            return n;
+        });
+
+#ifdef __ORCUS_XLSX
+        runner.run("import_xlsx", content.size(), [&content, &spec]
+        {
+            return import_stream<orcus_xlsx>(content, spec);
+        });
+#endif
+    }
+
+#ifdef __ORCUS_ODS
+    if (runner.selected("import_ods"))
+    {
+        const std::string content = bench::generate_ods(spec);
+
+        runner.run("import_ods", content.size(), [&content, &spec]
+        {
+            return import_stream<orcus_ods>(content, spec);
+        });
+    }
+#endif
+
+#ifdef __ORCUS_GNUMERIC
+    if (runner.selected("import_gnumeric"))
+    {
+        const std::string content = bench::generate_gnumeric(spec);
+
+        runner.run("import_gnumeric", content.size(), [&content, &spec]
+        {
+            return import_stream<orcus_gnumeric>(content, spec);
+        });
+    }
+#endif
+}
+
+bool parse_args(int argc, char** argv, options& opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg = argv[i];
+
+        if (arg == "--help")
+        {
+            std::cout << help_text;
+            std::exit(EXIT_SUCCESS);
+        }
+
+        if (arg == "--list")
+        {
+            for (std::string_view name : bench_names)
+                std::cout << name << std::endl;
+            std::exit(EXIT_SUCCESS);
+        }
+
+        if (i + 1 >= argc)
+        {
+            std::cerr << "missing value for " << arg << std::endl;
+            return false;
+        }
+
+        const char* value = argv[++i];
+
+        if (arg == "--rows")
+            opts.spec.rows = std::strtoul(value, nullptr, 10);
+        else if (arg == "--columns")
+            opts.spec.columns = std::strtoul(value, nullptr, 10);
+        else if (arg == "--string-ratio")
+            opts.spec.string_ratio = std::strtod(value, nullptr);
+        else if (arg == "--formula-ratio")
+            opts.spec.formula_ratio = std::strtod(value, nullptr);
+        else if (arg == "--unique-strings")
+            opts.spec.unique_strings = std::strtoul(value, nullptr, 10);
+        else if (arg == "--seed")
+            opts.spec.seed = std::strtoull(value, nullptr, 10);
+        else if (arg == "--repeat")
+            opts.repeat = std::strtoul(value, nullptr, 10);
+        else if (arg == "--warmup")
+            opts.warmup = std::strtoul(value, nullptr, 10);
+        else if (arg == "--filter")
+            opts.filters.emplace_back(value);
+        else if (arg == "--format")
+            opts.format = value;
+        else if (arg == "--output")
+            opts.output = value;
+        else
+        {
+            std::cerr << "unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (opts.format != "text" && opts.format != "json" && opts.format != "csv")
+    {
+        std::cerr << "unsupported output format: " << opts.format << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+}
+
+int main(int argc, char** argv) try
+{
+    options opts;
+    if (!parse_args(argc, argv, opts))
+    {
+        std::cerr << help_text;
+        return EXIT_FAILURE;
+    }
+
+    bench_runner runner(opts);
+    run_xml_benchmarks(runner, opts.spec);
+    run_json_benchmarks(runner, opts.spec);
+    run_text_benchmarks(runner, opts.spec);
+    run_package_benchmarks(runner, opts.spec);
+
+    if (opts.output.empty())
+        runner.write(std::cout);
+    else
+    {
+        std::ofstream of(opts.output);
+        runner.write(of);
+    }
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception& e)
+{
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,140 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+ * Measures the import time of the xls-xml and gnumeric filters with and
+ * without the threaded tokenizer, against a document generated in memory by
+ * the same generator orcus-bench uses.
+ *
+ * Usage: threaded-xml-import-test <xls-xml|gnumeric> [row count]
+ */
+
+#include "doc_generator.hpp"
+
+#include <orcus/orcus_xls_xml.hpp>
+#ifdef __ORCUS_GNUMERIC
+#include <orcus/orcus_gnumeric.hpp>
+#endif
+#include <orcus/spreadsheet/streaming_factory.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace orcus;
+namespace ss = orcus::spreadsheet;
+
+namespace {
+
+class global_settings : public ss::iface::import_global_settings
+{
+    ss::formula_grammar_t m_grammar = ss::formula_grammar_t::unknown;
+
+public:
+    virtual void set_origin_date(int, int, int) override {}
+
+    virtual void set_default_formula_grammar(ss::formula_grammar_t grammar) override
+    {
+        m_grammar = grammar;
+    }
+
+    virtual ss::formula_grammar_t get_default_formula_grammar() const override
+    {
+        return m_grammar;
+    }
+
+    virtual void set_character_set(character_set_t) override {}
+};
+
+/**
+ * Streaming factory that counts the delivered cells, so that the measured
+ * time is dominated by the import filter rather than the document model.
+ */
+class counting_factory : public ss::streaming_import_factory
+{
+    global_settings m_gs;
+    std::size_t m_cell_count = 0;
+
+public:
+    counting_factory() :
+        ss::streaming_import_factory([this](const ss::streamed_row_t& row) { m_cell_count += row.cells.size(); })
+    {}
+
+    virtual ss::iface::import_global_settings* get_global_settings() override
+    {
+        return &m_gs;
+    }
+
+    std::size_t cell_count() const { return m_cell_count; }
+};
+
+template<typename FilterT>
+void run(const char* name, const char* env_name, const std::string& content)
+{
+    for (const char* use_threads : { "false", "true" })
+    {
+        setenv(env_name, use_threads, 1);
+
+        counting_factory factory;
+        FilterT app(&factory);
+
+        auto start = std::chrono::steady_clock::now();
+        app.read_stream(content);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << name << " (threads: " << use_threads << "): "
+            << elapsed.count() << " sec; cell count: " << factory.cell_count() << std::endl;
+    }
+}
+
+}
+
+int main(int argc, char** argv) try
+{
+    if (argc < 2)
+        return EXIT_FAILURE;
+
+    std::string format = argv[1];
+
+    bench::doc_spec spec;
+    spec.rows = 100000;
+
+    if (argc >= 3)
+        spec.rows = strtol(argv[2], nullptr, 10);
+
+    std::cout << "format: " << format << std::endl;
+    std::cout << "row count: " << spec.rows << std::endl;
+
+    if (format == "xls-xml")
+    {
+        std::string content = bench::generate_xls_xml(spec);
+        std::cout << "stream size: " << content.size() << std::endl;
+        run<orcus_xls_xml>("xls-xml import", "ORCUS_XLS_XML_USE_THREADS", content);
+        return EXIT_SUCCESS;
+    }
+
+#ifdef __ORCUS_GNUMERIC
+    if (format == "gnumeric")
+    {
+        std::string content = bench::generate_gnumeric(spec);
+        std::cout << "stream size: " << content.size() << std::endl;
+        run<orcus_gnumeric>("gnumeric import", "ORCUS_GNUMERIC_USE_THREADS", content);
+        return EXIT_SUCCESS;
+    }
+#endif
+
+    std::cerr << "unsupported format: " << format << std::endl;
+    return EXIT_FAILURE;
+}
+catch (const std::exception& e)
+{
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -9,9 +9,12 @@
 
 #include "orcus/env.hpp"
 #include "orcus/types.hpp"
+#include "orcus/spreadsheet/types.hpp"
 
 #include <string>
 #include <variant>
+#include <vector>
+#include <optional>
 
 namespace orcus {
 
@@ -49,6 +52,46 @@ struct ORCUS_DLLPUBLIC config
     // TODO: add config for other formats as needed.
     using data_type = std::variant<csv_config>;
 
+    /**
+     * Selection of sheets and cell range to import.  It is used by the
+     * spreadsheet import filters to limit what gets imported from a document.
+     *
+     * Note that all sheets get created in the target document regardless of
+     * the selection, in order to keep the sheet indices and inter-sheet
+     * references intact.  Only the content of the unselected sheets is
+     * skipped.
+     */
+    struct sheet_selection
+    {
+        /**
+         * Names of the sheets to import.
+         */
+        std::vector<std::string> names;
+
+        /**
+         * 0-based positions of the sheets to import.  A sheet gets imported
+         * when either its name or its position is selected.  When both
+         * @p names and @p indices are empty, all sheets get imported.
+         */
+        std::vector<std::size_t> indices;
+
+        /**
+         * Optional cell range to import in each selected sheet.  Cells that
+         * fall outside this range are skipped.  The range gets clamped to the
+         * size of each sheet, which allows you to specify an open-ended range
+         * by setting its last row or column to a sufficiently large value.
+         */
+        std::optional<spreadsheet::range_t> range;
+
+        /**
+         * Check whether or not this selection imposes any restriction.
+         *
+         * @return true if no sheets and no cell range are selected, in which
+         *         case everything gets imported, otherwise false.
+         */
+        bool empty() const;
+    };
+
     /**
      * Enable or disable runtime debug output to stdout or stderr.
      */
@@ -64,6 +107,12 @@ struct ORCUS_DLLPUBLIC config
 
     data_type data;
 
+    /**
+     * Selection of sheets and cell range to import.  By default everything
+     * gets imported.
+     */
+    sheet_selection selection;
+
     config() = delete;
     config(const config& other);
     config(format_t input_format);
@@ -74,6 +123,27 @@ struct ORCUS_DLLPUBLIC config
 
 struct ORCUS_DLLPUBLIC json_config
 {
+    /**
+     * Storage of a json::document_tree populated from a JSON string.
+     *
+     * - tree: each value is stored in its own node.  The document can be
+     *   modified after it's loaded.
+     * - tape: all values are stored in a flat read-only sequence in document
+     *   order, which uses far less memory for a large document.  Object
+     *   members are always kept in their original order, and the keys of
+     *   a large object get indexed on the first lookup by key.
+     * - lazy: only the positions of the brackets of all containers are
+     *   indexed at load time, and the children of a container are parsed
+     *   when the container is first navigated into.  The document keeps the
+     *   JSON string, or references it without a copy when
+     *   persistent_string_values is false.  A syntax error inside a
+     *   container gets reported only when the container is navigated into.
+     *
+     * Resolving references to external files is not supported with the tape
+     * and lazy storages.
+     */
+    enum class storage_type { tree, tape, lazy };
+
     /**
      * Path of the JSON file being parsed, in case the JSON string originates
      * from a file.  This parameter is required if external JSON files need to
@@ -106,10 +176,74 @@ struct ORCUS_DLLPUBLIC json_config
      */
     bool persistent_string_values = true;
 
+    /**
+     * Storage of the document tree.
+     */
+    storage_type storage = storage_type::tree;
+
+    /**
+     * When true, the JSON string gets tokenized on a separate thread while
+     * the document tree gets built on the calling thread.  This is ignored
+     * with the lazy storage.
+     */
+    bool use_threads = false;
+
+    /**
+     * Number of tokens the parser thread accumulates before handing them
+     * over to the calling thread, when use_threads is true.  The threshold
+     * gets doubled each time the calling thread is still busy with the
+     * previous set of tokens.
+     */
+    std::size_t min_token_size = 1000;
+
+    /**
+     * Maximum value the token size threshold can grow to.  Once reached, the
+     * parser thread waits for the calling thread to take the tokens, which
+     * bounds the memory used for the pending tokens.
+     */
+    std::size_t max_token_size = 100000;
+
     json_config();
     ~json_config();
 };
 
+/**
+ * Settings that control how much of a document gets scanned when building
+ * its structure tree with xml_structure_tree or json::structure_tree.
+ */
+struct ORCUS_DLLPUBLIC structure_scan_config
+{
+    /**
+     * Stop scanning once this many elements in a row, or JSON nodes in case
+     * of JSON, have not added anything new to the structure tree.  0 means
+     * no limit.
+     */
+    std::size_t max_stale_count = 0;
+
+    /**
+     * Stop scanning before the first element, or JSON node in case of JSON,
+     * that starts at or past this many bytes into the stream.  0 means no
+     * limit.
+     */
+    std::size_t max_bytes = 0;
+
+    /**
+     * Number of threads to scan the stream with.  When greater than 1, the
+     * child elements of the root element, or the members of the root array
+     * in case of JSON, get split into up to as many contiguous ranges, which
+     * get scanned in parallel and merged in document order.  The child
+     * elements of an XML root element get split into ranges of about the
+     * same size in bytes.  The
+     * max_stale_count limit then applies to each range separately.  A
+     * stream whose root has no child to split, or a JSON stream whose root
+     * is not an array, gets scanned on the calling thread.
+     */
+    std::size_t thread_count = 1;
+
+    structure_scan_config();
+    ~structure_scan_config();
+};
+
 struct ORCUS_DLLPUBLIC yaml_config
 {
     enum class output_format_type { none, yaml, json };
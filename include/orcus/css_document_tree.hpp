@@ -10,8 +10,12 @@
 #include "orcus/css_selector.hpp"
 #include "orcus/exception.hpp"
 
+#include <compare>
+#include <cstdint>
 #include <string>
 #include <memory>
+#include <span>
+#include <vector>
 
 namespace orcus {
 
@@ -31,6 +35,55 @@ public:
         insertion_error(const std::string& msg);
     };
 
+    /**
+     * Element to match the selectors against.
+     */
+    struct ORCUS_DLLPUBLIC element
+    {
+        /** Tag name of the element. */
+        std::string_view name;
+        /** Value of the id attribute of the element. */
+        std::string_view id;
+        /** Class names of the element. */
+        std::vector<std::string_view> classes;
+        /** Pseudo classes the element is in, e.g. :hover, as bit flags. */
+        css::pseudo_class_t pseudo_classes = 0;
+    };
+
+    /**
+     * Specificity of a selector.  A selector with more ids is more specific,
+     * then one with more classes and pseudo classes, then one with more type
+     * names.
+     */
+    struct ORCUS_DLLPUBLIC specificity_t
+    {
+        std::uint32_t ids = 0;
+        std::uint32_t classes = 0;
+        std::uint32_t types = 0;
+
+        auto operator<=> (const specificity_t&) const = default;
+    };
+
+    /**
+     * Rule that matches an element.
+     */
+    struct ORCUS_DLLPUBLIC matched_rule
+    {
+        /** Selector of the rule. */
+        const css_selector_t* selector = nullptr;
+        /** Pseudo element flags of the rule. */
+        css::pseudo_element_t pseudo_element = 0;
+        /** Properties of the rule. */
+        const css_properties_t* properties = nullptr;
+        specificity_t specificity;
+        /**
+         * Position of the rule in the order of insertion.  When properties
+         * get inserted more than once for the same selector, it's the
+         * position of the last insertion.
+         */
+        std::size_t order = 0;
+    };
+
     css_document_tree(const css_document_tree&) = delete;
 
     css_document_tree();
@@ -87,6 +140,46 @@ public:
     const css_pseudo_element_properties_t*
         get_all_properties(const css_selector_t& selector) const;
 
+    /**
+     * Get all rules whose selectors match an element, in ascending order of
+     * precedence i.e. by specificity, then by the order of insertion.
+     *
+     * The rules are looked up in an index keyed by the id, the class names
+     * and the tag name of the last simple selector of each rule, so only
+     * the rules that may apply to the element get tested against it.
+     *
+     * Since the element's siblings are not known, a selector with a next
+     * sibling combinator never matches.  Tag names are compared case
+     * sensitively.
+     *
+     * @param path element to match, preceded by all its ancestors starting
+     *             with the root element.  The last element in the path is
+     *             the element to match.
+     * @param pseudo_elem pseudo element flags for the last simple selector.
+     *
+     * @return matching rules.  Each rule refers to the selector and the
+     *         properties stored in this instance, which stay valid until
+     *         this instance gets destroyed.
+     */
+    std::vector<matched_rule> get_matching_rules(
+        std::span<const element> path, css::pseudo_element_t pseudo_elem) const;
+
+    /**
+     * Get the properties that apply to an element after resolving the
+     * cascade.  When more than one matching rule sets the same property, the
+     * value from the rule with the highest specificity wins, and between
+     * rules of the same specificity, the value inserted last wins.
+     *
+     * @param path element to match, preceded by all its ancestors starting
+     *             with the root element.
+     * @param pseudo_elem pseudo element flags for the last simple selector.
+     *
+     * @return resolved properties.  The property names and the string
+     *         values refer to the strings stored in this instance.
+     */
+    css_properties_t resolve_properties(
+        std::span<const element> path, css::pseudo_element_t pseudo_elem) const;
+
     void dump() const;
 
     void swap(css_document_tree& other) noexcept;
@@ -9,9 +9,14 @@
 
 #include <orcus/env.hpp>
 #include <orcus/types.hpp>
+#include <orcus/spreadsheet/types.hpp>
 
 #include <cstdlib>
 #include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
 
 namespace orcus {
 
@@ -48,6 +53,78 @@ ORCUS_DLLPUBLIC format_t detect(std::string_view strm);
  */
 ORCUS_DLLPUBLIC bool detect(std::string_view strm, format_t type);
 
+/**
+ * Summary of a document's metadata as collected by probe(), without
+ * importing any of its content.  Members whose values cannot be determined
+ * cheaply for the given format are left empty.
+ */
+struct ORCUS_DLLPUBLIC document_info
+{
+    /**
+     * Single part (or file entry) stored in a zip-based document package.
+     */
+    struct part_type
+    {
+        /** Name of the part within the package. */
+        std::string name;
+        /** Uncompressed size of the part in bytes. */
+        std::size_t size = 0;
+        /** Compressed size of the part in bytes. */
+        std::size_t compressed_size = 0;
+    };
+
+    /**
+     * Single sheet in a spreadsheet document.
+     */
+    struct sheet_type
+    {
+        /** Name of the sheet. */
+        std::string name;
+        /** Name of the package part that stores the sheet content, if any. */
+        std::string part;
+        /**
+         * Used range of the sheet, if available.  For xlsx, this is the range
+         * recorded by the producer of the document.  For ods, it is measured
+         * from the cells that have a value or a formula, and is only available
+         * for the sheets that end within the head of the content part.
+         */
+        std::optional<spreadsheet::range_t> dimension;
+    };
+
+    /** Format of the document. */
+    format_t format = format_t::unknown;
+    /** Sheets in the order they appear in the document. */
+    std::vector<sheet_type> sheets;
+    /** Number of unique shared strings, if the format stores them. */
+    std::optional<std::size_t> shared_string_count;
+    /**
+     * Whether or not the document contains formula cells.  It is empty when
+     * this cannot be determined from the parts of the document that have
+     * been read.
+     */
+    std::optional<bool> has_formulas;
+    /** Parts stored in the document package, for zip-based formats only. */
+    std::vector<part_type> parts;
+};
+
+/**
+ * Collect the metadata of a given document stream without importing its
+ * content.  For zip-based formats, only the package directory, a few small
+ * parts, and the head of each sheet part (or of the content part for ods)
+ * get read.
+ *
+ * @param strm document stream to probe.
+ *
+ * @return metadata of the document.  Its format member is set to
+ *         format_t::unknown if the format of the stream cannot be detected.
+ *
+ * @exception orcus::parse_error if a part that has been read in full is not
+ *            well-formed.
+ */
+ORCUS_DLLPUBLIC document_info probe(std::string_view strm);
+
+ORCUS_DLLPUBLIC std::ostream& operator<<(std::ostream& os, const document_info& info);
+
 /**
  * Create an instance of import_filter for a specified format.
  *
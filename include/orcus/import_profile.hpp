@@ -0,0 +1,158 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "orcus/env.hpp"
+
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace orcus {
+
+/**
+ * Timings and counters collected during an import.
+ */
+struct ORCUS_DLLPUBLIC import_profile_t
+{
+    using duration_type = std::chrono::nanoseconds;
+
+    /**
+     * Single timed stage of an import, such as the parsing of a sheet stream
+     * or the finalization of the document.  Stages may be nested.
+     */
+    struct ORCUS_DLLPUBLIC stage_t
+    {
+        /** Name of the stage. */
+        std::string name;
+        /** Start time of the stage relative to the start of the profiling. */
+        duration_type start{0};
+        /** Time spent in the stage. */
+        duration_type duration{0};
+    };
+
+    /**
+     * Single part of a zip package that has been inflated.
+     */
+    struct ORCUS_DLLPUBLIC part_t
+    {
+        /** Path of the part inside the package. */
+        std::string name;
+        /** Size of the part as stored in the package. */
+        std::size_t compressed_size = 0;
+        /** Size of the part after inflation. */
+        std::size_t inflated_size = 0;
+        /** Start time of the inflation relative to the start of the profiling. */
+        duration_type start{0};
+        /**
+         * Time spent inflating the part, or waiting for it to be inflated on
+         * a helper thread.
+         */
+        duration_type duration{0};
+    };
+
+    /** Timed stages, in the order of their completion. */
+    std::vector<stage_t> stages;
+    /** Inflated parts, in the order of their use. */
+    std::vector<part_t> parts;
+
+    /** Time elapsed between the start of the profiling and the end of the last stage. */
+    duration_type total{0};
+
+    /** Number of XML elements processed. */
+    std::size_t xml_elements = 0;
+    /** Number of XML attributes processed. */
+    std::size_t xml_attributes = 0;
+    /** Number of cell values and formula cells pushed to the document. */
+    std::size_t cells = 0;
+    /** Number of formula cells and formula groups staged for the document. */
+    std::size_t formulas = 0;
+    /** Number of strings interned in the document's cell string pool. */
+    std::size_t strings = 0;
+
+    /**
+     * Write the stages and the parts as trace events in the Chrome trace
+     * event format, which can be loaded in a trace viewer such as Perfetto.
+     * The counters are written as the arguments of a counter event at the
+     * end of the trace.
+     *
+     * @param os output stream to write the trace to.
+     */
+    void write_chrome_trace(std::ostream& os) const;
+};
+
+ORCUS_DLLPUBLIC std::ostream& operator<<(std::ostream& os, const import_profile_t& v);
+
+/**
+ * Collects the timings and counters of an import.  An instance of this class
+ * gets attached to an import filter, and optionally to the spreadsheet
+ * import factory the filter pushes its content to.  The filter and the
+ * factory record their stages and counters only when a profiler is
+ * attached.
+ *
+ * The recording methods may be called from multiple threads.
+ */
+class ORCUS_DLLPUBLIC import_profiler
+{
+    struct impl;
+    std::unique_ptr<impl> mp_impl;
+
+public:
+    /**
+     * Times a single stage for the duration of its lifetime.  It does
+     * nothing when the profiler is null.
+     */
+    class ORCUS_DLLPUBLIC scope
+    {
+        import_profiler* mp_profiler;
+        std::string_view m_name;
+        import_profile_t::duration_type m_start;
+
+    public:
+        scope(import_profiler* profiler, std::string_view name);
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+        ~scope();
+    };
+
+    import_profiler();
+    import_profiler(const import_profiler&) = delete;
+    import_profiler& operator=(const import_profiler&) = delete;
+    ~import_profiler();
+
+    /**
+     * Get the time elapsed since the construction of the profiler.
+     */
+    import_profile_t::duration_type elapsed() const;
+
+    void add_stage(std::string_view name, import_profile_t::duration_type start);
+
+    void add_part(
+        std::string_view name, std::size_t compressed_size, std::size_t inflated_size,
+        import_profile_t::duration_type start);
+
+    void add_xml_elements(std::size_t elements, std::size_t attributes);
+
+    void add_cells(std::size_t n);
+
+    void add_formulas(std::size_t n);
+
+    void add_strings(std::size_t n);
+
+    /**
+     * Get a copy of the timings and counters collected so far.
+     */
+    import_profile_t get_profile() const;
+};
+
+} // namespace orcus
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
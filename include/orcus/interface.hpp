@@ -17,6 +17,7 @@
 namespace orcus {
 
 struct config;
+class import_profiler;
 
 namespace iface {
 
@@ -66,6 +67,23 @@ public:
      * @return Reference to currently stored filter configuration.
      */
     const orcus::config& get_config() const;
+
+    /**
+     * Attach a profiler to collect the timings and counters of the
+     * subsequent imports.
+     *
+     * @param profiler profiler to attach, or nullptr to detach the current
+     *                 one.  The caller retains the ownership of the profiler.
+     */
+    void set_profiler(import_profiler* profiler);
+
+    /**
+     * Get the profiler currently attached.
+     *
+     * @return pointer to the attached profiler, or nullptr if none is
+     *         attached.
+     */
+    import_profiler* get_profiler() const;
 };
 
 /**
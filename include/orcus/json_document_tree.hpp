@@ -9,9 +9,11 @@
 
 #include "env.hpp"
 #include "exception.hpp"
+#include "json_parser_thread.hpp"
 
 #include <string>
 #include <memory>
+#include <optional>
 #include <vector>
 #include <cstdint>
 
@@ -487,6 +489,15 @@ public:
      */
     void load(std::string_view stream, const json_config& config);
 
+    /**
+     * Get the statistics of the parser thread from the last load() call.
+     *
+     * @return statistics of the parser thread, or an empty value when the
+     *         last load() call did not tokenize the stream on a separate
+     *         thread.
+     */
+    std::optional<json::parser_stats> get_parser_stats() const;
+
     /**
      * Get the root node of the document.
      *
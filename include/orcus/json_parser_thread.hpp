@@ -94,6 +94,13 @@ public:
     parser_stats get_stats() const;
 
     void swap_string_pool(string_pool& pool);
+
+    /**
+     * Stop the parsing prematurely.  Call this from the client thread when
+     * it stops processing the tokens, so that the parser thread doesn't
+     * wait for the tokens to get used up.
+     */
+    void abort();
 };
 
 }}
@@ -16,7 +16,11 @@
 #include <functional>
 #include <any>
 
-namespace orcus { namespace json {
+namespace orcus {
+
+struct structure_scan_config;
+
+namespace json {
 
 struct ORCUS_DLLPUBLIC table_range_t
 {
@@ -148,6 +152,30 @@ public:
 
     void parse(std::string_view stream);
 
+    /**
+     * Parse a JSON stream, and build its structure tree from as much of the
+     * stream as the config allows to be scanned.
+     *
+     * When the config specifies more than one thread, the repeated-node
+     * callback gets called once for each repeated node after the whole
+     * tree is built, instead of each time a repeated node is encountered.
+     *
+     * @param stream JSON stream.
+     * @param config settings that limit how much of the stream gets
+     *               scanned, and how many threads to scan it with.
+     */
+    void parse(std::string_view stream, const structure_scan_config& config);
+
+    /**
+     * Check whether or not the structure tree has been built from the whole
+     * stream passed to the last parse() call.
+     *
+     * @return true if the whole stream has been scanned, or false if the
+     *         scan stopped early as specified by the config, or nothing has
+     *         been parsed yet.
+     */
+    bool is_exhaustive() const;
+
     /**
      * For now, normalizing a tree just means sorting child nodes.  We may add
      * other normalization stuff later.
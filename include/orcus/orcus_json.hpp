@@ -61,6 +61,23 @@ public:
 
     void read_stream(std::string_view stream);
 
+    /**
+     * Read a JSON Lines (also known as newline-delimited JSON) stream, where
+     * each line contains a complete JSON value.  The lines get mapped as if
+     * they were the elements of one array enclosing the whole stream.  A
+     * mapping that works with an array of records thus works with the same
+     * records written one per line, and a row group set to the root
+     * (<code>$</code>) produces one row per line.  Blank lines are skipped.
+     *
+     * The lines get parsed in blocks on worker threads, and the parsed values
+     * are pushed to the sheets in the order of the lines.  Set the
+     * ORCUS_JSON_USE_THREADS environment variable to false to parse all lines
+     * on the calling thread.
+     *
+     * @param stream JSON Lines stream.
+     */
+    void read_lines(std::string_view stream);
+
     /**
      * Read a JSON string that contains an entire set of mapping rules.
      *
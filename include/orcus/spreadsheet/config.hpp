@@ -9,6 +9,7 @@
 
 #include "orcus/env.hpp"
 
+#include <cstddef>
 #include <cstdint>
 
 namespace orcus { namespace spreadsheet {
@@ -22,6 +23,14 @@ struct ORCUS_SPM_DLLPUBLIC document_config
      */
     int8_t output_precision;
 
+    /**
+     * Maximum number of threads to use when dumping the content of a
+     * document into a directory, where each sheet gets dumped into its own
+     * file.  The sheets get dumped concurrently when this value is greater
+     * than 1.  The content of the output files does not depend on this value.
+     */
+    std::size_t dump_threads;
+
     document_config();
     document_config(const document_config& r);
     ~document_config();
@@ -10,6 +10,7 @@
 #include "orcus/env.hpp"
 #include "orcus/interface.hpp"
 #include "orcus/spreadsheet/types.hpp"
+#include "orcus/spreadsheet/document_types.hpp"
 
 #include <ostream>
 #include <memory>
@@ -69,6 +70,61 @@ public:
     /** See @ref iface::document_dumper. */
     virtual void dump_check(std::ostream& os) const override;
 
+    /**
+     * Save the content of the document as a binary snapshot, which can be
+     * loaded back much faster than re-importing the original file.
+     *
+     * @param filepath path of the snapshot file to write.
+     *
+     * @note The snapshot does not include the pivot table definitions.  It
+     *       can only be loaded on a platform of the same byte order and word
+     *       size.
+     */
+    void save_snapshot(const std::filesystem::path& filepath) const;
+
+    /**
+     * Save the content of the document as a binary snapshot.
+     *
+     * @param os output stream to write the snapshot to.  It should be opened
+     *           in binary mode.
+     */
+    void save_snapshot(std::ostream& os) const;
+
+    /**
+     * Replace the content of the document with that of a snapshot previously
+     * saved via save_snapshot().  The file gets memory-mapped, and the cell
+     * values are read from the arrays stored in it without any text parsing,
+     * though they still get set to the sheets one cell at a time.
+     *
+     * @param filepath path of the snapshot file to load.
+     *
+     * @exception orcus::general_error if the file is not a valid snapshot.
+     *            The document is left empty in this case.
+     */
+    void load_snapshot(const std::filesystem::path& filepath);
+
+    /**
+     * Replace the content of the document with that of a snapshot stored in
+     * memory.
+     *
+     * @param content content of a snapshot previously saved via
+     *                save_snapshot().
+     *
+     * @exception orcus::general_error if the content is not a valid
+     *            snapshot.  The document is left empty in this case.
+     */
+    void load_snapshot_stream(std::string_view content);
+
+    /**
+     * Estimate the amount of memory used by the document content, broken
+     * down by its components.  The values are approximate, as they are
+     * computed from the numbers of stored elements and the sizes of their
+     * data structures rather than measured from the allocator.
+     *
+     * @return breakdown of the memory used by the document.
+     */
+    document_memory_usage_t get_memory_usage() const;
+
     shared_strings& get_shared_strings();
     const shared_strings& get_shared_strings() const;
 
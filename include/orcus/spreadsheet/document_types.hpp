@@ -10,6 +10,8 @@
 #include "types.hpp"
 #include <vector>
 #include <optional>
+#include <string>
+#include <ostream>
 
 namespace orcus { namespace spreadsheet {
 
@@ -130,6 +132,72 @@ struct ORCUS_SPM_DLLPUBLIC format_run_t
 /** Collection of format properties of a string. */
 using format_runs_t = std::vector<format_run_t>;
 
+/**
+ * Approximate amount of memory used by the content of a single sheet.  All
+ * values are in bytes.
+ */
+struct ORCUS_SPM_DLLPUBLIC sheet_memory_usage_t
+{
+    /** Name of the sheet. */
+    std::string name;
+    /**
+     * Cell values, including the formula cell instances and their results.
+     * The size of the internal state of each formula cell is an estimate
+     * based on the layout of ixion's formula cell, which is not public, and
+     * may differ from the actual size with a different version of ixion.
+     */
+    std::size_t cells = 0;
+    /** Per-column segment trees that store the cell format indices. */
+    std::size_t cell_formats = 0;
+    /** Segment tree that stores the column format indices. */
+    std::size_t column_formats = 0;
+    /** Segment tree that stores the row format indices. */
+    std::size_t row_formats = 0;
+    /**
+     * Column widths, row heights, hidden column and row flags, merged cell
+     * ranges and the auto filter.
+     */
+    std::size_t properties = 0;
+
+    /**
+     * @return sum of all the values.
+     */
+    std::size_t total() const;
+};
+
+/**
+ * Approximate amount of memory used by a document, broken down by its
+ * components.  All values are in bytes.
+ */
+struct ORCUS_SPM_DLLPUBLIC document_memory_usage_t
+{
+    /** Memory used by each sheet, in the order of the sheets. */
+    std::vector<sheet_memory_usage_t> sheets;
+    /** Strings referenced by the string cells. */
+    std::size_t cell_strings = 0;
+    /** Format runs of the shared strings. */
+    std::size_t shared_strings = 0;
+    /** Strings interned in the document's string pool. */
+    std::size_t string_pool = 0;
+    /** Font, fill, border, protection, number format and cell style entries. */
+    std::size_t styles = 0;
+    /** Pivot cache fields and records. */
+    std::size_t pivot_caches = 0;
+    /** Formula token stores, counting each shared store only once. */
+    std::size_t formula_tokens = 0;
+    /** Table definitions. */
+    std::size_t tables = 0;
+    /** Data collected during import, which is kept until the next recalculation. */
+    std::size_t import_session = 0;
+
+    /**
+     * @return sum of all the values including those of the sheets.
+     */
+    std::size_t total() const;
+};
+
+ORCUS_SPM_DLLPUBLIC std::ostream& operator<<(std::ostream& os, const document_memory_usage_t& v);
+
 }} // namespace orcus::spreadsheet
 
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -18,6 +18,7 @@
 namespace orcus {
 
 class string_pool;
+class import_profiler;
 
 namespace spreadsheet {
 
@@ -90,6 +91,16 @@ public:
     void set_recalc_formula_cells(bool b);
 
     void set_formula_error_policy(formula_error_policy_t policy);
+
+    /**
+     * Attach a profiler to record the time spent finalizing the document and
+     * re-calculating its formula cells, and the numbers of the cells, the
+     * formula cells and the strings imported.
+     *
+     * @param profiler profiler to attach, or nullptr to detach the current
+     *                 one.  The caller retains the ownership of the profiler.
+     */
+    void set_profiler(import_profiler* profiler);
 };
 
 /**
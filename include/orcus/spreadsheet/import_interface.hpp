@@ -1055,7 +1055,9 @@ public:
 
     /**
      * Duplicate the value of the source cell to one or more cells located
-     * immediately below it.
+     * immediately below it.  When the source cell is a formula cell, its
+     * relative references get shifted for each destination cell, the same
+     * way a shared formula's would.
      *
      * @param src_row row ID of the source cell
      * @param src_col column ID of the source cell
@@ -1064,6 +1066,16 @@ public:
      */
     virtual void fill_down_cells(row_t src_row, col_t src_col, row_t range_size) = 0;
 
+    /**
+     * Signal that the import filter has pushed all cells of the rows up to
+     * and including the specified row, except for those it pushes after
+     * reading the whole sheet, such as the formula cells.  Not all import
+     * filters make this call, and the default implementation does nothing.
+     *
+     * @param row row ID of the last row that has been completed.
+     */
+    virtual void end_row(row_t row);
+
     /**
      * Get the maximum dimension of a sheet.
      *
@@ -39,6 +39,8 @@ namespace detail {
 
 class debug_state_dumper_pivot_cache;
 class debug_state_dumper_pivot_table;
+class document_snapshot_writer;
+class document_memory_counter;
 
 }
 
@@ -386,6 +388,9 @@ public:
 
 class ORCUS_SPM_DLLPUBLIC pivot_collection
 {
+    friend class detail::document_snapshot_writer;
+    friend class detail::document_memory_counter;
+
     struct impl;
     std::unique_ptr<impl> mp_impl;
 
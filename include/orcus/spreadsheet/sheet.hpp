@@ -31,6 +31,9 @@ struct auto_filter_t;
 namespace detail {
 
 struct sheet_impl;
+class document_snapshot_writer;
+class document_snapshot_reader;
+class document_memory_counter;
 
 }
 
@@ -42,6 +45,9 @@ class ORCUS_SPM_DLLPUBLIC sheet
 {
     friend class document;
     friend struct detail::sheet_impl;
+    friend class detail::document_snapshot_writer;
+    friend class detail::document_snapshot_reader;
+    friend class detail::document_memory_counter;
 
     static const row_t max_row_limit;
     static const col_t max_col_limit;
@@ -172,6 +178,19 @@ public:
      */
     void dump_csv(std::ostream& os) const;
 
+    /**
+     * Dump the content of an entire sheet in Apache Parquet format.  The first
+     * row provides the column names, and the type of each column is inferred
+     * from its values.
+     *
+     * @param os Output stream to dump the content to.  It should be opened
+     *           in binary mode.
+     *
+     * @exception orcus::general_error if orcus is built without Apache
+     *            Parquet support.
+     */
+    void dump_parquet(std::ostream& os) const;
+
     /**
      * Dump the stored state of a sheet across multiple files.  This is useful
      * for debugging.
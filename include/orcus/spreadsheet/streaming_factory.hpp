@@ -0,0 +1,139 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "import_interface.hpp"
+
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+// NB: This header must not depend on ixion.
+
+namespace orcus { namespace spreadsheet {
+
+/**
+ * Single cell of a row delivered by streaming_import_factory.
+ */
+struct ORCUS_DLLPUBLIC streamed_cell_t
+{
+    using value_type = std::variant<bool, double, std::string_view, date_time_t>;
+
+    enum class cell_type
+    {
+        /** The cell has a format but no value. */
+        empty = 0,
+        boolean,
+        numeric,
+        string,
+        date_time
+    };
+
+    col_t column = 0;
+    cell_type type = cell_type::empty;
+    /**
+     * Value of the cell.  For a formula cell, this is its cached result.  A
+     * string value is only valid for the duration of the row handler call.
+     */
+    value_type value;
+    /** 0-based xf (cell format) index. */
+    std::size_t xf = 0;
+
+    streamed_cell_t();
+    streamed_cell_t(col_t _column);
+    streamed_cell_t(const streamed_cell_t& other);
+    ~streamed_cell_t();
+
+    streamed_cell_t& operator=(const streamed_cell_t& other);
+};
+
+/**
+ * Single row delivered by streaming_import_factory.
+ */
+struct ORCUS_DLLPUBLIC streamed_row_t
+{
+    sheet_t sheet = -1;
+    std::string_view sheet_name;
+    row_t row = -1;
+    /** Cells of the row sorted by their column positions. */
+    std::vector<streamed_cell_t> cells;
+
+    streamed_row_t();
+    ~streamed_row_t();
+};
+
+/**
+ * Import factory that does not build any document model, but instead
+ * delivers the cells of each row to a caller-provided handler as soon as the
+ * import filter moves past that row.  Only the row currently being populated
+ * and the shared string table are kept in memory.
+ *
+ * A row is considered complete when the filter signals the end of it via
+ * iface::import_sheet::end_row(), or, for the filters that don't, when a
+ * cell gets pushed to a different row or to another sheet.  Rows with no
+ * cells are not delivered.
+ *
+ * Cells that the filter pushes to the rows already delivered are held until
+ * the import ends, and then delivered row by row, once for each of these
+ * rows, with only those cells in them.  The xlsx and ods filters push all
+ * formula cells after they have read all of the sheets, so a row that
+ * contains formula cells gets delivered in two parts: first with its other
+ * cells, then with the cached results of its formula cells.  A formula cell
+ * that has a format of its own also appears in the first part as an empty
+ * cell with that format.  The row and range formats don't apply to the cells
+ * in the second part.
+ *
+ * No styles are imported.  The format index delivered with each cell is the
+ * one referenced by the source document, taking the row and column formats
+ * into account when a cell has no format of its own.
+ */
+class ORCUS_DLLPUBLIC streaming_import_factory : public iface::import_factory
+{
+    struct impl;
+    std::unique_ptr<impl> mp_impl;
+
+public:
+    using row_handler_type = std::function<void(const streamed_row_t&)>;
+
+    streaming_import_factory(row_handler_type handler);
+    virtual ~streaming_import_factory() override;
+
+    virtual iface::import_shared_strings* get_shared_strings() override;
+    virtual iface::import_reference_resolver* get_reference_resolver(formula_ref_context_t cxt) override;
+    virtual iface::import_sheet* append_sheet(sheet_t sheet_index, std::string_view name) override;
+    virtual iface::import_sheet* get_sheet(std::string_view name) override;
+    virtual iface::import_sheet* get_sheet(sheet_t sheet_index) override;
+
+    /**
+     * Deliver the rows still pending.
+     */
+    virtual void finalize() override;
+
+    void set_default_row_size(row_t row_size);
+    void set_default_column_size(col_t col_size);
+
+    /**
+     * Get a string stored in the shared string table.
+     *
+     * @param sindex index of the string.
+     *
+     * @return string value, or an empty string if the index is out of range.
+     */
+    std::string_view get_shared_string(string_id_t sindex) const;
+
+    /**
+     * @return number of strings stored in the shared string table.
+     */
+    std::size_t get_shared_string_count() const;
+};
+
+}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -87,10 +87,20 @@ void threaded_json_parser<_Handler>::parse()
 
     json::parse_tokens_t tokens;
 
-    while (m_parser_thread.next_tokens(tokens))
-        process_tokens(tokens);
+    try
+    {
+        while (m_parser_thread.next_tokens(tokens))
+            process_tokens(tokens);
 
-    process_tokens(tokens);
+        process_tokens(tokens);
+    }
+    catch (...)
+    {
+        // The handler may throw anything to stop the parsing.  The parser
+        // thread must be stopped regardless, or it will never finish.
+        m_parser_thread.abort();
+        throw;
+    }
 }
 
 template<typename _Handler>
@@ -101,8 +101,10 @@ void threaded_sax_token_parser<_Handler>::parse()
 
         process_tokens(tokens);
     }
-    catch (const std::exception&)
+    catch (...)
     {
+        // The handler may throw anything to stop the parsing.  The parser
+        // thread must be stopped regardless, or it will never finish.
         m_parser_thread.abort();
         throw;
     }
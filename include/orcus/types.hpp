@@ -514,7 +514,8 @@ enum class dump_format_t
     json,
     xml,
     yaml,
-    debug_state
+    debug_state,
+    parquet
 };
 
 /**
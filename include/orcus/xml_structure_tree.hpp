@@ -18,6 +18,7 @@
 namespace orcus {
 
 class xmlns_context;
+struct structure_scan_config;
 
 struct ORCUS_DLLPUBLIC xml_table_range_t
 {
@@ -219,6 +220,31 @@ public:
 
     void parse(std::string_view s);
 
+    /**
+     * Parse an XML stream, and build its structure tree from as much of the
+     * stream as the config allows to be scanned.
+     *
+     * When the config specifies more than one thread, the repeated-element
+     * callback gets called once for each repeated element after the whole
+     * tree is built, instead of each time a repeated element is
+     * encountered.
+     *
+     * @param s XML stream.
+     * @param config settings that limit how much of the stream gets
+     *               scanned, and how many threads to scan it with.
+     */
+    void parse(std::string_view s, const structure_scan_config& config);
+
+    /**
+     * Check whether or not the structure tree has been built from the whole
+     * stream passed to the last parse() call.
+     *
+     * @return true if the whole stream has been scanned, or false if the
+     *         scan stopped early as specified by the config, or nothing has
+     *         been parsed yet.
+     */
+    bool is_exhaustive() const;
+
     void dump_compact(std::ostream& os) const;
 
     walker get_walker() const;
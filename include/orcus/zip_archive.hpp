@@ -121,10 +121,34 @@ public:
      */
     size_t get_file_entry_count() const;
 
+    /**
+     * Get the uncompressed size of a file entry as recorded in the central
+     * directory.  This does not read the file entry itself.
+     *
+     * @param index file entry index.
+     *
+     * @return uncompressed size of the file entry in bytes.
+     */
+    std::size_t get_file_entry_size(std::size_t index) const;
+
+    /**
+     * Get the compressed size of a file entry as recorded in the central
+     * directory.  This does not read the file entry itself.
+     *
+     * @param index file entry index.
+     *
+     * @return compressed size of the file entry in bytes.
+     */
+    std::size_t get_file_entry_compressed_size(std::size_t index) const;
+
     /**
      * Retrieve data stream of specified file entry. The retrieved data stream
      * gets uncompressed if the original stream is compressed.
      *
+     * This method may be called from multiple threads concurrently once the
+     * archive has been loaded.  The underlying stream gets accessed by one
+     * thread at a time, but the decompression runs in parallel.
+     *
      * @param entry_name file entry name.
      *
      * @return buffer containing the data stream for specified entry.
@@ -133,6 +157,23 @@ public:
      *                      stream retrieval.
      */
     unnamed_buffer read_file_entry(std::string_view entry_name) const;
+
+    /**
+     * Retrieve only the leading part of the data stream of specified file
+     * entry.  Only as much of the compressed stream gets read and inflated as
+     * is necessary to produce the requested number of bytes, which makes this
+     * suitable for peeking at the head of a large entry.
+     *
+     * @param entry_name file entry name.
+     * @param max_size   maximum number of uncompressed bytes to retrieve.
+     *
+     * @return buffer containing the first @p max_size bytes of the data
+     *         stream, or the entire data stream if it is shorter.
+     *
+     * @exception zip_error thrown when any problem is encountered during data
+     *                      stream retrieval.
+     */
+    unnamed_buffer read_file_entry(std::string_view entry_name, std::size_t max_size) const;
 };
 
 }
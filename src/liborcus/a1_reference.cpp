@@ -0,0 +1,90 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "a1_reference.hpp"
+
+#include <limits>
+
+namespace ss = orcus::spreadsheet;
+
+namespace orcus {
+
+std::optional<ss::address_t> parse_a1_address(std::string_view s)
+{
+    const char* p = s.data();
+    const char* p_end = p + s.size();
+
+    if (p != p_end && *p == '$')
+        ++p;
+
+    ss::col_t col = 0;
+    const char* p_col = p;
+    for (; p != p_end; ++p)
+    {
+        char c = *p;
+        if ('a' <= c && c <= 'z')
+            c -= 'a' - 'A';
+
+        if (c < 'A' || 'Z' < c)
+            break;
+
+        if (col > std::numeric_limits<ss::col_t>::max() / 26 - 1)
+            return std::nullopt;
+
+        col = col * 26 + (c - 'A' + 1);
+    }
+
+    if (p == p_col)
+        return std::nullopt;
+
+    if (p != p_end && *p == '$')
+        ++p;
+
+    ss::row_t row = 0;
+    const char* p_row = p;
+    for (; p != p_end && '0' <= *p && *p <= '9'; ++p)
+    {
+        if (row > std::numeric_limits<ss::row_t>::max() / 10 - 1)
+            return std::nullopt;
+
+        row = row * 10 + (*p - '0');
+    }
+
+    if (p == p_row || p != p_end || !row)
+        return std::nullopt;
+
+    return ss::address_t{row - 1, col - 1};
+}
+
+std::optional<ss::range_t> parse_a1_range(std::string_view s)
+{
+    auto pos = s.find(':');
+    auto first = parse_a1_address(s.substr(0, pos));
+    if (!first)
+        return std::nullopt;
+
+    auto last = pos == std::string_view::npos ? first : parse_a1_address(s.substr(pos + 1));
+    if (!last)
+        return std::nullopt;
+
+    return ss::range_t{*first, *last};
+}
+
+void write_a1_address(std::ostream& os, const ss::address_t& addr)
+{
+    char buf[8];
+    char* p = buf + sizeof(buf);
+
+    for (ss::col_t col = addr.column + 1; col > 0; col = (col - 1) / 26)
+        *--p = 'A' + (col - 1) % 26;
+
+    os << std::string_view{p, std::size_t(buf + sizeof(buf) - p)} << (addr.row + 1);
+}
+
+} // namespace orcus
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
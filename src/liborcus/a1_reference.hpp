@@ -0,0 +1,48 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "orcus/spreadsheet/types.hpp"
+
+#include <optional>
+#include <ostream>
+#include <string_view>
+
+namespace orcus {
+
+/**
+ * Parse a single cell address in A1 notation e.g. 'B2'.  Absolute reference
+ * markers are ignored.  This is for the code paths that need to interpret
+ * cell addresses without a formula engine.
+ *
+ * @param s cell address string.
+ *
+ * @return 0-based cell address, or an empty value if the string is not a
+ *         valid cell address.
+ */
+std::optional<spreadsheet::address_t> parse_a1_address(std::string_view s);
+
+/**
+ * Parse a range reference in A1 notation e.g. 'A1:C10'.  A single cell
+ * address is also accepted as a range reference.
+ *
+ * @param s range reference string.
+ *
+ * @return 0-based range, or an empty value if the string is not a valid range
+ *         reference.
+ */
+std::optional<spreadsheet::range_t> parse_a1_range(std::string_view s);
+
+/**
+ * Write a 0-based cell address in A1 notation.
+ */
+void write_a1_address(std::ostream& os, const spreadsheet::address_t& addr);
+
+} // namespace orcus
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
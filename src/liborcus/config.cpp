@@ -9,6 +9,11 @@
 
 namespace orcus {
 
+bool config::sheet_selection::empty() const
+{
+    return names.empty() && indices.empty() && !range;
+}
+
 config::config(const config& other) = default;
 config::~config() = default;
 
@@ -46,6 +51,9 @@ config& config::operator=(const config& other) = default;
 json_config::json_config() = default;
 json_config::~json_config() = default;
 
+structure_scan_config::structure_scan_config() = default;
+structure_scan_config::~structure_scan_config() = default;
+
 yaml_config::yaml_config() :
     output_format(output_format_type::none) {}
 
@@ -15,8 +15,11 @@
 #include <unordered_map>
 #include <map>
 #include <algorithm>
+#include <bit>
+#include <deque>
 #include <iterator>
 #include <string_view>
+#include <tuple>
 
 namespace orcus {
 
@@ -323,7 +326,7 @@ public:
     }
 };
 
-void store_properties(
+css_properties_t* store_properties(
     string_pool& sp, css_pseudo_element_properties_t& store,
     css::pseudo_element_t pseudo_flags, const css_properties_t& props)
 {
@@ -337,7 +340,7 @@ void store_properties(
                     pseudo_flags, css_properties_t()));
         if (!r.second)
             // insertion failed.
-            return;
+            return nullptr;
 
         it_store = r.first;
     }
@@ -352,6 +355,8 @@ void store_properties(
         for_each(it->second.begin(), it->second.end(), intern_inserter(sp, vals));
         prop_store[key] = vals;
     }
+
+    return &prop_store;
 }
 
 simple_selector_node* get_or_create_simple_selector_node(
@@ -525,6 +530,136 @@ const css_pseudo_element_properties_t* get_properties_map(
     return &node->properties;
 }
 
+using element_type = css_document_tree::element;
+using specificity_type = css_document_tree::specificity_t;
+
+/**
+ * Rule stored for a selector and pseudo element flags, along with what is
+ * needed to resolve the cascade.
+ */
+struct rule_entry
+{
+    css_selector_t selector;
+    css::pseudo_element_t pseudo_element = 0;
+    const css_properties_t* properties = nullptr;
+    specificity_type specificity;
+
+    /** Order of the last insertion for this rule. */
+    std::size_t order = 0;
+
+    /**
+     * Order of the last insertion that set each property.  It's empty until
+     * the rule gets inserted for the second time.
+     */
+    std::unordered_map<std::string_view, std::size_t> property_orders;
+};
+
+/** Positions of the rules keyed by an id, a class name or a tag name. */
+using rule_index_type = std::unordered_map<std::string_view, std::vector<std::size_t>>;
+
+bool is_universal(std::string_view name)
+{
+    return name.empty() || name == "*";
+}
+
+const css_simple_selector_t& get_simple_selector(const css_selector_t& selector, std::size_t pos)
+{
+    return pos ? selector.chained[pos-1].simple_selector : selector.first;
+}
+
+specificity_type compute_specificity(const css_selector_t& selector, css::pseudo_element_t pseudo_elem)
+{
+    specificity_type spec;
+
+    for (std::size_t i = 0; i <= selector.chained.size(); ++i)
+    {
+        const css_simple_selector_t& ss = get_simple_selector(selector, i);
+
+        if (!ss.id.empty())
+            ++spec.ids;
+
+        spec.classes += ss.classes.size() + std::popcount(ss.pseudo_classes);
+
+        if (!is_universal(ss.name))
+            ++spec.types;
+    }
+
+    spec.types += std::popcount(pseudo_elem);
+    return spec;
+}
+
+bool matches(const css_simple_selector_t& ss, const element_type& elem)
+{
+    if (!is_universal(ss.name) && ss.name != elem.name)
+        return false;
+
+    if (!ss.id.empty() && ss.id != elem.id)
+        return false;
+
+    if (ss.pseudo_classes & ~elem.pseudo_classes)
+        return false;
+
+    for (std::string_view cls : ss.classes)
+    {
+        if (std::find(elem.classes.begin(), elem.classes.end(), cls) == elem.classes.end())
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * Match the simple selector at the specified position in the chain, along
+ * with all the simple selectors preceding it, against the last element in
+ * the path and its ancestors.
+ */
+bool matches(const css_selector_t& selector, std::size_t pos, std::span<const element_type> path)
+{
+    if (!matches(get_simple_selector(selector, pos), path.back()))
+        return false;
+
+    if (!pos)
+        return true;
+
+    std::span<const element_type> ancestors = path.first(path.size() - 1);
+
+    switch (selector.chained[pos-1].combinator)
+    {
+        case css::combinator_t::direct_child:
+            return !ancestors.empty() && matches(selector, pos - 1, ancestors);
+        case css::combinator_t::descendant:
+        {
+            for (; !ancestors.empty(); ancestors = ancestors.first(ancestors.size() - 1))
+            {
+                if (matches(selector, pos - 1, ancestors))
+                    return true;
+            }
+            return false;
+        }
+        case css::combinator_t::next_sibling:
+            // the siblings of the elements are not known.
+            return false;
+    }
+
+    return false;
+}
+
+bool matches(const css_selector_t& selector, std::span<const element_type> path)
+{
+    // each simple selector in the chain matches a different element.
+    if (path.size() <= selector.chained.size())
+        return false;
+
+    return matches(selector, selector.chained.size(), path);
+}
+
+void append_rules(std::vector<std::size_t>& dest, const rule_index_type& index, std::string_view key)
+{
+    auto it = index.find(key);
+    if (it != index.end())
+        dest.insert(dest.end(), it->second.begin(), it->second.end());
+}
+
 }
 
 css_document_tree::insertion_error::insertion_error(const std::string& msg) :
@@ -534,6 +669,106 @@ struct css_document_tree::impl
 {
     string_pool m_string_pool;
     simple_selectors_type m_root;
+
+    std::deque<rule_entry> m_rules;
+    std::unordered_map<const css_properties_t*, std::size_t> m_rule_positions;
+    rule_index_type m_id_rules;
+    rule_index_type m_class_rules;
+    rule_index_type m_type_rules;
+    std::vector<std::size_t> m_universal_rules;
+    std::size_t m_insert_count = 0;
+
+    void index_rule(
+        css_selector_t selector, css::pseudo_element_t pseudo_elem,
+        const css_properties_t& stored, const css_properties_t& props)
+    {
+        std::size_t order = m_insert_count++;
+
+        auto [it, inserted] = m_rule_positions.try_emplace(&stored, m_rules.size());
+        if (inserted)
+        {
+            rule_entry& rule = m_rules.emplace_back();
+            rule.selector = std::move(selector);
+            rule.pseudo_element = pseudo_elem;
+            rule.properties = &stored;
+            rule.specificity = compute_specificity(rule.selector, pseudo_elem);
+            rule.order = order;
+
+            // Index the rule by the most selective part of its last simple
+            // selector, which has to match the element itself.
+            const css_simple_selector_t& subject =
+                get_simple_selector(rule.selector, rule.selector.chained.size());
+            if (!subject.id.empty())
+                m_id_rules[subject.id].push_back(it->second);
+            else if (!subject.classes.empty())
+                m_class_rules[*subject.classes.begin()].push_back(it->second);
+            else if (!is_universal(subject.name))
+                m_type_rules[subject.name].push_back(it->second);
+            else
+                m_universal_rules.push_back(it->second);
+
+            return;
+        }
+
+        rule_entry& rule = m_rules[it->second];
+
+        // The properties not set by this insertion keep the order of the
+        // previous insertion.
+        if (rule.property_orders.empty())
+        {
+            for (const auto& prop : stored)
+                rule.property_orders[prop.first] = rule.order;
+        }
+
+        for (const auto& prop : props)
+            rule.property_orders[m_string_pool.intern(prop.first).first] = order;
+
+        rule.order = order;
+    }
+
+    std::vector<const rule_entry*> match(
+        std::span<const element_type> path, css::pseudo_element_t pseudo_elem) const
+    {
+        std::vector<const rule_entry*> matched;
+        if (path.empty())
+            return matched;
+
+        const element_type& elem = path.back();
+
+        std::vector<std::size_t> candidates;
+        if (!elem.id.empty())
+            append_rules(candidates, m_id_rules, elem.id);
+        for (std::string_view cls : elem.classes)
+            append_rules(candidates, m_class_rules, cls);
+        if (!elem.name.empty())
+            append_rules(candidates, m_type_rules, elem.name);
+        candidates.insert(candidates.end(), m_universal_rules.begin(), m_universal_rules.end());
+
+        if (elem.classes.size() > 1)
+        {
+            // the same class may be listed more than once.
+            std::sort(candidates.begin(), candidates.end());
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+        }
+
+        for (std::size_t pos : candidates)
+        {
+            const rule_entry& rule = m_rules[pos];
+            if (rule.pseudo_element == pseudo_elem && matches(rule.selector, path))
+                matched.push_back(&rule);
+        }
+
+        std::sort(matched.begin(), matched.end(),
+            [](const rule_entry* left, const rule_entry* right)
+            {
+                if (left->specificity != right->specificity)
+                    return left->specificity < right->specificity;
+                return left->order < right->order;
+            }
+        );
+
+        return matched;
+    }
 };
 
 css_document_tree::css_document_tree() : mp_impl(std::make_unique<impl>())
@@ -606,7 +841,11 @@ void css_document_tree::insert_properties(
 
     // We found the right node to store the properties.
     assert(node);
-    store_properties(mp_impl->m_string_pool, node->properties, pseudo_elem, props);
+    const css_properties_t* stored =
+        store_properties(mp_impl->m_string_pool, node->properties, pseudo_elem, props);
+
+    if (stored)
+        mp_impl->index_rule(std::move(selector_interned), pseudo_elem, *stored, props);
 }
 
 const css_properties_t* css_document_tree::get_properties(
@@ -629,6 +868,60 @@ css_document_tree::get_all_properties(const css_selector_t& selector) const
     return get_properties_map(mp_impl->m_root, selector);
 }
 
+std::vector<css_document_tree::matched_rule> css_document_tree::get_matching_rules(
+    std::span<const element> path, css::pseudo_element_t pseudo_elem) const
+{
+    std::vector<matched_rule> rules;
+
+    for (const rule_entry* rule : mp_impl->match(path, pseudo_elem))
+    {
+        matched_rule& mr = rules.emplace_back();
+        mr.selector = &rule->selector;
+        mr.pseudo_element = rule->pseudo_element;
+        mr.properties = rule->properties;
+        mr.specificity = rule->specificity;
+        mr.order = rule->order;
+    }
+
+    return rules;
+}
+
+css_properties_t css_document_tree::resolve_properties(
+    std::span<const element> path, css::pseudo_element_t pseudo_elem) const
+{
+    struct winner
+    {
+        const std::vector<css_property_value_t>* values;
+        specificity_t specificity;
+        std::size_t order;
+    };
+
+    std::unordered_map<std::string_view, winner> winners;
+
+    for (const rule_entry* rule : mp_impl->match(path, pseudo_elem))
+    {
+        for (const auto& [name, values] : *rule->properties)
+        {
+            auto it_order = rule->property_orders.find(name);
+            std::size_t order = it_order == rule->property_orders.end() ? rule->order : it_order->second;
+
+            auto [it, inserted] = winners.try_emplace(name, winner{&values, rule->specificity, order});
+            if (inserted)
+                continue;
+
+            winner& cur = it->second;
+            if (std::tie(rule->specificity, order) > std::tie(cur.specificity, cur.order))
+                cur = winner{&values, rule->specificity, order};
+        }
+    }
+
+    css_properties_t props;
+    for (const auto& [name, w] : winners)
+        props.insert({name, *w.values});
+
+    return props;
+}
+
 void css_document_tree::dump() const
 {
     css_selector_t selector;
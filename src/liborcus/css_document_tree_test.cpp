@@ -661,6 +661,137 @@ void test_css_parse_utf8_1()
     assert(check_props(*props, expected));
 }
 
+void test_css_rule_matching()
+{
+    constexpr std::string_view stream =
+        "p { color: black; }\n"
+        ".note { color: gray; }\n"
+        "#main p.note { color: red; }\n"
+        "div > p { margin: 0; }\n"
+        "div + p { margin: 1px; }\n"
+        "a:hover { color: blue; }\n"
+        "p::first-line { font-weight: bold; }\n"
+        "span.note.small { font-size: 8pt; }\n";
+
+    css_document_tree doc;
+    doc.load(stream);
+
+    using element = css_document_tree::element;
+
+    // <div id="main"><p class="note">
+    std::vector<element> path = {
+        { "div", "main", {}, 0 },
+        { "p", "", { "note" }, 0 },
+    };
+
+    auto rules = doc.get_matching_rules(path, 0);
+
+    // 'p', 'div > p', '.note' and '#main p.note' in ascending specificity.
+    // 'div + p' doesn't match since the siblings are not known.
+    assert(rules.size() == 4);
+    assert(rules[0].selector->first.name == "p");
+    assert(rules[0].selector->chained.empty());
+    assert(rules[1].selector->first.name == "div");
+    assert(rules[1].selector->chained.at(0).combinator == css::combinator_t::direct_child);
+    assert(rules[2].selector->first.classes.count("note"));
+    assert(rules[3].selector->first.id == "main");
+    assert((rules[3].specificity == css_document_tree::specificity_t{1, 1, 1}));
+
+    for (std::size_t i = 1; i < rules.size(); ++i)
+        assert(rules[i-1].specificity <= rules[i].specificity);
+
+    // p::first-line
+    rules = doc.get_matching_rules(path, css::pseudo_element_first_line);
+    assert(rules.size() == 1);
+    assert(check_prop(*rules[0].properties, "font-weight", "bold"));
+
+    // <p class="note"> without the div ancestor.
+    rules = doc.get_matching_rules(std::span<const element>(path).subspan(1), 0);
+    assert(rules.size() == 2);
+
+    // <body><div id="main"><section><p class="note"> - '#main p.note' still
+    // matches but 'div > p' doesn't.
+    path = {
+        { "body", "", {}, 0 },
+        { "div", "main", {}, 0 },
+        { "section", "", {}, 0 },
+        { "p", "", { "note" }, 0 },
+    };
+    rules = doc.get_matching_rules(path, 0);
+    assert(rules.size() == 3);
+    assert(rules.back().selector->first.id == "main");
+
+    // the pseudo class must be set on the element.
+    path = { { "a", "", {}, 0 } };
+    assert(doc.get_matching_rules(path, 0).empty());
+    path[0].pseudo_classes = css::pseudo_class_hover;
+    assert(doc.get_matching_rules(path, 0).size() == 1);
+
+    // all classes of the selector must be present.
+    path = { { "span", "", { "note" }, 0 } };
+    assert(doc.get_matching_rules(path, 0).size() == 1);
+    path[0].classes = { "small", "note", "small" };
+    assert(doc.get_matching_rules(path, 0).size() == 2);
+
+    assert(doc.get_matching_rules({}, 0).empty());
+}
+
+void test_css_cascade()
+{
+    constexpr std::string_view stream =
+        "p { color: black; margin: 1px; }\n"
+        ".a { color: green; padding: 2px; }\n"
+        ".b { color: blue; padding: 3px; }\n"
+        "#x { margin: 4px; }\n"
+        ".a { color: red; }\n";
+
+    css_document_tree doc;
+    doc.load(stream);
+
+    using element = css_document_tree::element;
+
+    // <p class="a b">
+    std::vector<element> path = { { "p", "", { "a", "b" }, 0 } };
+
+    css_properties_t props = doc.resolve_properties(path, 0);
+    assert(props.size() == 3);
+
+    // '.a' and '.b' have the same specificity, and the last declaration wins.
+    assert(check_prop(props, "color", "red"));
+    assert(check_prop(props, "padding", "3px"));
+    assert(check_prop(props, "margin", "1px"));
+
+    // <p id="x" class="a b">
+    path[0].id = "x";
+    props = doc.resolve_properties(path, 0);
+    assert(check_prop(props, "margin", "4px"));
+    assert(check_prop(props, "color", "red"));
+
+    // the rule inserted twice takes the order of its last insertion.
+    auto rules = doc.get_matching_rules(path, 0);
+    assert(rules.size() == 4);
+    assert(rules[1].selector->first.classes.count("b"));
+    assert(rules[2].selector->first.classes.count("a"));
+    assert(check_prop(*rules[2].properties, "padding", "2px"));
+
+    // rules inserted directly take part in the cascade too.
+    css_selector_t selector;
+    selector.first.name = "p";
+    css_properties_t new_props;
+    new_props["padding"].emplace_back("5px");
+    doc.insert_properties(selector, 0, new_props);
+
+    path[0].id = std::string_view{};
+    props = doc.resolve_properties(path, 0);
+    assert(check_prop(props, "padding", "3px"));
+
+    path[0].classes.clear();
+    props = doc.resolve_properties(path, 0);
+    assert(props.size() == 3);
+    assert(check_prop(props, "padding", "5px"));
+    assert(check_prop(props, "color", "black"));
+}
+
 int main()
 {
     test_css_invalids();
@@ -683,6 +814,8 @@ int main()
     test_css_parse_chained1();
     test_css_parse_chained2();
     test_css_parse_utf8_1();
+    test_css_rule_matching();
+    test_css_cascade();
 
     return EXIT_SUCCESS;
 }
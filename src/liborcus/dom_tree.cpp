@@ -12,7 +12,6 @@
 #include <format>
 #include <algorithm>
 #include <stdexcept>
-#include <variant>
 
 namespace orcus {
 
@@ -38,36 +37,42 @@ std::strong_ordering entity_name::operator<=> (const entity_name& other) const
 
 struct const_node::impl
 {
-    using value_type = std::variant<
-        std::monostate,
-        detail::processing_instruction*,
-        detail::element*>;
-
     node_t type;
-    value_type value;
+    detail::tree_store* store; //< non-null only for an element
+    detail::index_type pos;
+    detail::processing_instruction* pi; //< non-null only for a declaration or processing instruction
     string_pool* pool; //< non-null only for handles obtained via the mutable API
     detail::namespace_set* ns_set; //< non-null only for handles obtained via the mutable API
 
-    impl() : type(node_t::unset), pool(nullptr), ns_set(nullptr) {}
+    impl() :
+        type(node_t::unset), store(nullptr), pos(detail::null_index), pi(nullptr),
+        pool(nullptr), ns_set(nullptr) {}
 
-    impl(detail::element* _elem) :
-        type(node_t::element), value(_elem), pool(nullptr), ns_set(nullptr) {}
+    impl(detail::tree_store* _store, detail::index_type _pos) :
+        type(node_t::element), store(_store), pos(_pos), pi(nullptr),
+        pool(nullptr), ns_set(nullptr) {}
 
     impl(detail::processing_instruction* _pi, node_t _type) :
-        type(_type), value(_pi), pool(nullptr), ns_set(nullptr) {}
+        type(_type), store(nullptr), pos(detail::null_index), pi(_pi),
+        pool(nullptr), ns_set(nullptr) {}
+
+    const detail::element& get_element() const
+    {
+        return store->get_element(pos);
+    }
 
     /**
-     * Ensure this node is an element and return a reference to it as an element
-     * type.
+     * Ensure this node is an element and return its position in the tree
+     * store.
      *
      * @param op Name of function where it is needed.
      */
-    detail::element& require_element(std::string_view op)
+    detail::index_type require_element(std::string_view op) const
     {
         if (type != node_t::element)
             throw std::invalid_argument(std::format("{}: node is not an element", op));
 
-        return *std::get<detail::element*>(value);
+        return pos;
     }
 };
 
@@ -87,10 +92,7 @@ size_t const_node::child_count() const
     switch (mp_impl->type)
     {
         case node_t::element:
-        {
-            const auto* p = std::get<detail::element*>(mp_impl->value);
-            return p->child_elem_positions.size();
-        }
+            return mp_impl->get_element().child_elems.size;
         default:
             ;
     }
@@ -104,15 +106,11 @@ const_node const_node::child(size_t index) const
     {
         case node_t::element:
         {
-            auto* p = std::get<detail::element*>(mp_impl->value);
-
-            size_t elem_pos = p->child_elem_positions.at(index);
-            assert(elem_pos < p->child_nodes.size());
+            auto child_elems = mp_impl->store->get_child_elems(mp_impl->get_element());
+            if (index >= child_elems.size())
+                throw std::out_of_range("dom::const_node::child: index is out-of-range");
 
-            detail::node* child_node = p->child_nodes[elem_pos].get();
-            assert(child_node->type == detail::node_type::element);
-
-            auto v = std::make_unique<impl>(static_cast<detail::element*>(child_node));
+            auto v = std::make_unique<impl>(mp_impl->store, child_elems[index]);
             return const_node(std::move(v));
         }
         default:
@@ -126,10 +124,7 @@ entity_name const_node::name() const
     switch (mp_impl->type)
     {
         case node_t::element:
-        {
-            const auto* p = std::get<detail::element*>(mp_impl->value);
-            return p->name;
-        }
+            return mp_impl->get_element().name;
         default:
             ;
     }
@@ -143,14 +138,11 @@ std::string_view const_node::attribute(const entity_name& name) const
     {
         case node_t::element:
         {
-            const auto* p = std::get<detail::element*>(mp_impl->value);
-            auto it = p->attr_map.find(name);
-            if (it == p->attr_map.end())
+            const detail::attr* p = mp_impl->store->find_attr(mp_impl->pos, name);
+            if (!p)
                 break;
 
-            size_t pos = it->second;
-            assert(pos < p->attrs.size());
-            return p->attrs[pos].value;
+            return p->value;
         }
         default:
             ;
@@ -166,7 +158,7 @@ std::string_view const_node::attribute(std::string_view name) const
         case node_t::declaration:
         case node_t::processing_instruction:
         {
-            const auto* p = std::get<detail::processing_instruction*>(mp_impl->value);
+            const auto* p = mp_impl->pi;
             auto it = p->attr_map.find(name);
             if (it == p->attr_map.end())
                 return std::string_view();
@@ -188,15 +180,9 @@ size_t const_node::attribute_count() const
     {
         case node_t::declaration:
         case node_t::processing_instruction:
-        {
-            const auto* p = std::get<detail::processing_instruction*>(mp_impl->value);
-            return p->attrs.size();
-        }
+            return mp_impl->pi->attrs.size();
         case node_t::element:
-        {
-            const auto* p = std::get<detail::element*>(mp_impl->value);
-            return p->attrs.size();
-        }
+            return mp_impl->get_element().attrs.size;
         default:
             ;
     }
@@ -208,11 +194,11 @@ const_node const_node::parent() const
     if (mp_impl->type != node_t::element)
         return const_node();
 
-    auto* p = std::get<detail::element*>(mp_impl->value)->parent;
-    if (!p)
+    detail::index_type pos = mp_impl->store->get_node(mp_impl->pos).parent;
+    if (pos == detail::null_index)
         return const_node();
 
-    auto v = std::make_unique<impl>(p);
+    auto v = std::make_unique<impl>(mp_impl->store, pos);
     return const_node(std::move(v));
 }
 
@@ -230,7 +216,8 @@ const_node& const_node::operator= (const const_node& other)
 
 bool const_node::operator== (const const_node& other) const
 {
-    return mp_impl->type == other.mp_impl->type && mp_impl->value == other.mp_impl->value;
+    return mp_impl->type == other.mp_impl->type && mp_impl->store == other.mp_impl->store &&
+        mp_impl->pos == other.mp_impl->pos && mp_impl->pi == other.mp_impl->pi;
 }
 
 bool const_node::operator!= (const const_node& other) const
@@ -254,19 +241,18 @@ node& node::operator= (const node& other) = default;
 
 namespace {
 
-void set_attr_on(detail::attrs_type& attrs, detail::attr_map_type& attr_map,
-    entity_name name, std::string_view value)
+void set_pi_attr(detail::processing_instruction& pi, entity_name name, std::string_view value)
 {
-    auto it = attr_map.find(name);
-    if (it == attr_map.end())
+    auto it = pi.attr_map.find(name);
+    if (it == pi.attr_map.end())
     {
-        std::size_t pos = attrs.size();
-        attrs.emplace_back(name.ns, name.name, value);
-        attr_map.emplace(entity_name(name.ns, name.name), pos);
+        std::size_t pos = pi.attrs.size();
+        pi.attrs.emplace_back(name.ns, name.name, value);
+        pi.attr_map.emplace(entity_name(name.ns, name.name), pos);
     }
     else
     {
-        attrs[it->second].value = value;
+        pi.attrs[it->second].value = value;
     }
 }
 
@@ -274,50 +260,39 @@ void set_attr_on(detail::attrs_type& attrs, detail::attr_map_type& attr_map,
 
 node node::append_element(entity_name name)
 {
-    auto& parent_elem = mp_impl->require_element("dom::node::append_element");
+    auto pos = mp_impl->require_element("dom::node::append_element");
 
     string_pool* pool = mp_impl->pool;
     name.name = pool->intern(name.name).first;
 
-    std::size_t pos = parent_elem.child_nodes.size();
-    parent_elem.child_elem_positions.push_back(pos);
-    parent_elem.child_nodes.push_back(
-        std::make_unique<detail::element>(name.ns, name.name));
-
-    auto* child = static_cast<detail::element*>(parent_elem.child_nodes.back().get());
-    child->parent = &parent_elem;
-
-    auto v = std::make_unique<const_node::impl>(child);
+    auto child = mp_impl->store->append_element(pos, name);
+    auto v = std::make_unique<const_node::impl>(mp_impl->store, child);
     return node(std::move(v), pool, mp_impl->ns_set);
 }
 
 void node::append_content(std::string_view value)
 {
-    auto& parent_elem = mp_impl->require_element("dom::node::append_content");
+    auto pos = mp_impl->require_element("dom::node::append_content");
 
     value = mp_impl->pool->intern(value).first;
-    auto child = std::make_unique<detail::content>(value);
-    child->parent = &parent_elem;
-    parent_elem.child_nodes.push_back(std::move(child));
+    mp_impl->store->append_value(pos, detail::node_type::content, value);
 }
 
 void node::append_comment(std::string_view value)
 {
-    auto& parent_elem = mp_impl->require_element("dom::node::append_comment");
+    auto pos = mp_impl->require_element("dom::node::append_comment");
 
     value = mp_impl->pool->intern(value).first;
-    auto child = std::make_unique<detail::comment>(value);
-    child->parent = &parent_elem;
-    parent_elem.child_nodes.push_back(std::move(child));
+    mp_impl->store->append_value(pos, detail::node_type::comment, value);
 }
 
 void node::set_attribute(entity_name name, std::string_view value)
 {
-    auto& elem = mp_impl->require_element("dom::node::set_attribute");
+    auto pos = mp_impl->require_element("dom::node::set_attribute");
 
     name.name = mp_impl->pool->intern(name.name).first;
     value = mp_impl->pool->intern(value).first;
-    set_attr_on(elem.attrs, elem.attr_map, name, value);
+    mp_impl->store->set_attr(pos, name, value);
 }
 
 void node::set_attribute(std::string_view name, std::string_view value)
@@ -329,19 +304,14 @@ void node::set_attribute(std::string_view name, std::string_view value)
     {
         case node_t::element:
         {
-            auto& elem = *std::get<detail::element*>(mp_impl->value);
-            set_attr_on(elem.attrs, elem.attr_map,
-                entity_name(XMLNS_UNKNOWN_ID, name), value);
-
+            mp_impl->store->set_attr(mp_impl->pos, entity_name(XMLNS_UNKNOWN_ID, name), value);
             break;
         }
         case node_t::declaration:
         case node_t::processing_instruction:
         {
-            auto& pi = *std::get<detail::processing_instruction*>(mp_impl->value);
-            set_attr_on(pi.attrs, pi.attr_map,
-                entity_name(XMLNS_UNKNOWN_ID, name), value);
-
+            auto& pi = *mp_impl->pi;
+            set_pi_attr(pi, entity_name(XMLNS_UNKNOWN_ID, name), value);
             break;
         }
         default:
@@ -352,16 +322,16 @@ void node::set_attribute(std::string_view name, std::string_view value)
 
 void node::set_name(entity_name name)
 {
-    auto& elem = mp_impl->require_element("dom::node::set_name");
+    auto pos = mp_impl->require_element("dom::node::set_name");
     name.name = mp_impl->pool->intern(name.name).first;
-    elem.name = name;
+    mp_impl->store->get_element(pos).name = name;
 }
 
 void node::declare_namespace(std::string_view alias, xmlns_id_t ns)
 {
-    auto& elem = mp_impl->require_element("dom::node::declare_namespace");
+    auto pos = mp_impl->require_element("dom::node::declare_namespace");
     alias = mp_impl->pool->intern(alias).first;
-    elem.ns_decls.emplace_back(alias, ns);
+    mp_impl->store->append_ns_decl(pos, detail::ns_declaration(alias, ns));
     mp_impl->ns_set->add(ns);
 }
 
@@ -385,10 +355,10 @@ void document_tree::load(std::string_view strm)
     mp_impl->m_pis.clear();
     mp_impl->m_doc_attrs.clear();
     mp_impl->m_cur_attrs.clear();
-    mp_impl->m_cur_attr_map.clear();
     mp_impl->m_cur_ns_decls.clear();
     mp_impl->m_elem_stack.clear();
-    mp_impl->m_root.reset();
+    mp_impl->m_child_elems.clear();
+    mp_impl->m_store.clear();
     mp_impl->m_prolog_comments.clear();
     mp_impl->m_epilog_comments.clear();
     mp_impl->m_namespaces.clear();
@@ -401,22 +371,28 @@ void document_tree::load(std::string_view strm)
 
     for (xmlns_id_t ns : ns_cxt.get_all_namespaces())
         mp_impl->m_namespaces.add(ns);
+
+    mp_impl->m_store.shrink_to_fit();
 }
 
 dom::const_node document_tree::root() const
 {
-    detail::element* p = mp_impl->m_root.get();
-    auto v = std::make_unique<const_node::impl>(p);
+    if (mp_impl->m_store.empty())
+        return dom::const_node();
+
+    auto v = std::make_unique<const_node::impl>(&mp_impl->m_store, 0);
     return dom::const_node(std::move(v));
 }
 
 dom::node document_tree::set_root(entity_name name)
 {
     name.name = mp_impl->m_pool.intern(name.name).first;
-    mp_impl->m_root = std::make_unique<detail::element>(name.ns, name.name);
     mp_impl->m_elem_stack.clear();
+    mp_impl->m_child_elems.clear();
+    mp_impl->m_store.clear();
+    auto pos = mp_impl->m_store.append_element(detail::null_index, name);
 
-    auto v = std::make_unique<const_node::impl>(mp_impl->m_root.get());
+    auto v = std::make_unique<const_node::impl>(&mp_impl->m_store, pos);
     return dom::node(std::move(v), &mp_impl->m_pool, &mp_impl->m_namespaces);
 }
 
@@ -465,13 +441,13 @@ dom::node document_tree::add_processing_instruction(std::string_view target)
 void document_tree::append_prolog_comment(std::string_view value)
 {
     value = mp_impl->m_pool.intern(value).first;
-    mp_impl->m_prolog_comments.emplace_back(value);
+    mp_impl->m_prolog_comments.push_back(value);
 }
 
 void document_tree::append_epilog_comment(std::string_view value)
 {
     value = mp_impl->m_pool.intern(value).first;
-    mp_impl->m_epilog_comments.emplace_back(value);
+    mp_impl->m_epilog_comments.push_back(value);
 }
 
 dom::const_node document_tree::declaration(std::string_view name) const
@@ -504,31 +480,32 @@ class compact_dumper : public tree_walker
     std::ostream& m_os;
     const xmlns_repository& m_repo;
 
-    void print_path(const detail::element& elem)
+    void print_path(detail::index_type pos)
     {
-        std::vector<const detail::element*> path;
-        for (const detail::element* p = &elem; p; p = p->parent)
-            path.push_back(p);
+        std::vector<detail::index_type> path;
+        for (; pos != detail::null_index; pos = m_store.get_node(pos).parent)
+            path.push_back(pos);
 
         for (auto it = path.rbegin(); it != path.rend(); ++it)
         {
             m_os << "/";
-            detail::print(m_os, (*it)->name, m_repo);
+            detail::print(m_os, m_store.get_element(*it).name, m_repo);
         }
     }
 
 public:
-    compact_dumper(const detail::element& root, std::ostream& os, const xmlns_repository& repo) :
-        tree_walker(root), m_os(os), m_repo(repo) {}
+    compact_dumper(const detail::tree_store& store, std::ostream& os, const xmlns_repository& repo) :
+        tree_walker(store, 0), m_os(os), m_repo(repo) {}
 
 protected:
-    void on_element_enter(const detail::element& elem, std::size_t /*depth*/) override
+    void on_element_enter(detail::index_type pos, std::size_t /*depth*/) override
     {
-        print_path(elem);
+        print_path(pos);
         m_os << "\n";
 
         // dump attributes sorted by name
-        detail::attrs_type attrs = elem.attrs;
+        auto elem_attrs = m_store.get_attrs(m_store.get_element(pos));
+        detail::attrs_type attrs(elem_attrs.begin(), elem_attrs.end());
         std::sort(attrs.begin(), attrs.end(),
             [](const detail::attr& left, const detail::attr& right) {
                 return left.name.name < right.name.name;
@@ -537,19 +514,18 @@ protected:
         for (const detail::attr& a : attrs)
         {
             // print path, element then the attribute
-            print_path(elem);
+            print_path(pos);
             m_os << "@";
             detail::print(m_os, a, m_repo);
             m_os << "\n";
         }
     }
 
-    void on_content(const detail::content& c, std::size_t /*depth*/) override
+    void on_content(detail::index_type pos, std::size_t /*depth*/) override
     {
         // print the value of this content node
-        assert(c.parent);
-        print_path(*c.parent);
-        detail::print(m_os, c, m_repo);
+        print_path(m_store.get_node(pos).parent);
+        detail::print_content(m_os, m_store.get_value(pos));
         m_os << "\n";
     }
 };
@@ -558,7 +534,7 @@ protected:
 
 void document_tree::dump_compact(std::ostream& os) const
 {
-    if (!mp_impl->m_root)
+    if (mp_impl->m_store.empty())
         return;
 
     for (xmlns_id_t ns : mp_impl->m_namespaces.all)
@@ -570,7 +546,7 @@ void document_tree::dump_compact(std::ostream& os) const
         os << "ns" << index << "=\"" << ns << '"' << std::endl;
     }
 
-    compact_dumper walker(*mp_impl->m_root, os, mp_impl->m_repo);
+    compact_dumper walker(mp_impl->m_store, os, mp_impl->m_repo);
     walker.run();
 }
 
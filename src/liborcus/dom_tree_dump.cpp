@@ -8,7 +8,6 @@
 #include "dom_tree_impl.hpp"
 #include <orcus/xml_encode.hpp>
 
-#include <functional>
 #include <ranges>
 #include <sstream>
 #include <unordered_map>
@@ -19,15 +18,22 @@ namespace {
 
 class xml_dumper : public tree_walker
 {
-    // true when elem has at least one element child
-    static bool has_element_children(const detail::element& elem)
+    std::ostream& m_os;
+    std::size_t m_indent;
+    std::vector<detail::index_type> m_alias_elems;
+
+    // true when the element at pos has at least one element child
+    bool has_element_children(detail::index_type pos) const
     {
-        return !elem.child_elem_positions.empty();
+        return m_store.get_element(pos).child_elems.size > 0;
     }
 
-    std::ostream& m_os;
-    std::size_t m_indent;
-    std::vector<std::reference_wrapper<const detail::element>> m_alias_elems;
+    // true when the parent of the node at pos is in block layout
+    bool in_block(detail::index_type pos) const
+    {
+        detail::index_type parent = m_store.get_node(pos).parent;
+        return parent != detail::null_index && has_element_children(parent);
+    }
 
     void write_indent(std::ostream& os, std::size_t depth)
     {
@@ -51,11 +57,12 @@ class xml_dumper : public tree_walker
     {
         // recursively search for the matching namespace from the inner element
         // and up
-        for (const detail::element& elem : m_alias_elems | std::views::reverse)
+        for (detail::index_type pos : m_alias_elems | std::views::reverse)
         {
-            assert(!elem.ns_decls.empty());
+            auto ns_decls = m_store.get_ns_decls(m_store.get_element(pos));
+            assert(!ns_decls.empty());
 
-            for (const auto& [alias, ns] : elem.ns_decls)
+            for (const auto& [alias, ns] : ns_decls)
             {
                 if (name.ns == ns)
                     return alias;
@@ -71,40 +78,42 @@ class xml_dumper : public tree_walker
         throw general_error(os.str());
     }
 
-    void push_aliases(const detail::element& elem)
+    void push_aliases(detail::index_type pos)
     {
-        if (!elem.ns_decls.empty())
-            m_alias_elems.push_back(elem);
+        if (m_store.get_element(pos).ns_decls.size)
+            m_alias_elems.push_back(pos);
     }
 
-    void pop_aliases(const detail::element& elem)
+    void pop_aliases(detail::index_type pos)
     {
         if (!m_alias_elems.empty())
         {
-            if (&m_alias_elems.back().get() == &elem)
+            if (m_alias_elems.back() == pos)
                 m_alias_elems.pop_back();
         }
     }
 
 public:
-    xml_dumper(const detail::element& root, std::ostream& os, std::size_t indent) :
-        tree_walker(root), m_os(os), m_indent(indent) {}
+    xml_dumper(const detail::tree_store& store, std::ostream& os, std::size_t indent) :
+        tree_walker(store, 0), m_os(os), m_indent(indent) {}
 
 protected:
-    void on_element_enter(const detail::element& elem, std::size_t depth) override
+    void on_element_enter(detail::index_type pos, std::size_t depth) override
     {
+        const detail::element& elem = m_store.get_element(pos);
+
         // register this element's namespace aliases before printing its name
-        push_aliases(elem);
+        push_aliases(pos);
 
         // indent only if parent element has at least one child element
-        if (m_indent && elem.parent && has_element_children(*elem.parent))
+        if (m_indent && in_block(pos))
             write_indent(m_os, depth);
 
         m_os << '<';
         write_name(elem.name);
 
         // emit namespace declarations recorded on this element
-        for (const auto& [alias, ns_id] : elem.ns_decls)
+        for (const auto& [alias, ns_id] : m_store.get_ns_decls(elem))
         {
             if (alias.empty())
                 m_os << " xmlns=\"";
@@ -114,7 +123,7 @@ protected:
             m_os << '"';
         }
 
-        for (const detail::attr& a : elem.attrs)
+        for (const detail::attr& a : m_store.get_attrs(elem))
         {
             m_os << ' ';
             write_name(a.name);
@@ -123,14 +132,14 @@ protected:
             m_os << '"';
         }
 
-        if (elem.child_nodes.empty())
+        if (elem.first_child == detail::null_index)
         {
             // self-close leaf elements
             m_os << "/>";
-            if (m_indent && elem.parent && has_element_children(*elem.parent))
+            if (m_indent && in_block(pos))
                 m_os << '\n';
         }
-        else if (has_element_children(elem))
+        else if (has_element_children(pos))
         {
             // block layout: each child element on its own line
             m_os << '>';
@@ -144,16 +153,18 @@ protected:
         }
     }
 
-    void on_element_exit(const detail::element& elem, std::size_t depth) override
+    void on_element_exit(detail::index_type pos, std::size_t depth) override
     {
-        if (elem.child_nodes.empty())
+        const detail::element& elem = m_store.get_element(pos);
+
+        if (elem.first_child == detail::null_index)
         {
             // already closed with />; just clean up aliases
-            pop_aliases(elem);
+            pop_aliases(pos);
             return;
         }
 
-        if (m_indent && has_element_children(elem))
+        if (m_indent && has_element_children(pos))
         {
             // close tag on its own indented line
             write_indent(m_os, depth);
@@ -167,39 +178,39 @@ protected:
             m_os << "</";
             write_name(elem.name);
             m_os << '>';
-            if (m_indent && elem.parent && has_element_children(*elem.parent))
+            if (m_indent && in_block(pos))
                 m_os << '\n';
         }
 
         // pop this element's aliases after writing the closing tag
-        pop_aliases(elem);
+        pop_aliases(pos);
     }
 
-    void on_content(const detail::content& c, std::size_t depth) override
+    void on_content(detail::index_type pos, std::size_t depth) override
     {
         // indent content that sits alongside element siblings
-        if (m_indent && c.parent && has_element_children(*c.parent))
+        if (m_indent && in_block(pos))
         {
             write_indent(m_os, depth);
-            write_content_encoded(m_os, c.value, xml_encode_context_t::text);
+            write_content_encoded(m_os, m_store.get_value(pos), xml_encode_context_t::text);
             m_os << '\n';
         }
         else
-            write_content_encoded(m_os, c.value, xml_encode_context_t::text);
+            write_content_encoded(m_os, m_store.get_value(pos), xml_encode_context_t::text);
     }
 
-    void on_comment(const detail::comment& c, std::size_t depth) override
+    void on_comment(detail::index_type pos, std::size_t depth) override
     {
         // follow the same indent logic as in on_content()
-        if (m_indent && c.parent && has_element_children(*c.parent))
+        if (m_indent && in_block(pos))
         {
             write_indent(m_os, depth);
-            m_os << "<!--" << c.value << "-->";
+            m_os << "<!--" << m_store.get_value(pos) << "-->";
             m_os << '\n';
         }
         else
         {
-            m_os << "<!--" << c.value << "-->";
+            m_os << "<!--" << m_store.get_value(pos) << "-->";
         }
     }
 
@@ -213,7 +224,7 @@ protected:
 
 std::string document_tree::dump(std::size_t indent) const
 {
-    if (!mp_impl->m_root)
+    if (mp_impl->m_store.empty())
         return {};
 
     std::ostringstream os;
@@ -239,15 +250,15 @@ std::string document_tree::dump(std::size_t indent) const
         write_pi(target, pi);
 
     // emit prolog comments between the declarations and the root element
-    for (const detail::comment& cm : mp_impl->m_prolog_comments)
+    for (std::string_view cm : mp_impl->m_prolog_comments)
     {
-        os << "<!--" << cm.value << "-->";
+        os << "<!--" << cm << "-->";
 
         if (indent)
             os << '\n';
     }
 
-    xml_dumper walker(*mp_impl->m_root, os, indent);
+    xml_dumper walker(mp_impl->m_store, os, indent);
     walker.run();
 
     if (indent && !mp_impl->m_epilog_comments.empty())
@@ -260,9 +271,9 @@ std::string document_tree::dump(std::size_t indent) const
     }
 
     // emit epilog comments after the root element
-    for (const detail::comment& cm : mp_impl->m_epilog_comments)
+    for (std::string_view cm : mp_impl->m_epilog_comments)
     {
-        os << "<!--" << cm.value << "-->";
+        os << "<!--" << cm << "-->";
 
         if (indent)
             os << '\n';
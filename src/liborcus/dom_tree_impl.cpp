@@ -7,9 +7,10 @@
 
 #include "dom_tree_impl.hpp"
 
+#include <orcus/exception.hpp>
+
 #include <algorithm>
 #include <cassert>
-#include <deque>
 
 namespace orcus { namespace dom { namespace detail {
 
@@ -100,24 +101,245 @@ void escape(std::ostream& os, std::string_view val)
     }
 }
 
-node::~node() = default;
+void print_content(std::ostream& os, std::string_view value)
+{
+    os << '"';
+    escape(os, value);
+    os << '"';
+}
+
+namespace {
+
+index_type to_index(std::size_t n)
+{
+    if (n >= null_index)
+        throw general_error("dom::document_tree: the document has too many entries to store.");
 
-element::element(xmlns_id_t _ns, std::string_view _name) :
-    node(node_type::element), name(_ns, _name) {}
+    return static_cast<index_type>(n);
+}
 
-element::~element() = default;
+/**
+ * Append a value to a range in a flat array, after moving the range to the
+ * end of the array if it's not there yet.
+ */
+template<typename T>
+void append_to_range(std::vector<T>& store, index_range& range, const T& v)
+{
+    if (range.size && std::size_t(range.first) + range.size != store.size())
+    {
+        std::size_t first = store.size();
+        store.reserve(first + range.size + 1);
+        for (index_type i = 0; i < range.size; ++i)
+            store.push_back(store[range.first + i]);
 
-content::content(std::string_view _value) : node(node_type::content), value(_value) {}
-content::~content() = default;
+        range.first = to_index(first);
+    }
+    else if (!range.size)
+        range.first = to_index(store.size());
 
-comment::comment(std::string_view _value) : node(node_type::comment), value(_value) {}
-comment::~comment() = default;
+    store.push_back(v);
+    range.size = to_index(std::size_t(range.size) + 1);
+}
 
-void print(std::ostream& os, const content& c, const xmlns_repository& /*repo*/)
+template<typename T>
+index_range append_range(std::vector<T>& store, std::span<const T> values)
 {
-    os << '"';
-    escape(os, c.value);
-    os << '"';
+    index_range range;
+    if (values.empty())
+        return range;
+
+    range.first = to_index(store.size());
+    range.size = to_index(values.size());
+    store.insert(store.end(), values.begin(), values.end());
+    return range;
+}
+
+template<typename T>
+std::span<const T> get_range(const std::vector<T>& store, const index_range& range)
+{
+    return std::span<const T>(store.data() + range.first, range.size);
+}
+
+} // anonymous namespace
+
+node::node(node_type _type, index_type _parent, index_type _data) :
+    type(_type), parent(_parent), data(_data) {}
+
+element::element(const entity_name& _name) : name(_name) {}
+
+tree_store::tree_store() = default;
+tree_store::~tree_store() = default;
+
+bool tree_store::empty() const
+{
+    return m_nodes.empty();
+}
+
+void tree_store::clear()
+{
+    m_nodes.clear();
+    m_elements.clear();
+    m_values.clear();
+    m_attrs.clear();
+    m_child_elems.clear();
+    m_ns_decls.clear();
+
+    std::lock_guard lock(m_attr_map_mtx);
+    m_attr_maps.clear();
+}
+
+void tree_store::shrink_to_fit()
+{
+    m_nodes.shrink_to_fit();
+    m_elements.shrink_to_fit();
+    m_values.shrink_to_fit();
+    m_attrs.shrink_to_fit();
+    m_child_elems.shrink_to_fit();
+    m_ns_decls.shrink_to_fit();
+}
+
+const node& tree_store::get_node(index_type pos) const
+{
+    assert(pos < m_nodes.size());
+    return m_nodes[pos];
+}
+
+const element& tree_store::get_element(index_type pos) const
+{
+    const node& nd = get_node(pos);
+    assert(nd.type == node_type::element);
+    return m_elements[nd.data];
+}
+
+element& tree_store::get_element(index_type pos)
+{
+    return const_cast<element&>(std::as_const(*this).get_element(pos));
+}
+
+std::string_view tree_store::get_value(index_type pos) const
+{
+    const node& nd = get_node(pos);
+    assert(nd.type != node_type::element);
+    return m_values[nd.data];
+}
+
+std::span<const attr> tree_store::get_attrs(const element& elem) const
+{
+    return get_range(m_attrs, elem.attrs);
+}
+
+std::span<const index_type> tree_store::get_child_elems(const element& elem) const
+{
+    return get_range(m_child_elems, elem.child_elems);
+}
+
+std::span<const ns_declaration> tree_store::get_ns_decls(const element& elem) const
+{
+    return get_range(m_ns_decls, elem.ns_decls);
+}
+
+const attr* tree_store::find_attr(index_type pos, const entity_name& name) const
+{
+    auto attrs = get_attrs(get_element(pos));
+
+    if (attrs.size() <= attr_map_threshold)
+    {
+        auto it = std::find_if(attrs.begin(), attrs.end(),
+            [&name](const attr& a) { return a.name == name; });
+
+        return it == attrs.end() ? nullptr : &*it;
+    }
+
+    std::lock_guard lock(m_attr_map_mtx);
+
+    auto& attr_map = m_attr_maps[pos];
+    if (!attr_map)
+    {
+        attr_map = std::make_unique<attr_map_type>();
+        for (std::size_t i = 0; i < attrs.size(); ++i)
+            attr_map->emplace(attrs[i].name, i);
+    }
+
+    auto it = attr_map->find(name);
+    return it == attr_map->end() ? nullptr : &attrs[it->second];
+}
+
+index_type tree_store::append_node(node_type type, index_type parent, index_type data)
+{
+    index_type pos = to_index(m_nodes.size());
+    m_nodes.emplace_back(type, parent, data);
+
+    if (parent != null_index)
+    {
+        element& elem = get_element(parent);
+        if (elem.last_child == null_index)
+            elem.first_child = pos;
+        else
+            m_nodes[elem.last_child].next_sibling = pos;
+
+        elem.last_child = pos;
+    }
+
+    return pos;
+}
+
+index_type tree_store::push_element(index_type parent, const entity_name& name)
+{
+    assert(parent != null_index || m_nodes.empty());
+
+    index_type data = to_index(m_elements.size());
+    m_elements.emplace_back(name);
+    return append_node(node_type::element, parent, data);
+}
+
+index_type tree_store::append_element(index_type parent, const entity_name& name)
+{
+    index_type pos = push_element(parent, name);
+    if (parent != null_index)
+        append_to_range(m_child_elems, get_element(parent).child_elems, pos);
+
+    return pos;
+}
+
+void tree_store::append_value(index_type parent, node_type type, std::string_view value)
+{
+    index_type data = to_index(m_values.size());
+    m_values.push_back(value);
+    append_node(type, parent, data);
+}
+
+void tree_store::set_attrs(index_type pos, const attrs_type& attrs)
+{
+    get_element(pos).attrs = append_range(m_attrs, std::span<const attr>(attrs));
+}
+
+void tree_store::set_child_elems(index_type pos, std::span<const index_type> elems)
+{
+    get_element(pos).child_elems = append_range(m_child_elems, elems);
+}
+
+void tree_store::set_ns_decls(index_type pos, const std::vector<ns_declaration>& decls)
+{
+    get_element(pos).ns_decls = append_range(m_ns_decls, std::span<const ns_declaration>(decls));
+}
+
+void tree_store::set_attr(index_type pos, const entity_name& name, std::string_view value)
+{
+    if (const attr* p = find_attr(pos, name); p)
+    {
+        m_attrs[p - m_attrs.data()].value = value;
+        return;
+    }
+
+    append_to_range(m_attrs, get_element(pos).attrs, attr(name.ns, name.name, value));
+
+    std::lock_guard lock(m_attr_map_mtx);
+    m_attr_maps.erase(pos);
+}
+
+void tree_store::append_ns_decl(index_type pos, const ns_declaration& decl)
+{
+    append_to_range(m_ns_decls, get_element(pos).ns_decls, decl);
 }
 
 }}} // namespace orcus::dom::detail
@@ -130,75 +352,74 @@ void document_tree::impl::namespace_declaration(std::string_view alias, xmlns_id
     m_cur_ns_decls.emplace_back(alias_safe, ns_id);
 }
 
-void document_tree::impl::end_declaration()
+namespace {
+
+detail::processing_instruction to_processing_instruction(detail::attrs_type& attrs)
 {
-    assert(m_cur_pi_target == "xml");
+    detail::processing_instruction pi;
+    pi.attrs.swap(attrs);
+
+    for (std::size_t i = 0; i < pi.attrs.size(); ++i)
+        pi.attr_map.insert({pi.attrs[i].name, i});
+
+    return pi;
+}
 
-    detail::processing_instruction decl;
-    decl.attrs.swap(m_cur_attrs);
-    decl.attr_map.swap(m_cur_attr_map);
+} // anonymous namespace
 
-    m_xml_decl = std::move(decl);
+void document_tree::impl::end_declaration()
+{
+    assert(m_cur_pi_target == "xml");
+    m_xml_decl = to_processing_instruction(m_cur_attrs);
 }
 
 void document_tree::impl::end_processing_instruction(std::string_view target)
 {
     assert(m_cur_pi_target == target);
-
-    detail::processing_instruction pi;
-    pi.attrs.swap(m_cur_attrs);
-    pi.attr_map.swap(m_cur_attr_map);
-
-    m_pis.insert_or_assign(m_pool.intern(target).first, std::move(pi));
+    m_pis.insert_or_assign(m_pool.intern(target).first, to_processing_instruction(m_cur_attrs));
 }
 
 void document_tree::impl::start_element(const sax_ns_parser_element& elem)
 {
-    xmlns_id_t ns = elem.ns;
-    std::string_view name = elem.name;
-
     // These strings must be persistent.
-    std::string_view name_safe = m_pool.intern(name).first;
+    entity_name name(elem.ns, m_pool.intern(elem.name).first);
+
+    detail::index_type parent = detail::null_index;
+    if (!m_elem_stack.empty())
+        parent = m_elem_stack.back().pos;
+    else if (!m_store.empty())
+        throw general_error("document has more than one root element.");
 
-    detail::element* p = nullptr;
-    if (!m_root)
+    detail::index_type pos = m_store.push_element(parent, name);
+    if (!m_cur_attrs.empty())
     {
-        // This must be the root element!
-        m_root = std::make_unique<detail::element>(ns, name_safe);
-        m_elem_stack.push_back(m_root.get());
-        p = m_elem_stack.back();
-        p->attrs.swap(m_cur_attrs);
-        p->attr_map.swap(m_cur_attr_map);
-        p->ns_decls.swap(m_cur_ns_decls);
-        return;
+        m_store.set_attrs(pos, m_cur_attrs);
+        m_cur_attrs.clear();
     }
 
-    // Append new element as a child element of the current element.
-    p = m_elem_stack.back();
-
-    size_t elem_pos = p->child_nodes.size();
-    p->child_elem_positions.push_back(elem_pos);
+    if (!m_cur_ns_decls.empty())
+    {
+        m_store.set_ns_decls(pos, m_cur_ns_decls);
+        m_cur_ns_decls.clear();
+    }
 
-    p->child_nodes.push_back(std::make_unique<detail::element>(ns, name_safe));
-    detail::element* parent = p;
-    p = static_cast<detail::element*>(p->child_nodes.back().get());
-    p->parent = parent;
-    p->attrs.swap(m_cur_attrs);
-    p->attr_map.swap(m_cur_attr_map);
-    p->ns_decls.swap(m_cur_ns_decls);
+    if (parent != detail::null_index)
+        m_child_elems.push_back(pos);
 
-    m_elem_stack.push_back(p);
+    m_elem_stack.push_back({pos, m_child_elems.size()});
 }
 
 void document_tree::impl::end_element(const sax_ns_parser_element& elem)
 {
-    xmlns_id_t ns = elem.ns;
-    std::string_view name = elem.name;
-
-    const detail::element* p = m_elem_stack.back();
-    if (p->name.ns != ns || p->name.name != name)
+    const open_element& cur = m_elem_stack.back();
+    const entity_name& name = m_store.get_element(cur.pos).name;
+    if (name.ns != elem.ns || name.name != elem.name)
         throw general_error("non-matching end element.");
 
+    std::span<const detail::index_type> child_elems(m_child_elems);
+    m_store.set_child_elems(cur.pos, child_elems.subspan(cur.child_elems_start));
+    m_child_elems.resize(cur.child_elems_start);
+
     m_elem_stack.pop_back();
 }
 
@@ -212,11 +433,8 @@ void document_tree::impl::characters(std::string_view val, bool /*transient*/)
     if (val2.empty())
         return;
 
-    detail::element* p = m_elem_stack.back();
     val2 = m_pool.intern(val2).first; // Make sure the string is persistent.
-    auto child = std::make_unique<detail::content>(val2);
-    child->parent = p;
-    p->child_nodes.push_back(std::move(child));
+    m_store.append_value(m_elem_stack.back().pos, detail::node_type::content, val2);
 }
 
 void document_tree::impl::comment(std::string_view val)
@@ -227,18 +445,15 @@ void document_tree::impl::comment(std::string_view val)
     {
         // outside any element: prolog if root not yet seen, epilog otherwise
 
-        if (m_root)
-            m_epilog_comments.emplace_back(val);
+        if (!m_store.empty())
+            m_epilog_comments.push_back(val);
         else
-            m_prolog_comments.emplace_back(val);
+            m_prolog_comments.push_back(val);
 
         return;
     }
 
-    detail::element* p = m_elem_stack.back();
-    auto child = std::make_unique<detail::comment>(val);
-    child->parent = p;
-    p->child_nodes.push_back(std::move(child));
+    m_store.append_value(m_elem_stack.back().pos, detail::node_type::comment, val);
 }
 
 void document_tree::impl::doctype(const sax::doctype_declaration& dtd)
@@ -260,74 +475,60 @@ void document_tree::impl::set_attribute(xmlns_id_t ns, std::string_view name, st
     std::string_view name2 = m_pool.intern(name).first;
     std::string_view val2 = m_pool.intern(val).first;
 
-    size_t pos = m_cur_attrs.size();
-    m_cur_attrs.push_back(detail::attr(ns, name2, val2));
-    m_cur_attr_map.insert({entity_name(ns, name2), pos});
+    m_cur_attrs.emplace_back(ns, name2, val2);
 }
 
-tree_walker::scope::scope(const detail::element* _owner, std::size_t _depth) :
-    current_pos(nodes.begin()), owner(_owner), depth(_depth) {}
-
-tree_walker::tree_walker(const detail::element& root) : m_root(root) {}
+tree_walker::tree_walker(const detail::tree_store& store, detail::index_type root) :
+    m_root(root), m_store(store) {}
 
 void tree_walker::run()
 {
-    std::deque<scope> scopes;
-    scopes.emplace_back(nullptr, 0u);
-    scopes.back().nodes.push_back(&m_root);
-    scopes.back().current_pos = scopes.back().nodes.begin();
+    std::vector<scope> scopes;
+    scopes.push_back({detail::null_index, m_root, 0u});
 
     while (!scopes.empty())
     {
         scope& cur_scope = scopes.back();
 
-        if (cur_scope.current_pos == cur_scope.nodes.end())
+        if (cur_scope.next == detail::null_index)
         {
             // current scope has no more nodes to process - end the scope
-            if (cur_scope.owner)
-                on_element_exit(*cur_scope.owner, cur_scope.depth - 1);
+            if (cur_scope.owner != detail::null_index)
+                on_element_exit(cur_scope.owner, cur_scope.depth - 1);
             scopes.pop_back();
             continue;
         }
 
         // process the current node in the current scope
-        const detail::node* this_node = *cur_scope.current_pos;
-        ++cur_scope.current_pos;
-        assert(this_node);
+        detail::index_type pos = cur_scope.next;
+        const detail::node& this_node = m_store.get_node(pos);
+        cur_scope.next = this_node.next_sibling;
+        std::size_t depth = cur_scope.depth;
 
-        if (this_node->type == detail::node_type::content)
+        if (this_node.type == detail::node_type::content)
         {
-            const auto* cnt = static_cast<const detail::content*>(this_node);
-            on_content(*cnt, cur_scope.depth);
+            on_content(pos, depth);
             continue;
         }
 
-        if (this_node->type == detail::node_type::comment)
+        if (this_node.type == detail::node_type::comment)
         {
-            const auto* cm = static_cast<const detail::comment*>(this_node);
-            on_comment(*cm, cur_scope.depth);
+            on_comment(pos, depth);
             continue;
         }
 
-        const auto* elem = static_cast<const detail::element*>(this_node);
-        on_element_enter(*elem, cur_scope.depth);
+        on_element_enter(pos, depth);
 
-        if (elem->child_nodes.empty())
+        const detail::element& elem = m_store.get_element(pos);
+        if (elem.first_child == detail::null_index)
         {
             // this element is a leaf element
-            on_element_exit(*elem, cur_scope.depth);
+            on_element_exit(pos, depth);
             continue;
         }
 
-        // push a new scope with the child elements of this element
-        nodes_type child_nodes;
-        for (const auto& p : elem->child_nodes)
-            child_nodes.push_back(p.get());
-
-        scopes.emplace_back(elem, cur_scope.depth + 1);
-        scope& child_scope = scopes.back();
-        child_scope.nodes.swap(child_nodes);
-        child_scope.current_pos = child_scope.nodes.begin();
+        // push a new scope with the child nodes of this element
+        scopes.push_back({pos, elem.first_child, depth + 1});
     }
 
     on_document_exit();
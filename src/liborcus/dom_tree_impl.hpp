@@ -12,12 +12,16 @@
 #include <orcus/string_pool.hpp>
 #include <orcus/sax_ns_parser.hpp>
 
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <ostream>
+#include <span>
+#include <unordered_map>
 #include <utility>
 #include <vector>
-#include <unordered_map>
-#include <memory>
-#include <optional>
 
 namespace orcus { namespace dom {
 
@@ -70,54 +74,168 @@ struct namespace_set
     void clear();
 };
 
-enum class node_type { element, content, comment };
+enum class node_type : std::uint8_t { element, content, comment };
+
+using index_type = std::uint32_t;
+
+constexpr index_type null_index = std::numeric_limits<index_type>::max();
 
-struct element;
+/**
+ * Range of consecutive entries in one of the flat arrays of a tree_store.
+ */
+struct index_range
+{
+    index_type first = 0;
+    index_type size = 0;
+};
 
+/**
+ * Record of a single node in a tree_store.  All child nodes of an element
+ * are linked in document order via their next_sibling positions.
+ */
 struct node
 {
-    element* parent;
     node_type type;
+    index_type parent = null_index;
+    index_type next_sibling = null_index;
 
-    node(node_type _type) : parent(nullptr), type(_type) {}
-    virtual ~node() = 0;
-};
+    /**
+     * Position of the element record of an element, or of the value of a
+     * content or comment node.
+     */
+    index_type data = null_index;
 
-using nodes_type = std::vector<std::unique_ptr<node>>;
+    node(node_type _type, index_type _parent, index_type _data);
+};
 
-struct element : public node
+struct element
 {
     entity_name name;
-    attrs_type attrs;
-    attr_map_type attr_map;
-    nodes_type child_nodes;
-    std::vector<size_t> child_elem_positions;
-    std::vector<ns_declaration> ns_decls; //< namespaces declared on this element
+    index_type first_child = null_index;
+    index_type last_child = null_index;
 
-    element() = delete;
-    element(xmlns_id_t _ns, std::string_view _name);
-    virtual ~element();
+    index_range attrs;
+    index_range child_elems; //< positions of the child elements
+    index_range ns_decls; //< namespaces declared on this element
+
+    element(const entity_name& _name);
 };
 
-struct content : public node
+/**
+ * Storage of the element tree of a document.  The nodes, the element
+ * records, the attributes, the child element positions and the namespace
+ * declarations are each stored in one flat array, and all references
+ * between them are positions into these arrays.  The root element, if
+ * any, is always at position 0.
+ *
+ * The attributes and the child element positions of an element occupy a
+ * consecutive range in their array.  When one of them grows via the
+ * mutable API while it's not at the end of its array, it gets moved to the
+ * end, and the old range is left unused until the tree is cleared.
+ */
+class tree_store
 {
-    std::string_view value;
+    using attr_maps_type = std::unordered_map<index_type, std::unique_ptr<attr_map_type>>;
 
-    content(std::string_view _value);
-    virtual ~content();
-};
+    std::vector<node> m_nodes;
+    std::vector<element> m_elements;
+    std::vector<std::string_view> m_values;
+    attrs_type m_attrs;
+    std::vector<index_type> m_child_elems;
+    std::vector<ns_declaration> m_ns_decls;
 
-struct comment : public node
-{
-    std::string_view value;
+    /**
+     * Attribute maps of the elements that have more than
+     * attr_map_threshold attributes, built on their first lookup by name.
+     */
+    mutable std::mutex m_attr_map_mtx;
+    mutable attr_maps_type m_attr_maps;
+
+    index_type append_node(node_type type, index_type parent, index_type data);
+
+public:
+    /**
+     * Maximum number of attributes an element can have for its attributes
+     * to be looked up by name without an attribute map.
+     */
+    static constexpr std::size_t attr_map_threshold = 8;
+
+    tree_store();
+    tree_store(const tree_store&) = delete;
+    tree_store& operator=(const tree_store&) = delete;
+    ~tree_store();
+
+    bool empty() const;
 
-    comment(std::string_view _value);
-    virtual ~comment();
+    void clear();
+
+    /**
+     * Release the excess capacity of all the arrays once the tree is fully
+     * built.
+     */
+    void shrink_to_fit();
+
+    const node& get_node(index_type pos) const;
+
+    const element& get_element(index_type pos) const;
+    element& get_element(index_type pos);
+
+    /**
+     * Get the value of a content or comment node.
+     */
+    std::string_view get_value(index_type pos) const;
+
+    std::span<const attr> get_attrs(const element& elem) const;
+    std::span<const index_type> get_child_elems(const element& elem) const;
+    std::span<const ns_declaration> get_ns_decls(const element& elem) const;
+
+    /**
+     * Find an attribute of an element by its name.
+     *
+     * @return pointer to the first attribute of the given name, or nullptr
+     *         if the element doesn't have it.
+     */
+    const attr* find_attr(index_type pos, const entity_name& name) const;
+
+    /**
+     * Append a new element as the last child node of an element, without
+     * registering it as a child element of its parent.  The parent's child
+     * elements need to be set via set_child_elems() afterward.
+     *
+     * @param parent position of the parent element, or null_index to create
+     *               the root element of an empty tree.
+     *
+     * @return position of the new element.
+     */
+    index_type push_element(index_type parent, const entity_name& name);
+
+    /**
+     * Append a new element as the last child node and the last child element
+     * of an element.
+     */
+    index_type append_element(index_type parent, const entity_name& name);
+
+    /**
+     * Append a content or comment node as the last child node of an element.
+     */
+    void append_value(index_type parent, node_type type, std::string_view value);
+
+    void set_attrs(index_type pos, const attrs_type& attrs);
+    void set_child_elems(index_type pos, std::span<const index_type> elems);
+    void set_ns_decls(index_type pos, const std::vector<ns_declaration>& decls);
+
+    /**
+     * Add a new attribute to an element, or update the value of an existing
+     * attribute of the same name.
+     */
+    void set_attr(index_type pos, const entity_name& name, std::string_view value);
+
+    void append_ns_decl(index_type pos, const ns_declaration& decl);
 };
 
 void print(std::ostream& os, const entity_name& name, const xmlns_repository& repo);
 void print(std::ostream& os, const attr& at, const xmlns_repository& repo);
-void print(std::ostream& os, const content& c, const xmlns_repository& repo);
+void print_content(std::ostream& os, std::string_view value);
 
 /**
  * Escape certain characters with backslash (\).
@@ -128,10 +246,19 @@ void escape(std::ostream& os, std::string_view val);
 
 struct document_tree::impl : public sax_ns_handler
 {
-    using element_stack_type = std::vector<detail::element*>;
     using processing_instructions_type =
         std::unordered_map<std::string_view, detail::processing_instruction>;
 
+    /**
+     * Element being parsed, whose child elements get collected in
+     * m_child_elems while it's open.
+     */
+    struct open_element
+    {
+        detail::index_type pos;
+        std::size_t child_elems_start;
+    };
+
     xmlns_repository& m_repo;
     detail::namespace_set m_namespaces;
     string_pool m_pool;
@@ -143,12 +270,12 @@ struct document_tree::impl : public sax_ns_handler
     processing_instructions_type m_pis;
     detail::attrs_type m_doc_attrs;
     detail::attrs_type m_cur_attrs;
-    detail::attr_map_type m_cur_attr_map;
     std::vector<detail::ns_declaration> m_cur_ns_decls;
-    element_stack_type m_elem_stack;
-    std::unique_ptr<detail::element> m_root;
-    std::vector<detail::comment> m_prolog_comments;
-    std::vector<detail::comment> m_epilog_comments;
+    std::vector<open_element> m_elem_stack;
+    std::vector<detail::index_type> m_child_elems;
+    detail::tree_store m_store;
+    std::vector<std::string_view> m_prolog_comments;
+    std::vector<std::string_view> m_epilog_comments;
 
     impl(xmlns_repository& repo) : m_repo(repo) {}
 
@@ -186,33 +313,28 @@ struct document_tree::impl : public sax_ns_handler
 
 class tree_walker
 {
-    using nodes_type = std::vector<const detail::node*>;
-
     struct scope
     {
-        nodes_type nodes;
-        nodes_type::const_iterator current_pos;
-        const detail::element* owner;
+        detail::index_type owner;
+        detail::index_type next;
         std::size_t depth;
-
-        scope(const scope&) = delete;
-        scope& operator=(const scope&) = delete;
-
-        scope(const detail::element* owner, std::size_t depth);
     };
 
-    const detail::element& m_root;
+    detail::index_type m_root;
+
+protected:
+    const detail::tree_store& m_store;
 
 public:
-    tree_walker(const detail::element& root);
+    tree_walker(const detail::tree_store& store, detail::index_type root);
     virtual ~tree_walker() = default;
     void run();
 
 protected:
-    virtual void on_element_enter(const detail::element&, std::size_t) {}
-    virtual void on_element_exit(const detail::element&, std::size_t) {}
-    virtual void on_content(const detail::content&, std::size_t) {}
-    virtual void on_comment(const detail::comment&, std::size_t) {}
+    virtual void on_element_enter(detail::index_type, std::size_t) {}
+    virtual void on_element_exit(detail::index_type, std::size_t) {}
+    virtual void on_content(detail::index_type, std::size_t) {}
+    virtual void on_comment(detail::index_type, std::size_t) {}
     virtual void on_document_exit() {}
 };
 
@@ -4,6 +4,7 @@
 #include <orcus/xml_namespace.hpp>
 #include <cassert>
 #include <iostream>
+#include <string>
 
 using namespace orcus::dom;
 
@@ -358,6 +359,62 @@ void test_mutable_reset_then_load()
     assert(tree.root().child_count() == 1);
 }
 
+void test_mutable_interleaved_appends()
+{
+    orcus::xmlns_repository repo;
+    document_tree tree(repo);
+
+    // an empty tree has no root element
+    assert(tree.root().type() == node_t::unset);
+
+    auto root = tree.set_root({"root"});
+    auto a = root.append_element({"a"});
+    auto b = root.append_element({"b"});
+
+    // grow the children and the attributes of both elements alternately
+    for (int i = 0; i < 20; ++i)
+    {
+        std::string name = "attr" + std::to_string(i);
+        a.append_element({"x"}).set_attribute("n", std::to_string(i));
+        a.set_attribute(name, "a");
+        b.append_element({"y"});
+        b.set_attribute(name, "b");
+    }
+
+    // update an existing attribute once the attribute map has been built
+    assert(a.attribute("attr15") == "a");
+    a.set_attribute("attr15", "updated");
+    a.set_attribute("attr-last", "last");
+
+    assert(root.child_count() == 2);
+    assert(a.child_count() == 20);
+    assert(b.child_count() == 20);
+    assert(a.attribute_count() == 21);
+    assert(b.attribute_count() == 20);
+    assert(a.attribute("attr0") == "a");
+    assert(a.attribute("attr15") == "updated");
+    assert(a.attribute("attr-last") == "last");
+    assert(b.attribute("attr19") == "b");
+    assert(b.attribute("attr-last").empty());
+
+    for (std::size_t i = 0; i < a.child_count(); ++i)
+    {
+        const_node x = a.child(i);
+        assert(x.name() == entity_name("x"));
+        assert(x.attribute("n") == std::to_string(i));
+        assert(x.parent() == a);
+    }
+
+    // the tree must survive a round-trip
+    auto rt = load_document_tree(tree.dump(0));
+    const_node rt_a = rt->tree.root().child(0);
+    assert(rt_a.child_count() == 20);
+    assert(rt_a.attribute_count() == 21);
+    assert(rt_a.attribute("attr15") == "updated");
+    assert(rt_a.child(19).attribute("n") == "19");
+    assert(rt->tree.root().child(1).child_count() == 20);
+}
+
 int main()
 {
     test_encoded_attr();
@@ -371,6 +428,7 @@ int main()
     test_mutable_namespaces();
     test_mutable_non_element_throws();
     test_mutable_reset_then_load();
+    test_mutable_interleaved_appends();
 
     return EXIT_SUCCESS;
 }
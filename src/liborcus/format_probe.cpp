@@ -0,0 +1,715 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <orcus/format_detection.hpp>
+#include <orcus/zip_archive.hpp>
+#include <orcus/zip_archive_stream.hpp>
+#include <orcus/sax_parser.hpp>
+
+#include "filter_env.hpp"
+#include "ooxml_content_types.hpp"
+#include "a1_reference.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace ss = orcus::spreadsheet;
+
+namespace orcus {
+
+namespace {
+
+/**
+ * Maximum number of bytes to inflate from the head of each sheet part, which
+ * is normally enough to reach the dimension element since it precedes the
+ * cell data.
+ */
+constexpr std::size_t sheet_head_size = 1024;
+
+/**
+ * Maximum number of bytes to inflate from the head of content.xml of an ods
+ * package.  The sheet content follows the font declarations and automatic
+ * styles in this part, so the head needs to be larger than that of an xlsx
+ * sheet part.
+ */
+constexpr std::size_t content_head_size = 64 * 1024;
+
+/**
+ * Thrown by a probe handler to end the parsing of a partial stream once the
+ * handler has seen what it needs.
+ */
+class probe_complete {};
+
+/**
+ * Parse an xml stream read from a package part.
+ *
+ * @param buf content of the part, or of its head only.
+ * @param handler handler to receive the parsed content.  It may end the
+ *                parsing early by throwing probe_complete.
+ * @param truncated whether the buffer holds only the head of the part.  A
+ *                  parse error is expected in that case when the handler
+ *                  doesn't end the parsing before the end of the buffer,
+ *                  and is not an error in itself.  Otherwise the parse error
+ *                  gets rethrown.
+ */
+template<typename HandlerT>
+void parse_partial(const unnamed_buffer& buf, HandlerT& handler, bool truncated = false)
+{
+    // Exclude the terminating null character.
+    std::string_view strm{buf.data(), buf.size() ? buf.size() - 1 : 0};
+
+    try
+    {
+        sax_parser<HandlerT> parser(strm, handler);
+        parser.parse();
+    }
+    catch (const probe_complete&)
+    {
+    }
+    catch (const parse_error&)
+    {
+        if (!truncated)
+            throw;
+    }
+}
+
+/**
+ * Collect the attributes of the current element.  Attributes get reported
+ * before the element itself by the sax parser, so the collected values are
+ * available in start_element().
+ */
+class attr_collector : public sax_handler
+{
+protected:
+    std::unordered_map<std::string, std::string> m_attrs;
+
+    std::string_view get_attr(std::string_view name) const
+    {
+        auto it = m_attrs.find(std::string{name});
+        return it == m_attrs.end() ? std::string_view{} : std::string_view{it->second};
+    }
+
+public:
+    void attribute(const sax::parser_attribute& attr)
+    {
+        std::string name{attr.ns};
+        if (!name.empty())
+            name.push_back(':');
+        name.append(attr.name);
+        m_attrs.insert_or_assign(std::move(name), std::string{attr.value});
+    }
+
+    void start_element(const sax::parser_element&)
+    {
+        m_attrs.clear();
+    }
+
+    void end_element(const sax::parser_element&)
+    {
+        m_attrs.clear();
+    }
+};
+
+/**
+ * Resolve a relationship target against the directory of its source part,
+ * and return it as a zip entry name.
+ */
+std::string resolve_part_path(std::string_view base_dir, std::string_view target)
+{
+    std::vector<std::string_view> segments;
+
+    auto push_segments = [&segments](std::string_view path)
+    {
+        while (!path.empty())
+        {
+            auto pos = path.find('/');
+            std::string_view seg = path.substr(0, pos);
+            path = pos == std::string_view::npos ? std::string_view{} : path.substr(pos + 1);
+
+            if (seg.empty() || seg == ".")
+                continue;
+
+            if (seg == "..")
+            {
+                if (!segments.empty())
+                    segments.pop_back();
+                continue;
+            }
+
+            segments.push_back(seg);
+        }
+    };
+
+    if (target.empty() || target[0] != '/')
+        push_segments(base_dir);
+
+    push_segments(target);
+
+    std::string path;
+    for (std::string_view seg : segments)
+    {
+        if (!path.empty())
+            path.push_back('/');
+        path.append(seg);
+    }
+
+    return path;
+}
+
+/**
+ * Check whether a buffer returned from a partial read of a package part holds
+ * the entire part.
+ */
+bool is_part_complete(const document_info& info, std::string_view part_name, const unnamed_buffer& buf)
+{
+    auto it = std::find_if(info.parts.begin(), info.parts.end(),
+        [part_name](const auto& part) { return part.name == part_name; });
+
+    if (it == info.parts.end())
+        return false;
+
+    std::size_t n = buf.size() ? buf.size() - 1 : 0; // exclude the terminating null
+    return n == it->size;
+}
+
+void probe_zip_parts(const zip_archive& archive, document_info& info)
+{
+    for (std::size_t i = 0, n = archive.get_file_entry_count(); i < n; ++i)
+    {
+        std::string_view name = archive.get_file_entry_name(i);
+        if (name.empty() || name.back() == '/')
+            continue; // directory entry
+
+        document_info::part_type part;
+        part.name = name;
+        part.size = archive.get_file_entry_size(i);
+        part.compressed_size = archive.get_file_entry_compressed_size(i);
+        info.parts.push_back(std::move(part));
+    }
+}
+
+#if XLSX_ENABLED
+
+class xlsx_content_types_handler : public attr_collector
+{
+    std::string m_workbook;
+    std::string m_shared_strings;
+    bool m_calc_chain = false;
+
+public:
+    void start_element(const sax::parser_element& elem)
+    {
+        if (elem.name == "Override")
+        {
+            std::string_view part = get_attr("PartName");
+            std::string_view ct = get_attr("ContentType");
+
+            if (!part.empty() && part[0] == '/')
+                part = part.substr(1);
+
+            if (ct == CT_ooxml_xlsx_sheet_main)
+                m_workbook = part;
+            else if (ct == CT_ooxml_xlsx_shared_strings)
+                m_shared_strings = part;
+            else if (ct == CT_ooxml_xlsx_calc_chain)
+                m_calc_chain = true;
+        }
+
+        attr_collector::start_element(elem);
+    }
+
+    const std::string& get_workbook() const { return m_workbook; }
+    const std::string& get_shared_strings() const { return m_shared_strings; }
+    bool has_calc_chain() const { return m_calc_chain; }
+};
+
+class xlsx_workbook_handler : public attr_collector
+{
+    std::vector<std::pair<std::string, std::string>> m_sheets; // name, rid
+
+public:
+    void start_element(const sax::parser_element& elem)
+    {
+        if (elem.name == "sheet")
+            m_sheets.emplace_back(get_attr("name"), get_attr("r:id"));
+        else if (elem.name == "definedNames" || elem.name == "calcPr")
+            // Sheet list is complete at this point.
+            throw probe_complete();
+
+        attr_collector::start_element(elem);
+    }
+
+    const std::vector<std::pair<std::string, std::string>>& get_sheets() const { return m_sheets; }
+};
+
+class opc_rels_handler : public attr_collector
+{
+    std::unordered_map<std::string, std::string> m_targets;
+
+public:
+    void start_element(const sax::parser_element& elem)
+    {
+        if (elem.name == "Relationship")
+            m_targets.insert_or_assign(std::string{get_attr("Id")}, std::string{get_attr("Target")});
+
+        attr_collector::start_element(elem);
+    }
+
+    std::string_view get_target(const std::string& rid) const
+    {
+        auto it = m_targets.find(rid);
+        return it == m_targets.end() ? std::string_view{} : std::string_view{it->second};
+    }
+};
+
+class xlsx_sheet_head_handler : public attr_collector
+{
+    std::optional<ss::range_t> m_dimension;
+    bool m_formula = false;
+
+public:
+    void start_element(const sax::parser_element& elem)
+    {
+        if (elem.name == "dimension")
+            m_dimension = parse_a1_range(get_attr("ref"));
+        else if (elem.name == "f")
+        {
+            // One formula cell is enough.
+            m_formula = true;
+            throw probe_complete();
+        }
+
+        attr_collector::start_element(elem);
+    }
+
+    const std::optional<ss::range_t>& get_dimension() const { return m_dimension; }
+
+    bool has_formula() const { return m_formula; }
+};
+
+class xlsx_sst_head_handler : public attr_collector
+{
+    std::optional<std::size_t> m_count;
+
+public:
+    void start_element(const sax::parser_element& elem)
+    {
+        if (elem.name == "sst")
+        {
+            std::string_view v = get_attr("uniqueCount");
+            if (v.empty())
+                v = get_attr("count");
+
+            if (!v.empty())
+            {
+                char* p_end = nullptr;
+                std::string s{v};
+                auto n = std::strtoull(s.data(), &p_end, 10);
+                if (p_end == s.data() + s.size())
+                    m_count = n;
+            }
+
+            throw probe_complete();
+        }
+
+        attr_collector::start_element(elem);
+    }
+
+    const std::optional<std::size_t>& get_count() const { return m_count; }
+};
+
+void probe_xlsx(std::string_view strm, document_info& info)
+{
+    zip_archive_stream_blob stream(strm);
+    zip_archive archive(&stream);
+    archive.load();
+
+    probe_zip_parts(archive, info);
+
+    xlsx_content_types_handler ct_hdl;
+    parse_partial(archive.read_file_entry("[Content_Types].xml"), ct_hdl);
+
+    const std::string& wb_part = ct_hdl.get_workbook();
+    if (wb_part.empty())
+        return;
+
+    // Excel drops the calc chain part when the workbook contains no formula
+    // cells, but other producers may not write one at all, so its absence
+    // alone is inconclusive.  In that case, look for formula cells in the
+    // head of each sheet part.  The answer is only negative when each sheet
+    // part has been read in full.
+    bool formula_found = ct_hdl.has_calc_chain();
+    bool all_sheets_read = true;
+
+    std::string_view wb_dir{wb_part};
+    std::string_view wb_name{wb_part};
+    if (auto pos = wb_dir.rfind('/'); pos != std::string_view::npos)
+    {
+        wb_dir = wb_dir.substr(0, pos);
+        wb_name = wb_name.substr(pos + 1);
+    }
+    else
+        wb_dir = std::string_view{};
+
+    if (const std::string& sst_part = ct_hdl.get_shared_strings(); !sst_part.empty())
+    {
+        xlsx_sst_head_handler hdl;
+        auto buf = archive.read_file_entry(sst_part, sheet_head_size);
+        parse_partial(buf, hdl, !is_part_complete(info, sst_part, buf));
+        info.shared_string_count = hdl.get_count();
+    }
+
+    xlsx_workbook_handler wb_hdl;
+    parse_partial(archive.read_file_entry(wb_part), wb_hdl);
+
+    opc_rels_handler rels_hdl;
+    std::string rels_part = resolve_part_path(wb_dir, "_rels");
+    rels_part.push_back('/');
+    rels_part.append(wb_name);
+    rels_part.append(".rels");
+
+    try
+    {
+        parse_partial(archive.read_file_entry(rels_part), rels_hdl);
+    }
+    catch (const zip_error&)
+    {
+        // missing relationship part - leave the sheet parts unresolved.
+    }
+
+    for (const auto& [name, rid] : wb_hdl.get_sheets())
+    {
+        document_info::sheet_type sheet;
+        sheet.name = name;
+
+        if (std::string_view target = rels_hdl.get_target(rid); !target.empty())
+        {
+            sheet.part = resolve_part_path(wb_dir, target);
+
+            try
+            {
+                xlsx_sheet_head_handler hdl;
+                auto buf = archive.read_file_entry(sheet.part, sheet_head_size);
+                bool complete = is_part_complete(info, sheet.part, buf);
+                parse_partial(buf, hdl, !complete);
+                sheet.dimension = hdl.get_dimension();
+
+                if (hdl.has_formula())
+                    formula_found = true;
+                else if (!complete)
+                    all_sheets_read = false;
+            }
+            catch (const zip_error&)
+            {
+                // dangling relationship - leave the dimension unknown.
+                all_sheets_read = false;
+            }
+        }
+        else
+            all_sheets_read = false;
+
+        info.sheets.push_back(std::move(sheet));
+    }
+
+    if (formula_found)
+        info.has_formulas = true;
+    else if (all_sheets_read)
+        info.has_formulas = false;
+}
+
+#endif
+
+#if ODS_ENABLED
+
+/**
+ * Picks up the sheet names from the view settings stored in settings.xml,
+ * which is much smaller than content.xml and has an entry for each sheet.
+ */
+class ods_settings_handler : public attr_collector
+{
+    std::vector<std::string> m_names;
+    std::size_t m_depth = 0;
+    std::size_t m_tables_depth = 0; // depth of the "Tables" map element, or 0
+
+public:
+    void start_element(const sax::parser_element& elem)
+    {
+        ++m_depth;
+
+        if (elem.name == "config-item-map-named" && get_attr("config:name") == "Tables")
+            m_tables_depth = m_depth;
+        else if (m_tables_depth && m_depth == m_tables_depth + 1 && elem.name == "config-item-map-entry")
+            m_names.emplace_back(get_attr("config:name"));
+
+        attr_collector::start_element(elem);
+    }
+
+    void end_element(const sax::parser_element& elem)
+    {
+        if (m_depth == m_tables_depth)
+            // End of the first set of sheet entries.
+            throw probe_complete();
+
+        --m_depth;
+        attr_collector::end_element(elem);
+    }
+
+    const std::vector<std::string>& get_names() const { return m_names; }
+};
+
+/**
+ * Measures the extent of each table found in the head of content.xml, from
+ * the cells that have a value or a formula.  A table gets its extent only
+ * when its end is within the head.
+ */
+class ods_content_head_handler : public attr_collector
+{
+public:
+    struct table_type
+    {
+        std::string name;
+        std::optional<ss::range_t> extent;
+        bool complete = false;
+    };
+
+private:
+    std::vector<table_type> m_tables;
+    ss::row_t m_row = 0;
+    ss::row_t m_row_span = 1;
+    ss::col_t m_col = 0;
+    bool m_formula = false;
+
+    static std::size_t get_span(std::string_view v)
+    {
+        if (v.empty())
+            return 1;
+
+        char* p_end = nullptr;
+        std::string s{v};
+        auto n = std::strtoul(s.data(), &p_end, 10);
+        return (p_end == s.data() + s.size() && n > 0) ? n : 1;
+    }
+
+    void extend(ss::col_t col_span)
+    {
+        ss::range_t range;
+        range.first.row = m_row;
+        range.first.column = m_col;
+        range.last.row = m_row + m_row_span - 1;
+        range.last.column = m_col + col_span - 1;
+
+        auto& extent = m_tables.back().extent;
+        if (!extent)
+        {
+            extent = range;
+            return;
+        }
+
+        extent->first.row = std::min(extent->first.row, range.first.row);
+        extent->first.column = std::min(extent->first.column, range.first.column);
+        extent->last.row = std::max(extent->last.row, range.last.row);
+        extent->last.column = std::max(extent->last.column, range.last.column);
+    }
+
+public:
+    void start_element(const sax::parser_element& elem)
+    {
+        if (elem.name == "table")
+        {
+            m_tables.emplace_back();
+            m_tables.back().name = get_attr("table:name");
+            m_row = 0;
+        }
+        else if (m_tables.empty())
+        {
+            // not inside a table
+        }
+        else if (elem.name == "table-row")
+        {
+            m_row_span = get_span(get_attr("table:number-rows-repeated"));
+            m_col = 0;
+        }
+        else if (elem.name == "table-cell" || elem.name == "covered-table-cell")
+        {
+            ss::col_t col_span = get_span(get_attr("table:number-columns-repeated"));
+            bool formula = !get_attr("table:formula").empty();
+
+            if (formula || !get_attr("office:value-type").empty())
+                extend(col_span);
+
+            m_formula = m_formula || formula;
+            m_col += col_span;
+        }
+
+        attr_collector::start_element(elem);
+    }
+
+    void end_element(const sax::parser_element& elem)
+    {
+        if (elem.name == "table-row")
+            m_row += m_row_span;
+        else if (elem.name == "table" && !m_tables.empty())
+            m_tables.back().complete = true;
+
+        attr_collector::end_element(elem);
+    }
+
+    const std::vector<table_type>& get_tables() const { return m_tables; }
+
+    bool has_formula() const { return m_formula; }
+};
+
+void probe_ods(std::string_view strm, document_info& info)
+{
+    zip_archive_stream_blob stream(strm);
+    zip_archive archive(&stream);
+    archive.load();
+
+    probe_zip_parts(archive, info);
+
+    try
+    {
+        ods_settings_handler hdl;
+        parse_partial(archive.read_file_entry("settings.xml"), hdl);
+
+        for (const std::string& name : hdl.get_names())
+        {
+            document_info::sheet_type sheet;
+            sheet.name = name;
+            sheet.part = "content.xml";
+            info.sheets.push_back(std::move(sheet));
+        }
+    }
+    catch (const zip_error&)
+    {
+        // settings.xml is optional.
+    }
+
+    ods_content_head_handler content_hdl;
+    auto buf = archive.read_file_entry("content.xml", content_head_size);
+    bool complete = is_part_complete(info, "content.xml", buf);
+    parse_partial(buf, content_hdl, !complete);
+
+    const auto& tables = content_hdl.get_tables();
+
+    if (info.sheets.empty())
+    {
+        // Take the sheet names from the tables instead.  This may miss the
+        // sheets that start past the head.
+        for (const auto& table : tables)
+        {
+            document_info::sheet_type sheet;
+            sheet.name = table.name;
+            sheet.part = "content.xml";
+            info.sheets.push_back(std::move(sheet));
+        }
+    }
+
+    for (auto& sheet : info.sheets)
+    {
+        auto it = std::find_if(tables.begin(), tables.end(),
+            [&sheet](const auto& table) { return table.name == sheet.name; });
+
+        if (it != tables.end() && it->complete)
+            sheet.dimension = it->extent;
+    }
+
+    if (content_hdl.has_formula())
+        info.has_formulas = true;
+    else if (complete)
+        info.has_formulas = false;
+}
+
+#endif
+
+} // anonymous namespace
+
+document_info probe(std::string_view strm)
+{
+    document_info info;
+    info.format = detect(strm);
+
+    try
+    {
+        switch (info.format)
+        {
+#if XLSX_ENABLED
+            case format_t::xlsx:
+                probe_xlsx(strm, info);
+                break;
+#endif
+#if ODS_ENABLED
+            case format_t::ods:
+                probe_ods(strm, info);
+                break;
+#endif
+            default:
+                break;
+        }
+    }
+    catch (const zip_error&)
+    {
+        // Return whatever has been collected so far.
+    }
+
+    return info;
+}
+
+std::ostream& operator<<(std::ostream& os, const document_info& info)
+{
+    os << "format: " << info.format << "\n";
+
+    if (!info.sheets.empty())
+    {
+        os << "sheets:\n";
+
+        for (const auto& sheet : info.sheets)
+        {
+            os << "  - name: " << sheet.name << "\n";
+
+            if (!sheet.part.empty())
+                os << "    part: " << sheet.part << "\n";
+
+            if (sheet.dimension)
+            {
+                os << "    dimension: ";
+                write_a1_address(os, sheet.dimension->first);
+                if (sheet.dimension->first != sheet.dimension->last)
+                {
+                    os << ':';
+                    write_a1_address(os, sheet.dimension->last);
+                }
+                os << "\n";
+            }
+        }
+    }
+
+    if (info.shared_string_count)
+        os << "shared strings: " << *info.shared_string_count << "\n";
+
+    if (info.has_formulas)
+        os << "formulas: " << (*info.has_formulas ? "true" : "false") << "\n";
+
+    if (!info.parts.empty())
+    {
+        os << "parts:\n";
+
+        for (const auto& part : info.parts)
+        {
+            os << "  - name: " << part.name << "\n";
+            os << "    size: " << part.size << "\n";
+            os << "    compressed size: " << part.compressed_size << "\n";
+        }
+    }
+
+    return os;
+}
+
+} // namespace orcus
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
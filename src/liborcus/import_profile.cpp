@@ -0,0 +1,242 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <orcus/import_profile.hpp>
+#include <orcus/json_global.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+namespace orcus {
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+std::string to_ms(import_profile_t::duration_type v)
+{
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(3)
+        << std::chrono::duration<double, std::milli>(v).count() << " ms";
+    return os.str();
+}
+
+std::int64_t to_us(import_profile_t::duration_type v)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(v).count();
+}
+
+/**
+ * Print a counter value along with its rate over the total import time.
+ */
+void print_rate(std::ostream& os, std::string_view name, std::size_t n, import_profile_t::duration_type total)
+{
+    os << name << ": " << n;
+
+    double secs = std::chrono::duration<double>(total).count();
+    if (secs > 0.0)
+        os << " (" << std::size_t(n / secs) << "/s)";
+
+    os << std::endl;
+}
+
+} // anonymous namespace
+
+void import_profile_t::write_chrome_trace(std::ostream& os) const
+{
+    // The stages are recorded on the thread that drives the import, whereas
+    // the parts may get inflated ahead of time on a helper thread, so they
+    // are put on separate tracks.
+    constexpr int pid = 1;
+    constexpr int stage_tid = 1;
+    constexpr int part_tid = 2;
+
+    os << "{\"traceEvents\":[";
+
+    bool first = true;
+    auto sep = [&os, &first]
+    {
+        if (!first)
+            os << ',';
+        first = false;
+        os << "\n";
+    };
+
+    for (const auto& stage : stages)
+    {
+        sep();
+        os << "{\"name\":\"" << json::escape_string(stage.name) << "\",\"cat\":\"stage\",\"ph\":\"X\""
+            << ",\"ts\":" << to_us(stage.start) << ",\"dur\":" << to_us(stage.duration)
+            << ",\"pid\":" << pid << ",\"tid\":" << stage_tid << "}";
+    }
+
+    for (const auto& part : parts)
+    {
+        sep();
+        os << "{\"name\":\"" << json::escape_string(part.name) << "\",\"cat\":\"inflate\",\"ph\":\"X\""
+            << ",\"ts\":" << to_us(part.start) << ",\"dur\":" << to_us(part.duration)
+            << ",\"pid\":" << pid << ",\"tid\":" << part_tid
+            << ",\"args\":{\"compressed\":" << part.compressed_size
+            << ",\"inflated\":" << part.inflated_size << "}}";
+    }
+
+    sep();
+    os << "{\"name\":\"counters\",\"ph\":\"C\",\"ts\":" << to_us(total) << ",\"pid\":" << pid
+        << ",\"args\":{\"xml-elements\":" << xml_elements
+        << ",\"xml-attributes\":" << xml_attributes
+        << ",\"cells\":" << cells
+        << ",\"formulas\":" << formulas
+        << ",\"strings\":" << strings << "}}";
+
+    os << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+}
+
+std::ostream& operator<<(std::ostream& os, const import_profile_t& v)
+{
+    os << "total: " << to_ms(v.total) << std::endl;
+
+    if (!v.stages.empty())
+    {
+        os << "stages:" << std::endl;
+
+        for (const auto& stage : v.stages)
+        {
+            os << "  - name: " << stage.name << std::endl;
+            os << "    start: " << to_ms(stage.start) << std::endl;
+            os << "    duration: " << to_ms(stage.duration) << std::endl;
+        }
+    }
+
+    if (!v.parts.empty())
+    {
+        os << "parts:" << std::endl;
+
+        for (const auto& part : v.parts)
+        {
+            os << "  - name: " << part.name << std::endl;
+            os << "    compressed: " << part.compressed_size << std::endl;
+            os << "    inflated: " << part.inflated_size << std::endl;
+            os << "    duration: " << to_ms(part.duration) << std::endl;
+        }
+    }
+
+    print_rate(os, "xml-elements", v.xml_elements, v.total);
+    print_rate(os, "xml-attributes", v.xml_attributes, v.total);
+    print_rate(os, "cells", v.cells, v.total);
+    os << "formulas: " << v.formulas << std::endl;
+    os << "strings: " << v.strings << std::endl;
+
+    return os;
+}
+
+struct import_profiler::impl
+{
+    const clock_type::time_point start_time = clock_type::now();
+
+    mutable std::mutex mtx; // protects the stages and the parts
+    std::vector<import_profile_t::stage_t> stages;
+    std::vector<import_profile_t::part_t> parts;
+    import_profile_t::duration_type end{0};
+
+    std::atomic<std::size_t> xml_elements{0};
+    std::atomic<std::size_t> xml_attributes{0};
+    std::atomic<std::size_t> cells{0};
+    std::atomic<std::size_t> formulas{0};
+    std::atomic<std::size_t> strings{0};
+
+    import_profile_t::duration_type elapsed() const
+    {
+        return std::chrono::duration_cast<import_profile_t::duration_type>(clock_type::now() - start_time);
+    }
+};
+
+import_profiler::scope::scope(import_profiler* profiler, std::string_view name) :
+    mp_profiler(profiler), m_name(name), m_start(profiler ? profiler->elapsed() : import_profile_t::duration_type{0})
+{
+}
+
+import_profiler::scope::~scope()
+{
+    if (mp_profiler)
+        mp_profiler->add_stage(m_name, m_start);
+}
+
+import_profiler::import_profiler() : mp_impl(std::make_unique<impl>()) {}
+import_profiler::~import_profiler() = default;
+
+import_profile_t::duration_type import_profiler::elapsed() const
+{
+    return mp_impl->elapsed();
+}
+
+void import_profiler::add_stage(std::string_view name, import_profile_t::duration_type start)
+{
+    auto now = mp_impl->elapsed();
+
+    std::lock_guard lock(mp_impl->mtx);
+    mp_impl->stages.push_back({std::string{name}, start, now - start});
+    mp_impl->end = std::max(mp_impl->end, now);
+}
+
+void import_profiler::add_part(
+    std::string_view name, std::size_t compressed_size, std::size_t inflated_size,
+    import_profile_t::duration_type start)
+{
+    auto now = mp_impl->elapsed();
+
+    std::lock_guard lock(mp_impl->mtx);
+    mp_impl->parts.push_back({std::string{name}, compressed_size, inflated_size, start, now - start});
+    mp_impl->end = std::max(mp_impl->end, now);
+}
+
+void import_profiler::add_xml_elements(std::size_t elements, std::size_t attributes)
+{
+    mp_impl->xml_elements.fetch_add(elements, std::memory_order_relaxed);
+    mp_impl->xml_attributes.fetch_add(attributes, std::memory_order_relaxed);
+}
+
+void import_profiler::add_cells(std::size_t n)
+{
+    mp_impl->cells.fetch_add(n, std::memory_order_relaxed);
+}
+
+void import_profiler::add_formulas(std::size_t n)
+{
+    mp_impl->formulas.fetch_add(n, std::memory_order_relaxed);
+}
+
+void import_profiler::add_strings(std::size_t n)
+{
+    mp_impl->strings.fetch_add(n, std::memory_order_relaxed);
+}
+
+import_profile_t import_profiler::get_profile() const
+{
+    import_profile_t ret;
+
+    {
+        std::lock_guard lock(mp_impl->mtx);
+        ret.stages = mp_impl->stages;
+        ret.parts = mp_impl->parts;
+        ret.total = mp_impl->end;
+    }
+
+    ret.xml_elements = mp_impl->xml_elements.load(std::memory_order_relaxed);
+    ret.xml_attributes = mp_impl->xml_attributes.load(std::memory_order_relaxed);
+    ret.cells = mp_impl->cells.load(std::memory_order_relaxed);
+    ret.formulas = mp_impl->formulas.load(std::memory_order_relaxed);
+    ret.strings = mp_impl->strings.load(std::memory_order_relaxed);
+
+    return ret;
+}
+
+} // namespace orcus
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
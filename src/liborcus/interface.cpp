@@ -13,6 +13,7 @@ namespace orcus { namespace iface {
 struct import_filter::impl
 {
     orcus::config m_config;
+    import_profiler* mp_profiler = nullptr;
 
     impl(format_t input) : m_config(input) {}
 };
@@ -35,6 +36,16 @@ const config& import_filter::get_config() const
     return mp_impl->m_config;
 }
 
+void import_filter::set_profiler(import_profiler* profiler)
+{
+    mp_impl->mp_profiler = profiler;
+}
+
+import_profiler* import_filter::get_profiler() const
+{
+    return mp_impl->mp_profiler;
+}
+
 document_dumper::~document_dumper() = default;
 
 }}
@@ -0,0 +1,351 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "json_document_tape.hpp"
+#include "json_util.hpp"
+
+#include <orcus/config.hpp>
+#include <orcus/string_pool.hpp>
+
+#include <cassert>
+#include <sstream>
+#include <unordered_set>
+
+namespace orcus { namespace json {
+
+namespace {
+
+/**
+ * Containers with this many children or fewer are always scanned linearly.
+ */
+constexpr std::size_t linear_scan_limit = 16;
+
+using entry_type = document_tape::entry_type;
+using size_type = document_tape::size_type;
+
+class tape_builder
+{
+    struct scope
+    {
+        size_type pos;
+        std::uint32_t count = 0;
+
+        /**
+         * Keys of an object, only used to detect duplicate keys once the
+         * object has grown past the linear scan limit.
+         */
+        std::unique_ptr<std::unordered_set<std::string_view>> keys;
+
+        scope(size_type _pos) : pos(_pos) {}
+    };
+
+    const json_config& m_config;
+    string_pool& m_pool;
+    std::vector<document_tape::entry>& m_entries;
+    std::vector<size_type>& m_parents;
+    std::vector<scope> m_stack;
+
+    std::string_view store_string(std::string_view s, bool transient)
+    {
+        if (s.size() > std::numeric_limits<std::uint32_t>::max())
+            throw document_error("string value is too long for the tape storage");
+
+        if (m_config.persistent_string_values || transient)
+            // The tape manages the life cycle of this string value.
+            s = m_pool.intern(s).first;
+
+        return s;
+    }
+
+    document_tape::entry& append_entry()
+    {
+        m_parents.push_back(m_stack.empty() ? document_tape::npos : m_stack.back().pos);
+        return m_entries.emplace_back();
+    }
+
+    document_tape::entry& push_entry(entry_type type)
+    {
+        if (!m_stack.empty() && m_entries[m_stack.back().pos].type == entry_type::array)
+            increment_count(m_stack.back());
+
+        document_tape::entry& e = append_entry();
+        e.type = type;
+        e.size = 0;
+        e.value.end = 0;
+        return e;
+    }
+
+    void increment_count(scope& cur)
+    {
+        if (cur.count == std::numeric_limits<std::uint32_t>::max())
+            throw document_error("too many child values for the tape storage");
+
+        ++cur.count;
+    }
+
+    void check_duplicate_key(scope& cur, std::string_view key)
+    {
+        if (cur.keys)
+        {
+            if (!cur.keys->insert(key).second)
+                throw document_error("adding the same key twice");
+            return;
+        }
+
+        // Walk the members stored so far, which are all complete.
+        std::unordered_set<std::string_view> keys;
+        bool build_set = cur.count >= linear_scan_limit;
+
+        for (size_type pos = cur.pos + 1; pos < m_entries.size(); )
+        {
+            assert(m_entries[pos].type == entry_type::key);
+            const document_tape::entry& e = m_entries[pos];
+            std::string_view this_key(e.value.str, e.size);
+
+            if (this_key == key)
+                throw document_error("adding the same key twice");
+
+            if (build_set)
+                keys.insert(this_key);
+
+            ++pos; // value of the member
+            const document_tape::entry& v = m_entries[pos];
+            pos = (v.type == entry_type::object || v.type == entry_type::array) ? v.value.end : pos + 1;
+        }
+
+        if (build_set)
+        {
+            keys.insert(key);
+            cur.keys = std::make_unique<std::unordered_set<std::string_view>>(std::move(keys));
+        }
+    }
+
+    void begin_container(entry_type type)
+    {
+        size_type pos = m_entries.size();
+        push_entry(type);
+        m_stack.emplace_back(pos);
+    }
+
+    void end_container()
+    {
+        assert(!m_stack.empty());
+        const scope& cur = m_stack.back();
+        document_tape::entry& e = m_entries[cur.pos];
+        e.size = cur.count;
+        e.value.end = m_entries.size();
+        m_stack.pop_back();
+    }
+
+public:
+    tape_builder(
+        const json_config& config, string_pool& pool,
+        std::vector<document_tape::entry>& entries, std::vector<size_type>& parents) :
+        m_config(config), m_pool(pool), m_entries(entries), m_parents(parents) {}
+
+    void begin_parse()
+    {
+        m_entries.clear();
+        m_parents.clear();
+        m_stack.clear();
+    }
+
+    void end_parse()
+    {
+        m_entries.shrink_to_fit();
+        m_parents.shrink_to_fit();
+    }
+
+    void begin_array()
+    {
+        begin_container(entry_type::array);
+    }
+
+    void end_array()
+    {
+        end_container();
+    }
+
+    void begin_object()
+    {
+        begin_container(entry_type::object);
+    }
+
+    void object_key(std::string_view key, bool transient)
+    {
+        assert(!m_stack.empty());
+        scope& cur = m_stack.back();
+        key = store_string(key, transient);
+        check_duplicate_key(cur, key);
+        increment_count(cur);
+
+        document_tape::entry& e = append_entry();
+        e.type = entry_type::key;
+        e.size = key.size();
+        e.value.str = key.data();
+    }
+
+    void end_object()
+    {
+        end_container();
+    }
+
+    void boolean_true()
+    {
+        push_entry(entry_type::boolean_true);
+    }
+
+    void boolean_false()
+    {
+        push_entry(entry_type::boolean_false);
+    }
+
+    void null()
+    {
+        push_entry(entry_type::null);
+    }
+
+    void string(std::string_view s, bool transient)
+    {
+        s = store_string(s, transient);
+        document_tape::entry& e = push_entry(entry_type::string);
+        e.size = s.size();
+        e.value.str = s.data();
+    }
+
+    void number(double val)
+    {
+        document_tape::entry& e = push_entry(entry_type::number);
+        e.value.numeric = val;
+    }
+};
+
+} // anonymous namespace
+
+document_tape::document_tape() = default;
+document_tape::~document_tape() = default;
+
+std::optional<parser_stats> document_tape::load(std::string_view stream, const json_config& config, string_pool& pool)
+{
+    if (config.resolve_references)
+        throw document_error("resolving external references is not supported with the tape storage");
+
+    {
+        std::lock_guard lock(m_index_mtx);
+        m_indices.clear();
+    }
+
+    tape_builder hdl(config, pool, m_entries, m_parents);
+    return parse_stream(stream, hdl, config, pool);
+}
+
+size_type document_tape::child_count(size_type pos) const
+{
+    const entry& e = m_entries[pos];
+    switch (e.type)
+    {
+        case entry_type::object:
+        case entry_type::array:
+            return e.size;
+        default:
+            ;
+    }
+
+    return 0;
+}
+
+size_type document_tape::child(size_type pos, size_type index) const
+{
+    const entry& e = m_entries[pos];
+    if (index >= e.size)
+        return npos;
+
+    bool object = e.type == entry_type::object;
+
+    if (e.size > linear_scan_limit)
+        return get_index(pos).positions[index];
+
+    size_type cur = pos + 1;
+    for (size_type i = 0; i < index; ++i)
+    {
+        if (object)
+            ++cur; // skip the key
+        cur = next(cur);
+    }
+
+    return object ? cur + 1 : cur;
+}
+
+size_type document_tape::child(size_type pos, std::string_view key) const
+{
+    const entry& e = m_entries[pos];
+    assert(e.type == entry_type::object);
+
+    if (e.size > linear_scan_limit)
+    {
+        const container_index& index = get_index(pos);
+        auto it = index.keys.find(key);
+        return it == index.keys.end() ? npos : it->second;
+    }
+
+    for (size_type cur = pos + 1; cur < e.value.end; cur = next(cur + 1))
+    {
+        if (string_value(cur) == key)
+            return cur + 1;
+    }
+
+    return npos;
+}
+
+std::string_view document_tape::key(size_type pos, size_type index) const
+{
+    size_type value_pos = child(pos, index);
+    assert(value_pos != npos && m_entries[value_pos - 1].type == entry_type::key);
+    return string_value(value_pos - 1);
+}
+
+size_type document_tape::parent(size_type pos) const
+{
+    return pos < m_parents.size() ? m_parents[pos] : npos;
+}
+
+const document_tape::container_index& document_tape::get_index(size_type pos) const
+{
+    std::lock_guard lock(m_index_mtx);
+
+    auto it = m_indices.find(pos);
+    if (it != m_indices.end())
+        return *it->second;
+
+    const entry& e = m_entries[pos];
+    bool object = e.type == entry_type::object;
+
+    auto index = std::make_unique<container_index>();
+    index->positions.reserve(e.size);
+    if (object)
+        index->keys.reserve(e.size);
+
+    for (size_type cur = pos + 1; cur < e.value.end; )
+    {
+        if (object)
+        {
+            std::string_view key = string_value(cur);
+            ++cur;
+            index->keys.emplace(key, cur);
+        }
+
+        index->positions.push_back(cur);
+        cur = next(cur);
+    }
+
+    auto r = m_indices.emplace(pos, std::move(index));
+    return *r.first->second;
+}
+
+}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
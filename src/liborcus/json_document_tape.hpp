@@ -0,0 +1,167 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "json_node_store.hpp"
+
+#include <orcus/json_parser_thread.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace orcus {
+
+struct json_config;
+class string_pool;
+
+namespace json {
+
+/**
+ * Read-only storage of a JSON document as a flat sequence of fixed-size
+ * entries in document order.  Each value takes one entry, and each member
+ * of an object takes one key entry immediately followed by the entries of
+ * its value.  A container entry stores the number of its children and the
+ * position past its last descendant, which allows skipping over the whole
+ * container in one step.  The position of the parent container of each
+ * entry is stored separately.
+ *
+ * Containers are scanned linearly by default.  The positions of the
+ * children of a large container, and the keys of a large object, get
+ * indexed on the first random access, and the index is kept for the life
+ * time of the tape.
+ */
+class document_tape : public node_store
+{
+public:
+    /**
+     * The values are the same as those of node_t for the value types.
+     */
+    enum class entry_type : std::uint8_t
+    {
+        string = 1,
+        number = 2,
+        object = 3,
+        array = 4,
+        boolean_true = 5,
+        boolean_false = 6,
+        null = 7,
+        key = 8,
+    };
+
+    struct entry
+    {
+        entry_type type;
+
+        /** Length of a string or a key, or the number of children of a container. */
+        std::uint32_t size;
+
+        union
+        {
+            double numeric;
+            const char* str;
+
+            /** Position past the last descendant of a container. */
+            size_type end;
+
+        } value;
+    };
+
+    document_tape();
+    document_tape(const document_tape&) = delete;
+    document_tape& operator=(const document_tape&) = delete;
+    ~document_tape() override;
+
+    /**
+     * Parse a JSON stream and store its content.
+     *
+     * @param stream JSON stream.
+     * @param config configuration, for the handling of the string values
+     *               and the threading.  Resolving external references is
+     *               not supported.
+     * @param pool string pool to store the keys and the string values that
+     *             do not point into the stream.
+     *
+     * @return statistics of the parser thread when the stream is tokenized
+     *         on a separate thread.
+     */
+    std::optional<parser_stats> load(std::string_view stream, const json_config& config, string_pool& pool);
+
+    bool empty() const override { return m_entries.empty(); }
+
+    size_type size() const { return m_entries.size(); }
+
+    const entry& get(size_type pos) const { return m_entries[pos]; }
+
+    node_t type(size_type pos) const override { return static_cast<node_t>(m_entries[pos].type); }
+
+    std::string_view string_value(size_type pos) const override
+    {
+        const entry& e = m_entries[pos];
+        return {e.value.str, e.size};
+    }
+
+    double numeric_value(size_type pos) const override { return m_entries[pos].value.numeric; }
+
+    /**
+     * Get the position of the entry that follows a value and all its
+     * descendants.
+     */
+    size_type next(size_type pos) const
+    {
+        const entry& e = m_entries[pos];
+        return (e.type == entry_type::object || e.type == entry_type::array) ? e.value.end : pos + 1;
+    }
+
+    size_type child_count(size_type pos) const override;
+
+    size_type child(size_type pos, size_type index) const override;
+
+    size_type child(size_type pos, std::string_view key) const override;
+
+    std::string_view key(size_type pos, size_type index) const override;
+
+    /**
+     * Get the position of the container a value belongs to, or npos for the
+     * root value.
+     */
+    size_type parent(size_type pos) const override;
+
+    uintptr_t identity(size_type pos) const override
+    {
+        return reinterpret_cast<uintptr_t>(&m_entries[pos]);
+    }
+
+private:
+    struct container_index
+    {
+        /** Positions of the child values in order. */
+        std::vector<size_type> positions;
+
+        /** Positions of the child values by their keys, for objects only. */
+        std::unordered_map<std::string_view, size_type> keys;
+    };
+
+    const container_index& get_index(size_type pos) const;
+
+    std::vector<entry> m_entries;
+
+    /** Position of the parent container of each entry. */
+    std::vector<size_type> m_parents;
+
+    mutable std::mutex m_index_mtx;
+    mutable std::unordered_map<size_type, std::unique_ptr<container_index>> m_indices;
+};
+
+}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -13,6 +13,8 @@
 
 #include "json_util.hpp"
 #include "json_path.hpp"
+#include "json_document_tape.hpp"
+#include "json_lazy_tree.hpp"
 
 #include <string>
 #include <vector>
@@ -199,13 +201,188 @@ void dump_repeat(std::ostringstream& os, std::string_view s, int repeat)
         os << s;
 }
 
+/**
+ * Value of a document stored on a tape.  The dump functions take either
+ * this or a json_value pointer, and access them through the functions
+ * below.
+ */
+struct tape_value
+{
+    const document_tape* tape;
+    document_tape::size_type pos;
+};
+
+detail::node_t get_type(const json_value* v)
+{
+    return v->type;
+}
+
+detail::node_t get_type(const tape_value& v)
+{
+    return static_cast<detail::node_t>(v.tape->type(v.pos));
+}
+
+double get_numeric(const json_value* v)
+{
+    return v->value.numeric;
+}
+
+double get_numeric(const tape_value& v)
+{
+    return v.tape->get(v.pos).value.numeric;
+}
+
+std::string_view get_string(const json_value* v)
+{
+    return {v->value.str.p, v->value.str.n};
+}
+
+std::string_view get_string(const tape_value& v)
+{
+    return v.tape->string_value(v.pos);
+}
+
+std::size_t get_child_count(const json_value* v)
+{
+    switch (v->type)
+    {
+        case detail::node_t::array:
+            return v->value.array->value_array.size();
+        case detail::node_t::object:
+            return v->value.object->value_object.size();
+        default:
+            ;
+    }
+
+    return 0;
+}
+
+std::size_t get_child_count(const tape_value& v)
+{
+    return v.tape->child_count(v.pos);
+}
+
+/**
+ * Value of a document in any other read-only storage, accessed through its
+ * virtual interface.
+ */
+struct store_value
+{
+    const node_store* store;
+    node_store::size_type pos;
+};
+
+detail::node_t get_type(const store_value& v)
+{
+    return static_cast<detail::node_t>(v.store->type(v.pos));
+}
+
+double get_numeric(const store_value& v)
+{
+    return v.store->numeric_value(v.pos);
+}
+
+std::string_view get_string(const store_value& v)
+{
+    return v.store->string_value(v.pos);
+}
+
+std::size_t get_child_count(const store_value& v)
+{
+    return v.store->child_count(v.pos);
+}
+
+template<typename FuncT>
+void for_each_element(const json_value* v, FuncT func)
+{
+    for (json_value* cv : v->value.array->value_array)
+        func(cv);
+}
+
+template<typename FuncT>
+void for_each_element(const tape_value& v, FuncT func)
+{
+    const document_tape& tape = *v.tape;
+    document_tape::size_type end = tape.get(v.pos).value.end;
+
+    for (auto pos = v.pos + 1; pos < end; pos = tape.next(pos))
+        func(tape_value{&tape, pos});
+}
+
+template<typename FuncT>
+void for_each_element(const store_value& v, FuncT func)
+{
+    std::size_t n = v.store->child_count(v.pos);
+    for (std::size_t i = 0; i < n; ++i)
+        func(store_value{v.store, v.store->child(v.pos, i)});
+}
+
+template<typename FuncT>
+void for_each_member(const json_value* v, FuncT func)
+{
+    const json_value_object& jvo = *v->value.object;
+    const std::vector<std::string_view>& key_order = jvo.key_order;
+    const json_value_object::object_type& vals = jvo.value_object;
+
+    if (key_order.empty())
+    {
+        // Visit object's children unordered.
+        for (const auto& [key, cv] : vals)
+            func(key, cv);
+
+        return;
+    }
+
+    // Visit them based on key's original ordering.
+    for (std::string_view key : key_order)
+    {
+        auto val_pos = vals.find(key);
+        assert(val_pos != vals.end());
+        func(key, val_pos->second);
+    }
+}
+
+template<typename FuncT>
+void for_each_member(const tape_value& v, FuncT func)
+{
+    // Members are always stored in their original order.
+    const document_tape& tape = *v.tape;
+    document_tape::size_type end = tape.get(v.pos).value.end;
+
+    for (auto pos = v.pos + 1; pos < end; pos = tape.next(pos + 1))
+        func(tape.string_value(pos), tape_value{&tape, pos + 1});
+}
+
+template<typename FuncT>
+void for_each_member(const store_value& v, FuncT func)
+{
+    std::size_t n = v.store->child_count(v.pos);
+    for (std::size_t i = 0; i < n; ++i)
+        func(v.store->key(v.pos, i), store_value{v.store, v.store->child(v.pos, i)});
+}
+
+/**
+ * Pass a value of a read-only storage to a function, as a tape_value when
+ * the storage is a tape to walk it sequentially.
+ */
+template<typename FuncT>
+auto visit_store_value(const node_store* store, node_store::size_type pos, FuncT func)
+{
+    if (const auto* tape = dynamic_cast<const document_tape*>(store))
+        return func(tape_value{tape, pos});
+
+    return func(store_value{store, pos});
+}
+
+template<typename ValueT>
 void dump_item(
-    std::ostringstream& os, const dump_context& cxt, const std::string_view* key, const json_value* val,
+    std::ostringstream& os, const dump_context& cxt, const std::string_view* key, const ValueT& val,
     int indent, int level, bool sep);
 
+template<typename ValueT>
 void dump_value(
     std::ostringstream& os, const dump_context& cxt,
-    const json_value* v, std::size_t indent, int level, const std::string_view* key = nullptr)
+    const ValueT& v, std::size_t indent, int level, const std::string_view* key = nullptr)
 {
     dump_repeat(os, cxt.indent, level);
 
@@ -215,17 +392,19 @@ void dump_value(
         os << ": ";
     }
 
-    switch (v->type)
+    switch (get_type(v))
     {
         case detail::node_t::array:
         {
-            auto& vals = v->value.array->value_array;
             os << "[" << cxt.end;
 
             // dump each array element, passing a separator flag for all but the last
-            std::size_t n = vals.size();
-            for (std::size_t pos : std::views::iota(std::size_t{0}, n))
-                dump_item(os, cxt, nullptr, vals[pos], indent, level, pos < (n-1));
+            std::size_t n = get_child_count(v);
+            std::size_t pos = 0;
+            for_each_element(v, [&](const ValueT& cv)
+            {
+                dump_item(os, cxt, nullptr, cv, indent, level, ++pos < n);
+            });
 
             dump_repeat(os, cxt.indent, level);
             os << "]";
@@ -241,40 +420,18 @@ void dump_value(
             os << "null";
             break;
         case detail::node_t::number:
-            os << v->value.numeric;
+            os << get_numeric(v);
             break;
         case detail::node_t::object:
         {
-            const std::vector<std::string_view>& key_order = v->value.object->key_order;
-            auto& vals = v->value.object->value_object;
             os << "{" << cxt.end;
-            size_t n = vals.size();
-
-            if (key_order.empty())
-            {
-                // Dump object's children unordered.
-                size_t pos = 0;
-                for (auto it = vals.begin(), ite = vals.end(); it != ite; ++it, ++pos)
-                {
-                    std::string_view this_key = it->first;
-                    auto& this_val = it->second;
 
-                    dump_item(os, cxt, &this_key, this_val, indent, level, pos < (n-1));
-                }
-            }
-            else
+            std::size_t n = get_child_count(v);
+            std::size_t pos = 0;
+            for_each_member(v, [&](std::string_view this_key, const ValueT& cv)
             {
-                // Dump them based on key's original ordering.
-                size_t pos = 0;
-                for (auto it = key_order.begin(), ite = key_order.end(); it != ite; ++it, ++pos)
-                {
-                    std::string_view this_key = *it;
-                    auto val_pos = vals.find(this_key);
-                    assert(val_pos != vals.end());
-
-                    dump_item(os, cxt, &this_key, val_pos->second, indent, level, pos < (n-1));
-                }
-            }
+                dump_item(os, cxt, &this_key, cv, indent, level, ++pos < n);
+            });
 
             dump_repeat(os, cxt.indent, level);
             os << "}";
@@ -282,7 +439,7 @@ void dump_value(
             break;
         }
         case detail::node_t::string:
-            json::dump_string(os, {v->value.str.p, v->value.str.n});
+            json::dump_string(os, get_string(v));
             break;
         case detail::node_t::unset:
         default:
@@ -290,8 +447,9 @@ void dump_value(
     }
 }
 
+template<typename ValueT>
 void dump_item(
-    std::ostringstream& os, const dump_context& cxt, const std::string_view* key, const json_value* val,
+    std::ostringstream& os, const dump_context& cxt, const std::string_view* key, const ValueT& val,
     int indent, int level, bool sep)
 {
     dump_value(os, cxt, val, indent, level+1, key);
@@ -300,9 +458,10 @@ void dump_item(
     os << cxt.end;
 }
 
-std::string dump_json_tree(const dump_context cxt, const json_value* root, std::size_t indent)
+template<typename ValueT>
+std::string dump_json_tree(const dump_context cxt, const ValueT& root, std::size_t indent)
 {
-    if (root->type == detail::node_t::unset)
+    if (get_type(root) == detail::node_t::unset)
         return std::string();
 
     std::ostringstream os;
@@ -345,12 +504,14 @@ void dump_string_xml(std::ostringstream& os, std::string_view s)
     }
 }
 
+template<typename ValueT>
 void dump_object_item_xml(
-    std::ostringstream& os, std::string_view key, const json_value* val, int level);
+    std::ostringstream& os, std::string_view key, const ValueT& val, int level);
 
-void dump_value_xml(std::ostringstream& os, const json_value* v, int level)
+template<typename ValueT>
+void dump_value_xml(std::ostringstream& os, const ValueT& v, int level)
 {
-    switch (v->type)
+    switch (get_type(v))
     {
         case detail::node_t::array:
         {
@@ -359,14 +520,12 @@ void dump_value_xml(std::ostringstream& os, const json_value* v, int level)
                 os << " xmlns=\"" << NS_orcus_json_xml << "\"";
             os << ">";
 
-            auto& vals = v->value.array->value_array;
-
-            for (auto it = vals.begin(), ite = vals.end(); it != ite; ++it)
+            for_each_element(v, [&](const ValueT& cv)
             {
                 os << "<item>";
-                dump_value_xml(os, *it, level+1);
+                dump_value_xml(os, cv, level+1);
                 os << "</item>";
-            }
+            });
 
             os << "</array>";
         }
@@ -382,7 +541,7 @@ void dump_value_xml(std::ostringstream& os, const json_value* v, int level)
         break;
         case detail::node_t::number:
             os << "<number value=\"";
-            os << v->value.numeric;
+            os << get_numeric(v);
             os << "\"/>";
         break;
         case detail::node_t::object:
@@ -392,39 +551,17 @@ void dump_value_xml(std::ostringstream& os, const json_value* v, int level)
                 os << " xmlns=\"" << NS_orcus_json_xml << "\"";
             os << ">";
 
-            const json_value_object& jvo = *v->value.object;
-            auto& key_order = jvo.key_order;
-            auto& vals = jvo.value_object;
-
-            if (key_order.empty())
-            {
-                // Dump object's children unordered.
-                for (auto it = vals.begin(), ite = vals.end(); it != ite; ++it)
-                {
-                    auto& key = it->first;
-                    auto& val = it->second;
-                    dump_object_item_xml(os, key, val, level);
-                }
-            }
-            else
+            for_each_member(v, [&](std::string_view key, const ValueT& cv)
             {
-                // Dump them based on key's original ordering.
-                for (auto it = key_order.begin(), ite = key_order.end(); it != ite; ++it)
-                {
-                    auto& key = *it;
-                    auto val_pos = vals.find(key);
-                    assert(val_pos != vals.end());
-
-                    dump_object_item_xml(os, key, val_pos->second, level);
-                }
-            }
+                dump_object_item_xml(os, key, cv, level);
+            });
 
             os << "</object>";
         }
         break;
         case detail::node_t::string:
             os << "<string value=\"";
-            dump_string_xml(os, std::string_view(v->value.str.p, v->value.str.n));
+            dump_string_xml(os, get_string(v));
             os << "\"/>";
         break;
         case detail::node_t::unset:
@@ -473,16 +610,17 @@ class yaml_dumper
     }
 
 public:
-    std::string dump(const json_value* root)
+    template<typename ValueT>
+    std::string dump(const ValueT& root)
     {
-        if (!root || root->type == detail::node_t::unset)
+        if (get_type(root) == detail::node_t::unset)
             return std::string();
 
         reset();
 
         std::ostringstream os;
         os << "---" << std::endl;
-        write_value(os, root);
+        write_value(os, root, detail::node_t::unset);
         return os.str();
     }
 
@@ -539,27 +677,27 @@ private:
             os << '"';
     }
 
-    void write_value(std::ostringstream& os, const json_value* v)
+    template<typename ValueT>
+    void write_value(std::ostringstream& os, const ValueT& v, detail::node_t parent_type)
     {
         m_last_write = write_type::value;
-        detail::node_t parent_type = v->parent ? v->parent->type : detail::node_t::unset;
 
-        switch (v->type)
+        switch (get_type(v))
         {
             case detail::node_t::array:
             {
                 if (parent_type != detail::node_t::unset)
                     write_linebreak(os);
 
-                for (const json_value* cv : v->value.array->value_array)
+                for_each_element(v, [this, &os](const ValueT& cv)
                 {
                     write_indent(os);
                     os << "- ";
                     m_indent_length += 2;
-                    write_value(os, cv);
+                    write_value(os, cv, detail::node_t::array);
                     m_indent_length -= 2;
                     write_linebreak(os);
-                }
+                });
                 break;
             }
             case detail::node_t::boolean_false:
@@ -573,44 +711,28 @@ private:
                 break;
             case detail::node_t::number:
             {
-                os << v->value.numeric;
+                os << get_numeric(v);
                 break;
             }
             case detail::node_t::object:
             {
-                const json_value_object& jvo = *v->value.object;
-                const std::vector<std::string_view>& key_order = jvo.key_order;
-                const json_value_object::object_type& vals = jvo.value_object;
+                std::deque<std::tuple<std::string_view, ValueT>> key_values;
 
-                std::deque<std::tuple<std::string_view, const json_value*>> key_values;
-
-                if (key_order.empty())
-                {
-                    // Dump object's children unordered.
-                    for (const auto& val : vals)
-                        key_values.emplace_back(val.first, val.second);
-                }
-                else
+                for_each_member(v, [&key_values](std::string_view key, const ValueT& cv)
                 {
-                    // Dump them based on key's original ordering.
-                    for (std::string_view key : key_order)
-                    {
-                        auto val_pos = vals.find(key);
-                        assert(val_pos != vals.end());
-                        key_values.emplace_back(key, val_pos->second);
-                    }
-                }
+                    key_values.emplace_back(key, cv);
+                });
 
                 if (key_values.empty())
                     break;
 
-                auto write_key_value = [this, &os](std::string_view key, const json_value* value)
+                auto write_key_value = [this, &os](std::string_view key, const ValueT& value)
                 {
                     std::size_t indent_add = 2;
                     write_string(os, key);
                     os << ": ";
                     m_indent_length += indent_add;
-                    write_value(os, value);
+                    write_value(os, value, detail::node_t::object);
                     m_indent_length -= indent_add;
                     write_linebreak(os);
                 };
@@ -634,7 +756,7 @@ private:
             }
             case detail::node_t::string:
             {
-                write_string(os, {v->value.str.p, v->value.str.n});
+                write_string(os, get_string(v));
                 break;
             }
             case detail::node_t::unset:
@@ -644,8 +766,9 @@ private:
     }
 };
 
+template<typename ValueT>
 void dump_object_item_xml(
-    std::ostringstream& os, std::string_view key, const json_value* val, int level)
+    std::ostringstream& os, std::string_view key, const ValueT& val, int level)
 {
     os << "<item name=\"";
     dump_string_xml(os, key);
@@ -654,9 +777,10 @@ void dump_object_item_xml(
     os << "</item>";
 }
 
-std::string dump_xml_tree(const json_value* root)
+template<typename ValueT>
+std::string dump_xml_tree(const ValueT& root)
 {
-    if (root->type == detail::node_t::unset)
+    if (get_type(root) == detail::node_t::unset)
         return std::string();
 
     std::ostringstream os;
@@ -873,9 +997,18 @@ struct const_node::impl
     const document_tree* doc = nullptr;
     json_value* node = nullptr;
 
+    /**
+     * Storage of the document when it uses a read-only storage, in which
+     * case the node is referenced by its position in the storage.
+     */
+    const node_store* store = nullptr;
+    node_store::size_type pos = 0;
+
     impl() = default;
     impl(const document_tree* _doc, json_value* jv) : doc(_doc), node(jv) {}
-    impl(const impl& other) : doc(other.doc), node(other.node) {}
+    impl(const document_tree* _doc, const node_store* _store, node_store::size_type _pos) :
+        doc(_doc), store(_store), pos(_pos) {}
+    impl(const impl& other) : doc(other.doc), node(other.node), store(other.store), pos(other.pos) {}
 };
 
 json_value* const_node::get_json_value()
@@ -911,12 +1044,15 @@ const_node& const_node::operator=(const_node&& other)
 
 uintptr_t const_node::identity() const
 {
+    if (mp_impl->store)
+        return mp_impl->store->identity(mp_impl->pos);
+
     return reinterpret_cast<uintptr_t>(mp_impl->node);
 }
 
 const_node_iterator const_node::begin() const
 {
-    if (mp_impl->node->type != detail::node_t::array)
+    if (type() != node_t::array)
         throw document_error("const_node::begin: this method only supports array nodes.");
 
     return const_node_iterator(mp_impl->doc, *this, true);
@@ -924,7 +1060,7 @@ const_node_iterator const_node::begin() const
 
 const_node_iterator const_node::end() const
 {
-    if (mp_impl->node->type != detail::node_t::array)
+    if (type() != node_t::array)
         throw document_error("const_node::end: this method only supports array nodes.");
 
     return const_node_iterator(mp_impl->doc, *this, false);
@@ -932,15 +1068,25 @@ const_node_iterator const_node::end() const
 
 std::string const_node::dump(std::size_t indent) const
 {
+    dump_context cxt(indent);
+
+    if (mp_impl->store)
+        return visit_store_value(mp_impl->store, mp_impl->pos, [&cxt, indent](const auto& v)
+        {
+            return json::dump_json_tree(cxt, v, indent);
+        });
+
     if (!mp_impl->node)
         return {};
 
-    dump_context cxt(indent);
     return json::dump_json_tree(cxt, mp_impl->node, indent);
 }
 
 node_t const_node::type() const
 {
+    if (mp_impl->store)
+        return mp_impl->store->type(mp_impl->pos);
+
     if (!mp_impl->node)
         return node_t::unset;
 
@@ -950,6 +1096,9 @@ node_t const_node::type() const
 
 size_t const_node::child_count() const
 {
+    if (mp_impl->store)
+        return mp_impl->store->child_count(mp_impl->pos);
+
     switch (mp_impl->node->type)
     {
         case detail::node_t::object:
@@ -970,16 +1119,25 @@ size_t const_node::child_count() const
 
 std::vector<std::string_view> const_node::keys() const
 {
-    if (mp_impl->node->type != detail::node_t::object)
+    if (type() != node_t::object)
         throw document_error("node::keys: this node is not of object type.");
 
+    std::vector<std::string_view> keys;
+
+    if (mp_impl->store)
+    {
+        std::size_t n = mp_impl->store->child_count(mp_impl->pos);
+        keys.reserve(n);
+        for (std::size_t i = 0; i < n; ++i)
+            keys.push_back(mp_impl->store->key(mp_impl->pos, i));
+        return keys;
+    }
+
     const json_value_object* jvo = mp_impl->node->value.object;
     if (!jvo->key_order.empty())
         // Prefer to use key_order when it's populated.
         return jvo->key_order;
 
-    std::vector<std::string_view> keys;
-
     for (const auto& n : jvo->value_object)
         keys.push_back(n.first);
 
@@ -988,9 +1146,17 @@ std::vector<std::string_view> const_node::keys() const
 
 std::string_view const_node::key(size_t index) const
 {
-    if (mp_impl->node->type != detail::node_t::object)
+    if (type() != node_t::object)
         throw document_error("node::key: this node is not of object type.");
 
+    if (mp_impl->store)
+    {
+        if (index >= mp_impl->store->child_count(mp_impl->pos))
+            throw std::out_of_range("node::key: index is out-of-range.");
+
+        return mp_impl->store->key(mp_impl->pos, index);
+    }
+
     const json_value_object* jvo = mp_impl->node->value.object;
     if (index >= jvo->key_order.size())
         throw std::out_of_range("node::key: index is out-of-range.");
@@ -1000,9 +1166,12 @@ std::string_view const_node::key(size_t index) const
 
 bool const_node::has_key(std::string_view key) const
 {
-    if (mp_impl->node->type != detail::node_t::object)
+    if (type() != node_t::object)
         return false;
 
+    if (mp_impl->store)
+        return mp_impl->store->child(mp_impl->pos, key) != node_store::npos;
+
     const json_value_object* jvo = mp_impl->node->value.object;
     const json_value_object::object_type& children = jvo->value_object;
 
@@ -1011,6 +1180,24 @@ bool const_node::has_key(std::string_view key) const
 
 const_node const_node::child(size_t index) const
 {
+    if (mp_impl->store)
+    {
+        switch (mp_impl->store->type(mp_impl->pos))
+        {
+            case node_t::object:
+            case node_t::array:
+            {
+                auto pos = mp_impl->store->child(mp_impl->pos, index);
+                if (pos == node_store::npos)
+                    throw std::out_of_range("node::child: index is out-of-range");
+
+                return const_node(std::make_unique<impl>(mp_impl->doc, mp_impl->store, pos));
+            }
+            default:
+                throw document_error("node::child: this node cannot have child nodes.");
+        }
+    }
+
     switch (mp_impl->node->type)
     {
         case detail::node_t::object:
@@ -1048,23 +1235,44 @@ const_node const_node::child(size_t index) const
 
 const_node const_node::child(std::string_view key) const
 {
-    if (mp_impl->node->type != detail::node_t::object)
+    if (type() != node_t::object)
         throw document_error("node::child: this node is not of object type.");
 
-    const json_value_object* jvo = mp_impl->node->value.object;
-    auto it = jvo->value_object.find(key);
-    if (it == jvo->value_object.end())
+    auto throw_no_key = [key]()
     {
         std::ostringstream os;
         os << "node::child: this object does not have a key labeled '" << key << "'";
         throw document_error(os.str());
+    };
+
+    if (mp_impl->store)
+    {
+        auto pos = mp_impl->store->child(mp_impl->pos, key);
+        if (pos == node_store::npos)
+            throw_no_key();
+
+        return const_node(std::make_unique<impl>(mp_impl->doc, mp_impl->store, pos));
     }
 
+    const json_value_object* jvo = mp_impl->node->value.object;
+    auto it = jvo->value_object.find(key);
+    if (it == jvo->value_object.end())
+        throw_no_key();
+
     return const_node(mp_impl->doc, it->second);
 }
 
 const_node const_node::parent() const
 {
+    if (mp_impl->store)
+    {
+        auto pos = mp_impl->store->parent(mp_impl->pos);
+        if (pos == node_store::npos)
+            throw document_error("node::parent: this node has no parent.");
+
+        return const_node(std::make_unique<impl>(mp_impl->doc, mp_impl->store, pos));
+    }
+
     if (!mp_impl->node->parent)
         throw document_error("node::parent: this node has no parent.");
 
@@ -1073,9 +1281,19 @@ const_node const_node::parent() const
 
 const_node const_node::back() const
 {
-    if (mp_impl->node->type != detail::node_t::array)
+    if (type() != node_t::array)
         throw document_error("const_node::child: this node is not of array type.");
 
+    if (mp_impl->store)
+    {
+        std::size_t n = mp_impl->store->child_count(mp_impl->pos);
+        if (!n)
+            throw document_error("const_node::child: this node has no children.");
+
+        auto pos = mp_impl->store->child(mp_impl->pos, n - 1);
+        return const_node(std::make_unique<impl>(mp_impl->doc, mp_impl->store, pos));
+    }
+
     const json_value_array* jva = mp_impl->node->value.array;
     if (jva->value_array.empty())
         throw document_error("const_node::child: this node has no children.");
@@ -1085,17 +1303,23 @@ const_node const_node::back() const
 
 std::string_view const_node::string_value() const
 {
-    if (mp_impl->node->type != detail::node_t::string)
+    if (type() != node_t::string)
         throw document_error("node::key: current node is not of string type.");
 
+    if (mp_impl->store)
+        return mp_impl->store->string_value(mp_impl->pos);
+
     return std::string_view(mp_impl->node->value.str.p, mp_impl->node->value.str.n);
 }
 
 double const_node::numeric_value() const
 {
-    if (mp_impl->node->type != detail::node_t::number)
+    if (type() != node_t::number)
         throw document_error("node::key: current node is not of numeric type.");
 
+    if (mp_impl->store)
+        return mp_impl->store->numeric_value(mp_impl->pos);
+
     return mp_impl->node->value.numeric;
 }
 
@@ -1117,6 +1341,9 @@ node& node::operator=(const node& other)
 
 node& node::operator=(const detail::init::node& v)
 {
+    if (mp_impl->store)
+        throw document_error("node::operator=: the document is in a read-only storage.");
+
     document_resource& res =
         const_cast<document_resource&>(mp_impl->doc->get_resource());
 
@@ -1127,6 +1354,9 @@ node& node::operator=(const detail::init::node& v)
 
 node node::operator[](std::string_view key)
 {
+    if (mp_impl->store)
+        throw document_error("node::operator[]: the document is in a read-only storage.");
+
     if (mp_impl->node->type != detail::node_t::object)
         throw document_error("node::operator[]: the node must be of object type.");
 
@@ -1173,6 +1403,9 @@ node node::back()
 
 void node::push_back(const detail::init::node& v)
 {
+    if (mp_impl->store)
+        throw document_error("node::push_back: the document is in a read-only storage.");
+
     if (mp_impl->node->type != detail::node_t::array)
     {
         std::ostringstream os;
@@ -1190,6 +1423,16 @@ struct const_node_iterator::impl
     const document_tree* doc;
     std::vector<json_value*>::const_iterator pos;
     std::vector<json_value*>::const_iterator end;
+
+    /**
+     * Array being iterated over and the index of the current element, when
+     * the document uses a read-only storage.
+     */
+    const node_store* store = nullptr;
+    node_store::size_type array_pos = 0;
+    std::size_t index = 0;
+    std::size_t count = 0;
+
     const_node current_node;
 
     impl() : doc(nullptr), current_node(nullptr, nullptr) {}
@@ -1198,11 +1441,25 @@ struct const_node_iterator::impl
         doc(other.doc),
         pos(other.pos),
         end(other.end),
+        store(other.store),
+        array_pos(other.array_pos),
+        index(other.index),
+        count(other.count),
         current_node(other.current_node) {}
 
     impl(const document_tree* _doc, const const_node& v, bool begin) :
         doc(_doc), current_node(nullptr, nullptr)
     {
+        if (v.mp_impl->store)
+        {
+            store = v.mp_impl->store;
+            array_pos = v.mp_impl->pos;
+            count = store->child_count(array_pos);
+            index = begin ? 0 : count;
+            update_current();
+            return;
+        }
+
         const json_value_array* jva = v.mp_impl->node->value.array;
         pos = begin ? jva->value_array.cbegin() : jva->value_array.cend();
         end = jva->value_array.cend();
@@ -1211,8 +1468,44 @@ struct const_node_iterator::impl
             current_node = const_node(doc, *pos);
     }
 
+    void increment()
+    {
+        if (store)
+            ++index;
+        else
+            ++pos;
+
+        update_current();
+    }
+
+    void decrement()
+    {
+        if (store)
+            --index;
+        else
+            --pos;
+
+        update_current();
+    }
+
+    bool equals(const impl& other) const
+    {
+        if (store)
+            return store == other.store && array_pos == other.array_pos && index == other.index;
+
+        return pos == other.pos && end == other.end;
+    }
+
     void update_current()
     {
+        if (store)
+        {
+            current_node = index >= count ?
+                const_node(doc, nullptr) :
+                const_node(std::make_unique<const_node::impl>(doc, store, store->child(array_pos, index)));
+            return;
+        }
+
         current_node = const_node(doc, pos == end ? nullptr : *pos);
     }
 };
@@ -1240,37 +1533,33 @@ const const_node* const_node_iterator::operator->() const
 
 const_node_iterator& const_node_iterator::operator++()
 {
-    ++mp_impl->pos;
-    mp_impl->update_current();
+    mp_impl->increment();
     return *this;
 }
 
 const_node_iterator const_node_iterator::operator++(int)
 {
     const_node_iterator tmp(*this);
-    ++mp_impl->pos;
-    mp_impl->update_current();
+    mp_impl->increment();
     return tmp;
 }
 
 const_node_iterator& const_node_iterator::operator--()
 {
-    --mp_impl->pos;
-    mp_impl->update_current();
+    mp_impl->decrement();
     return *this;
 }
 
 const_node_iterator const_node_iterator::operator--(int)
 {
     const_node_iterator tmp(*this);
-    --mp_impl->pos;
-    mp_impl->update_current();
+    mp_impl->decrement();
     return tmp;
 }
 
 bool const_node_iterator::operator== (const const_node_iterator& other) const
 {
-    return mp_impl->pos == other.mp_impl->pos && mp_impl->end == other.mp_impl->end;
+    return mp_impl->equals(*other.mp_impl);
 }
 
 bool const_node_iterator::operator!= (const const_node_iterator& other) const
@@ -1283,6 +1572,10 @@ const_node_iterator& const_node_iterator::operator= (const const_node_iterator&
     mp_impl->doc = other.mp_impl->doc;
     mp_impl->pos = other.mp_impl->pos;
     mp_impl->end = other.mp_impl->end;
+    mp_impl->store = other.mp_impl->store;
+    mp_impl->array_pos = other.mp_impl->array_pos;
+    mp_impl->index = other.mp_impl->index;
+    mp_impl->count = other.mp_impl->count;
     mp_impl->update_current();
 
     return *this;
@@ -1674,6 +1967,12 @@ struct document_tree::impl
     std::unique_ptr<document_resource> own_res;
     document_resource& res;
 
+    /** Content of the document when it's loaded with a read-only storage. */
+    std::unique_ptr<node_store> store;
+
+    /** Statistics of the parser thread from the last load. */
+    std::optional<parser_stats> stats;
+
     impl() : root(nullptr), own_res(std::make_unique<document_resource>()), res(*own_res) {}
     impl(document_resource& _res) : root(nullptr), res(_res) {}
 };
@@ -1747,9 +2046,34 @@ document_tree& document_tree::operator= (object obj)
 
 void document_tree::load(std::string_view stream, const json_config& config)
 {
+    mp_impl->stats.reset();
+
+    switch (config.storage)
+    {
+        case json_config::storage_type::tape:
+        {
+            auto tape = std::make_unique<document_tape>();
+            mp_impl->stats = tape->load(stream, config, mp_impl->res.str_pool);
+            mp_impl->store = std::move(tape);
+            mp_impl->root = nullptr;
+            return;
+        }
+        case json_config::storage_type::lazy:
+        {
+            auto lazy = std::make_unique<lazy_tree>();
+            lazy->load(stream, config, mp_impl->res.str_pool);
+            mp_impl->store = std::move(lazy);
+            mp_impl->root = nullptr;
+            return;
+        }
+        case json_config::storage_type::tree:
+            break;
+    }
+
+    mp_impl->store.reset();
+
     json::parser_handler hdl(config, mp_impl->res);
-    json_parser<json::parser_handler> parser(stream, hdl);
-    parser.parse();
+    mp_impl->stats = parse_stream(stream, hdl, config, mp_impl->res.str_pool);
     mp_impl->root = hdl.get_root();
 
     auto& external_refs = hdl.get_external_refs();
@@ -1822,8 +2146,21 @@ void document_tree::load(std::string_view stream, const json_config& config)
     }
 }
 
+std::optional<json::parser_stats> document_tree::get_parser_stats() const
+{
+    return mp_impl->stats;
+}
+
 json::const_node document_tree::get_document_root() const
 {
+    if (mp_impl->store)
+    {
+        if (mp_impl->store->empty())
+            throw document_error("document tree is empty");
+
+        return json::const_node(std::make_unique<const_node::impl>(this, mp_impl->store.get(), 0));
+    }
+
     json::json_value* p = mp_impl->root;
     if (!p)
         throw document_error("document tree is empty");
@@ -1833,6 +2170,12 @@ json::const_node document_tree::get_document_root() const
 
 json::node document_tree::get_document_root()
 {
+    if (mp_impl->store)
+    {
+        const document_tree* cthis = this;
+        return json::node(cthis->get_document_root());
+    }
+
     json::json_value* p = mp_impl->root;
     if (!p)
         throw document_error("document tree is empty");
@@ -1842,6 +2185,18 @@ json::node document_tree::get_document_root()
 
 std::string document_tree::dump(std::size_t indent) const
 {
+    if (mp_impl->store)
+    {
+        if (mp_impl->store->empty())
+            return std::string();
+
+        dump_context cxt(indent);
+        return visit_store_value(mp_impl->store.get(), 0, [&cxt, indent](const auto& v)
+        {
+            return json::dump_json_tree(cxt, v, indent);
+        });
+    }
+
     if (!mp_impl->root)
         return std::string();
 
@@ -1851,6 +2206,14 @@ std::string document_tree::dump(std::size_t indent) const
 
 std::string document_tree::dump_xml() const
 {
+    if (mp_impl->store && !mp_impl->store->empty())
+    {
+        return visit_store_value(mp_impl->store.get(), 0, [](const auto& v)
+        {
+            return json::dump_xml_tree(v);
+        });
+    }
+
     if (!mp_impl->root)
         return std::string();
 
@@ -1860,6 +2223,18 @@ std::string document_tree::dump_xml() const
 std::string document_tree::dump_yaml() const
 {
     json::yaml_dumper dumper;
+
+    if (mp_impl->store && !mp_impl->store->empty())
+    {
+        return visit_store_value(mp_impl->store.get(), 0, [&dumper](const auto& v)
+        {
+            return dumper.dump(v);
+        });
+    }
+
+    if (!mp_impl->root)
+        return std::string();
+
     return dumper.dump(mp_impl->root);
 }
 
@@ -1887,6 +2262,63 @@ struct path_scope
     path_scope(const_node _node) : node(std::move(_node)) {}
 };
 
+/**
+ * Copy a value in a read-only storage into a new tree of values.  The keys
+ * and string values still point to the read-only storage.
+ */
+template<typename ValueT>
+json_value* copy_store_value(document_resource& res, const ValueT& v)
+{
+    detail::node_t type = get_type(v);
+    json_value* jv = res.obj_pool.construct(type);
+
+    switch (type)
+    {
+        case detail::node_t::array:
+        {
+            jv->value.array = res.obj_pool_jva.construct();
+            auto& vals = jv->value.array->value_array;
+            vals.reserve(get_child_count(v));
+
+            for_each_element(v, [&res, jv, &vals](const ValueT& cv)
+            {
+                json_value* child = copy_store_value(res, cv);
+                child->parent = jv;
+                vals.push_back(child);
+            });
+            break;
+        }
+        case detail::node_t::object:
+        {
+            json_value_object* jvo = res.obj_pool_jvo.construct();
+            jv->value.object = jvo;
+
+            for_each_member(v, [&res, jv, jvo](std::string_view key, const ValueT& cv)
+            {
+                json_value* child = copy_store_value(res, cv);
+                child->parent = jv;
+                jvo->key_order.push_back(key);
+                jvo->value_object.insert({key, child});
+            });
+            break;
+        }
+        case detail::node_t::number:
+            jv->value.numeric = get_numeric(v);
+            break;
+        case detail::node_t::string:
+        {
+            std::string_view s = get_string(v);
+            jv->value.str.p = s.data();
+            jv->value.str.n = s.size();
+            break;
+        }
+        default:
+            ;
+    }
+
+    return jv;
+}
+
 } // anonymous namespace
 
 subtree::subtree(const document_tree& src, std::string_view path) :
@@ -1982,7 +2414,15 @@ subtree::subtree(const document_tree& src, std::string_view path) :
             if (++it == it_end)
             {
                 // reached the path destination - turn around
-                json_value* jv = path_stack.back().node.get_json_value();
+                const_node& dest = path_stack.back().node;
+                json_value* jv = dest.get_json_value();
+                if (dest.mp_impl->store)
+                {
+                    jv = visit_store_value(dest.mp_impl->store, dest.mp_impl->pos, [this](const auto& v)
+                    {
+                        return copy_store_value(mp_impl->res, v);
+                    });
+                }
                 path_stack.back().value = jv;
                 down = false;
             }
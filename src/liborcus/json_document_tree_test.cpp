@@ -177,10 +177,14 @@ void test_json_parse()
 {
     ORCUS_TEST_FUNC_SCOPE;
 
-    json_config test_config;
+    for (auto storage : { json_config::storage_type::tree, json_config::storage_type::tape, json_config::storage_type::lazy })
+    {
+        json_config test_config;
+        test_config.storage = storage;
 
-    for (const auto& basedir : json_test_dirs)
-        verify_input(test_config, basedir);
+        for (const auto& basedir : json_test_dirs)
+            verify_input(test_config, basedir);
+    }
 }
 
 void test_json_dump_indent_0()
@@ -335,6 +339,16 @@ void dump_and_load(
     doc2.load(dumped, json_config());
     json::const_node node = doc2.get_document_root();
     test_func(node);
+
+    // Load it again with the read-only storages.
+    for (auto storage : { json_config::storage_type::tape, json_config::storage_type::lazy })
+    {
+        json_config config;
+        config.storage = storage;
+        json::document_tree doc3;
+        doc3.load(dumped, config);
+        test_func(doc3.get_document_root());
+    }
 }
 
 void test_json_const_node_unset()
@@ -995,12 +1009,8 @@ void test_json_dump_subtree()
     assert(node.dump(0) == "false");
 }
 
-void test_json_subtree()
+void verify_subtrees(const json_config& test_config)
 {
-    ORCUS_TEST_FUNC_SCOPE;
-
-    json_config test_config;
-
     const fs::path test_dirs[] = {
         SRCDIR"/test/json/subtree/one-array",
         SRCDIR"/test/json/subtree/array-of-objects",
@@ -1072,6 +1082,299 @@ void test_json_subtree()
     }
 }
 
+void test_json_subtree()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    for (auto storage : { json_config::storage_type::tree, json_config::storage_type::tape, json_config::storage_type::lazy })
+    {
+        json_config test_config;
+        test_config.storage = storage;
+        verify_subtrees(test_config);
+    }
+}
+
+void verify_read_only_storage(json_config::storage_type storage)
+{
+    // Build an object and an array large enough to get indexed.
+    std::ostringstream os;
+    os << "{\"values\": [";
+    for (int i = 0; i < 100; ++i)
+    {
+        if (i)
+            os << ", ";
+        os << "{\"id\": " << i << ", \"name\": \"item" << i << "\"}";
+    }
+    os << "], \"keys\": {";
+    for (int i = 0; i < 100; ++i)
+    {
+        if (i)
+            os << ", ";
+        os << "\"key" << i << "\": " << i;
+    }
+    os << "}}";
+    std::string strm = os.str();
+
+    json_config config;
+    config.storage = storage;
+
+    json::document_tree doc;
+    doc.load(strm, config);
+
+    json::document_tree doc_tree;
+    doc_tree.load(strm, json_config());
+    assert(doc.dump(4) == doc_tree.dump(4));
+    assert(doc.dump_xml() == doc_tree.dump_xml());
+    assert(doc.dump_yaml() == doc_tree.dump_yaml());
+
+    json::const_node root = doc.get_document_root();
+    assert(root.type() == json::node_t::object);
+    assert(root.child_count() == 2);
+    assert(root.key(0) == "values");
+    assert(root.key(1) == "keys");
+    assert(root.has_key("keys"));
+    assert(!root.has_key("unknown"));
+
+    json::const_node values = root.child("values");
+    assert(values.type() == json::node_t::array);
+    assert(values.child_count() == 100);
+    assert(values.parent().identity() == root.identity());
+
+    for (int i : { 99, 0, 50, 17, 16 })
+    {
+        json::const_node item = values.child(i);
+        assert(number_expected(item.child("id"), i));
+        std::string name = "item" + std::to_string(i);
+        assert(string_expected(item.child("name"), name.data()));
+        assert(item.parent().identity() == values.identity());
+        assert(item.child("name").parent().identity() == item.identity());
+    }
+
+    assert(number_expected(values.back().child("id"), 99.0));
+
+    // Iterate forward and backward.
+    int count = 0;
+    for (const json::const_node& item : values)
+        assert(number_expected(item.child("id"), count++));
+    assert(count == 100);
+
+    auto it = values.end();
+    for (int i = 99; i >= 0; --i)
+    {
+        --it;
+        assert(number_expected(it->child("id"), i));
+    }
+    assert(it == values.begin());
+
+    json::const_node keys = root.child("keys");
+    assert(keys.child_count() == 100);
+    assert(keys.keys().size() == 100);
+    assert(keys.key(42) == "key42");
+    assert(number_expected(keys.child("key73"), 73.0));
+    assert(number_expected(keys.child(5), 5.0));
+    assert(!keys.has_key("key100"));
+
+    try
+    {
+        keys.child("key100");
+        assert(!"document_error was expected to be thrown");
+    }
+    catch (const json::document_error&)
+    {
+        // expected
+    }
+
+    try
+    {
+        keys.child(100);
+        assert(!"std::out_of_range was expected to be thrown");
+    }
+    catch (const std::out_of_range&)
+    {
+        // expected
+    }
+
+    // The storage is read-only.
+    json::node mroot = doc.get_document_root();
+    try
+    {
+        mroot["new"] = 1.0;
+        assert(!"document_error was expected to be thrown");
+    }
+    catch (const json::document_error&)
+    {
+        // expected
+    }
+
+    // Duplicate keys are detected in both small and large objects.
+    const char* invalid_strms[] = {
+        "{\"a\": 1, \"b\": 2, \"a\": 3}",
+        "{\"k0\": 0, \"k1\": 1, \"k2\": 2, \"k3\": 3, \"k4\": 4, \"k5\": 5, \"k6\": 6, \"k7\": 7, \"k8\": 8, "
+        "\"k9\": 9, \"k10\": 10, \"k11\": 11, \"k12\": 12, \"k13\": 13, \"k14\": 14, \"k15\": 15, \"k16\": 16, "
+        "\"k17\": 17, \"k18\": 18, \"k3\": 19}",
+    };
+
+    for (const char* invalid_strm : invalid_strms)
+    {
+        try
+        {
+            json::document_tree invalid_doc;
+            invalid_doc.load(invalid_strm, config);
+            assert(!"document_error was expected to be thrown");
+        }
+        catch (const json::document_error&)
+        {
+            // expected
+        }
+    }
+}
+
+void test_json_tape_storage()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    verify_read_only_storage(json_config::storage_type::tape);
+}
+
+void test_json_lazy_storage()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    verify_read_only_storage(json_config::storage_type::lazy);
+
+    json_config config;
+    config.storage = json_config::storage_type::lazy;
+    config.persistent_string_values = false;
+
+    // The error inside the nested array is only detected when the array gets
+    // navigated into.
+    std::string strm = "{\"good\": [1, \"two\", {\"three\": 3}], \"bad\": [1, 2 3]}";
+
+    json::document_tree doc;
+    doc.load(strm, config);
+
+    json::const_node root = doc.get_document_root();
+    assert(root.child_count() == 2);
+    json::const_node good = root.child("good");
+    assert(good.child_count() == 3);
+    assert(number_expected(good.child(0), 1.0));
+    assert(string_expected(good.child(1), "two"));
+    assert(number_expected(good.child(2).child("three"), 3.0));
+
+    // The string value points into the original stream.
+    std::string_view sv = good.child(1).string_value();
+    assert(strm.data() <= sv.data() && sv.data() < strm.data() + strm.size());
+
+    json::const_node bad = root.child("bad");
+    assert(bad.type() == json::node_t::array);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        try
+        {
+            bad.child_count();
+            assert(!"parse_error was expected to be thrown");
+        }
+        catch (const parse_error& e)
+        {
+            assert(e.offset() == std::ptrdiff_t(strm.find("3]")));
+        }
+    }
+
+    // Brackets that don't match are detected up front.
+    const char* invalid_strms[] = {
+        "[1, 2",
+        "{\"a\": [1, 2}",
+        "[1, \"]\"",
+        "[1] 2",
+    };
+
+    for (const char* invalid_strm : invalid_strms)
+    {
+        try
+        {
+            json::document_tree invalid_doc;
+            invalid_doc.load(invalid_strm, config);
+            assert(!"parse_error was expected to be thrown");
+        }
+        catch (const parse_error&)
+        {
+            // expected
+        }
+    }
+}
+
+void test_json_threaded_load()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    for (auto storage : { json_config::storage_type::tree, json_config::storage_type::tape })
+    {
+        json_config test_config;
+        test_config.storage = storage;
+        test_config.use_threads = true;
+
+        // Keep the token size thresholds small so that the tokens get handed
+        // over many times.
+        test_config.min_token_size = 1;
+        test_config.max_token_size = 4;
+
+        for (const auto& basedir : json_test_dirs)
+            verify_input(test_config, basedir);
+
+        // The strings with escaped characters are stored in the pool of the
+        // parser thread, and must outlive it.
+        test_config.persistent_string_values = false;
+        std::string strm = "{\"a\\\"b\": \"c\\nd\", \"plain\": [1, 2, 3]}";
+
+        json::document_tree doc;
+        assert(!doc.get_parser_stats());
+        doc.load(strm, test_config);
+
+        auto stats = doc.get_parser_stats();
+        assert(stats);
+        assert(stats->token_buffer_size_threshold > 0);
+
+        json::const_node root = doc.get_document_root();
+        assert(root.key(0) == "a\"b");
+        assert(string_expected(root.child("a\"b"), "c\nd"));
+        assert(root.child("plain").child_count() == 3);
+
+        // An error from the handler must stop the parser thread.
+        std::string dup_strm = "[{\"a\": 1, \"a\": 2}";
+        for (int i = 0; i < 1000; ++i)
+            dup_strm += ", 1";
+        dup_strm += "]";
+
+        try
+        {
+            json::document_tree dup_doc;
+            dup_doc.load(dup_strm, test_config);
+            assert(!"document_error was expected to be thrown");
+        }
+        catch (const json::document_error&)
+        {
+            // expected
+        }
+
+        try
+        {
+            json::document_tree invalid_doc;
+            invalid_doc.load("[1, 2, 3,, 4]", test_config);
+            assert(!"parse_error was expected to be thrown");
+        }
+        catch (const parse_error& e)
+        {
+            assert(e.offset() == 9);
+        }
+
+        // The statistics are only available after a threaded load.
+        test_config.use_threads = false;
+        doc.load(strm, test_config);
+        assert(!doc.get_parser_stats());
+    }
+}
+
 int main()
 {
     try
@@ -1102,6 +1405,9 @@ int main()
         test_json_dump_subtree();
 
         test_json_subtree();
+        test_json_tape_storage();
+        test_json_lazy_storage();
+        test_json_threaded_load();
     }
     catch (const orcus::general_error& e)
     {
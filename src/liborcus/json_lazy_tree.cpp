@@ -0,0 +1,494 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "json_lazy_tree.hpp"
+
+#include <orcus/config.hpp>
+#include <orcus/exception.hpp>
+#include <orcus/parser_global.hpp>
+#include <orcus/string_pool.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <unordered_set>
+
+namespace orcus { namespace json {
+
+namespace {
+
+/**
+ * Objects with this many members or fewer are always scanned linearly.
+ */
+constexpr std::size_t linear_scan_limit = 16;
+
+bool is_ws(char c)
+{
+    switch (c)
+    {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+            return true;
+        default:
+            ;
+    }
+
+    return false;
+}
+
+void skip_ws(const char*& p, const char* p_end)
+{
+    while (p != p_end && is_ws(*p))
+        ++p;
+}
+
+bool is_value_end(char c)
+{
+    switch (c)
+    {
+        case ',':
+        case ']':
+        case '}':
+            return true;
+        default:
+            ;
+    }
+
+    return is_ws(c);
+}
+
+} // anonymous namespace
+
+lazy_tree::lazy_tree() = default;
+lazy_tree::~lazy_tree() = default;
+
+void lazy_tree::load(std::string_view stream, const json_config& config, string_pool& pool)
+{
+    if (config.resolve_references)
+        throw document_error("resolving external references is not supported with the lazy storage");
+
+    std::lock_guard lock(m_mtx);
+
+    m_nodes.clear();
+    m_key_indices.clear();
+    m_spans.clear();
+    mp_pool = &pool;
+
+    if (config.persistent_string_values)
+    {
+        m_buffer = stream;
+        m_stream = m_buffer;
+    }
+    else
+    {
+        m_buffer.clear();
+        m_stream = stream;
+    }
+
+    build_index();
+
+    const char* p0 = m_stream.data();
+    const char* p = p0;
+    const char* p_end = p + m_stream.size();
+
+    skip_ws(p, p_end);
+    if (p == p_end)
+        throw parse_error("parse: no json content could be found in file", p - p0);
+
+    try
+    {
+        parse_value(p, p_end, npos, std::string_view{});
+
+        // The root container is always navigated into, so parse its children
+        // up front for its errors to surface at load time.
+        if (m_nodes[0].type == node_t::object || m_nodes[0].type == node_t::array)
+            load_children(0);
+    }
+    catch (...)
+    {
+        m_nodes.clear();
+        throw;
+    }
+
+    skip_ws(p, p_end);
+    if (p != p_end)
+    {
+        m_nodes.clear();
+        throw parse_error("parse: unexpected trailing string segment.", p - p0);
+    }
+}
+
+bool lazy_tree::empty() const
+{
+    std::lock_guard lock(m_mtx);
+    return m_nodes.empty();
+}
+
+node_t lazy_tree::type(size_type pos) const
+{
+    std::lock_guard lock(m_mtx);
+    return m_nodes[pos].type;
+}
+
+std::string_view lazy_tree::string_value(size_type pos) const
+{
+    std::lock_guard lock(m_mtx);
+    const node& nd = m_nodes[pos];
+    return {nd.value.str, nd.size};
+}
+
+double lazy_tree::numeric_value(size_type pos) const
+{
+    std::lock_guard lock(m_mtx);
+    return m_nodes[pos].value.numeric;
+}
+
+lazy_tree::size_type lazy_tree::child_count(size_type pos) const
+{
+    std::lock_guard lock(m_mtx);
+
+    switch (m_nodes[pos].type)
+    {
+        case node_t::object:
+        case node_t::array:
+            return get_loaded(pos).size;
+        default:
+            ;
+    }
+
+    return 0;
+}
+
+lazy_tree::size_type lazy_tree::child(size_type pos, size_type index) const
+{
+    std::lock_guard lock(m_mtx);
+    const node& nd = get_loaded(pos);
+    return index < nd.size ? nd.first + index : npos;
+}
+
+lazy_tree::size_type lazy_tree::child(size_type pos, std::string_view key) const
+{
+    std::lock_guard lock(m_mtx);
+    const node& nd = get_loaded(pos);
+    assert(nd.type == node_t::object);
+
+    if (nd.size > linear_scan_limit)
+    {
+        auto it = m_key_indices.find(pos);
+        assert(it != m_key_indices.end());
+        const key_index_type& index = *it->second;
+        auto it_key = index.find(key);
+        return it_key == index.end() ? npos : it_key->second;
+    }
+
+    for (size_type i = 0; i < nd.size; ++i)
+    {
+        if (m_nodes[nd.first + i].key == key)
+            return nd.first + i;
+    }
+
+    return npos;
+}
+
+std::string_view lazy_tree::key(size_type pos, size_type index) const
+{
+    std::lock_guard lock(m_mtx);
+    const node& nd = get_loaded(pos);
+    assert(index < nd.size);
+    return m_nodes[nd.first + index].key;
+}
+
+lazy_tree::size_type lazy_tree::parent(size_type pos) const
+{
+    std::lock_guard lock(m_mtx);
+    return m_nodes[pos].parent;
+}
+
+uintptr_t lazy_tree::identity(size_type pos) const
+{
+    // The nodes never move once created.
+    std::lock_guard lock(m_mtx);
+    return reinterpret_cast<uintptr_t>(&m_nodes[pos]);
+}
+
+lazy_tree::size_type lazy_tree::loaded_count() const
+{
+    std::lock_guard lock(m_mtx);
+    return m_nodes.size();
+}
+
+const lazy_tree::node& lazy_tree::get_loaded(size_type pos) const
+{
+    const node& nd = m_nodes[pos];
+    if (!nd.loaded)
+        load_children(pos);
+
+    return nd;
+}
+
+void lazy_tree::load_children(size_type pos) const
+{
+    node& nd = m_nodes[pos];
+    assert(nd.type == node_t::object || nd.type == node_t::array);
+    assert(!nd.loaded);
+
+    bool object = nd.type == node_t::object;
+    size_type first = m_nodes.size();
+
+    const char* p0 = m_stream.data();
+    const char* p = p0 + nd.value.offset + 1;
+    const char* p_end = p0 + find_closing_offset(nd.value.offset);
+
+    try
+    {
+        skip_ws(p, p_end);
+
+        while (p != p_end)
+        {
+            std::string_view key;
+
+            if (object)
+            {
+                if (*p != '"')
+                    parse_error::throw_with("object: '\"' was expected, but '", *p, "' found.", p - p0);
+
+                key = parse_string(p, p_end);
+
+                skip_ws(p, p_end);
+                if (p == p_end || *p != ':')
+                    throw parse_error("object: ':' was expected.", p - p0);
+
+                ++p;
+                skip_ws(p, p_end);
+                if (p == p_end)
+                    throw parse_error("object: stream ended prematurely before reaching a value.", p - p0);
+            }
+
+            parse_value(p, p_end, pos, key);
+
+            skip_ws(p, p_end);
+            if (p == p_end)
+                break;
+
+            if (*p != ',')
+                parse_error::throw_with("either ',' or a closing bracket expected, but '", *p, "' found.", p - p0);
+
+            ++p;
+            skip_ws(p, p_end);
+            if (p == p_end)
+                throw parse_error("a value was expected after ','.", p - p0);
+        }
+
+        size_type count = m_nodes.size() - first;
+        if (count > std::numeric_limits<std::uint32_t>::max())
+            throw document_error("too many child values for the lazy storage");
+
+        nd.first = first;
+        nd.size = count;
+
+        if (object)
+            check_duplicate_keys(pos);
+    }
+    catch (...)
+    {
+        // Discard the children parsed so far, to leave the container unloaded.
+        m_nodes.resize(first);
+        m_key_indices.erase(pos);
+        nd.size = 0;
+        throw;
+    }
+
+    nd.loaded = true;
+}
+
+void lazy_tree::parse_value(const char*& p, const char* p_end, size_type parent, std::string_view key) const
+{
+    const char* p0 = m_stream.data();
+    assert(p != p_end);
+
+    node nd;
+    nd.parent = parent;
+    nd.key = key;
+
+    switch (*p)
+    {
+        case '{':
+        case '[':
+        {
+            nd.type = *p == '{' ? node_t::object : node_t::array;
+            nd.value.offset = p - p0;
+            p = p0 + find_closing_offset(nd.value.offset) + 1;
+            break;
+        }
+        case '"':
+        {
+            std::string_view s = parse_string(p, p_end);
+            if (s.size() > std::numeric_limits<std::uint32_t>::max())
+                throw document_error("string value is too long for the lazy storage");
+
+            nd.type = node_t::string;
+            nd.size = s.size();
+            nd.value.str = s.data();
+            break;
+        }
+        default:
+        {
+            const char* p_token = p;
+            while (p != p_end && !is_value_end(*p))
+                ++p;
+
+            std::string_view token(p_token, p - p_token);
+
+            if (token == "true")
+                nd.type = node_t::boolean_true;
+            else if (token == "false")
+                nd.type = node_t::boolean_false;
+            else if (token == "null")
+                nd.type = node_t::null;
+            else
+            {
+                double v = 0.0;
+                const char* p_parsed = token.empty() ? nullptr : parse_numeric(p_token, p, v);
+                if (p_parsed != p || std::isnan(v))
+                    parse_error::throw_with("value: failed to parse '", token, "'.", p_token - p0);
+
+                nd.type = node_t::number;
+                nd.value.numeric = v;
+            }
+        }
+    }
+
+    m_nodes.push_back(nd);
+}
+
+std::string_view lazy_tree::parse_string(const char*& p, const char* p_end) const
+{
+    assert(*p == '"');
+    const char* p0 = m_stream.data();
+    std::ptrdiff_t offset = p - p0;
+
+    parse_quoted_string_state res = parse_double_quoted_string(p, p_end - p, m_cell_buffer);
+    if (!res.str)
+    {
+        switch (res.length)
+        {
+            case parse_quoted_string_state::error_no_closing_quote:
+                throw parse_error("parse_string: stream ended prematurely before reaching the closing quote", offset);
+            case parse_quoted_string_state::error_illegal_escape_char:
+                throw parse_error("parse_string: illegal escape character", offset);
+            case parse_quoted_string_state::error_invalid_hex_digits:
+                throw parse_error("parse_string: hex digits in escaped surrogate is invalid", offset);
+            default:
+                throw parse_error("parse_string: unknown error while parsing a string value", offset);
+        }
+    }
+
+    if (res.has_control_character)
+        throw parse_error("parse_string: string contains at least one unescaped control character", offset);
+
+    std::string_view s(res.str, res.length);
+    if (res.transient)
+        s = mp_pool->intern(s).first;
+
+    return s;
+}
+
+lazy_tree::size_type lazy_tree::find_closing_offset(size_type offset) const
+{
+    auto it = std::lower_bound(
+        m_spans.begin(), m_spans.end(), offset,
+        [](const std::pair<size_type, size_type>& span, size_type v) { return span.first < v; }
+    );
+
+    assert(it != m_spans.end() && it->first == offset);
+    return it->second;
+}
+
+void lazy_tree::build_index()
+{
+    const char* p0 = m_stream.data();
+    const char* p_end = p0 + m_stream.size();
+
+    // Positions of the open containers in m_spans.
+    std::vector<size_type> stack;
+
+    for (const char* p = p0; p != p_end; ++p)
+    {
+        switch (*p)
+        {
+            case '"':
+            {
+                const char* p_close = parse_to_closing_double_quote(p, p_end - p);
+                if (!p_close)
+                    throw parse_error("stream ended prematurely before reaching the closing quote", p - p0);
+
+                p = p_close - 1;
+                break;
+            }
+            case '{':
+            case '[':
+                stack.push_back(m_spans.size());
+                m_spans.emplace_back(p - p0, npos);
+                break;
+            case '}':
+            case ']':
+            {
+                char expected = *p == '}' ? '{' : '[';
+                if (stack.empty() || p0[m_spans[stack.back()].first] != expected)
+                    parse_error::throw_with("unexpected closing bracket '", *p, "' found.", p - p0);
+
+                m_spans[stack.back()].second = p - p0;
+                stack.pop_back();
+                break;
+            }
+            default:
+                ;
+        }
+    }
+
+    if (!stack.empty())
+        throw parse_error("stream ended prematurely before reaching the closing bracket", m_stream.size());
+}
+
+void lazy_tree::check_duplicate_keys(size_type pos) const
+{
+    const node& nd = m_nodes[pos];
+
+    if (nd.size <= linear_scan_limit)
+    {
+        for (size_type i = 1; i < nd.size; ++i)
+        {
+            for (size_type j = 0; j < i; ++j)
+            {
+                if (m_nodes[nd.first + i].key == m_nodes[nd.first + j].key)
+                    throw document_error("adding the same key twice");
+            }
+        }
+
+        return;
+    }
+
+    // Build the key index of a large object up front, which is needed for
+    // the lookups by key anyway.
+    auto index = std::make_unique<key_index_type>();
+    index->reserve(nd.size);
+
+    for (size_type i = 0; i < nd.size; ++i)
+    {
+        auto r = index->emplace(m_nodes[nd.first + i].key, nd.first + i);
+        if (!r.second)
+            throw document_error("adding the same key twice");
+    }
+
+    m_key_indices.insert_or_assign(pos, std::move(index));
+}
+
+}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,153 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "json_node_store.hpp"
+
+#include <orcus/cell_buffer.hpp>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace orcus {
+
+struct json_config;
+class string_pool;
+
+namespace json {
+
+/**
+ * Storage of a JSON document that keeps the source stream, and parses the
+ * children of a container only when the container is first navigated into.
+ *
+ * Loading a stream only records the offsets of the opening and closing
+ * brackets of all containers, which allows skipping over a nested container
+ * without parsing it.  Errors in the part of the stream that has not been
+ * navigated into are detected only when it gets navigated into.
+ *
+ * All access is serialized by a mutex, since any access may parse more of
+ * the stream.
+ */
+class lazy_tree : public node_store
+{
+public:
+    lazy_tree();
+    lazy_tree(const lazy_tree&) = delete;
+    lazy_tree& operator=(const lazy_tree&) = delete;
+    ~lazy_tree() override;
+
+    /**
+     * Index the structure of a JSON stream, and parse its root value along
+     * with the direct children of the root.
+     *
+     * @param stream JSON stream.  It gets copied when the config specifies
+     *               persistent string values.  Otherwise the caller must
+     *               keep it alive for the life time of this instance.
+     * @param config configuration, for the handling of the string values.
+     *               Resolving external references is not supported.
+     * @param pool string pool to store the strings that have escaped
+     *             characters.
+     */
+    void load(std::string_view stream, const json_config& config, string_pool& pool);
+
+    bool empty() const override;
+
+    node_t type(size_type pos) const override;
+
+    std::string_view string_value(size_type pos) const override;
+
+    double numeric_value(size_type pos) const override;
+
+    size_type child_count(size_type pos) const override;
+
+    size_type child(size_type pos, size_type index) const override;
+
+    size_type child(size_type pos, std::string_view key) const override;
+
+    std::string_view key(size_type pos, size_type index) const override;
+
+    size_type parent(size_type pos) const override;
+
+    uintptr_t identity(size_type pos) const override;
+
+    /**
+     * @return number of values parsed so far.
+     */
+    size_type loaded_count() const;
+
+private:
+    struct node
+    {
+        node_t type = node_t::unset;
+
+        /** Whether or not the children of a container have been parsed. */
+        bool loaded = false;
+
+        /** Length of a string, or the number of children of a loaded container. */
+        std::uint32_t size = 0;
+
+        size_type parent = npos;
+
+        /** Key of an object member. */
+        std::string_view key;
+
+        union
+        {
+            double numeric;
+            const char* str;
+
+            /** Offset of the opening bracket of a container in the stream. */
+            size_type offset;
+
+        } value;
+
+        /** Position of the first child of a loaded container. */
+        size_type first = 0;
+    };
+
+    using key_index_type = std::unordered_map<std::string_view, size_type>;
+
+    void load_children(size_type pos) const;
+
+    /**
+     * Parse a value starting at the current position and append it as a new
+     * node.
+     */
+    void parse_value(const char*& p, const char* p_end, size_type parent, std::string_view key) const;
+
+    std::string_view parse_string(const char*& p, const char* p_end) const;
+
+    size_type find_closing_offset(size_type offset) const;
+
+    void build_index();
+
+    void check_duplicate_keys(size_type pos) const;
+
+    const node& get_loaded(size_type pos) const;
+
+    std::string m_buffer;
+    std::string_view m_stream;
+    string_pool* mp_pool = nullptr;
+
+    /** Offsets of the opening and closing brackets of all containers in document order. */
+    std::vector<std::pair<size_type, size_type>> m_spans;
+
+    mutable std::mutex m_mtx;
+    mutable std::deque<node> m_nodes;
+    mutable std::unordered_map<size_type, std::unique_ptr<key_index_type>> m_key_indices;
+    mutable cell_buffer m_cell_buffer;
+};
+
+}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,78 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <orcus/json_document_tree.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+namespace orcus { namespace json {
+
+/**
+ * Read-only storage of a JSON document other than the tree of nodes.  Each
+ * value in the storage is referenced by its position, and the root value is
+ * always at position 0.
+ */
+class node_store
+{
+public:
+    using size_type = std::size_t;
+
+    static constexpr size_type npos = std::numeric_limits<size_type>::max();
+
+    virtual ~node_store() = default;
+
+    virtual bool empty() const = 0;
+
+    virtual node_t type(size_type pos) const = 0;
+
+    virtual std::string_view string_value(size_type pos) const = 0;
+
+    virtual double numeric_value(size_type pos) const = 0;
+
+    virtual size_type child_count(size_type pos) const = 0;
+
+    /**
+     * Get the position of a child value of a container by its index.
+     *
+     * @return position of the child value, or npos if the index is out of
+     *         range.
+     */
+    virtual size_type child(size_type pos, size_type index) const = 0;
+
+    /**
+     * Get the position of a child value of an object by its key.
+     *
+     * @return position of the child value, or npos if the object doesn't
+     *         have the key.
+     */
+    virtual size_type child(size_type pos, std::string_view key) const = 0;
+
+    /**
+     * Get the key of an object member by its index.  It assumes that the
+     * index is within range.
+     */
+    virtual std::string_view key(size_type pos, size_type index) const = 0;
+
+    /**
+     * Get the position of the parent container of a value, or npos if the
+     * value is the root.
+     */
+    virtual size_type parent(size_type pos) const = 0;
+
+    /**
+     * Get a value that uniquely identifies a value in the storage.
+     */
+    virtual uintptr_t identity(size_type pos) const = 0;
+};
+
+}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
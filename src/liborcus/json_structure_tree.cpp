@@ -8,6 +8,8 @@
 #include <orcus/json_structure_tree.hpp>
 #include <orcus/json_parser.hpp>
 #include <orcus/string_pool.hpp>
+#include <orcus/config.hpp>
+#include <orcus/parser_global.hpp>
 
 #include "json_structure_mapper.hpp"
 
@@ -16,6 +18,8 @@
 #include <algorithm>
 #include <map>
 #include <functional>
+#include <future>
+#include <optional>
 
 #include <boost/pool/object_pool.hpp>
 
@@ -72,6 +76,19 @@ struct structure_node
      */
     array_positions_type array_positions;
 
+    /**
+     * For a value node that is an immediate child of an array node, the
+     * position of the parent array at which the value first occurs.
+     */
+    int32_t first_array_position = -1;
+
+    /**
+     * For an array node, the positions at which non-value child nodes
+     * occur.  These are only recorded when building a tree to be merged
+     * with another one.
+     */
+    std::vector<bool> non_value_positions;
+
     structure_node(node_type _type) : type(_type) {}
 
     bool operator== (const structure_node& other) const
@@ -173,6 +190,112 @@ structure_tree::node_properties to_node_properties(const structure_node& sn)
 
 void empty_callback(std::any) {}
 
+/**
+ * Thrown by the handler to stop parsing once the scan limit has been
+ * reached.
+ */
+struct scan_stopped {};
+
+/**
+ * JSON parser that lets the handler query the current offset in the stream.
+ */
+template<typename HandlerT>
+class structure_parser : public json_parser<HandlerT>
+{
+public:
+    using json_parser<HandlerT>::json_parser;
+    using json_parser<HandlerT>::offset;
+};
+
+/**
+ * Begin and end positions of a member of an array in a JSON stream.
+ */
+using member_span = std::pair<std::size_t, std::size_t>;
+
+/**
+ * Locate the members of the root array of a JSON stream.  This only tracks
+ * the nesting of the brackets and the strings, and leaves the full
+ * validation of each member to the parser.
+ *
+ * @return spans of the members of the root array, or std::nullopt if the
+ *         root is not a non-empty array, or the stream is not well-formed
+ *         at the root level.
+ */
+std::optional<std::vector<member_span>> scan_root_array(std::string_view s)
+{
+    const char* p0 = s.data();
+    const char* p = p0;
+    const char* p_end = p0 + s.size();
+
+    auto skip_ws = [&p, p_end]()
+    {
+        while (p != p_end && is_blank(*p))
+            ++p;
+    };
+
+    skip_ws();
+    if (p == p_end || *p != '[')
+        return std::nullopt;
+
+    std::vector<member_span> spans;
+
+    for (++p; ; ++p)
+    {
+        skip_ws();
+        const char* p_member = p;
+        std::size_t depth = 0;
+
+        for (; p != p_end; ++p)
+        {
+            char c = *p;
+
+            if (c == '"')
+            {
+                const char* p_close = parse_to_closing_double_quote(p, p_end - p);
+                if (!p_close)
+                    return std::nullopt;
+
+                p = p_close - 1;
+            }
+            else if (c == '[' || c == '{')
+                ++depth;
+            else if (c == ']' || c == '}')
+            {
+                if (!depth)
+                    break;
+                --depth;
+            }
+            else if (c == ',' && !depth)
+                break;
+        }
+
+        if (p == p_end)
+            return std::nullopt;
+
+        const char* p_member_end = p;
+        while (p_member_end != p_member && is_blank(p_member_end[-1]))
+            --p_member_end;
+
+        if (p_member == p_member_end)
+            return std::nullopt;
+
+        spans.emplace_back(p_member - p0, p_member_end - p0);
+
+        if (*p == ']')
+            break;
+
+        if (*p != ',')
+            return std::nullopt;
+    }
+
+    ++p;
+    skip_ws();
+    if (p != p_end)
+        return std::nullopt;
+
+    return spans;
+}
+
 } // anonymous namespace
 
 struct structure_tree::impl
@@ -184,9 +307,124 @@ struct structure_tree::impl
 
     structure_tree::callback_handler_type m_cb_on_repeat = empty_callback;
 
+    const structure_parser<impl>* mp_parser = nullptr;
+    std::size_t m_max_stale_count = 0;
+    std::size_t m_max_bytes = 0;
+
+    /** Number of nodes in a row that have not added anything new. */
+    std::size_t m_stale_count = 0;
+
+    /**
+     * When true, record all array positions of the value nodes along with
+     * the positions of the non-value nodes, for the tree to be merged with
+     * the trees built from the subsequent ranges of the same stream.
+     */
+    bool m_merge_positions = false;
+
+    bool m_exhaustive = false;
+
     impl() : m_root(nullptr) {}
     ~impl() {}
 
+    void parse(std::string_view stream, const structure_scan_config& config)
+    {
+        structure_parser<impl> parser(stream, *this);
+        mp_parser = &parser;
+        m_max_stale_count = config.max_stale_count;
+        m_max_bytes = config.max_bytes;
+        m_stale_count = 0;
+        m_exhaustive = false;
+
+        try
+        {
+            parser.parse();
+            m_exhaustive = true;
+        }
+        catch (const scan_stopped&)
+        {
+            unwind_stack();
+        }
+
+        mp_parser = nullptr;
+    }
+
+    /**
+     * Scan the members of the root array in contiguous ranges on multiple
+     * threads, and merge the results.
+     *
+     * @return false if the root is not an array, or any of the ranges fails
+     *         to parse, in which case the stream should be parsed
+     *         sequentially.
+     */
+    bool parse_parallel(std::string_view stream, const structure_scan_config& config)
+    {
+        if (m_root)
+            // only an empty tree can be built from ranges
+            return false;
+
+        std::optional<std::vector<member_span>> spans = scan_root_array(stream);
+        if (!spans)
+            return false;
+
+        // Only scan the members that start within the byte limit.
+        std::size_t n = spans->size();
+        if (config.max_bytes)
+        {
+            n = std::lower_bound(
+                spans->begin(), spans->end(), config.max_bytes,
+                [](const member_span& span, std::size_t pos) { return span.first < pos; }
+            ) - spans->begin();
+        }
+
+        std::size_t n_threads = std::min(config.thread_count, n);
+        std::vector<std::future<std::unique_ptr<impl>>> futures;
+
+        for (std::size_t i = 0; i < n_threads; ++i)
+        {
+            std::size_t first = n * i / n_threads;
+            std::size_t last = n * (i + 1) / n_threads;
+
+            futures.push_back(
+                std::async(
+                    std::launch::async, scan_members, stream, std::cref(*spans), first, last,
+                    config.max_stale_count));
+        }
+
+        std::vector<std::unique_ptr<impl>> trees;
+        bool failed = false;
+
+        for (auto& f : futures)
+        {
+            try
+            {
+                trees.push_back(f.get());
+            }
+            catch (const std::exception&)
+            {
+                failed = true;
+            }
+        }
+
+        if (failed)
+            return false;
+
+        bool exhaustive = n == spans->size();
+        m_root = m_node_store.construct(node_type::array);
+
+        for (auto& tree : trees)
+        {
+            merge_node(*m_root, *tree->m_root);
+            m_pool.merge(tree->m_pool);
+            exhaustive = exhaustive && tree->m_exhaustive;
+        }
+
+        finalize_positions(*m_root);
+        notify_repeats(*m_root);
+
+        m_exhaustive = exhaustive;
+        return true;
+    }
+
     void begin_parse() {}
 
     void end_parse() {}
@@ -337,6 +575,156 @@ struct structure_tree::impl
 
 private:
 
+    /**
+     * Build a tree from a range of the members of the root array.
+     */
+    static std::unique_ptr<impl> scan_members(
+        std::string_view stream, const std::vector<member_span>& spans,
+        std::size_t first, std::size_t last, std::size_t max_stale_count)
+    {
+        auto tree = std::make_unique<impl>();
+        tree->m_merge_positions = true;
+        tree->m_max_stale_count = max_stale_count;
+        tree->m_root = tree->m_node_store.construct(node_type::array);
+        tree->m_stack.emplace_back(*tree->m_root);
+
+        // Array positions are counted from the first member of the range.
+        tree->m_stack.back().child_count = first;
+
+        try
+        {
+            for (; first < last; ++first)
+            {
+                const member_span& span = spans[first];
+                json_parser<impl> parser(stream.substr(span.first, span.second - span.first), *tree);
+                parser.parse();
+            }
+
+            tree->m_exhaustive = true;
+        }
+        catch (const scan_stopped&)
+        {
+        }
+
+        tree->unwind_stack();
+        return tree;
+    }
+
+    /**
+     * Merge a node of a tree built from a subsequent range of the same
+     * stream into a node of this tree.
+     */
+    void merge_node(structure_node& dst, const structure_node& src)
+    {
+        dst.child_count = std::max(dst.child_count, src.child_count);
+
+        if (dst.type == node_type::array)
+        {
+            // Array positions taken by non-value nodes in the subsequent
+            // range are not always values.
+            for (structure_node* child : dst.children)
+            {
+                if (child->type != node_type::value)
+                    continue;
+
+                for (auto& [pos, valid] : child->array_positions)
+                {
+                    if (std::size_t(pos) < src.non_value_positions.size() && src.non_value_positions[pos])
+                        valid = false;
+                }
+            }
+        }
+
+        for (const structure_node* src_child : src.children)
+        {
+            auto it = std::find_if(dst.children.begin(), dst.children.end(),
+                [src_child](const structure_node* p) -> bool
+                {
+                    return *p == *src_child;
+                }
+            );
+
+            structure_node* child = nullptr;
+
+            if (it == dst.children.end())
+            {
+                child = m_node_store.construct(src_child->type);
+                child->name = src_child->name;
+                child->repeat = src_child->repeat;
+                dst.children.push_back(child);
+            }
+            else
+            {
+                child = *it;
+                bool repeatable = dst.type == node_type::array &&
+                    (child->type == node_type::array || child->type == node_type::object);
+                child->repeat = child->repeat || src_child->repeat || repeatable;
+            }
+
+            merge_node(*child, *src_child);
+        }
+
+        // Values recorded earlier at the same positions take precedence.
+        dst.array_positions.insert(src.array_positions.begin(), src.array_positions.end());
+
+        if (dst.first_array_position < 0)
+            dst.first_array_position = src.first_array_position;
+
+        if (dst.non_value_positions.size() < src.non_value_positions.size())
+            dst.non_value_positions.resize(src.non_value_positions.size());
+
+        for (std::size_t i = 0; i < src.non_value_positions.size(); ++i)
+        {
+            if (src.non_value_positions[i])
+                dst.non_value_positions[i] = true;
+        }
+    }
+
+    /**
+     * Drop the array positions that come before the first position of each
+     * value node, which a sequential parse would not record.
+     */
+    void finalize_positions(structure_node& node)
+    {
+        if (node.first_array_position >= 0)
+        {
+            auto& aps = node.array_positions;
+            aps.erase(aps.begin(), aps.lower_bound(node.first_array_position));
+        }
+
+        node.non_value_positions.clear();
+        node.non_value_positions.shrink_to_fit();
+
+        for (structure_node* child : node.children)
+            finalize_positions(*child);
+    }
+
+    void notify_repeats(const structure_node& node)
+    {
+        for (const structure_node* child : node.children)
+        {
+            if (child->repeat)
+                m_cb_on_repeat(child->type);
+
+            notify_repeats(*child);
+        }
+    }
+
+    /**
+     * Pop all remaining scopes after the parsing has stopped early.
+     */
+    void unwind_stack()
+    {
+        while (!m_stack.empty())
+        {
+            parse_scope& cur_scope = m_stack.back();
+            if (cur_scope.child_count > cur_scope.node.child_count)
+                cur_scope.node.child_count = cur_scope.child_count;
+
+            m_stack.pop_back();
+        }
+    }
+
     parse_scope& get_current_scope()
     {
         assert(!m_stack.empty());
@@ -364,6 +752,18 @@ private:
             return;
         }
 
+        if (m_max_bytes && mp_parser && std::size_t(mp_parser->offset()) >= m_max_bytes)
+            throw scan_stopped();
+
+        ++m_stale_count;
+        push_child(node);
+
+        if (m_max_stale_count && m_stale_count >= m_max_stale_count)
+            throw scan_stopped();
+    }
+
+    void push_child(const structure_node& node)
+    {
         parse_scope& cur_scope = get_current_scope();
         structure_node& cur_node = cur_scope.node;
 
@@ -378,6 +778,13 @@ private:
 
             if (node.type != node_type::value)
             {
+                if (m_merge_positions)
+                {
+                    if (cur_node.non_value_positions.size() <= std::size_t(array_pos))
+                        cur_node.non_value_positions.resize(array_pos + 1);
+                    cur_node.non_value_positions[array_pos] = true;
+                }
+
                 // See if this array has a child value node.
                 auto it = std::find_if(
                     cur_node.children.begin(), cur_node.children.end(),
@@ -415,6 +822,7 @@ private:
                 // current node doesn't have a child of specified type.  Add one.
                 cur_node.children.push_back(m_node_store.construct(node));
                 m_stack.emplace_back(*cur_node.children.back());
+                m_stale_count = 0;
             }
             else
             {
@@ -431,9 +839,16 @@ private:
 
         if (array_pos >= 0)
         {
-            array_positions_type& aps = m_stack.back().node.array_positions;
+            structure_node& value_node = m_stack.back().node;
+            array_positions_type& aps = value_node.array_positions;
             int32_t min_pos = aps.empty() ? 0 : aps.begin()->first;
-            if (array_pos >= min_pos)
+
+            if (value_node.first_array_position < 0)
+                value_node.first_array_position = array_pos;
+
+            // All positions get recorded when the tree is to be merged, and
+            // the positions before the first one get dropped after the merge.
+            if (array_pos >= min_pos || m_merge_positions)
             {
                 auto it = aps.lower_bound(array_pos);
 
@@ -442,6 +857,7 @@ private:
                     // Insert a new array child node of unspecified type at the specified position.
                     aps.insert(
                         it, array_positions_type::value_type(array_pos, true));
+                    m_stale_count = 0;
                 }
             }
         }
@@ -683,8 +1099,20 @@ void structure_tree::set_callback(callback_type type, callback_handler_type call
 
 void structure_tree::parse(std::string_view stream)
 {
-    json_parser<impl> parser(stream, *mp_impl);
-    parser.parse();
+    mp_impl->parse(stream, structure_scan_config());
+}
+
+void structure_tree::parse(std::string_view stream, const structure_scan_config& config)
+{
+    if (config.thread_count > 1 && mp_impl->parse_parallel(stream, config))
+        return;
+
+    mp_impl->parse(stream, config);
+}
+
+bool structure_tree::is_exhaustive() const
+{
+    return mp_impl->m_exhaustive;
 }
 
 void structure_tree::normalize_tree()
@@ -9,9 +9,11 @@
 #include <orcus/json_structure_tree.hpp>
 #include <orcus/stream.hpp>
 #include <orcus/parser_global.hpp>
+#include <orcus/config.hpp>
 
 #include <vector>
 #include <sstream>
+#include <string>
 #include <cassert>
 #include <unordered_set>
 #include <filesystem>
@@ -260,12 +262,120 @@ void test_callback()
     }
 }
 
+std::string dump_structure(std::string_view s, const structure_scan_config& config, bool& exhaustive)
+{
+    json::structure_tree tree;
+    tree.parse(s, config);
+    exhaustive = tree.is_exhaustive();
+    tree.normalize_tree();
+
+    std::ostringstream os;
+    tree.dump_compact(os);
+    return os.str();
+}
+
+void test_parallel()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    std::vector<std::string> inputs;
+
+    for (const char* base_dir : base_dirs)
+    {
+        std::string filepath(base_dir);
+        filepath.append("input.json");
+        file_content strm(filepath.data());
+        inputs.emplace_back(strm.str());
+    }
+
+    // Values mixed with containers at the same array positions, and strings
+    // containing brackets that the split must skip over.
+    inputs.push_back(
+        R"([1, {"a": 1}, 2, [3], "x, ]", {"a": [1, {"b": "\"}"}]}, null, 5])");
+    inputs.push_back(
+        R"([[1, {"a": 1}], [{"a": 2}, 2], [3, 3, {}], [4], [[5], 5, 5]])");
+    inputs.push_back(
+        R"( [ {"a": 1}, [0], [{"x": 1}, 5], [7, 8], [9, {}, 10] ] )");
+    inputs.push_back(
+        R"([{"a": [1, 2]}, {"a": [{"b": 1}, 3]}, {"a": [4, 5, 6]}, {"c": {"d": [1]}}])");
+
+    for (const std::string& input : inputs)
+    {
+        bool exhaustive = false;
+        std::string expected = dump_structure(input, structure_scan_config(), exhaustive);
+        assert(exhaustive);
+
+        for (std::size_t n_threads : {2u, 3u, 8u})
+        {
+            structure_scan_config config;
+            config.thread_count = n_threads;
+            std::string actual = dump_structure(input, config, exhaustive);
+            assert(exhaustive);
+
+            if (actual != expected)
+            {
+                std::cerr << "expected:" << std::endl << expected << std::endl;
+                std::cerr << "actual (threads: " << n_threads << "):" << std::endl << actual << std::endl;
+                assert(!"structure built in parallel differs");
+            }
+        }
+    }
+}
+
+void test_sampling()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    std::string input = "[";
+    for (int i = 0; i < 100; ++i)
+        input += R"({"a": 1, "b": 2}, )";
+    input += R"({"c": 3}])";
+
+    structure_scan_config config;
+    bool exhaustive = false;
+    std::string full = dump_structure(input, config, exhaustive);
+    assert(exhaustive);
+    assert(full.find("['c']") != full.npos);
+
+    // stop once 10 nodes in a row have added nothing new
+    config.max_stale_count = 10;
+    std::string sampled = dump_structure(input, config, exhaustive);
+    assert(!exhaustive);
+    assert(sampled.find("['a']") != sampled.npos);
+    assert(sampled.find("['c']") == sampled.npos);
+
+    // a limit that is never reached
+    config.max_stale_count = 1000;
+    sampled = dump_structure(input, config, exhaustive);
+    assert(exhaustive);
+    assert(sampled == full);
+
+    // stop past the first two objects
+    config.max_stale_count = 0;
+    config.max_bytes = 30;
+    sampled = dump_structure(input, config, exhaustive);
+    assert(!exhaustive);
+    assert(sampled == "$array[2].object(*)['a'].value\n$array[2].object(*)['b'].value\n");
+
+    config.thread_count = 4;
+    sampled = dump_structure(input, config, exhaustive);
+    assert(!exhaustive);
+    assert(sampled == "$array[2].object(*)['a'].value\n$array[2].object(*)['b'].value\n");
+
+    config.max_bytes = 0;
+    sampled = dump_structure(input, config, exhaustive);
+    assert(exhaustive);
+    assert(sampled == full);
+}
+
 int main()
 {
     test_no_value_nodes();
     test_basic();
     test_automatic_range_detection();
     test_callback();
+    test_parallel();
+    test_sampling();
 
     return EXIT_SUCCESS;
 }
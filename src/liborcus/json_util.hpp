@@ -7,6 +7,12 @@
 
 #pragma once
 
+#include <orcus/config.hpp>
+#include <orcus/json_parser.hpp>
+#include <orcus/threaded_json_parser.hpp>
+#include <orcus/string_pool.hpp>
+
+#include <optional>
 #include <sstream>
 #include <string_view>
 
@@ -14,6 +20,83 @@ namespace orcus { namespace json {
 
 void dump_string(std::ostringstream& os, std::string_view s);
 
+/**
+ * Adapts a json_parser handler to threaded_json_parser, which passes the
+ * strings as pointer and size pairs.
+ */
+template<typename HandlerT>
+class threaded_handler_adapter
+{
+    HandlerT& m_hdl;
+
+public:
+    threaded_handler_adapter(HandlerT& hdl) : m_hdl(hdl) {}
+
+    void begin_parse() { m_hdl.begin_parse(); }
+    void end_parse() { m_hdl.end_parse(); }
+    void begin_array() { m_hdl.begin_array(); }
+    void end_array() { m_hdl.end_array(); }
+    void begin_object() { m_hdl.begin_object(); }
+    void end_object() { m_hdl.end_object(); }
+    void boolean_true() { m_hdl.boolean_true(); }
+    void boolean_false() { m_hdl.boolean_false(); }
+    void null() { m_hdl.null(); }
+    void number(double val) { m_hdl.number(val); }
+
+    void object_key(const char* p, std::size_t n, bool transient)
+    {
+        m_hdl.object_key({p, n}, transient);
+    }
+
+    void string(const char* p, std::size_t n, bool transient)
+    {
+        m_hdl.string({p, n}, transient);
+    }
+};
+
+/**
+ * Parse a JSON stream on the calling thread, or tokenize it on a separate
+ * thread when the config says so.
+ *
+ * @param stream JSON stream to parse.
+ * @param hdl handler to receive the parsed values on the calling thread.
+ * @param config configuration specifying whether to use a separate thread.
+ * @param pool string pool to take over the strings the parser thread
+ *             stores, which the handler may reference.
+ *
+ * @return statistics of the parser thread, or an empty value when the stream
+ *         got parsed on the calling thread.
+ */
+template<typename HandlerT>
+std::optional<parser_stats> parse_stream(
+    std::string_view stream, HandlerT& hdl, const json_config& config, string_pool& pool)
+{
+    if (!config.use_threads)
+    {
+        json_parser<HandlerT> parser(stream, hdl);
+        parser.parse();
+        return {};
+    }
+
+    using adapter_type = threaded_handler_adapter<HandlerT>;
+    adapter_type adapter(hdl);
+
+    threaded_json_parser<adapter_type> parser(
+        stream, adapter, config.min_token_size, config.max_token_size);
+    parser.parse();
+
+    if (!config.persistent_string_values)
+    {
+        // The strings with escaped characters are stored in the pool of the
+        // parser thread, and the handler references them without a copy.
+        string_pool thread_pool;
+        parser.swap_string_pool(thread_pool);
+        pool.merge(thread_pool);
+    }
+
+    return parser.get_stats();
+}
+
 }}
 
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -483,6 +483,9 @@ void ods_content_xml_context::start_row(const xml_token_attrs_t& attrs)
         }
     }
 
+    if (m_row_attr.number_rows_repeated < 1)
+        m_row_attr.number_rows_repeated = 1;
+
     if (!m_cur_sheet.sheet)
         return;
 
@@ -499,7 +502,7 @@ void ods_content_xml_context::start_row(const xml_token_attrs_t& attrs)
             {
                 const auto& data = std::get<odf_style::row>(style.data);
                 if (data.height_set)
-                    sheet_props->set_row_height(m_row, 1, data.height.value, data.height.unit);
+                    sheet_props->set_row_height(m_row, get_row_span(), data.height.value, data.height.unit);
             }
         }
     }
@@ -507,13 +510,11 @@ void ods_content_xml_context::start_row(const xml_token_attrs_t& attrs)
 
 void ods_content_xml_context::end_row()
 {
-    if (m_row_attr.number_rows_repeated > 1)
-    {
-        // TODO: repeat this row.
-        if (get_config().debug)
-            std::cout << "TODO: repeat this row " << m_row_attr.number_rows_repeated << " times." << std::endl;
-    }
+    // The content of a repeated row has already been repeated cell by cell.
     m_row += m_row_attr.number_rows_repeated;
+
+    if (m_cur_sheet.sheet)
+        m_cur_sheet.sheet->end_row(m_row - 1);
 }
 
 void ods_content_xml_context::start_cell(const xml_token_attrs_t& attrs)
@@ -629,6 +630,9 @@ void ods_content_xml_context::start_cell(const xml_token_attrs_t& attrs)
             }
         }
     }
+
+    if (m_cell_attr.number_columns_repeated < 1)
+        m_cell_attr.number_columns_repeated = 1;
 }
 
 void ods_content_xml_context::end_cell()
@@ -636,16 +640,28 @@ void ods_content_xml_context::end_cell()
     push_cell_format();
     push_cell_value();
 
-    ++m_col;
-    if (m_cell_attr.number_columns_repeated > 1)
-    {
-        int col_upper = m_col + m_cell_attr.number_columns_repeated - 2;
-        for (; m_col <= col_upper; ++m_col)
-            push_cell_value();
-    }
+    m_col += m_cell_attr.number_columns_repeated;
     m_has_content = false;
 }
 
+ss::row_t ods_content_xml_context::get_row_span() const
+{
+    if (!m_cur_sheet.sheet)
+        return 1;
+
+    long n_rows = m_cur_sheet.sheet->get_sheet_size().rows - m_row;
+    return std::max<long>(1, std::min<long>(m_row_attr.number_rows_repeated, n_rows));
+}
+
+ss::col_t ods_content_xml_context::get_cell_span() const
+{
+    if (!m_cur_sheet.sheet)
+        return 1;
+
+    long n_cols = m_cur_sheet.sheet->get_sheet_size().columns - m_col;
+    return std::max<long>(1, std::min<long>(m_cell_attr.number_columns_repeated, n_cols));
+}
+
 std::optional<std::size_t> ods_content_xml_context::push_named_cell_style(std::string_view style_name)
 {
     ss::iface::import_styles* xstyles = mp_factory->get_styles();
@@ -736,11 +752,14 @@ void ods_content_xml_context::push_cell_format()
     if (m_cell_attr.style_name.empty())
         return;
 
+    // Apply the format to the entire block of repeated cells at once.
+    ss::row_t row_last = m_row + get_row_span() - 1;
+    ss::col_t col_last = m_col + get_cell_span() - 1;
+
     if (auto it = m_cell_format_map.find(m_cell_attr.style_name); it != m_cell_format_map.end())
     {
-        for (ss::col_t col_offset = 0; col_offset < m_cell_attr.number_columns_repeated; ++col_offset)
-            m_cur_sheet.sheet->set_format(m_row, m_col + col_offset, it->second);
         // style key found and direct cell format set.
+        m_cur_sheet.sheet->set_format(m_row, m_col, row_last, col_last, it->second);
         return;
     }
 
@@ -748,8 +767,7 @@ void ods_content_xml_context::push_cell_format()
     if (!xfid)
         return;
 
-    for (ss::col_t col_offset = 0; col_offset < m_cell_attr.number_columns_repeated; ++col_offset)
-        m_cur_sheet.sheet->set_format(m_row, m_col + col_offset, *xfid);
+    m_cur_sheet.sheet->set_format(m_row, m_col, row_last, col_last, *xfid);
 }
 
 void ods_content_xml_context::push_cell_value()
@@ -765,6 +783,8 @@ void ods_content_xml_context::push_cell_value()
             m_cur_sheet.index, m_row, m_col, m_cell_attr.formula_grammar, m_cell_attr.formula);
 
         ods_session_data::formula& formula_data = ods_data.formulas.back();
+        formula_data.row_span = get_row_span();
+        formula_data.col_span = get_cell_span();
 
         // Store formula result.
         switch (m_cell_attr.type)
@@ -785,33 +805,61 @@ void ods_content_xml_context::push_cell_value()
         return;
     }
 
-    if (m_cur_sheet.sheet)
+    if (!m_cur_sheet.sheet)
+        return;
+
+    std::optional<std::size_t> sindex;
+    date_time_t dt;
+
+    switch (m_cell_attr.type)
+    {
+        case vt_float:
+            break;
+        case vt_string:
+            sindex = push_cell_value_string();
+            if (!sindex)
+                return;
+            break;
+        case vt_date:
+            dt = date_time_t::from_chars(m_cell_attr.date_value);
+            break;
+        default:
+            return;
+    }
+
+    const ss::row_t row_span = get_row_span();
+    const ss::col_t col_span = get_cell_span();
+
+    // There is no way to copy a cell to the cells on its right, so the value
+    // gets pushed to each repeated column, then gets copied down to the rest
+    // of the repeated rows.
+    for (ss::col_t col = m_col; col < m_col + col_span; ++col)
     {
         switch (m_cell_attr.type)
         {
             case vt_float:
-                m_cur_sheet.sheet->set_value(m_row, m_col, m_cell_attr.value);
+                m_cur_sheet.sheet->set_value(m_row, col, m_cell_attr.value);
                 break;
             case vt_string:
-                push_cell_value_string();
+                m_cur_sheet.sheet->set_string(m_row, col, *sindex);
                 break;
             case vt_date:
-            {
-                date_time_t val = date_time_t::from_chars(m_cell_attr.date_value);
                 m_cur_sheet.sheet->set_date_time(
-                    m_row, m_col, val.year, val.month, val.day, val.hour, val.minute, val.second);
+                    m_row, col, dt.year, dt.month, dt.day, dt.hour, dt.minute, dt.second);
                 break;
-            }
             default:
                 ;
         }
+
+        if (row_span > 1)
+            m_cur_sheet.sheet->fill_down_cells(m_row, col, row_span - 1);
     }
 }
 
-void ods_content_xml_context::push_cell_value_string()
+std::optional<std::size_t> ods_content_xml_context::push_cell_value_string()
 {
     if (m_paragraphs.empty())
-        return;
+        return {};
 
     std::size_t para_index = 0;
 
@@ -848,7 +896,7 @@ void ods_content_xml_context::push_cell_value_string()
         para_index = mp_sstrings->commit_segments();
     }
 
-    m_cur_sheet.sheet->set_string(m_row, m_col, para_index);
+    return para_index;
 }
 
 void ods_content_xml_context::end_spreadsheet()
@@ -909,6 +957,8 @@ void ods_content_xml_context::end_spreadsheet()
     // Push all formula cells.  Formula cells needs to be processed after all
     // the sheet data have been imported, else 3D reference would fail to
     // resolve.
+    std::size_t shared_index = 0;
+
     for (ods_session_data::formula& data : ods_data.formulas)
     {
         if (data.sheet < 0 || static_cast<size_t>(data.sheet) >= m_tables.size())
@@ -916,29 +966,50 @@ void ods_content_xml_context::end_spreadsheet()
             continue;
 
         spreadsheet::iface::import_sheet* sheet = m_tables[data.sheet];
-        if (sheet)
+        if (!sheet)
+            continue;
+
+        // A formula cell repeated over multiple columns gets pushed to each
+        // column as a shared formula, with the first cell as its master.
+        // Each of these cells then gets copied down to the rest of the
+        // repeated rows as a block, the same way the values are.
+        const bool shared = data.col_span > 1;
+
+        for (ss::col_t col_offset = 0; col_offset < data.col_span; ++col_offset)
         {
             spreadsheet::iface::import_formula* formula = sheet->get_formula();
-            if (formula)
-            {
-                formula->set_position(data.row, data.column);
+            if (!formula)
+                break;
+
+            const ss::col_t col = data.column + col_offset;
+            formula->set_position(data.row, col);
+
+            if (!col_offset)
                 formula->set_formula(data.grammar, data.exp);
 
-                switch (data.result.type)
-                {
-                    case ods_session_data::rt_numeric:
-                        formula->set_result_value(data.result.numeric_value);
-                        break;
-                    case ods_session_data::rt_string:
-                    case ods_session_data::rt_error:
-                    case ods_session_data::rt_none:
-                    default:
-                        ;
-                }
+            if (shared)
+                formula->set_shared_formula_index(shared_index);
 
-                formula->commit();
+            switch (data.result.type)
+            {
+                case ods_session_data::rt_numeric:
+                    formula->set_result_value(data.result.numeric_value);
+                    break;
+                case ods_session_data::rt_string:
+                case ods_session_data::rt_error:
+                case ods_session_data::rt_none:
+                default:
+                    ;
             }
+
+            formula->commit();
+
+            if (data.row_span > 1)
+                sheet->fill_down_cells(data.row, col, data.row_span - 1);
         }
+
+        if (shared)
+            ++shared_index;
     }
 
     // Clear the formula buffer.
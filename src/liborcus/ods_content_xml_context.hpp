@@ -17,6 +17,7 @@
 
 #include <vector>
 #include <unordered_map>
+#include <optional>
 
 namespace orcus {
 
@@ -94,6 +95,18 @@ private:
     void start_cell(const xml_token_attrs_t& attrs);
     void end_cell();
 
+    /**
+     * Get the number of rows the current row is repeated over, without going
+     * past the end of the current sheet.
+     */
+    spreadsheet::row_t get_row_span() const;
+
+    /**
+     * Get the number of columns the current cell is repeated over, without
+     * going past the end of the current sheet.
+     */
+    spreadsheet::col_t get_cell_span() const;
+
     /**
      * Push a named cell style as a parent style of an automatic style, as we
      * cannot directly reference a named cell style from a cell, column etc.
@@ -107,7 +120,14 @@ private:
     void push_default_column_cell_style(std::string_view style_name, spreadsheet::col_t span);
     void push_cell_format();
     void push_cell_value();
-    void push_cell_value_string();
+
+    /**
+     * Push the paragraphs of the current cell to the shared string store.
+     *
+     * @return index of the pushed string, or no value if the cell has no
+     *         paragraphs.
+     */
+    std::optional<std::size_t> push_cell_value_string();
 
     void end_spreadsheet();
 
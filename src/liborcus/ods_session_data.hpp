@@ -41,6 +41,15 @@ struct ods_session_data : public session_context::custom_data
 
         formula_result result;
 
+        /**
+         * Number of rows and columns the formula cell is repeated over,
+         * starting at its own position.  A repeated formula cell gets pushed
+         * as a shared formula, so that its relative references get shifted
+         * in each repeated cell.
+         */
+        spreadsheet::row_t row_span = 1;
+        spreadsheet::col_t col_span = 1;
+
         formula(
             spreadsheet::sheet_t _sheet, spreadsheet::row_t _row, spreadsheet::col_t _col,
             spreadsheet::formula_grammar_t _grammar, std::string_view _exp);
@@ -0,0 +1,161 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "opc_part_prefetcher.hpp"
+
+#include "orcus/zip_archive.hpp"
+
+#include <algorithm>
+
+namespace orcus {
+
+namespace {
+
+constexpr std::size_t lookahead = 1;
+
+}
+
+void opc_part_prefetcher::run()
+{
+    std::unique_lock lock(m_mtx);
+
+    while (true)
+    {
+        m_cond.wait(lock, [this] {
+            return m_stop || m_next >= m_entries.size() || m_next < m_requested + lookahead;
+        });
+
+        if (m_stop || m_next >= m_entries.size())
+            break;
+
+        std::size_t pos = m_next++;
+        entry_type& entry = m_entries[pos];
+
+        if (entry.state != state_type::pending || pos + 1 < m_requested)
+        {
+            // This part has either been requested already, or skipped by the
+            // consumer.
+            if (entry.state == state_type::pending)
+            {
+                entry.state = state_type::consumed;
+                m_cond.notify_all();
+            }
+            continue;
+        }
+
+        entry.state = state_type::inflating;
+        lock.unlock();
+
+        unnamed_buffer buf;
+        bool success = true;
+
+        try
+        {
+            buf = m_archive.read_file_entry(entry.path);
+        }
+        catch (const std::exception&)
+        {
+            // Let the consumer read it again and handle the error.
+            success = false;
+        }
+
+        lock.lock();
+
+        if (pos + 1 < m_requested)
+            // The consumer has moved past this part in the meantime.
+            entry.state = state_type::consumed;
+        else
+        {
+            entry.buffer.swap(buf);
+            entry.state = success ? state_type::ready : state_type::failed;
+        }
+
+        m_cond.notify_all();
+    }
+}
+
+opc_part_prefetcher::opc_part_prefetcher(const zip_archive& archive, std::vector<std::string> paths) :
+    m_archive(archive)
+{
+    m_entries.reserve(paths.size());
+    for (std::string& path : paths)
+    {
+        m_entries.emplace_back();
+        m_entries.back().path = std::move(path);
+    }
+
+    for (std::size_t i = 0; i < m_entries.size(); ++i)
+        m_positions.insert({m_entries[i].path, i});
+
+    m_thread = std::thread(&opc_part_prefetcher::run, this);
+}
+
+opc_part_prefetcher::~opc_part_prefetcher()
+{
+    {
+        std::lock_guard lock(m_mtx);
+        m_stop = true;
+    }
+
+    m_cond.notify_all();
+    m_thread.join();
+}
+
+bool opc_part_prefetcher::take(std::string_view path, unnamed_buffer& buf)
+{
+    auto it = m_positions.find(path);
+    if (it == m_positions.end())
+        return false;
+
+    const std::size_t pos = it->second;
+
+    std::unique_lock lock(m_mtx);
+    entry_type& entry = m_entries[pos];
+    if (entry.state == state_type::consumed)
+        return false;
+
+    m_requested = std::max(m_requested, pos + 1);
+
+    // Release the parts that have been skipped by the consumer.
+    for (std::size_t i = 0; i < pos; ++i)
+    {
+        if (m_entries[i].state == state_type::ready)
+        {
+            m_entries[i].buffer = unnamed_buffer();
+            m_entries[i].state = state_type::consumed;
+        }
+    }
+
+    m_cond.notify_all();
+
+    // The helper thread releases this part instead of inflating it when a
+    // later part has been requested in the meantime.
+    m_cond.wait(lock, [&entry] {
+        switch (entry.state)
+        {
+            case state_type::ready:
+            case state_type::failed:
+            case state_type::consumed:
+                return true;
+            default:
+                ;
+        }
+        return false;
+    });
+
+    bool success = entry.state == state_type::ready;
+    if (success)
+        buf.swap(entry.buffer);
+
+    entry.buffer = unnamed_buffer();
+    entry.state = state_type::consumed;
+    return success;
+}
+
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
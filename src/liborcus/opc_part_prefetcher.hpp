@@ -0,0 +1,83 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "orcus/unnamed_buffer.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace orcus {
+
+class zip_archive;
+
+/**
+ * Inflates a list of parts in order on a helper thread, staying at most one
+ * part ahead of the part most recently requested.  This allows the next part
+ * to get inflated while the current part is being parsed, without holding
+ * more than two inflated parts in memory at any given time.
+ */
+class opc_part_prefetcher
+{
+    enum class state_type { pending, inflating, ready, failed, consumed };
+
+    struct entry_type
+    {
+        std::string path;
+        state_type state = state_type::pending;
+        unnamed_buffer buffer;
+    };
+
+    const zip_archive& m_archive;
+    std::vector<entry_type> m_entries;
+    std::unordered_map<std::string_view, std::size_t> m_positions;
+
+    /** Position of the next entry for the helper thread to process. */
+    std::size_t m_next = 0;
+    /** One past the position of the entry most recently requested. */
+    std::size_t m_requested = 0;
+    bool m_stop = false;
+
+    std::mutex m_mtx;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+
+    void run();
+
+public:
+    opc_part_prefetcher(const zip_archive& archive, std::vector<std::string> paths);
+    ~opc_part_prefetcher();
+
+    opc_part_prefetcher(const opc_part_prefetcher&) = delete;
+    opc_part_prefetcher& operator=(const opc_part_prefetcher&) = delete;
+
+    /**
+     * Take the inflated content of a part, waiting for the helper thread to
+     * finish inflating it if necessary.  Taking a part releases all the parts
+     * that precede it in the list, so a part requested after a later one has
+     * been taken is no longer available.
+     *
+     * @param path path of the part to take.
+     * @param buf buffer to receive the inflated content of the part.
+     *
+     * @return true if the content has been taken, or false if the part is
+     *         not managed by this prefetcher, has already been released, or
+     *         its inflation has failed.  The caller should read the part
+     *         directly from the archive in that case.
+     */
+    bool take(std::string_view path, unnamed_buffer& buf);
+};
+
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,134 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "test_global.hpp"
+#include "opc_part_prefetcher.hpp"
+
+#include <orcus/zip_archive.hpp>
+#include <orcus/zip_archive_stream.hpp>
+
+#include <iostream>
+
+namespace {
+
+const char* input_path = SRCDIR"/test/xlsx/sheet-selection/input.xlsx";
+
+const std::vector<std::string> part_paths = {
+    "xl/workbook.xml",
+    "xl/sharedStrings.xml",
+    "xl/styles.xml",
+    "xl/worksheets/sheet1.xml",
+    "xl/tables/table1.xml",
+    "xl/worksheets/sheet2.xml",
+};
+
+bool equals(const orcus::unnamed_buffer& buf, const orcus::unnamed_buffer& expected)
+{
+    return buf.str() == expected.str();
+}
+
+}
+
+void test_in_order()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    orcus::zip_archive_stream_fd strm(input_path);
+    orcus::zip_archive archive(&strm);
+    archive.load();
+
+    orcus::opc_part_prefetcher prefetcher(archive, part_paths);
+
+    for (const std::string& path : part_paths)
+    {
+        orcus::unnamed_buffer buf;
+        bool taken = prefetcher.take(path, buf);
+        assert(taken);
+        assert(equals(buf, archive.read_file_entry(path)));
+
+        // A part can only be taken once.
+        taken = prefetcher.take(path, buf);
+        assert(!taken);
+    }
+
+    orcus::unnamed_buffer buf;
+    bool taken = prefetcher.take("xl/worksheets/_rels/sheet1.xml.rels", buf);
+    assert(!taken); // not managed by the prefetcher
+}
+
+void test_out_of_order()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    orcus::zip_archive_stream_fd strm(input_path);
+    orcus::zip_archive archive(&strm);
+    archive.load();
+
+    {
+        // Take the parts in reverse order.  Every part but the last one gets
+        // released when the last one is taken, and taking any of them must
+        // return false rather than wait for it.
+        orcus::opc_part_prefetcher prefetcher(archive, part_paths);
+
+        for (auto it = part_paths.rbegin(); it != part_paths.rend(); ++it)
+        {
+            orcus::unnamed_buffer buf;
+            bool taken = prefetcher.take(*it, buf);
+            assert(taken == (it == part_paths.rbegin()));
+            if (taken)
+                assert(equals(buf, archive.read_file_entry(*it)));
+        }
+    }
+
+    {
+        // Skip ahead, then go back to a skipped part, then resume after the
+        // part taken last.
+        orcus::opc_part_prefetcher prefetcher(archive, part_paths);
+
+        orcus::unnamed_buffer buf;
+        bool taken = prefetcher.take(part_paths[3], buf);
+        assert(taken);
+        assert(equals(buf, archive.read_file_entry(part_paths[3])));
+
+        taken = prefetcher.take(part_paths[1], buf);
+        assert(!taken);
+
+        for (std::size_t i = 4; i < part_paths.size(); ++i)
+        {
+            taken = prefetcher.take(part_paths[i], buf);
+            assert(taken);
+            assert(equals(buf, archive.read_file_entry(part_paths[i])));
+        }
+    }
+
+    // Repeat with different intervals between the two requests, so that the
+    // helper thread is caught in different states.
+    for (std::size_t i = 0; i < 200; ++i)
+    {
+        orcus::opc_part_prefetcher prefetcher(archive, part_paths);
+
+        const std::size_t first = i % part_paths.size();
+        const std::size_t second = (i / part_paths.size()) % part_paths.size();
+
+        orcus::unnamed_buffer buf;
+        bool taken = prefetcher.take(part_paths[first], buf);
+        assert(taken);
+
+        taken = prefetcher.take(part_paths[second], buf);
+        assert(taken == (second > first));
+    }
+}
+
+int main()
+{
+    test_in_order();
+    test_out_of_order();
+
+    return EXIT_SUCCESS;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -6,13 +6,16 @@
  */
 
 #include "opc_reader.hpp"
+#include "opc_part_prefetcher.hpp"
 #include "xml_stream_parser.hpp"
 
 #include "ooxml_global.hpp"
 #include "opc_context.hpp"
+#include "session_context.hpp"
 #include "ooxml_tokens.hpp"
 
 #include "orcus/config.hpp"
+#include "orcus/import_profile.hpp"
 
 #include <iostream>
 
@@ -39,6 +42,19 @@ private:
     const char* m_prefix;
 };
 
+/**
+ * Restores the prefetcher pointer of opc_reader on scope exit.
+ */
+template<typename T>
+class pointer_scope
+{
+    T*& m_ref;
+    T* m_old;
+public:
+    pointer_scope(T*& ref, T* p) : m_ref(ref), m_old(ref) { m_ref = p; }
+    ~pointer_scope() { m_ref = m_old; }
+};
+
 }
 
 opc_reader::part_handler::~part_handler() {}
@@ -69,10 +85,29 @@ void opc_reader::read_file(std::unique_ptr<zip_archive_stream>&& stream)
 
 bool opc_reader::open_zip_stream(std::string_view path, unnamed_buffer& buf)
 {
+    import_profiler* profiler = m_session_cxt.profiler;
+    auto start = profiler ? profiler->elapsed() : import_profile_t::duration_type{0};
+
+    auto record_part = [&]
+    {
+        if (profiler)
+        {
+            std::size_t compressed_size = m_archive->get_file_entry_header(path).compressed_size;
+            profiler->add_part(path, compressed_size, buf.size(), start);
+        }
+    };
+
+    if (mp_prefetcher && mp_prefetcher->take(path, buf))
+    {
+        record_part();
+        return true;
+    }
+
     try
     {
         auto entry = m_archive->read_file_entry(path);
         buf.swap(entry);
+        record_part();
         return true;
     }
     catch (const std::exception&)
@@ -169,7 +204,8 @@ void opc_reader::read_part(std::string_view path, const schema_t type, opc_rel_e
 }
 
 void opc_reader::check_relation_part(
-    const std::string& file_name, opc_rel_extras_t* extras, sort_compare_type* sorter)
+    const std::string& file_name, opc_rel_extras_t* extras, sort_compare_type* sorter,
+    const prefetch_filter_type* prefetch)
 {
     // Read the relationship file associated with this file, located at
     // _rels/<file name>.rels.
@@ -185,21 +221,35 @@ void opc_reader::check_relation_part(
     if (m_config.debug)
         std::for_each(rels.begin(), rels.end(), print_opc_rel());
 
-    std::for_each(rels.begin(), rels.end(),
-        [&](opc_rel_t& v)
+    auto get_extra = [extras](const opc_rel_t& v) -> opc_rel_extra*
+    {
+        if (!extras)
+            return nullptr;
+
+        // See if there is an extra data associated with this relation ID.
+        opc_rel_extras_t::map_type::iterator it = extras->data.find(v.rid);
+        return it == extras->data.end() ? nullptr : it->second.get();
+    };
+
+    std::unique_ptr<opc_part_prefetcher> prefetcher;
+
+    if (prefetch && !mp_prefetcher)
+    {
+        std::vector<std::string> paths;
+        for (const opc_rel_t& v : rels)
         {
-            opc_rel_extra* data = nullptr;
-            if (extras)
-            {
-                // See if there is an extra data associated with this relation ID.
-                opc_rel_extras_t::map_type::iterator it = extras->data.find(v.rid);
-                if (it != extras->data.end())
-                    // There is one !
-                    data = it->second.get();
-            }
-            read_part(v.target, v.type, data);
+            if ((*prefetch)(v, get_extra(v)))
+                paths.push_back(get_part_path(v.target));
         }
-    );
+
+        if (paths.size() > 1)
+            prefetcher = std::make_unique<opc_part_prefetcher>(*m_archive, std::move(paths));
+    }
+
+    pointer_scope<opc_part_prefetcher> scope(mp_prefetcher, prefetcher ? prefetcher.get() : mp_prefetcher);
+
+    for (const opc_rel_t& v : rels)
+        read_part(v.target, v.type, get_extra(v));
 }
 
 void opc_reader::list_content() const
@@ -304,5 +354,34 @@ std::string opc_reader::get_current_dir() const
     return os.str();
 }
 
+std::string opc_reader::get_part_path(std::string_view target) const
+{
+    dir_stack_type dirs = m_dir_stack;
+
+    std::size_t pos = 0;
+    for (std::size_t i = 0; i < target.size(); ++i)
+    {
+        if (target[i] != '/')
+            continue;
+
+        std::string_view segment = target.substr(pos, i - pos);
+        if (segment == "..")
+        {
+            if (dirs.size() > 1)
+                dirs.pop_back();
+        }
+        else
+            dirs.emplace_back(target.substr(pos, i - pos + 1));
+
+        pos = i + 1;
+    }
+
+    std::ostringstream os;
+    for (const auto& dir : dirs)
+        os << dir;
+
+    return resolve_file_path(os.str(), target.substr(pos));
+}
+
 }
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -14,6 +14,8 @@
 #include "ooxml_schemas.hpp"
 #include "xml_simple_stream_handler.hpp"
 
+#include <functional>
+#include <memory>
 #include <vector>
 #include <string>
 #include <unordered_set>
@@ -25,6 +27,7 @@ struct config;
 class xmlns_repository;
 struct session_context;
 struct opc_rel_extra;
+class opc_part_prefetcher;
 
 /**
  * Class to handle parsing through all xml parts stored in a file packaged
@@ -42,6 +45,13 @@ public:
 
     using sort_compare_type = std::function<bool(const opc_rel_t&, const opc_rel_t&)>;
 
+    /**
+     * Predicate that determines whether or not to inflate a part in advance.
+     * The second argument is the extra data associated with the relation, or
+     * nullptr if there is none.
+     */
+    using prefetch_filter_type = std::function<bool(const opc_rel_t&, const opc_rel_extra*)>;
+
     /**
      * Interface class for the user of opc_reader to receive callback to
      * handle each xml part.
@@ -89,10 +99,14 @@ public:
      *               the next xml part(s).
      * @param sorter optoinal comparator function used to sort the relation
      *               items prior to processing them.
+     * @param prefetch optional predicate to select the parts to inflate on a
+     *                 helper thread ahead of time, while the preceding part
+     *                 is being processed.  Prefetching is not done when
+     *                 another call up the stack is already prefetching.
      */
     void check_relation_part(
         const std::string& file_name, opc_rel_extras_t* extras = nullptr,
-        sort_compare_type* sorter = nullptr);
+        sort_compare_type* sorter = nullptr, const prefetch_filter_type* prefetch = nullptr);
 
 private:
 
@@ -103,6 +117,11 @@ private:
 
     std::string get_current_dir() const;
 
+    /**
+     * Get the full path of a part, the same way read_part() resolves it.
+     */
+    std::string get_part_path(std::string_view target) const;
+
 private:
     const config& m_config;
     xmlns_repository& m_ns_repo;
@@ -112,6 +131,9 @@ private:
     std::unique_ptr<zip_archive> m_archive;
     std::unique_ptr<zip_archive_stream> m_archive_stream;
 
+    /** Non-null only while a prefetching check_relation_part() runs. */
+    opc_part_prefetcher* mp_prefetcher = nullptr;
+
     xml_simple_stream_handler m_opc_rel_handler;
 
     std::vector<xml_part_t> m_parts;
@@ -12,8 +12,11 @@
 #include <orcus/spreadsheet/import_interface.hpp>
 #include <orcus/config.hpp>
 #include <orcus/string_pool.hpp>
+#include <orcus/import_profile.hpp>
 #include <orcus/stream.hpp>
 
+#include "spreadsheet_selection.hpp"
+
 #include <cstring>
 #include <iostream>
 
@@ -86,6 +89,7 @@ public:
 
     void end_row()
     {
+        mp_sheet->end_row(m_row);
         ++m_row;
         m_col = 0;
     }
@@ -139,14 +143,22 @@ struct orcus_csv::impl
 
     impl(spreadsheet::iface::import_factory* _factory) : factory(_factory) {}
 
-    void parse(std::string_view stream, const config& conf)
+    void parse(std::string_view stream, const config& conf, import_profiler* profiler)
     {
         if (stream.empty())
             return;
 
+        import_profiler::scope profile_scope(profiler, "parse");
+
+        auto format_config = std::get<config::csv_config>(conf.data);
+
+        // Rows arrive in order unless the content gets split into multiple
+        // sheets, in which case the rows of each sheet start over.
+        selective_import_scope selection(
+            factory, conf.selection, !format_config.split_to_multiple_sheets);
+
         orcus_csv_handler handler(*factory, conf);
         csv::parser_config config;
-        auto format_config = std::get<config::csv_config>(conf.data);
         config.delimiters = format_config.delimiters;
         config.text_qualifier = format_config.text_qualifier;
         csv_parser<orcus_csv_handler> parser(stream, handler, config);
@@ -159,6 +171,10 @@ struct orcus_csv::impl
             // The parser has decided to end the import due to the destination
             // sheet being full.
         }
+        catch (const selection_range_complete&)
+        {
+            // The rest of the content is outside the selected range.
+        }
         catch (const parse_error& e)
         {
             std::cout << "parse failed at offset " << e.offset() << ": " << e.what() << std::endl;
@@ -174,8 +190,10 @@ orcus_csv::~orcus_csv() {}
 
 void orcus_csv::read_file(const fs::path& filepath)
 {
+    import_profiler::scope profile_scope(get_profiler(), "csv import");
+
     file_content fc(filepath);
-    mp_impl->parse(fc.str(), get_config());
+    mp_impl->parse(fc.str(), get_config(), get_profiler());
     mp_impl->factory->finalize();
 }
 
@@ -184,7 +202,9 @@ void orcus_csv::read_stream(std::string_view stream)
     if (stream.empty())
         return;
 
-    mp_impl->parse(stream, get_config());
+    import_profiler::scope profile_scope(get_profiler(), "csv import");
+
+    mp_impl->parse(stream, get_config(), get_profiler());
     mp_impl->factory->finalize();
 }
 
@@ -10,6 +10,9 @@
 #include "orcus/spreadsheet/import_interface.hpp"
 #include "orcus/stream.hpp"
 #include "orcus/config.hpp"
+#include "orcus/measurement.hpp"
+#include "orcus/string_pool.hpp"
+#include "orcus/import_profile.hpp"
 
 #include "xml_stream_parser.hpp"
 #include "gnumeric_handler.hpp"
@@ -18,14 +21,18 @@
 #include "gnumeric_detection_handler.hpp"
 #include "session_context.hpp"
 #include "detection_result.hpp"
+#include "spreadsheet_selection.hpp"
 
 #define ORCUS_DEBUG_GNUMERIC 0
 
+#include <cstdlib>
+#include <algorithm>
 #include <iostream>
 #include <string>
 
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/device/array.hpp>
 
 namespace fs = std::filesystem;
 
@@ -33,17 +40,77 @@ namespace orcus {
 
 namespace {
 
-bool decompress_gzip(const char* buffer, size_t size, std::string& decompressed)
+/**
+ * Size of the head of the decompressed stream to use for format detection.
+ */
+constexpr std::size_t detection_head_size = 8192;
+
+/**
+ * Guess the size of the decompressed content from the trailer of a gzip
+ * stream, for use as the initial size of the output buffer.
+ */
+std::size_t estimate_decompressed_size(std::string_view strm)
+{
+    if (strm.size() < 18)
+        return 0;
+
+    // The last 4 bytes store the size of the uncompressed input modulo 2^32,
+    // in little endian.
+    const auto* p = reinterpret_cast<const unsigned char*>(strm.data() + strm.size() - 4);
+    std::size_t n = p[0] | (p[1] << 8) | (p[2] << 16) | (std::size_t(p[3]) << 24);
+
+    // Don't trust a value beyond the maximum compression ratio of deflate.
+    return std::min(n, strm.size() * 1032);
+}
+
+/**
+ * Decompress a gzip-compressed stream into a single buffer.  The stream gets
+ * read in chunks, but the decompressed content is not released until the
+ * whole of it has been read.
+ *
+ * @param strm gzip-compressed stream.
+ * @param decompressed buffer to store the decompressed content in.
+ * @param max_size maximum number of bytes to decompress, or 0 to decompress
+ *                 the whole stream.
+ *
+ * @return true if the decompression was successful, false otherwise.
+ */
+bool decompress_gzip(std::string_view strm, std::string& decompressed, std::size_t max_size = 0)
 {
+    constexpr std::size_t chunk_size = 65536;
+
     std::string buf;
 
     try
     {
-        boost::iostreams::filtering_ostream os;
-        os.push(boost::iostreams::gzip_decompressor());
-        os.push(boost::iostreams::back_inserter(buf));
-        boost::iostreams::write(os, buffer, size);
-        os.flush();
+        boost::iostreams::filtering_istream is;
+        is.push(boost::iostreams::gzip_decompressor());
+        is.push(boost::iostreams::array_source(strm.data(), strm.size()));
+
+        // Leave room for the last read which hits the end of the stream.
+        std::size_t n_expected = estimate_decompressed_size(strm) + chunk_size;
+        if (max_size)
+            n_expected = std::min(n_expected, max_size);
+
+        buf.reserve(n_expected);
+
+        while (!max_size || buf.size() < max_size)
+        {
+            std::size_t n = chunk_size;
+            if (max_size)
+                n = std::min(n, max_size - buf.size());
+
+            std::size_t pos = buf.size();
+            buf.resize(pos + n);
+            is.read(&buf[pos], n);
+            buf.resize(pos + is.gcount());
+
+            if (!is)
+                break;
+        }
+
+        if (is.bad())
+            return false;
     }
     catch (const std::exception&)
     {
@@ -67,13 +134,39 @@ struct orcus_gnumeric::impl
 
     void read_content_xml(std::string_view s, const config& conf)
     {
-        xml_stream_parser parser(conf, m_ns_repo, gnumeric_tokens, s.data(), s.size());
+        bool use_threads = true;
+
+        if (const char* p_env = std::getenv("ORCUS_GNUMERIC_USE_THREADS"); p_env)
+            use_threads = to_bool(p_env);
 
         auto handler = std::make_unique<gnumeric_content_xml_handler>(
             m_cxt, gnumeric_tokens, mp_factory);
 
+        if (!use_threads)
+        {
+            xml_stream_parser parser(conf, m_ns_repo, gnumeric_tokens, s.data(), s.size());
+            parser.set_handler(handler.get());
+            parser.parse();
+            return;
+        }
+
+        // Tokenize the stream on a separate thread while the handler
+        // processes the tokens on the calling thread.
+        threaded_xml_stream_parser parser(conf, m_ns_repo, gnumeric_tokens, s.data(), s.size());
         parser.set_handler(handler.get());
-        parser.parse();
+
+        try
+        {
+            parser.parse();
+        }
+        catch (...)
+        {
+            // Keep the strings the handler may reference.
+            parser.merge_string_pool(m_cxt.spool);
+            throw;
+        }
+
+        parser.merge_string_pool(m_cxt.spool);
     }
 };
 
@@ -90,35 +183,55 @@ orcus_gnumeric::~orcus_gnumeric()
 
 bool orcus_gnumeric::detect(std::string_view strm)
 {
-    // Detect gnumeric format that's already in memory.
-
-    std::string decompressed;
-    if (!decompress_gzip(strm.data(), strm.size(), decompressed))
-        return false;
+    // Detect gnumeric format that's already in memory.  Only the head of the
+    // stream gets decompressed, which is usually enough to reach a verdict.
+    // The head gets extended only when the parse runs off its end before
+    // reaching one.
 
-    if (decompressed.empty())
-        return false;
-
-    // Parse this xml stream for detection.
-    config opt(format_t::gnumeric);
-    xmlns_repository ns_repo;
-    ns_repo.add_predefined_values(NS_gnumeric_all);
-    session_context cxt;
-    xml_stream_parser parser(opt, ns_repo, gnumeric_tokens, &decompressed[0], decompressed.size());
-    gnumeric_detection_handler handler(cxt, gnumeric_tokens);
-    parser.set_handler(&handler);
-
-    try
+    for (std::size_t max_size = detection_head_size; ; max_size *= 8)
     {
-        parser.parse();
+        std::string decompressed;
+        if (!decompress_gzip(strm, decompressed, max_size))
+            return false;
+
+        if (decompressed.empty())
+            return false;
+
+        bool complete = decompressed.size() < max_size;
+
+        // Parse this xml stream for detection.
+        config opt(format_t::gnumeric);
+        xmlns_repository ns_repo;
+        ns_repo.add_predefined_values(NS_gnumeric_all);
+        session_context cxt;
+        xml_stream_parser parser(opt, ns_repo, gnumeric_tokens, decompressed.data(), decompressed.size());
+        gnumeric_detection_handler handler(cxt, gnumeric_tokens);
+        parser.set_handler(&handler);
+
+        try
+        {
+            parser.parse();
+        }
+        catch (const detection_result& res)
+        {
+            return res.get_result();
+        }
+        catch (const parse_error& e)
+        {
+            // An error before the end of the head is not due to truncation.
+            if (complete || e.offset() < std::ptrdiff_t(decompressed.size()))
+                return false;
+
+            continue;
+        }
+        catch (...)
+        {
+            return false;
+        }
+
+        if (complete)
+            return false;
     }
-    catch (const detection_result& res)
-    {
-        return res.get_result();
-    }
-    catch (...) {}
-
-    return false;
 }
 
 void orcus_gnumeric::read_file(const fs::path& filepath)
@@ -135,17 +248,37 @@ void orcus_gnumeric::read_stream(std::string_view stream)
     if (stream.empty())
         return;
 
+    import_profiler* profiler = get_profiler();
+    import_profiler::scope profile_scope(profiler, "gnumeric import");
+    mp_impl->m_cxt.profiler = profiler;
+
+    auto start = profiler ? profiler->elapsed() : import_profile_t::duration_type{0};
+
+    // The XML parsers need the entire document in one contiguous buffer, so
+    // it gets decompressed in full before the parsing starts.
+    // TODO: Feed the inflated chunks to the parser through a bounded buffer
+    // once the threaded SAX token parser can read its input incrementally,
+    // so that the memory used by the import stays bounded.
     std::string file_content;
-    if (!decompress_gzip(stream.data(), stream.size(), file_content))
+    if (!decompress_gzip(stream, file_content))
         return;
 
+    if (profiler)
+        profiler->add_part("content", stream.size(), file_content.size(), start);
+
+    selective_import_scope selection(mp_impl->mp_factory, get_config().selection, false);
+
     if (auto* gs = mp_impl->mp_factory->get_global_settings(); gs)
     {
         gs->set_origin_date(1899, 12, 30);
         gs->set_default_formula_grammar(spreadsheet::formula_grammar_t::gnumeric);
     }
 
-    mp_impl->read_content_xml(file_content, get_config());
+    {
+        import_profiler::scope content_scope(profiler, "content");
+        mp_impl->read_content_xml(file_content, get_config());
+    }
+
     mp_impl->mp_factory->finalize();
 }
 
@@ -11,14 +11,23 @@
 #include <orcus/config.hpp>
 #include <orcus/spreadsheet/import_interface.hpp>
 #include <orcus/json_parser.hpp>
+#include <orcus/measurement.hpp>
+#include <orcus/parser_global.hpp>
 #include <orcus/stream.hpp>
+#include <orcus/string_pool.hpp>
 
 #include "json_map_tree.hpp"
 #include "json_structure_mapper.hpp"
 #include "detection_result.hpp"
 
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <future>
 #include <ostream>
 #include <sstream>
+#include <thread>
 #include <vector>
 
 namespace orcus {
@@ -370,6 +379,239 @@ private:
     }
 };
 
+/**
+ * Target size of a block of lines in a JSON Lines stream that gets parsed as
+ * a single unit on a worker thread.  Blocks always end at a line boundary.
+ */
+constexpr std::size_t json_lines_block_size = 256 * 1024;
+
+/**
+ * Single parser event recorded from a line of a JSON Lines stream, to be
+ * replayed through json_content_handler.
+ */
+struct json_event
+{
+    enum class event_type : std::uint8_t
+    {
+        begin_array,
+        end_array,
+        begin_object,
+        object_key,
+        end_object,
+        boolean_true,
+        boolean_false,
+        null,
+        string,
+        number
+    };
+
+    event_type type;
+    std::string_view str;
+    double numeric = 0.0;
+
+    json_event(event_type _type) : type(_type) {}
+    json_event(event_type _type, std::string_view _str) : type(_type), str(_str) {}
+    json_event(double v) : type(event_type::number), numeric(v) {}
+};
+
+/**
+ * Parsed content of a block of lines.
+ */
+struct json_lines_block
+{
+    std::vector<json_event> events;
+
+    /** Stores the transient keys and string values. */
+    string_pool pool;
+
+    /**
+     * Error from the first line that failed to parse.  The events only cover
+     * the lines that precede it.
+     */
+    std::exception_ptr error;
+};
+
+class json_event_recorder : public json_handler
+{
+    using event_type = json_event::event_type;
+
+    json_lines_block& m_block;
+
+    std::string_view persist(std::string_view s, bool transient)
+    {
+        return transient ? m_block.pool.intern(s).first : s;
+    }
+
+public:
+    json_event_recorder(json_lines_block& block) : m_block(block) {}
+
+    void begin_array()
+    {
+        m_block.events.emplace_back(event_type::begin_array);
+    }
+
+    void end_array()
+    {
+        m_block.events.emplace_back(event_type::end_array);
+    }
+
+    void begin_object()
+    {
+        m_block.events.emplace_back(event_type::begin_object);
+    }
+
+    void object_key(std::string_view key, bool transient)
+    {
+        m_block.events.emplace_back(event_type::object_key, persist(key, transient));
+    }
+
+    void end_object()
+    {
+        m_block.events.emplace_back(event_type::end_object);
+    }
+
+    void boolean_true()
+    {
+        m_block.events.emplace_back(event_type::boolean_true);
+    }
+
+    void boolean_false()
+    {
+        m_block.events.emplace_back(event_type::boolean_false);
+    }
+
+    void null()
+    {
+        m_block.events.emplace_back(event_type::null);
+    }
+
+    void string(std::string_view val, bool transient)
+    {
+        m_block.events.emplace_back(event_type::string, persist(val, transient));
+    }
+
+    void number(double val)
+    {
+        m_block.events.emplace_back(val);
+    }
+};
+
+/**
+ * Parse all lines in a block, skipping the blank ones.
+ *
+ * @param block block of lines.
+ * @param offset offset of the block in the whole stream.
+ */
+json_lines_block parse_json_lines(std::string_view block, std::ptrdiff_t offset)
+{
+    json_lines_block ret;
+    json_event_recorder hdl(ret);
+
+    const char* p = block.data();
+    const char* p_end = p + block.size();
+
+    while (p < p_end)
+    {
+        const char* p_eol = std::find(p, p_end, '\n');
+        std::string_view line(p, p_eol - p);
+        std::ptrdiff_t line_offset = offset + (p - block.data());
+        p = p_eol == p_end ? p_end : p_eol + 1;
+
+        if (trim(line).empty())
+            continue;
+
+        std::size_t n_events = ret.events.size();
+
+        try
+        {
+            json_parser<json_event_recorder> parser(line, hdl);
+            parser.parse();
+        }
+        catch (const parse_error& e)
+        {
+            // Drop the events of the partially-parsed line, and re-base the
+            // error offset from the line to the whole stream.
+            ret.events.resize(n_events, json_event::event_type::null);
+
+            std::string_view msg = e.what();
+            if (auto pos = msg.rfind(" (offset="); pos != msg.npos)
+                msg = msg.substr(0, pos);
+
+            ret.error = std::make_exception_ptr(parse_error(std::string{msg}, line_offset + e.offset()));
+            break;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Push the events of a block through the content handler, and re-throw the
+ * parse error of the block if any.
+ */
+void replay_json_lines(json_content_handler& hdl, const json_lines_block& block)
+{
+    using event_type = json_event::event_type;
+
+    for (const json_event& e : block.events)
+    {
+        switch (e.type)
+        {
+            case event_type::begin_array:
+                hdl.begin_array();
+                break;
+            case event_type::end_array:
+                hdl.end_array();
+                break;
+            case event_type::begin_object:
+                hdl.begin_object();
+                break;
+            case event_type::object_key:
+                hdl.object_key(e.str, false);
+                break;
+            case event_type::end_object:
+                hdl.end_object();
+                break;
+            case event_type::boolean_true:
+                hdl.boolean_true();
+                break;
+            case event_type::boolean_false:
+                hdl.boolean_false();
+                break;
+            case event_type::null:
+                hdl.null();
+                break;
+            case event_type::string:
+                hdl.string(e.str, false);
+                break;
+            case event_type::number:
+                hdl.number(e.numeric);
+                break;
+        }
+    }
+
+    if (block.error)
+        std::rethrow_exception(block.error);
+}
+
+/**
+ * Cut out the next block of lines from the front of a stream.
+ */
+std::string_view pop_json_lines_block(std::string_view& rest)
+{
+    std::size_t n = std::min(rest.size(), json_lines_block_size);
+
+    if (n < rest.size())
+    {
+        std::size_t pos = rest.find('\n', n);
+        n = pos == rest.npos ? rest.size() : pos + 1;
+    }
+
+    std::string_view block = rest.substr(0, n);
+    rest.remove_prefix(n);
+    return block;
+}
+
 } // anonymous namespace
 
 struct orcus_json::impl
@@ -380,6 +622,44 @@ struct orcus_json::impl
 
     impl(spreadsheet::iface::import_factory* _im_factory) :
         im_factory(_im_factory), sheet_count(0) {}
+
+    /**
+     * Insert range headers (if applicable).
+     *
+     * @return false if the factory provides no shared strings interface, in
+     *         which case nothing can be imported.
+     */
+    bool insert_range_headers()
+    {
+        spreadsheet::iface::import_shared_strings* ss = im_factory->get_shared_strings();
+        if (!ss)
+            return false;
+
+        for (const auto& entry : map_tree.get_range_references())
+        {
+            const json_map_tree::range_reference_type& ref = entry.second;
+            if (!ref.row_header)
+                // This range does not use row header.
+                continue;
+
+            const cell_position_t& origin = ref.pos;
+
+            spreadsheet::iface::import_sheet* sheet = im_factory->get_sheet(origin.sheet);
+
+            if (!sheet)
+                continue;
+
+            for (const json_map_tree::range_field_reference_type* field : ref.fields)
+            {
+                cell_position_t pos = origin;
+                pos.col += field->column_pos;
+                size_t sid = ss->add(field->label);
+                sheet->set_string(pos.row, pos.col, sid);
+            }
+        }
+
+        return true;
+    }
 };
 
 orcus_json::orcus_json(spreadsheet::iface::import_factory* im_fact) :
@@ -469,37 +749,82 @@ void orcus_json::read_stream(std::string_view stream)
     if (!mp_impl->im_factory)
         return;
 
-    spreadsheet::iface::import_shared_strings* ss = mp_impl->im_factory->get_shared_strings();
-    if (!ss)
+    if (!mp_impl->insert_range_headers())
         return;
 
-    // Insert range headers first (if applicable).
-    for (const auto& entry : mp_impl->map_tree.get_range_references())
+    json_content_handler hdl(mp_impl->map_tree, *mp_impl->im_factory);
+    json_parser<json_content_handler> parser(stream, hdl);
+    parser.parse();
+
+    mp_impl->im_factory->finalize();
+}
+
+void orcus_json::read_lines(std::string_view stream)
+{
+    if (!mp_impl->im_factory)
+        return;
+
+    if (!mp_impl->insert_range_headers())
+        return;
+
+    json_content_handler hdl(mp_impl->map_tree, *mp_impl->im_factory);
+
+    // Each line gets mapped as an element of an array enclosing the whole
+    // stream.
+    hdl.begin_array();
+
+    bool use_threads = true;
+
+    if (const char* p_env = std::getenv("ORCUS_JSON_USE_THREADS"); p_env)
+        use_threads = to_bool(p_env);
+
+    std::string_view rest = stream;
+
+    auto _next_block = [&stream, &rest]()
     {
-        const json_map_tree::range_reference_type& ref = entry.second;
-        if (!ref.row_header)
-            // This range does not use row header.
-            continue;
+        std::string_view block = pop_json_lines_block(rest);
+        return std::make_pair(block, block.data() - stream.data());
+    };
 
-        const cell_position_t& origin = ref.pos;
+    if (!use_threads)
+    {
+        while (!rest.empty())
+        {
+            auto [block, offset] = _next_block();
+            replay_json_lines(hdl, parse_json_lines(block, offset));
+        }
+    }
+    else
+    {
+        // Parse the blocks on worker threads while the parsed ones get
+        // pushed to the sheets in order on this thread.  Only a limited
+        // number of blocks are kept in flight to bound the memory usage.
+        const std::size_t n_threads = std::max(1u, std::thread::hardware_concurrency());
 
-        spreadsheet::iface::import_sheet* sheet = mp_impl->im_factory->get_sheet(origin.sheet);
+        std::deque<std::future<json_lines_block>> pending;
 
-        if (!sheet)
-            continue;
+        auto _launch_next = [&]()
+        {
+            auto [block, offset] = _next_block();
+            pending.push_back(std::async(std::launch::async, parse_json_lines, block, offset));
+        };
+
+        while (!rest.empty() && pending.size() < n_threads)
+            _launch_next();
 
-        for (const json_map_tree::range_field_reference_type* field : ref.fields)
+        while (!pending.empty())
         {
-            cell_position_t pos = origin;
-            pos.col += field->column_pos;
-            size_t sid = ss->add(field->label);
-            sheet->set_string(pos.row, pos.col, sid);
+            json_lines_block block = pending.front().get();
+            pending.pop_front();
+
+            if (!rest.empty())
+                _launch_next();
+
+            replay_json_lines(hdl, block);
         }
     }
 
-    json_content_handler hdl(mp_impl->map_tree, *mp_impl->im_factory);
-    json_parser<json_content_handler> parser(stream, hdl);
-    parser.parse();
+    hdl.end_array();
 
     mp_impl->im_factory->finalize();
 }
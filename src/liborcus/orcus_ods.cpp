@@ -11,6 +11,7 @@
 #include <orcus/zip_archive_stream.hpp>
 #include <orcus/measurement.hpp>
 #include <orcus/stream.hpp>
+#include <orcus/import_profile.hpp>
 
 #include "xml_stream_parser.hpp"
 #include "ods_content_xml_context.hpp"
@@ -20,6 +21,7 @@
 #include "odf_styles.hpp"
 #include "odf_namespace_types.hpp"
 #include "session_context.hpp"
+#include "spreadsheet_selection.hpp"
 
 #include <cstdlib>
 #include <iostream>
@@ -30,6 +32,25 @@ namespace fs = std::filesystem;
 
 namespace orcus {
 
+namespace {
+
+/**
+ * Inflate a file entry, and record its sizes and the time spent inflating it
+ * when a profiler is given.
+ */
+unnamed_buffer read_file_entry(const zip_archive& archive, std::string_view name, import_profiler* profiler)
+{
+    auto start = profiler ? profiler->elapsed() : import_profile_t::duration_type{0};
+    unnamed_buffer buf = archive.read_file_entry(name);
+
+    if (profiler)
+        profiler->add_part(name, archive.get_file_entry_header(name).compressed_size, buf.size(), start);
+
+    return buf;
+}
+
+}
+
 struct orcus_ods::impl
 {
     xmlns_repository ns_repo;
@@ -74,7 +95,7 @@ void orcus_ods::read_styles(const zip_archive& archive)
 
     try
     {
-        buf = archive.read_file_entry("styles.xml");
+        buf = read_file_entry(archive, "styles.xml", get_profiler());
     }
     catch (const std::exception& e)
     {
@@ -92,8 +113,11 @@ void orcus_ods::read_styles(const zip_archive& archive)
 
     xml_stream_handler handler(mp_impl->cxt, odf_tokens, std::move(context));
 
-    parser.set_handler(&handler);
-    parser.parse();
+    {
+        import_profiler::scope profile_scope(get_profiler(), "styles");
+        parser.set_handler(&handler);
+        parser.parse();
+    }
 
     if (get_config().debug)
         dump_state(ods_data.styles_map, std::cout);
@@ -105,7 +129,7 @@ void orcus_ods::read_content(const zip_archive& archive)
 
     try
     {
-        buf = archive.read_file_entry("content.xml");
+        buf = read_file_entry(archive, "content.xml", get_profiler());
     }
     catch (const std::exception& e)
     {
@@ -126,6 +150,8 @@ void orcus_ods::read_content_xml(const unsigned char* p, size_t size)
     auto context = std::make_unique<ods_content_xml_context>(
         mp_impl->cxt, odf_tokens, mp_impl->xfactory);
 
+    import_profiler::scope profile_scope(get_profiler(), "content");
+
     if (use_threads)
     {
         threaded_xml_stream_parser parser(
@@ -135,10 +161,7 @@ void orcus_ods::read_content_xml(const unsigned char* p, size_t size)
         xml_stream_handler handler(mp_impl->cxt, odf_tokens, std::move(context));
         parser.set_handler(&handler);
         parser.parse();
-
-        string_pool this_pool;
-        parser.swap_string_pool(this_pool);
-        mp_impl->cxt.spool.merge(this_pool);
+        parser.merge_string_pool(mp_impl->cxt.spool);
     }
     else
     {
@@ -200,11 +223,16 @@ void orcus_ods::read_stream(std::string_view stream)
 
 void orcus_ods::read_file_impl(zip_archive_stream* stream)
 {
+    import_profiler::scope profile_scope(get_profiler(), "ods import");
+    mp_impl->cxt.profiler = get_profiler();
+
     zip_archive archive(stream);
     archive.load();
     if (get_config().debug)
         list_content(archive);
 
+    selective_import_scope selection(mp_impl->xfactory, get_config().selection, false);
+
     spreadsheet::formula_grammar_t old_grammar = spreadsheet::formula_grammar_t::unknown;
 
     spreadsheet::iface::import_global_settings* gs = mp_impl->xfactory->get_global_settings();
@@ -8,19 +8,29 @@
 #include <orcus/orcus_parquet.hpp>
 #include <orcus/stream.hpp>
 #include <orcus/config.hpp>
+#include <orcus/measurement.hpp>
+#include <orcus/import_profile.hpp>
 #include <orcus/spreadsheet/types.hpp>
 
+#include "spreadsheet_selection.hpp"
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wshadow"
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 #include <arrow/buffer.h>
 #include <arrow/io/file.h>
 #include <arrow/io/memory.h>
-#include <parquet/stream_reader.h>
-#include <parquet/arrow/reader.h>
+#include <parquet/column_reader.h>
+#include <parquet/file_reader.h>
 #pragma GCC diagnostic pop
 
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <future>
 #include <iostream>
+#include <sstream>
+#include <thread>
 #include <unordered_map>
 
 namespace ss = orcus::spreadsheet;
@@ -28,40 +38,178 @@ namespace fs = std::filesystem;
 
 namespace orcus {
 
-class orcus_parquet::impl
+namespace {
+
+/**
+ * Maximum number of values to read from a column chunk in a single
+ * ReadBatch() call.
+ */
+constexpr std::int64_t batch_size = 4096;
+
+/**
+ * How the values of a column get imported.
+ */
+enum class column_kind_t { skip, boolean, numeric, string };
+
+struct column_type
 {
-    using columns_type = std::vector<std::pair<ss::col_t, const parquet::ColumnDescriptor*>>;
+    int index = 0;
+    const parquet::ColumnDescriptor* desc = nullptr;
+    column_kind_t kind = column_kind_t::skip;
+};
 
-    const config& m_config;
+using columns_type = std::vector<column_type>;
 
-    ss::iface::import_factory* m_factory = nullptr;
-    ss::iface::import_shared_strings* m_sstrings = nullptr;
-    ss::iface::import_sheet* m_sheet = nullptr;
+/**
+ * Values of a single column chunk decoded ahead of being pushed to the
+ * sheet.  Null values are not stored in the value stores, but are recorded
+ * as absent in the presence flags which store one entry per row.
+ */
+struct decoded_column
+{
+    std::vector<bool> present;
+    std::vector<bool> bools;
+    std::vector<double> numbers;
+    std::string str_buffer;
+    std::vector<std::size_t> str_ends;
+};
 
-    columns_type m_columns;
+struct decoded_row_group
+{
+    ss::row_t row_count = 0;
+    std::vector<decoded_column> columns;
+};
+
+template<typename ReaderT, typename FuncT>
+void read_column_chunk(
+    parquet::ColumnReader& base, const parquet::ColumnDescriptor& desc, decoded_column& dest, FuncT append)
+{
+    using value_type = typename ReaderT::T;
+
+    auto& reader = static_cast<ReaderT&>(base);
+    const std::int16_t max_def_level = desc.max_definition_level();
 
-    parquet::StreamReader m_stream;
+    std::vector<std::int16_t> def_levels(batch_size);
+    std::unique_ptr<value_type[]> values(new value_type[batch_size]);
 
-    static columns_type init_columns(const parquet::FileMetaData& file_md)
+    while (reader.HasNext())
     {
-        columns_type columns;
+        std::int64_t values_read = 0;
+        std::int64_t levels_read = reader.ReadBatch(
+            batch_size, max_def_level ? def_levels.data() : nullptr, nullptr, values.get(), &values_read);
 
-        const parquet::SchemaDescriptor* schema_desc = file_md.schema();
+        if (!max_def_level)
+        {
+            // Required column.  Every row has a value.
+            dest.present.insert(dest.present.end(), values_read, true);
 
-        if (!schema_desc)
-            return columns;
+            for (std::int64_t i = 0; i < values_read; ++i)
+                append(values[i]);
 
-        columns.reserve(schema_desc->num_columns());
+            continue;
+        }
 
-        for (int i = 0; i < schema_desc->num_columns(); ++i)
+        std::int64_t pos = 0;
+
+        for (std::int64_t i = 0; i < levels_read; ++i)
         {
-            const parquet::ColumnDescriptor* col_desc = schema_desc->Column(i);
-            columns.emplace_back(i, col_desc);
+            bool present = def_levels[i] == max_def_level;
+            dest.present.push_back(present);
+
+            if (present)
+                append(values[pos++]);
         }
+    }
+}
+
+/**
+ * Decode all column chunks of a row group.  This gets called on worker
+ * threads, and must not touch the import interfaces.
+ */
+decoded_row_group decode_row_group(parquet::ParquetFileReader& file_reader, int rg_index, const columns_type& columns)
+{
+    auto rg_reader = file_reader.RowGroup(rg_index);
+
+    decoded_row_group decoded;
+    decoded.row_count = rg_reader->metadata()->num_rows();
+    decoded.columns.resize(columns.size());
+
+    for (std::size_t i = 0; i < columns.size(); ++i)
+    {
+        const column_type& col = columns[i];
+        decoded_column& dest = decoded.columns[i];
+
+        if (col.kind == column_kind_t::skip)
+            continue;
 
-        return columns;
+        auto reader = rg_reader->Column(col.index);
+
+        switch (col.desc->physical_type())
+        {
+            case parquet::Type::BOOLEAN:
+            {
+                read_column_chunk<parquet::BoolReader>(
+                    *reader, *col.desc, dest, [&dest](bool v) { dest.bools.push_back(v); });
+                break;
+            }
+            case parquet::Type::INT32:
+            {
+                read_column_chunk<parquet::Int32Reader>(
+                    *reader, *col.desc, dest, [&dest](std::int32_t v) { dest.numbers.push_back(v); });
+                break;
+            }
+            case parquet::Type::INT64:
+            {
+                read_column_chunk<parquet::Int64Reader>(
+                    *reader, *col.desc, dest, [&dest](std::int64_t v) { dest.numbers.push_back(v); });
+                break;
+            }
+            case parquet::Type::FLOAT:
+            {
+                read_column_chunk<parquet::FloatReader>(
+                    *reader, *col.desc, dest, [&dest](float v) { dest.numbers.push_back(v); });
+                break;
+            }
+            case parquet::Type::DOUBLE:
+            {
+                read_column_chunk<parquet::DoubleReader>(
+                    *reader, *col.desc, dest, [&dest](double v) { dest.numbers.push_back(v); });
+                break;
+            }
+            case parquet::Type::BYTE_ARRAY:
+            {
+                read_column_chunk<parquet::ByteArrayReader>(
+                    *reader, *col.desc, dest,
+                    [&dest](const parquet::ByteArray& v)
+                    {
+                        // The value points into the page buffer, which gets
+                        // overwritten by the next batch.
+                        dest.str_buffer.append(reinterpret_cast<const char*>(v.ptr), v.len);
+                        dest.str_ends.push_back(dest.str_buffer.size());
+                    }
+                );
+                break;
+            }
+            default:
+                ;
+        }
     }
 
+    return decoded;
+}
+
+} // anonymous namespace
+
+class orcus_parquet::impl
+{
+    const config& m_config;
+
+    ss::iface::import_factory* m_factory = nullptr;
+    ss::iface::import_shared_strings* m_sstrings = nullptr;
+    ss::iface::import_sheet* m_sheet = nullptr;
+
+    columns_type m_columns;
+
     void warn(std::string_view msg) const
     {
         if (!m_config.debug)
@@ -71,152 +219,150 @@ class orcus_parquet::impl
     }
 
     /**
-     * Import column labels as the first row.
+     * Determine how to import each column from its physical and converted
+     * types.  Columns of unhandled types are skipped.
      */
-    void import_column_labels()
+    void init_columns(const parquet::FileMetaData& file_md)
     {
-        // Import column labels as first row
-        for (const auto& [col, p] : m_columns)
-        {
-            if (!m_sstrings)
-                continue;
+        m_columns.clear();
 
-            std::size_t si = m_sstrings->add(p->name());
-            m_sheet->set_string(0, col, si);
-        }
-    }
+        const parquet::SchemaDescriptor* schema_desc = file_md.schema();
 
-    template<typename T>
-    std::optional<T> read_or_warn(ss::row_t row, ss::col_t col)
-    {
-        T v;
+        if (!schema_desc)
+            return;
 
-        try
-        {
-            m_stream >> v;
-            return v;
-        }
-        catch (const std::exception& e)
+        m_columns.reserve(schema_desc->num_columns());
+
+        for (int i = 0; i < schema_desc->num_columns(); ++i)
         {
-            std::ostringstream os;
-            os << "failed to read a value for (row=" << row << "; col=" << col << "): " << e.what();
-            warn(os.str());
-        }
+            const parquet::ColumnDescriptor* p = schema_desc->Column(i);
+            column_type col{i, p, column_kind_t::skip};
 
-        return std::optional<T>{};
-    }
+            if (p->max_repetition_level() > 0)
+            {
+                warn("WIP: repeated fields not handled yet");
+                m_columns.push_back(col);
+                continue;
+            }
 
-    void import_byte_array(ss::row_t row, ss::col_t col, const parquet::ColumnDescriptor* p)
-    {
-        switch (p->converted_type())
-        {
-            case parquet::ConvertedType::UTF8:
+            auto _warn_converted = [this, p](std::string_view physical)
             {
-                if (!m_sstrings)
+                std::ostringstream os;
+                os << "WIP: unhandled converted type for " << physical << " (converted="
+                    << p->converted_type() << ")";
+                warn(os.str());
+            };
+
+            switch (p->physical_type())
+            {
+                case parquet::Type::BOOLEAN:
                 {
-                    m_stream.SkipColumns(1);
+                    if (p->converted_type() == parquet::ConvertedType::NONE)
+                        col.kind = column_kind_t::boolean;
+                    else
+                        _warn_converted("BOOLEAN");
                     break;
                 }
-
-                if (auto v = read_or_warn<std::string>(row, col); v)
+                case parquet::Type::INT32:
+                case parquet::Type::INT64:
+                case parquet::Type::FLOAT:
+                case parquet::Type::DOUBLE:
                 {
-                    std::size_t si = m_sstrings->add(*v);
-                    m_sheet->set_string(row, col, si);
+                    if (p->converted_type() == parquet::ConvertedType::NONE)
+                        col.kind = column_kind_t::numeric;
+                    else
+                        _warn_converted(parquet::TypeToString(p->physical_type()));
+                    break;
+                }
+                case parquet::Type::BYTE_ARRAY:
+                {
+                    if (p->converted_type() != parquet::ConvertedType::UTF8)
+                        _warn_converted("BYTE_ARRAY");
+                    else if (m_sstrings)
+                        col.kind = column_kind_t::string;
+                    break;
+                }
+                case parquet::Type::INT96:
+                {
+                    warn("WIP: physical=INT96 not handled yet");
+                    break;
+                }
+                case parquet::Type::FIXED_LEN_BYTE_ARRAY:
+                {
+                    warn("WIP: physical=FIXED_LEN_BYTE_ARRAY not handled yet");
+                    break;
+                }
+                default:
+                {
+                    std::ostringstream os;
+                    os << "WIP: type not handled: physical=" << p->physical_type() << "; converted=" << p->converted_type();
+                    warn(os.str());
                 }
-                break;
-            }
-            default:
-            {
-                std::ostringstream os;
-                os << "WIP: unhandled converted type for BYTE_ARRAY (converted="
-                    << p->converted_type() << ")";
-                warn(os.str());
-                m_stream.SkipColumns(1);
             }
+
+            m_columns.push_back(col);
         }
     }
 
-    void import_fixed_len_byte_array(ss::row_t /*row*/, ss::col_t /*col*/, const parquet::ColumnDescriptor* /*p*/)
+    /**
+     * Import column labels as the first row.
+     */
+    void import_column_labels()
     {
-        warn("WIP: physical=FIXED_LEN_BYTE_ARRAY not handled yet");
-        m_stream.SkipColumns(1);
-    }
+        if (!m_sstrings)
+            return;
 
-    void import_int32(ss::row_t row, ss::col_t col, const parquet::ColumnDescriptor* p)
-    {
-        switch (p->converted_type())
+        for (const auto& col : m_columns)
         {
-            case parquet::ConvertedType::NONE:
-            {
-                if (auto v = read_or_warn<int32_t>(row, col); v)
-                    m_sheet->set_value(row, col, *v);
-                break;
-            }
-            default:
-                warn("WIP: unhandled converted type for INT32");
-                m_stream.SkipColumns(1);
+            std::size_t si = m_sstrings->add(col.desc->name());
+            m_sheet->set_string(0, col.index, si);
         }
     }
 
-    void import_int64(ss::row_t row, ss::col_t col, const parquet::ColumnDescriptor* p)
+    /**
+     * Push the values of a decoded row group to the sheet one column at a
+     * time.
+     */
+    void push_row_group(ss::row_t row_offset, const decoded_row_group& rg)
     {
-        switch (p->converted_type())
+        for (std::size_t i = 0; i < m_columns.size(); ++i)
         {
-            case parquet::ConvertedType::NONE:
-            {
-                if (auto v = read_or_warn<int64_t>(row, col); v)
-                    m_sheet->set_value(row, col, *v);
-                break;
-            }
-            default:
-                warn("WIP: unhandled converted type for INT64");
-                m_stream.SkipColumns(1);
-        }
-    }
-
-    void import_int96(ss::row_t /*row*/, ss::col_t /*col*/, const parquet::ColumnDescriptor* /*p*/)
-    {
-        warn("WIP: physical=INT96 not handled yet");
-        m_stream.SkipColumns(1);
-    }
+            const column_type& col = m_columns[i];
+            const decoded_column& src = rg.columns[i];
 
-    void import_boolean(ss::row_t row, ss::col_t col, const parquet::ColumnDescriptor* p)
-    {
-        if (p->converted_type() != parquet::ConvertedType::NONE)
-        {
-            warn("WIP: unhandled covnerted type for BOOLEAN");
-            m_stream.SkipColumns(1);
-            return;
-        }
+            std::size_t pos = 0;
+            std::size_t str_start = 0;
 
-        if (auto v = read_or_warn<bool>(row, col); v)
-            m_sheet->set_bool(row, col, *v);
-    }
+            for (std::size_t r = 0; r < src.present.size(); ++r)
+            {
+                if (!src.present[r])
+                    continue;
 
-    void import_float(ss::row_t row, ss::col_t col, const parquet::ColumnDescriptor* p)
-    {
-        if (p->converted_type() != parquet::ConvertedType::NONE)
-        {
-            warn("WIP: unhandled covnerted type for FLOAT");
-            m_stream.SkipColumns(1);
-            return;
-        }
+                ss::row_t row = row_offset + r;
 
-        if (auto v = read_or_warn<float>(row, col); v)
-            m_sheet->set_value(row, col, *v);
-    }
+                switch (col.kind)
+                {
+                    case column_kind_t::boolean:
+                        m_sheet->set_bool(row, col.index, src.bools[pos]);
+                        break;
+                    case column_kind_t::numeric:
+                        m_sheet->set_value(row, col.index, src.numbers[pos]);
+                        break;
+                    case column_kind_t::string:
+                    {
+                        std::size_t str_end = src.str_ends[pos];
+                        std::string_view s{src.str_buffer.data() + str_start, str_end - str_start};
+                        str_start = str_end;
+                        m_sheet->set_string(row, col.index, m_sstrings->add(s));
+                        break;
+                    }
+                    case column_kind_t::skip:
+                        break;
+                }
 
-    void import_double(ss::row_t row, ss::col_t col, const parquet::ColumnDescriptor* p)
-    {
-        if (p->converted_type() != parquet::ConvertedType::NONE)
-        {
-            warn("WIP: unhandled covnerted type for DOUBLE");
-            m_stream.SkipColumns(1);
-            return;
+                ++pos;
+            }
         }
-
-        if (auto v = read_or_warn<double>(row, col); v)
-            m_sheet->set_value(row, col, *v);
     }
 
     void dump_metadata(const parquet::FileMetaData& metadata) const
@@ -337,8 +483,9 @@ class orcus_parquet::impl
             return false;
 
         if (schema->group_node()->field_count() != schema->num_columns())
-            // StreamReader assumes these two values to be equal, and crashes
-            // if not.  But with some files the two can be different.
+            // The leaf columns don't map one-to-one to the top-level fields,
+            // which means the schema has nested groups.  We import each leaf
+            // column as a sheet column, which doesn't work for such schema.
             return false;
 
         return true;
@@ -346,10 +493,12 @@ class orcus_parquet::impl
 
     void read_stream_with_sheet_name(std::string_view sheet_name, std::string_view stream)
     {
+        selective_import_scope selection(m_factory, m_config.selection, false);
+
         auto buf = std::make_shared<arrow::Buffer>(stream);
         auto buf_reader = std::make_shared<arrow::io::BufferReader>(buf);
 
-        auto file_reader = parquet::ParquetFileReader::Open(buf_reader);
+        std::unique_ptr<parquet::ParquetFileReader> file_reader = parquet::ParquetFileReader::Open(buf_reader);
         if (!file_reader)
         {
             warn("failed to open a parquet file reader from an in-memory buffer.");
@@ -376,83 +525,72 @@ class orcus_parquet::impl
             // Failed to append sheet. Bail out.
             return;
 
-        m_columns = init_columns(*file_md);
+        m_sstrings = m_factory->get_shared_strings();
+
+        init_columns(*file_md);
         if (m_columns.empty())
             // Column data initialization failed. Bail out.
             return;
 
-        m_stream = parquet::StreamReader{std::move(file_reader)};
-        if (m_stream.eof())
+        const int n_row_groups = file_md->num_row_groups();
+        if (!n_row_groups)
             return;
 
-        m_sstrings = m_factory->get_shared_strings();
-
         import_column_labels();
 
-        for (int i = 0; i < file_md->num_rows(); ++i)
-        {
-            ss::row_t row = i + 1; // account for the header row
+        bool use_threads = true;
+
+        if (const char* p_env = std::getenv("ORCUS_PARQUET_USE_THREADS"); p_env)
+            use_threads = to_bool(p_env);
 
-            for (const auto& [col, p] : m_columns)
+        ss::row_t row_offset = 1; // account for the header row
+
+        if (!use_threads)
+        {
+            for (int i = 0; i < n_row_groups; ++i)
             {
-                switch (p->physical_type())
-                {
-                    case parquet::Type::BOOLEAN:
-                    {
-                        import_boolean(row, col, p);
-                        break;
-                    }
-                    case parquet::Type::INT32:
-                    {
-                        import_int32(row, col, p);
-                        break;
-                    }
-                    case parquet::Type::INT64:
-                    {
-                        import_int64(row, col, p);
-                        break;
-                    }
-                    case parquet::Type::INT96:
-                    {
-                        import_int96(row, col, p);
-                        break;
-                    }
-                    case parquet::Type::FLOAT:
-                    {
-                        import_float(row, col, p);
-                        break;
-                    }
-                    case parquet::Type::DOUBLE:
-                    {
-                        import_double(row, col, p);
-                        break;
-                    }
-                    case parquet::Type::BYTE_ARRAY:
-                    {
-                        import_byte_array(row, col, p);
-                        break;
-                    }
-                    case parquet::Type::FIXED_LEN_BYTE_ARRAY:
-                    {
-                        import_fixed_len_byte_array(row, col, p);
-                        break;
-                    }
-                    default:
-                    {
-                        std::ostringstream os;
-                        os << "WIP: type not handled: physical=" << p->physical_type() << "; converted=" << p->converted_type();
-                        warn(os.str());
-                        m_stream.SkipColumns(1);
-                    }
-                }
+                decoded_row_group rg = decode_row_group(*file_reader, i, m_columns);
+                push_row_group(row_offset, rg);
+                row_offset += rg.row_count;
             }
 
-            m_stream >> parquet::EndRow;
+            m_factory->finalize();
+            return;
+        }
+
+        // Decode the row groups on worker threads while the decoded ones get
+        // pushed to the sheet in order on this thread.  Only a limited number
+        // of row groups are kept in flight to bound the memory usage.
+        const std::size_t n_threads = std::max(1u, std::thread::hardware_concurrency());
+
+        std::deque<std::future<decoded_row_group>> pending;
+        int next_rg = 0;
+
+        auto _launch_next = [&]()
+        {
+            pending.push_back(
+                std::async(
+                    std::launch::async, decode_row_group,
+                    std::ref(*file_reader), next_rg++, std::cref(m_columns)));
+        };
+
+        while (next_rg < n_row_groups && pending.size() < n_threads)
+            _launch_next();
+
+        while (!pending.empty())
+        {
+            decoded_row_group rg = pending.front().get();
+            pending.pop_front();
+
+            if (next_rg < n_row_groups)
+                _launch_next();
+
+            push_row_group(row_offset, rg);
+            row_offset += rg.row_count;
         }
 
         m_factory->finalize();
     }
-
 public:
     impl(const config& c, ss::iface::import_factory* factory) : m_config(c), m_factory(factory) {}
 
@@ -530,11 +668,13 @@ bool orcus_parquet::detect(std::string_view strm)
 
 void orcus_parquet::read_file(const fs::path& filepath)
 {
+    import_profiler::scope profile_scope(get_profiler(), "parquet import");
     mp_impl->read_file(filepath);
 }
 
 void orcus_parquet::read_stream(std::string_view stream)
 {
+    import_profiler::scope profile_scope(get_profiler(), "parquet import");
     mp_impl->read_stream(stream);
 }
 
@@ -11,6 +11,9 @@
 #include "orcus/config.hpp"
 #include "orcus/spreadsheet/import_interface.hpp"
 #include "orcus/parser_base.hpp"
+#include "orcus/measurement.hpp"
+#include "orcus/string_pool.hpp"
+#include "orcus/import_profile.hpp"
 
 #include "xml_stream_parser.hpp"
 #include "xls_xml_handler.hpp"
@@ -19,7 +22,9 @@
 #include "xls_xml_tokens.hpp"
 #include "xls_xml_namespace_types.hpp"
 #include "detection_result.hpp"
+#include "spreadsheet_selection.hpp"
 
+#include <cstdlib>
 #include <iostream>
 #include <locale>
 #include <codecvt>
@@ -36,11 +41,50 @@ struct orcus_xls_xml::impl
 
     impl(spreadsheet::iface::import_factory* factory) : mp_factory(factory) {}
 
-    void read_stream(const char* content, size_t len, const config& cnf)
+    void parse(const char* content, size_t len, const config& cnf, xml_stream_handler& handler)
+    {
+        bool use_threads = true;
+
+        if (const char* p_env = std::getenv("ORCUS_XLS_XML_USE_THREADS"); p_env)
+            use_threads = to_bool(p_env);
+
+        if (!use_threads)
+        {
+            xml_stream_parser parser(cnf, m_ns_repo, xls_xml_tokens, content, len);
+            parser.set_handler(&handler);
+            parser.parse();
+            return;
+        }
+
+        // Tokenize the stream on a separate thread while the handler
+        // processes the tokens on the calling thread.
+        threaded_xml_stream_parser parser(cnf, m_ns_repo, xls_xml_tokens, content, len);
+        parser.set_handler(&handler);
+
+        try
+        {
+            parser.parse();
+        }
+        catch (...)
+        {
+            // Keep the strings the handler may reference.
+            parser.merge_string_pool(m_cxt.spool);
+            throw;
+        }
+
+        parser.merge_string_pool(m_cxt.spool);
+    }
+
+    void read_stream(const char* content, size_t len, const config& cnf, import_profiler* profiler)
     {
         if (!content || !len)
             return;
 
+        import_profiler::scope profile_scope(profiler, "xls-xml import");
+        m_cxt.profiler = profiler;
+
+        selective_import_scope selection(mp_factory, cnf.selection, false);
+
         spreadsheet::iface::import_global_settings* gs =
             mp_factory->get_global_settings();
 
@@ -50,14 +94,12 @@ struct orcus_xls_xml::impl
         gs->set_origin_date(1899, 12, 30);
         gs->set_default_formula_grammar(spreadsheet::formula_grammar_t::xls_xml);
 
-        xml_stream_parser parser(cnf, m_ns_repo, xls_xml_tokens, content, len);
-
         auto handler = std::make_unique<xls_xml_handler>(m_cxt, xls_xml_tokens, mp_factory);
 
-        parser.set_handler(handler.get());
         try
         {
-            parser.parse();
+            import_profiler::scope parse_scope(profiler, "parse");
+            parse(content, len, cnf, *handler);
         }
         catch (const parse_error& e)
         {
@@ -112,7 +154,7 @@ void orcus_xls_xml::read_file(const fs::path& filepath)
         return;
 
     content.convert_to_utf8();
-    mp_impl->read_stream(content.data(), content.size(), get_config());
+    mp_impl->read_stream(content.data(), content.size(), get_config(), get_profiler());
 }
 
 void orcus_xls_xml::read_stream(std::string_view stream)
@@ -122,7 +164,7 @@ void orcus_xls_xml::read_stream(std::string_view stream)
         return;
 
     mem_content.convert_to_utf8();
-    mp_impl->read_stream(mem_content.data(), mem_content.size(), get_config());
+    mp_impl->read_stream(mem_content.data(), mem_content.size(), get_config(), get_profiler());
 }
 
 std::string_view orcus_xls_xml::get_name() const
@@ -13,6 +13,7 @@
 #include <orcus/config.hpp>
 #include <orcus/measurement.hpp>
 #include <orcus/stream.hpp>
+#include <orcus/import_profile.hpp>
 
 #include "xlsx_types.hpp"
 #include "xlsx_handler.hpp"
@@ -31,6 +32,7 @@
 #include "ooxml_global.hpp"
 #include "spreadsheet_iface_util.hpp"
 #include "ooxml_content_types.hpp"
+#include "spreadsheet_selection.hpp"
 
 #include <cstdlib>
 #include <iostream>
@@ -125,11 +127,54 @@ struct orcus_xlsx::impl
     xlsx_opc_handler m_opc_handler;
     opc_reader m_opc_reader;
 
+    /**
+     * When true, the parts get inflated ahead of time on a helper thread,
+     * and the large parts get tokenized on a separate thread.
+     */
+    bool m_use_threads = true;
+
     impl(spreadsheet::iface::import_factory* factory, orcus_xlsx& parent) :
         m_cxt(std::make_unique<xlsx_session_data>()),
         mp_factory(factory),
         m_opc_handler(parent),
         m_opc_reader(parent.get_config(), m_ns_repo, m_cxt, m_opc_handler) {}
+
+    /**
+     * Parse a large part such as a worksheet or the shared string table.
+     * When threading is enabled, the part gets tokenized on a separate thread
+     * while the handler processes the tokens on the calling thread.
+     */
+    void parse_part(const config& opt, const unnamed_buffer& buffer, xml_stream_handler& handler)
+    {
+        parse_part(opt, std::string_view{buffer.data(), buffer.size()}, handler);
+    }
+
+    void parse_part(const config& opt, std::string_view stream, xml_stream_handler& handler)
+    {
+        if (!m_use_threads)
+        {
+            xml_stream_parser parser(opt, m_ns_repo, ooxml_tokens, stream.data(), stream.size());
+            parser.set_handler(&handler);
+            parser.parse();
+            return;
+        }
+
+        threaded_xml_stream_parser parser(opt, m_ns_repo, ooxml_tokens, stream.data(), stream.size());
+        parser.set_handler(&handler);
+
+        try
+        {
+            parser.parse();
+        }
+        catch (...)
+        {
+            // Keep the strings the handler may reference.
+            parser.merge_string_pool(m_cxt.spool);
+            throw;
+        }
+
+        parser.merge_string_pool(m_cxt.spool);
+    }
 };
 
 orcus_xlsx::orcus_xlsx(spreadsheet::iface::import_factory* factory) :
@@ -207,6 +252,17 @@ void orcus_xlsx::read_file(const fs::path& filepath)
 
 void orcus_xlsx::read_stream(std::string_view stream)
 {
+    // The sheet contexts skip the cells past the selected range themselves.
+    selective_import_scope selection(mp_impl->mp_factory, get_config().selection, false);
+
+    import_profiler* profiler = get_profiler();
+    import_profiler::scope profile_scope(profiler, "xlsx import");
+    mp_impl->m_cxt.profiler = profiler;
+
+    mp_impl->m_use_threads = true;
+    if (const char* p_env = std::getenv("ORCUS_XLSX_USE_THREADS"); p_env)
+        mp_impl->m_use_threads = to_bool(p_env);
+
     std::unique_ptr<zip_archive_stream> blob(
         new zip_archive_stream_blob(
             std::span{reinterpret_cast<const uint8_t*>(stream.data()), stream.size()}));
@@ -215,7 +271,10 @@ void orcus_xlsx::read_stream(std::string_view stream)
     // Formulas need to be inserted to the document after the shared string
     // table get imported, because tokenization of formulas may add new shared
     // string instances.
-    set_formulas_to_doc();
+    {
+        import_profiler::scope set_formulas_scope(profiler, "set_formulas_to_doc");
+        set_formulas_to_doc();
+    }
 
     mp_impl->mp_factory->finalize();
 }
@@ -351,11 +410,14 @@ void orcus_xlsx::read_workbook(const std::string& dir_path, const std::string& f
         mp_impl->m_cxt, ooxml_tokens,
         std::make_unique<xlsx_workbook_context>(mp_impl->m_cxt, ooxml_tokens, *mp_impl->mp_factory));
 
-    xml_stream_parser parser(
-        get_config(), mp_impl->m_ns_repo, ooxml_tokens,
-        buffer.data(), buffer.size());
-    parser.set_handler(handler.get());
-    parser.parse();
+    {
+        import_profiler::scope profile_scope(get_profiler(), "workbook");
+        xml_stream_parser parser(
+            get_config(), mp_impl->m_ns_repo, ooxml_tokens,
+            buffer.data(), buffer.size());
+        parser.set_handler(handler.get());
+        parser.parse();
+    }
 
     // Get sheet info from the context instance.
     auto& context = static_cast<xlsx_workbook_context&>(handler->get_root_context());
@@ -403,7 +465,31 @@ void orcus_xlsx::read_workbook(const std::string& dir_path, const std::string& f
             return left.rid < right.rid;
         };
 
-    mp_impl->m_opc_reader.check_relation_part(file_name, &workbook_data, &sort_func);
+    // Inflate the shared strings, styles, pivot caches and the selected
+    // sheets ahead of time, while the preceding part is being parsed.
+    auto* selection = dynamic_cast<const selective_import_factory*>(mp_impl->mp_factory);
+    const bool has_styles = mp_impl->mp_factory->get_styles() != nullptr;
+
+    opc_reader::prefetch_filter_type prefetch_func =
+        [selection, has_styles](const opc_rel_t& rel, const opc_rel_extra* extra)
+        {
+            if (rel.type == SCH_od_rels_worksheet)
+            {
+                const auto* info = dynamic_cast<const xlsx_rel_sheet_info*>(extra);
+                if (!info || !info->id)
+                    return false;
+
+                return !selection || selection->is_selected(info->name);
+            }
+
+            if (rel.type == SCH_od_rels_styles)
+                return has_styles;
+
+            return rel.type == SCH_od_rels_shared_strings || rel.type == SCH_od_rels_pivot_cache_def;
+        };
+
+    mp_impl->m_opc_reader.check_relation_part(
+        file_name, &workbook_data, &sort_func, mp_impl->m_use_threads ? &prefetch_func : nullptr);
 }
 
 void orcus_xlsx::read_sheet(
@@ -413,6 +499,15 @@ void orcus_xlsx::read_sheet(
         // Sheet ID must not be 0.
         return;
 
+    auto* selection = dynamic_cast<const selective_import_factory*>(mp_impl->mp_factory);
+    if (selection && !selection->is_selected(data->name))
+    {
+        // Skip this sheet without decompressing its stream.
+        if (get_config().debug)
+            std::cout << "read_sheet: sheet '" << data->name << "' is not selected" << std::endl;
+        return;
+    }
+
     std::string filepath = resolve_file_path(dir_path, file_name);
     if (get_config().debug)
     {
@@ -447,18 +542,22 @@ void orcus_xlsx::read_sheet(
     if (!resolver)
         throw general_error("orcus_xlsx::read_sheet: reference resolver interface is not available.");
 
-    xml_stream_parser parser(
-        get_config(), mp_impl->m_ns_repo, ooxml_tokens,
-        buffer.data(), buffer.size());
-
     auto handler = std::make_unique<xlsx_sheet_xml_handler>(
         mp_impl->m_cxt, ooxml_tokens, data->id-1, *resolver, *sheet);
 
-    parser.set_handler(handler.get());
-    parser.parse();
+    std::string stage_name = "sheet: ";
+    stage_name += data->name;
+
+    {
+        // The sheet context skips the cell data past the selected range by
+        // itself, but keeps parsing the elements that follow it.
+        import_profiler::scope profile_scope(get_profiler(), stage_name);
+        mp_impl->parse_part(get_config(), buffer, *handler);
+    }
 
     opc_rel_extras_t table_info;
     handler->pop_rel_extras(table_info);
+
     handler.reset();
     mp_impl->m_opc_reader.check_relation_part(file_name, &table_info);
 }
@@ -479,17 +578,13 @@ void orcus_xlsx::read_shared_strings(const std::string& dir_path, const std::str
     if (buffer.empty())
         return;
 
-    xml_stream_parser parser(
-        get_config(), mp_impl->m_ns_repo, ooxml_tokens,
-        buffer.data(), buffer.size());
-
     auto handler = std::make_unique<xml_stream_handler>(
         mp_impl->m_cxt, ooxml_tokens,
         std::make_unique<xlsx_shared_strings_context>(
             mp_impl->m_cxt, ooxml_tokens, mp_impl->mp_factory->get_shared_strings()));
 
-    parser.set_handler(handler.get());
-    parser.parse();
+    import_profiler::scope profile_scope(get_profiler(), "shared strings");
+    mp_impl->parse_part(get_config(), buffer, *handler);
 }
 
 void orcus_xlsx::read_styles(const std::string& dir_path, const std::string& file_name)
@@ -513,17 +608,13 @@ void orcus_xlsx::read_styles(const std::string& dir_path, const std::string& fil
     if (buffer.empty())
         return;
 
-    xml_stream_parser parser(
-        get_config(), mp_impl->m_ns_repo, ooxml_tokens,
-        buffer.data(), buffer.size());
-
     auto handler = std::make_unique<xml_stream_handler>(
         mp_impl->m_cxt, ooxml_tokens,
         std::make_unique<xlsx_styles_context>(
             mp_impl->m_cxt, ooxml_tokens, mp_impl->mp_factory->get_styles()));
 
-    parser.set_handler(handler.get());
-    parser.parse();
+    import_profiler::scope profile_scope(get_profiler(), "styles");
+    mp_impl->parse_part(get_config(), buffer, *handler);
 }
 
 void orcus_xlsx::read_table(const std::string& dir_path, const std::string& file_name, xlsx_rel_table_info* data)
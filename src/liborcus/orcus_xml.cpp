@@ -6,13 +6,14 @@
  */
 
 #include <orcus/orcus_xml.hpp>
-#include <orcus/sax_ns_parser.hpp>
+#include <orcus/sax_parser.hpp>
 #include <orcus/spreadsheet/import_interface.hpp>
 #include <orcus/spreadsheet/export_interface.hpp>
 #include <orcus/stream.hpp>
 #include <orcus/string_pool.hpp>
 
 #include "orcus_xml_impl.hpp"
+#include "xml_map_automaton.hpp"
 #include "detection_result.hpp"
 
 #define ORCUS_DEBUG_XML 0
@@ -61,47 +62,135 @@ public:
     }
 };
 
-class xml_data_sax_handler : public sax_ns_handler
+/**
+ * Handler for the content stream of a mapped XML import.  It drives the
+ * automaton compiled from the map tree, and only resolves namespaces along
+ * the mapped paths.  Once an element takes no transition, the whole subtree
+ * under it is skipped with its attributes and namespace declarations, and
+ * only the names of its elements are tracked to detect mis-matching closing
+ * elements.
+ */
+class xml_data_sax_handler : public sax_handler
 {
     struct scope
     {
-        xml_name_t name;
+        std::string_view ns_alias;
+        std::string_view name;
+        xml_map_automaton::state_type state;
         std::ptrdiff_t element_open_begin;
         std::ptrdiff_t element_open_end;
 
-        xml_map_tree::element_type type;
-
-        scope(xmlns_id_t _ns, std::string_view _name) :
-            name(_ns, _name),
-            element_open_begin(0),
-            element_open_end(0),
-            type(xml_map_tree::element_type::unknown) {}
+        /** Namespace aliases declared in this element. */
+        std::vector<std::string_view> ns_keys;
     };
 
-    std::vector<sax_ns_parser_attribute> m_attrs;
+    /** Attributes of the current element, stored only when its parent is mapped. */
+    std::vector<sax::parser_attribute> m_attrs;
+    std::vector<std::string_view> m_ns_keys;
     std::vector<scope> m_scopes;
 
+    /** Names of the elements in the unmapped subtree being skipped. */
+    std::vector<std::pair<std::string_view, std::string_view>> m_skipped;
+
     string_pool m_pool;
+    xmlns_context& m_ns_cxt;
     spreadsheet::iface::import_factory& m_factory;
     xml_map_tree::const_element_list_type& m_link_positions;
     const xml_map_tree& m_map_tree;
-    xml_map_tree::walker m_map_tree_walker;
+    const xml_map_automaton& m_automaton;
 
     xml_map_tree::element* mp_current_elem;
     std::string_view m_current_chars;
     bool m_in_range_ref;
+    bool m_in_pi_block;
     xml_map_tree::range_reference* mp_increment_row;
 
 private:
 
-    const sax_ns_parser_attribute* find_attr_by_name(const xml_name_t& name)
+    xml_map_automaton::state_type get_current_state() const
     {
-        for (const sax_ns_parser_attribute& attr : m_attrs)
+        return m_scopes.empty() ? xml_map_automaton::initial_state : m_scopes.back().state;
+    }
+
+    /**
+     * Check whether the element being opened may be part of the map tree.
+     */
+    bool in_mapped_path() const
+    {
+        return m_skipped.empty() && m_automaton.has_transitions(get_current_state());
+    }
+
+    void push_namespaces()
+    {
+        for (const sax::parser_attribute& attr : m_attrs)
         {
-            if (attr.ns == name.ns && attr.name == name.name)
-                return &attr;
+            if (attr.ns.empty() && attr.name == "xmlns")
+            {
+                // Default namespace
+                m_ns_cxt.push(std::string_view{}, attr.value);
+                m_ns_keys.push_back(std::string_view{});
+            }
+            else if (attr.ns == "xmlns" && !attr.name.empty())
+            {
+                // Namespace alias
+                m_ns_cxt.push(attr.name, attr.value);
+                // The builtin 'xml' alias is never pushed to the context map, so don't track it for popping.
+                if (attr.name != XML_BUILTIN_NS_ALIAS)
+                    m_ns_keys.push_back(attr.name);
+            }
+        }
+    }
+
+    void pop_namespaces(const std::vector<std::string_view>& keys)
+    {
+        for (std::string_view key : keys)
+            m_ns_cxt.pop(key);
+    }
+
+    void skip_element(const sax::parser_element& elem)
+    {
+        m_skipped.emplace_back(elem.ns, elem.name);
+        mp_current_elem = nullptr;
+        m_attrs.clear();
+    }
+
+    void import_linked_attributes(xml_map_automaton::state_type state)
+    {
+        for (const sax::parser_attribute& attr : m_attrs)
+        {
+            if (attr.ns == "xmlns" || (attr.ns.empty() && attr.name == "xmlns"))
+                continue;
+
+            xmlns_id_t ns = attr.ns.empty() ? XMLNS_UNKNOWN_ID : m_ns_cxt.get(attr.ns);
+            xml_map_automaton::token_type token = m_automaton.get_token(ns, attr.name);
+            if (token == xml_map_automaton::unknown_token)
+                continue;
+
+            const xml_map_tree::attribute* p = m_automaton.get_attribute(state, token);
+            if (!p)
+                continue;
+
+            // This attribute is linked. Import its value.
+
+            const xml_map_tree::attribute& linked_attr = *p;
+            std::string_view val_trimmed = trim(attr.value);
+            switch (linked_attr.ref_type)
+            {
+                case xml_map_tree::reference_type::cell:
+                    set_single_link_cell(*linked_attr.cell_ref, val_trimmed);
+                    break;
+                case xml_map_tree::reference_type::range_field:
+                {
+                    set_field_link_cell(*linked_attr.field_ref, val_trimmed);
+                    break;
+                }
+                default:
+                    ;
+            }
+
+            // Record the namespace alias used in the content stream.
+            linked_attr.ns_alias = m_map_tree.intern_string(attr.ns);
         }
-        return nullptr;
     }
 
     void set_single_link_cell(const xml_map_tree::cell_reference& ref, std::string_view val)
@@ -127,162 +216,185 @@ private:
 
 public:
     xml_data_sax_handler(
+        xmlns_context& ns_cxt,
         spreadsheet::iface::import_factory& factory,
         xml_map_tree::const_element_list_type& link_positions,
-        const xml_map_tree& map_tree) :
+        const xml_map_tree& map_tree,
+        const xml_map_automaton& automaton) :
+        m_ns_cxt(ns_cxt),
         m_factory(factory),
         m_link_positions(link_positions),
         m_map_tree(map_tree),
-        m_map_tree_walker(map_tree.get_tree_walker()),
+        m_automaton(automaton),
         mp_current_elem(nullptr),
         m_in_range_ref(false),
+        m_in_pi_block(false),
         mp_increment_row(nullptr) {}
 
-    void doctype(const sax::doctype_declaration&)
+    void start_declaration()
     {
+        m_in_pi_block = true;
     }
 
     void end_declaration()
     {
-        m_attrs.clear();
+        m_in_pi_block = false;
+    }
+
+    void start_processing_instruction(std::string_view /*target*/)
+    {
+        m_in_pi_block = true;
     }
 
     void end_processing_instruction(std::string_view /*target*/)
     {
-        m_attrs.clear();
+        m_in_pi_block = false;
     }
 
-    void start_element(const sax_ns_parser_element& elem)
+    void start_element(const sax::parser_element& elem)
     {
-        m_scopes.emplace_back(elem.ns, elem.name);
-        scope& cur = m_scopes.back();
-        cur.element_open_begin = elem.begin_pos;
-        cur.element_open_end = elem.end_pos;
         m_current_chars = std::string_view{};
 
-        mp_current_elem = m_map_tree_walker.push_element({elem.ns, elem.name});
-        if (mp_current_elem)
+        if (!in_mapped_path())
         {
-            if (mp_current_elem->row_group && mp_increment_row == mp_current_elem->row_group)
-            {
-                // The last closing element was a row group boundary.  Increment the row position.
-                xml_map_tree::range_reference* ref = mp_current_elem->row_group;
-                ++ref->row_position;
-                mp_increment_row = nullptr;
-            }
+            skip_element(elem);
+            return;
+        }
 
-            // Go through all linked attributes that belong to this element,
-            // and see if they exist in this content xml.
-            for (const auto& p_attr : mp_current_elem->attributes)
-            {
-                const xml_map_tree::attribute& linked_attr = *p_attr;
-                const sax_ns_parser_attribute* p = find_attr_by_name(linked_attr.name);
-                if (!p)
-                    continue;
+        push_namespaces();
 
-                // This attribute is linked. Import its value.
+        xmlns_id_t ns = m_ns_cxt.get(elem.ns);
+        xml_map_automaton::token_type token = m_automaton.get_token(ns, elem.name);
+        xml_map_automaton::state_type state = xml_map_automaton::no_state;
+        if (token != xml_map_automaton::unknown_token)
+            state = m_automaton.transition(get_current_state(), token);
 
-                std::string_view val_trimmed = trim(p->value);
-                switch (linked_attr.ref_type)
-                {
-                    case xml_map_tree::reference_type::cell:
-                        set_single_link_cell(*linked_attr.cell_ref, val_trimmed);
-                        break;
-                    case xml_map_tree::reference_type::range_field:
-                    {
-                        set_field_link_cell(*linked_attr.field_ref, val_trimmed);
-                        break;
-                    }
-                    default:
-                        ;
-                }
+        if (state == xml_map_automaton::no_state)
+        {
+            // This element is not mapped.  The namespaces it declares only
+            // apply to the subtree being skipped.
+            pop_namespaces(m_ns_keys);
+            m_ns_keys.clear();
+            skip_element(elem);
+            return;
+        }
 
-                // Record the namespace alias used in the content stream.
-                linked_attr.ns_alias = m_map_tree.intern_string(p->ns_alias);
-            }
+        m_scopes.push_back({elem.ns, elem.name, state, elem.begin_pos, elem.end_pos, {}});
+        m_scopes.back().ns_keys.swap(m_ns_keys);
+
+        mp_current_elem = m_automaton.get_element(state);
+        assert(mp_current_elem);
 
-            if (mp_current_elem->range_parent)
-                m_in_range_ref = true;
+        if (mp_current_elem->row_group && mp_increment_row == mp_current_elem->row_group)
+        {
+            // The last closing element was a row group boundary.  Increment the row position.
+            xml_map_tree::range_reference* ref = mp_current_elem->row_group;
+            ++ref->row_position;
+            mp_increment_row = nullptr;
         }
+
+        if (m_automaton.has_attributes(state))
+            import_linked_attributes(state);
+
+        if (mp_current_elem->range_parent)
+            m_in_range_ref = true;
+
         m_attrs.clear();
     }
 
-    void end_element(const sax_ns_parser_element& elem)
+    void end_element(const sax::parser_element& elem)
     {
+        if (!m_skipped.empty())
+        {
+            const auto& [ns_alias, name] = m_skipped.back();
+            if (ns_alias != elem.ns || name != elem.name)
+                throw malformed_xml_error("mis-matching closing element.", -1);
+
+            m_skipped.pop_back();
+
+            if (m_skipped.empty() && !m_scopes.empty())
+                mp_current_elem = m_automaton.get_element(m_scopes.back().state);
+
+            return;
+        }
+
         assert(!m_scopes.empty());
+        assert(mp_current_elem);
 
-        if (mp_current_elem)
+        const scope& cur = m_scopes.back();
+        if (cur.ns_alias != elem.ns || cur.name != elem.name)
+            throw malformed_xml_error("mis-matching closing element.", -1);
+
+        switch (mp_current_elem->ref_type)
         {
-            switch (mp_current_elem->ref_type)
+            case xml_map_tree::reference_type::cell:
             {
-                case xml_map_tree::reference_type::cell:
-                {
-                    set_single_link_cell(*mp_current_elem->cell_ref, m_current_chars);
-                    break;
-                }
-                case xml_map_tree::reference_type::range_field:
-                {
-                    set_field_link_cell(*mp_current_elem->field_ref, m_current_chars);
-                    break;
-                }
-                default:
-                    ;
+                set_single_link_cell(*mp_current_elem->cell_ref, m_current_chars);
+                break;
+            }
+            case xml_map_tree::reference_type::range_field:
+            {
+                set_field_link_cell(*mp_current_elem->field_ref, m_current_chars);
+                break;
             }
+            default:
+                ;
+        }
 
-            if (mp_current_elem->row_group)
+        if (mp_current_elem->row_group)
+        {
+            // This element defines a row-group boundary.
+            spreadsheet::row_t row_start = mp_current_elem->row_group_position;
+            spreadsheet::row_t row_end = mp_current_elem->row_group->row_position - 1;
+            if (row_end > row_start)
             {
-                // This element defines a row-group boundary.
-                spreadsheet::row_t row_start = mp_current_elem->row_group_position;
-                spreadsheet::row_t row_end = mp_current_elem->row_group->row_position - 1;
-                if (row_end > row_start)
-                {
-                    // This is the end of a parent row-group.  Fill down the
-                    // cell values.
-                    const xml_map_tree::range_reference& ref = *mp_current_elem->row_group;
+                // This is the end of a parent row-group.  Fill down the
+                // cell values.
+                const xml_map_tree::range_reference& ref = *mp_current_elem->row_group;
 
-                    spreadsheet::iface::import_sheet* sheet = m_factory.get_sheet(ref.pos.sheet);
+                spreadsheet::iface::import_sheet* sheet = m_factory.get_sheet(ref.pos.sheet);
 
-                    if (sheet)
+                if (sheet)
+                {
+                    row_start += ref.pos.row + 1;
+                    row_end += ref.pos.row + 1;
+
+                    for (spreadsheet::col_t col : mp_current_elem->linked_range_fields)
                     {
-                        row_start += ref.pos.row + 1;
-                        row_end += ref.pos.row + 1;
-
-                        for (spreadsheet::col_t col : mp_current_elem->linked_range_fields)
-                        {
-                            col += ref.pos.col;
-                            sheet->fill_down_cells(row_start, col, row_end - row_start);
-                        }
+                        col += ref.pos.col;
+                        sheet->fill_down_cells(row_start, col, row_end - row_start);
                     }
                 }
-
-                mp_current_elem->row_group_position = mp_current_elem->row_group->row_position;
-                mp_increment_row = mp_current_elem->row_group;
             }
 
-            // Store the end element position in stream for linked elements.
-            const scope& cur = m_scopes.back();
-            if (mp_current_elem->ref_type == xml_map_tree::reference_type::cell ||
-                mp_current_elem->range_parent ||
-                (!m_in_range_ref && mp_current_elem->unlinked_attribute_anchor()))
-            {
-                // either single link element, parent of range link elements,
-                // or an unlinked attribute anchor outside linked ranges.
-                mp_current_elem->stream_pos.open_begin = cur.element_open_begin;
-                mp_current_elem->stream_pos.open_end = cur.element_open_end;
-                mp_current_elem->stream_pos.close_begin = elem.begin_pos;
-                mp_current_elem->stream_pos.close_end = elem.end_pos;
-                m_link_positions.push_back(mp_current_elem);
-            }
-
-            if (mp_current_elem->range_parent)
-                m_in_range_ref = false;
+            mp_current_elem->row_group_position = mp_current_elem->row_group->row_position;
+            mp_increment_row = mp_current_elem->row_group;
+        }
 
-            // Record the namespace alias used in the content stream.
-            mp_current_elem->ns_alias = m_map_tree.intern_string(elem.ns_alias);
+        // Store the end element position in stream for linked elements.
+        if (mp_current_elem->ref_type == xml_map_tree::reference_type::cell ||
+            mp_current_elem->range_parent ||
+            (!m_in_range_ref && mp_current_elem->unlinked_attribute_anchor()))
+        {
+            // either single link element, parent of range link elements,
+            // or an unlinked attribute anchor outside linked ranges.
+            mp_current_elem->stream_pos.open_begin = cur.element_open_begin;
+            mp_current_elem->stream_pos.open_end = cur.element_open_end;
+            mp_current_elem->stream_pos.close_begin = elem.begin_pos;
+            mp_current_elem->stream_pos.close_end = elem.end_pos;
+            m_link_positions.push_back(mp_current_elem);
         }
 
+        if (mp_current_elem->range_parent)
+            m_in_range_ref = false;
+
+        // Record the namespace alias used in the content stream.
+        mp_current_elem->ns_alias = m_map_tree.intern_string(elem.ns);
+
+        pop_namespaces(cur.ns_keys);
         m_scopes.pop_back();
-        mp_current_elem = m_map_tree_walker.pop_element({elem.ns, elem.name});
+
+        mp_current_elem = m_scopes.empty() ? nullptr : m_automaton.get_element(m_scopes.back().state);
     }
 
     void characters(std::string_view val, bool transient)
@@ -295,21 +407,40 @@ public:
             m_current_chars = m_pool.intern(m_current_chars).first;
     }
 
-    void attribute(std::string_view name, std::string_view val)
+    void attribute(const sax::parser_attribute& attr)
     {
-        if (name == "encoding")
+        if (m_in_pi_block)
         {
-            if (auto* gs = m_factory.get_global_settings(); gs)
+            // attribute of the XML declaration or of a processing instruction.
+            if (attr.name == "encoding")
             {
-                character_set_t cs = to_character_set(val);
-                gs->set_character_set(cs);
+                if (auto* gs = m_factory.get_global_settings(); gs)
+                {
+                    character_set_t cs = to_character_set(attr.value);
+                    gs->set_character_set(cs);
+                }
             }
+            return;
         }
-    }
 
-    void attribute(const sax_ns_parser_attribute& at)
-    {
-        m_attrs.push_back(at);
+        if (!in_mapped_path())
+            return;
+
+        for (const sax::parser_attribute& prev : m_attrs)
+        {
+            if (prev.ns == attr.ns && prev.name == attr.name)
+                throw malformed_xml_error(
+                    "You can't define two attributes of the same name in the same element.", -1);
+        }
+
+        m_attrs.push_back(attr);
+
+        if (attr.transient)
+        {
+            sax::parser_attribute& stored = m_attrs.back();
+            stored.value = m_pool.intern(attr.value).first;
+            stored.transient = false;
+        }
     }
 };
 
@@ -640,10 +771,11 @@ void orcus_xml::read_stream(std::string_view stream)
 
     // Parse the content xml.
     xmlns_context ns_cxt = mp_impl->ns_repo.create_context(); // new ns context for the content xml stream.
+    xml_map_automaton automaton(mp_impl->map_tree);
     xml_data_sax_handler handler(
-       *mp_impl->im_factory, mp_impl->link_positions, mp_impl->map_tree);
+       ns_cxt, *mp_impl->im_factory, mp_impl->link_positions, mp_impl->map_tree, automaton);
 
-    sax_ns_parser<xml_data_sax_handler> parser(stream, ns_cxt, handler);
+    sax_parser<xml_data_sax_handler> parser(stream, handler);
     parser.parse();
 
     mp_impl->im_factory->finalize();
@@ -14,6 +14,8 @@
 
 namespace orcus {
 
+class import_profiler;
+
 struct session_context
 {
     session_context(const session_context&) = delete;
@@ -32,6 +34,9 @@ struct session_context
 
     std::unique_ptr<custom_data> cdata;
 
+    /** Profiler to record the timings and counters to, if any. */
+    import_profiler* profiler = nullptr;
+
     session_context() = default;
     session_context(std::unique_ptr<custom_data> data);
 
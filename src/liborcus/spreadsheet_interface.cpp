@@ -116,6 +116,8 @@ import_sheet::~import_sheet() {}
 
 void import_sheet::set_string(row_t /*row*/, col_t /*col*/, std::string_view /*s*/) {}
 
+void import_sheet::end_row(row_t /*row*/) {}
+
 import_sheet_view* import_sheet::get_sheet_view()
 {
     return nullptr;
@@ -0,0 +1,578 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "spreadsheet_selection.hpp"
+
+#include <orcus/exception.hpp>
+
+#include <algorithm>
+#include <optional>
+#include <string>
+
+namespace ss = orcus::spreadsheet;
+
+namespace orcus {
+
+namespace {
+
+bool contains(const ss::range_t& range, ss::row_t row, ss::col_t col)
+{
+    return range.first.row <= row && row <= range.last.row
+        && range.first.column <= col && col <= range.last.column;
+}
+
+bool contains(const ss::range_t& outer, const ss::range_t& inner)
+{
+    return contains(outer, inner.first.row, inner.first.column)
+        && contains(outer, inner.last.row, inner.last.column);
+}
+
+/**
+ * Sheet whose content is not selected.  It discards all its content.
+ */
+class skipped_sheet : public ss::iface::import_sheet
+{
+    ss::range_size_t m_sheet_size;
+
+public:
+    skipped_sheet(ss::range_size_t sheet_size) : m_sheet_size(sheet_size) {}
+
+    virtual void set_auto(ss::row_t, ss::col_t, std::string_view) override {}
+    virtual void set_string(ss::row_t, ss::col_t, ss::string_id_t) override {}
+    virtual void set_string(ss::row_t, ss::col_t, std::string_view) override {}
+    virtual void set_value(ss::row_t, ss::col_t, double) override {}
+    virtual void set_bool(ss::row_t, ss::col_t, bool) override {}
+    virtual void set_date_time(ss::row_t, ss::col_t, int, int, int, int, int, double) override {}
+    virtual void set_format(ss::row_t, ss::col_t, std::size_t) override {}
+    virtual void set_format(ss::row_t, ss::col_t, ss::row_t, ss::col_t, std::size_t) override {}
+    virtual void set_column_format(ss::col_t, ss::col_t, std::size_t) override {}
+    virtual void set_row_format(ss::row_t, std::size_t) override {}
+    virtual void fill_down_cells(ss::row_t, ss::col_t, ss::row_t) override {}
+
+    virtual ss::range_size_t get_sheet_size() const override
+    {
+        return m_sheet_size;
+    }
+};
+
+/**
+ * Buffers the properties of a formula cell, and pushes them to the wrapped
+ * formula interface on commit only when the cell is inside the selected
+ * range.
+ */
+class clipped_formula : public ss::iface::import_formula
+{
+    enum class result_type { none, string, value, boolean, empty };
+
+    ss::iface::import_formula* mp_formula = nullptr;
+    const ss::range_t& m_range;
+
+    ss::address_t m_pos{-1, -1};
+    ss::formula_grammar_t m_grammar = ss::formula_grammar_t::unknown;
+    std::optional<std::string> m_formula;
+    std::optional<std::size_t> m_shared_index;
+
+    result_type m_result_type = result_type::none;
+    std::string m_result_string;
+    double m_result_value = 0.0;
+    bool m_result_bool = false;
+
+    void reset()
+    {
+        m_pos = {-1, -1};
+        m_grammar = ss::formula_grammar_t::unknown;
+        m_formula.reset();
+        m_shared_index.reset();
+        m_result_type = result_type::none;
+        m_result_string.clear();
+    }
+
+public:
+    clipped_formula(const ss::range_t& range) : m_range(range) {}
+
+    void reset(ss::iface::import_formula* formula)
+    {
+        mp_formula = formula;
+        reset();
+    }
+
+    virtual void set_position(ss::row_t row, ss::col_t col) override
+    {
+        m_pos = {row, col};
+    }
+
+    virtual void set_formula(ss::formula_grammar_t grammar, std::string_view formula) override
+    {
+        m_grammar = grammar;
+        m_formula = std::string{formula};
+    }
+
+    virtual void set_shared_formula_index(std::size_t index) override
+    {
+        m_shared_index = index;
+    }
+
+    virtual void set_result_string(std::string_view value) override
+    {
+        m_result_type = result_type::string;
+        m_result_string = value;
+    }
+
+    virtual void set_result_value(double value) override
+    {
+        m_result_type = result_type::value;
+        m_result_value = value;
+    }
+
+    virtual void set_result_bool(bool value) override
+    {
+        m_result_type = result_type::boolean;
+        m_result_bool = value;
+    }
+
+    virtual void set_result_empty() override
+    {
+        m_result_type = result_type::empty;
+    }
+
+    virtual void commit() override
+    {
+        // The master cell of a shared formula gets imported even when it's
+        // outside the range, as the cells inside the range may depend on it.
+        bool shared_master = m_formula && m_shared_index;
+
+        if (!contains(m_range, m_pos.row, m_pos.column) && !shared_master)
+        {
+            reset();
+            return;
+        }
+
+        mp_formula->set_position(m_pos.row, m_pos.column);
+
+        if (m_formula)
+            mp_formula->set_formula(m_grammar, *m_formula);
+
+        if (m_shared_index)
+            mp_formula->set_shared_formula_index(*m_shared_index);
+
+        switch (m_result_type)
+        {
+            case result_type::string:
+                mp_formula->set_result_string(m_result_string);
+                break;
+            case result_type::value:
+                mp_formula->set_result_value(m_result_value);
+                break;
+            case result_type::boolean:
+                mp_formula->set_result_bool(m_result_bool);
+                break;
+            case result_type::empty:
+                mp_formula->set_result_empty();
+                break;
+            case result_type::none:
+                break;
+        }
+
+        mp_formula->commit();
+        reset();
+    }
+};
+
+/**
+ * Passes an array formula through to the wrapped interface only when its
+ * entire range is inside the selected range.
+ */
+class clipped_array_formula : public ss::iface::import_array_formula
+{
+    ss::iface::import_array_formula* mp_array = nullptr;
+    const ss::range_t& m_range;
+    bool m_active = false;
+
+public:
+    clipped_array_formula(const ss::range_t& range) : m_range(range) {}
+
+    void reset(ss::iface::import_array_formula* array)
+    {
+        mp_array = array;
+        m_active = false;
+    }
+
+    virtual void set_range(const ss::range_t& range) override
+    {
+        m_active = contains(m_range, range);
+        if (m_active)
+            mp_array->set_range(range);
+    }
+
+    virtual void set_formula(ss::formula_grammar_t grammar, std::string_view formula) override
+    {
+        if (m_active)
+            mp_array->set_formula(grammar, formula);
+    }
+
+    virtual void set_result_string(ss::row_t row, ss::col_t col, std::string_view value) override
+    {
+        if (m_active)
+            mp_array->set_result_string(row, col, value);
+    }
+
+    virtual void set_result_value(ss::row_t row, ss::col_t col, double value) override
+    {
+        if (m_active)
+            mp_array->set_result_value(row, col, value);
+    }
+
+    virtual void set_result_bool(ss::row_t row, ss::col_t col, bool value) override
+    {
+        if (m_active)
+            mp_array->set_result_bool(row, col, value);
+    }
+
+    virtual void set_result_empty(ss::row_t row, ss::col_t col) override
+    {
+        if (m_active)
+            mp_array->set_result_empty(row, col);
+    }
+
+    virtual void commit() override
+    {
+        if (m_active)
+            mp_array->commit();
+
+        m_active = false;
+    }
+};
+
+/**
+ * Sheet that only passes through the cells that are inside the selected
+ * range.
+ */
+class clipped_sheet : public ss::iface::import_sheet
+{
+    ss::iface::import_sheet& m_sheet;
+    const ss::range_t m_range;
+    const bool m_stop_past_range;
+
+    clipped_formula m_formula;
+    clipped_array_formula m_array_formula;
+
+    /**
+     * Check whether or not a cell is inside the range, and signal the filter
+     * in case it has moved past the last row of the range.
+     */
+    bool check(ss::row_t row, ss::col_t col) const
+    {
+        if (m_stop_past_range && row > m_range.last.row)
+            throw selection_range_complete();
+
+        return contains(m_range, row, col);
+    }
+
+public:
+    clipped_sheet(ss::iface::import_sheet& sheet, const ss::range_t& range, bool stop_past_range) :
+        m_sheet(sheet), m_range(range), m_stop_past_range(stop_past_range),
+        m_formula(m_range), m_array_formula(m_range) {}
+
+    virtual ss::iface::import_sheet_view* get_sheet_view() override
+    {
+        return m_sheet.get_sheet_view();
+    }
+
+    virtual ss::iface::import_sheet_properties* get_sheet_properties() override
+    {
+        return m_sheet.get_sheet_properties();
+    }
+
+    virtual ss::iface::import_data_table* get_data_table() override
+    {
+        return m_sheet.get_data_table();
+    }
+
+    virtual ss::iface::import_auto_filter* start_auto_filter(const ss::range_t& range) override
+    {
+        return m_sheet.start_auto_filter(range);
+    }
+
+    virtual ss::iface::import_table* start_table() override
+    {
+        return m_sheet.start_table();
+    }
+
+    virtual ss::iface::import_conditional_format* get_conditional_format() override
+    {
+        return m_sheet.get_conditional_format();
+    }
+
+    virtual ss::iface::import_named_expression* get_named_expression() override
+    {
+        return m_sheet.get_named_expression();
+    }
+
+    virtual ss::iface::import_array_formula* get_array_formula() override
+    {
+        auto* array = m_sheet.get_array_formula();
+        if (!array)
+            return nullptr;
+
+        m_array_formula.reset(array);
+        return &m_array_formula;
+    }
+
+    virtual ss::iface::import_formula* get_formula() override
+    {
+        auto* formula = m_sheet.get_formula();
+        if (!formula)
+            return nullptr;
+
+        m_formula.reset(formula);
+        return &m_formula;
+    }
+
+    virtual void set_auto(ss::row_t row, ss::col_t col, std::string_view s) override
+    {
+        if (check(row, col))
+            m_sheet.set_auto(row, col, s);
+    }
+
+    virtual void set_string(ss::row_t row, ss::col_t col, ss::string_id_t sindex) override
+    {
+        if (check(row, col))
+            m_sheet.set_string(row, col, sindex);
+    }
+
+    virtual void set_string(ss::row_t row, ss::col_t col, std::string_view s) override
+    {
+        if (check(row, col))
+            m_sheet.set_string(row, col, s);
+    }
+
+    virtual void set_value(ss::row_t row, ss::col_t col, double value) override
+    {
+        if (check(row, col))
+            m_sheet.set_value(row, col, value);
+    }
+
+    virtual void set_bool(ss::row_t row, ss::col_t col, bool value) override
+    {
+        if (check(row, col))
+            m_sheet.set_bool(row, col, value);
+    }
+
+    virtual void set_date_time(
+        ss::row_t row, ss::col_t col,
+        int year, int month, int day, int hour, int minute, double second) override
+    {
+        if (check(row, col))
+            m_sheet.set_date_time(row, col, year, month, day, hour, minute, second);
+    }
+
+    virtual void set_format(ss::row_t row, ss::col_t col, std::size_t xf_index) override
+    {
+        if (check(row, col))
+            m_sheet.set_format(row, col, xf_index);
+    }
+
+    virtual void set_format(
+        ss::row_t row_start, ss::col_t col_start, ss::row_t row_end, ss::col_t col_end,
+        std::size_t xf_index) override
+    {
+        row_start = std::max(row_start, m_range.first.row);
+        col_start = std::max(col_start, m_range.first.column);
+        row_end = std::min(row_end, m_range.last.row);
+        col_end = std::min(col_end, m_range.last.column);
+
+        if (row_start <= row_end && col_start <= col_end)
+            m_sheet.set_format(row_start, col_start, row_end, col_end, xf_index);
+    }
+
+    virtual void set_column_format(ss::col_t col, ss::col_t col_span, std::size_t xf_index) override
+    {
+        ss::col_t col_end = std::min<ss::col_t>(col + col_span - 1, m_range.last.column);
+        col = std::max(col, m_range.first.column);
+
+        if (col <= col_end)
+            m_sheet.set_column_format(col, col_end - col + 1, xf_index);
+    }
+
+    virtual void set_row_format(ss::row_t row, std::size_t xf_index) override
+    {
+        if (check(row, m_range.first.column))
+            m_sheet.set_row_format(row, xf_index);
+    }
+
+    virtual void fill_down_cells(ss::row_t src_row, ss::col_t src_col, ss::row_t range_size) override
+    {
+        if (!contains(m_range, src_row, src_col))
+            return;
+
+        range_size = std::min<ss::row_t>(range_size, m_range.last.row - src_row);
+        if (range_size > 0)
+            m_sheet.fill_down_cells(src_row, src_col, range_size);
+    }
+
+    virtual void end_row(ss::row_t row) override
+    {
+        if (row >= m_range.first.row)
+            m_sheet.end_row(std::min(row, m_range.last.row));
+    }
+
+    virtual ss::range_size_t get_sheet_size() const override
+    {
+        return m_sheet.get_sheet_size();
+    }
+};
+
+} // anonymous namespace
+
+selection_range_complete::selection_range_complete() = default;
+
+selective_import_factory::selective_import_factory(
+    ss::iface::import_factory& factory, const config::sheet_selection& selection, bool stop_past_range) :
+    m_factory(factory), m_selection(selection), m_stop_past_range(stop_past_range)
+{
+    if (m_selection.range)
+    {
+        const ss::range_t& r = *m_selection.range;
+        if (r.first.row < 0 || r.first.column < 0 || r.last.row < r.first.row || r.last.column < r.first.column)
+            throw invalid_arg_error("selected cell range is invalid.");
+    }
+}
+
+selective_import_factory::~selective_import_factory() = default;
+
+ss::iface::import_sheet* selective_import_factory::wrap_sheet(ss::iface::import_sheet* sheet)
+{
+    if (!sheet)
+        return nullptr;
+
+    auto it = m_sheets.find(sheet);
+    if (it == m_sheets.end())
+        // This sheet was not appended during this import.  Leave it alone.
+        return sheet;
+
+    return it->second.wrapper ? it->second.wrapper.get() : sheet;
+}
+
+bool selective_import_factory::is_selected(std::string_view name) const
+{
+    const ss::iface::import_sheet* sheet = m_factory.get_sheet(name);
+    auto it = m_sheets.find(sheet);
+    return it == m_sheets.end() || it->second.selected;
+}
+
+ss::iface::import_global_settings* selective_import_factory::get_global_settings()
+{
+    return m_factory.get_global_settings();
+}
+
+ss::iface::import_shared_strings* selective_import_factory::get_shared_strings()
+{
+    return m_factory.get_shared_strings();
+}
+
+ss::iface::import_named_expression* selective_import_factory::get_named_expression()
+{
+    return m_factory.get_named_expression();
+}
+
+ss::iface::import_styles* selective_import_factory::get_styles()
+{
+    return m_factory.get_styles();
+}
+
+ss::iface::import_reference_resolver* selective_import_factory::get_reference_resolver(
+    ss::formula_ref_context_t cxt)
+{
+    return m_factory.get_reference_resolver(cxt);
+}
+
+ss::iface::import_pivot_cache_definition* selective_import_factory::create_pivot_cache_definition(
+    ss::pivot_cache_id_t cache_id)
+{
+    return m_factory.create_pivot_cache_definition(cache_id);
+}
+
+ss::iface::import_pivot_cache_records* selective_import_factory::create_pivot_cache_records(
+    ss::pivot_cache_id_t cache_id)
+{
+    return m_factory.create_pivot_cache_records(cache_id);
+}
+
+ss::iface::import_pivot_table_definition* selective_import_factory::create_pivot_table_definition()
+{
+    return m_factory.create_pivot_table_definition();
+}
+
+ss::iface::import_sheet* selective_import_factory::append_sheet(ss::sheet_t sheet_index, std::string_view name)
+{
+    ss::iface::import_sheet* sheet = m_factory.append_sheet(sheet_index, name);
+    if (!sheet)
+        return nullptr;
+
+    const auto& names = m_selection.names;
+    const auto& indices = m_selection.indices;
+
+    sheet_entry entry;
+    entry.selected = (names.empty() && indices.empty())
+        || std::find(names.begin(), names.end(), name) != names.end()
+        || std::find(indices.begin(), indices.end(), std::size_t(sheet_index)) != indices.end();
+
+    if (!entry.selected)
+        entry.wrapper = std::make_unique<skipped_sheet>(sheet->get_sheet_size());
+    else if (m_selection.range)
+    {
+        auto range = ss::clamp_range(*m_selection.range, sheet->get_sheet_size());
+        if (range)
+            entry.wrapper = std::make_unique<clipped_sheet>(*sheet, *range, m_stop_past_range);
+        else
+            // The range is entirely outside the sheet.
+            entry.wrapper = std::make_unique<skipped_sheet>(sheet->get_sheet_size());
+    }
+
+    auto [it, inserted] = m_sheets.insert_or_assign(sheet, std::move(entry));
+    return it->second.wrapper ? it->second.wrapper.get() : sheet;
+}
+
+ss::iface::import_sheet* selective_import_factory::get_sheet(std::string_view name)
+{
+    return wrap_sheet(m_factory.get_sheet(name));
+}
+
+ss::iface::import_sheet* selective_import_factory::get_sheet(ss::sheet_t sheet_index)
+{
+    return wrap_sheet(m_factory.get_sheet(sheet_index));
+}
+
+void selective_import_factory::finalize()
+{
+    m_factory.finalize();
+}
+
+selective_import_scope::selective_import_scope(
+    ss::iface::import_factory*& factory, const config::sheet_selection& selection, bool stop_past_range) :
+    m_factory(factory), m_original(factory)
+{
+    if (!m_factory || selection.empty())
+        return;
+
+    m_selective = std::make_unique<selective_import_factory>(*m_factory, selection, stop_past_range);
+    m_factory = m_selective.get();
+}
+
+selective_import_scope::~selective_import_scope()
+{
+    m_factory = m_original;
+}
+
+const selective_import_factory* selective_import_scope::get() const
+{
+    return m_selective.get();
+}
+
+} // namespace orcus
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
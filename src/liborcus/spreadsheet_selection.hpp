@@ -0,0 +1,116 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "orcus/spreadsheet/import_interface.hpp"
+#include "orcus/config.hpp"
+
+#include <memory>
+#include <unordered_map>
+
+namespace orcus {
+
+/**
+ * Thrown by a sheet wrapped by selective_import_factory when a cell below the
+ * selected range gets pushed, to signal the filter that it may stop parsing
+ * the current sheet stream.  It only gets thrown when the factory is created
+ * with stop_past_range set to true.
+ */
+class selection_range_complete
+{
+public:
+    selection_range_complete();
+};
+
+/**
+ * Import factory wrapper that filters out the content of unselected sheets,
+ * and the cells of selected sheets that fall outside the selected range.
+ * All other calls get passed through to the wrapped factory.
+ */
+class selective_import_factory : public spreadsheet::iface::import_factory
+{
+    struct sheet_entry
+    {
+        bool selected = false;
+        std::unique_ptr<spreadsheet::iface::import_sheet> wrapper;
+    };
+
+    using sheet_map_type = std::unordered_map<const spreadsheet::iface::import_sheet*, sheet_entry>;
+
+    spreadsheet::iface::import_factory& m_factory;
+    const config::sheet_selection& m_selection;
+    sheet_map_type m_sheets;
+    bool m_stop_past_range;
+
+    spreadsheet::iface::import_sheet* wrap_sheet(spreadsheet::iface::import_sheet* sheet);
+
+public:
+    selective_import_factory(
+        spreadsheet::iface::import_factory& factory,
+        const config::sheet_selection& selection, bool stop_past_range);
+
+    virtual ~selective_import_factory() override;
+
+    /**
+     * Check whether or not the content of a sheet is to be imported.
+     *
+     * @param name name of the sheet.  The sheet must have already been
+     *             appended.
+     *
+     * @return true if the sheet is selected, false otherwise.
+     */
+    bool is_selected(std::string_view name) const;
+
+    virtual spreadsheet::iface::import_global_settings* get_global_settings() override;
+    virtual spreadsheet::iface::import_shared_strings* get_shared_strings() override;
+    virtual spreadsheet::iface::import_named_expression* get_named_expression() override;
+    virtual spreadsheet::iface::import_styles* get_styles() override;
+    virtual spreadsheet::iface::import_reference_resolver* get_reference_resolver(
+        spreadsheet::formula_ref_context_t cxt) override;
+    virtual spreadsheet::iface::import_pivot_cache_definition* create_pivot_cache_definition(
+        spreadsheet::pivot_cache_id_t cache_id) override;
+    virtual spreadsheet::iface::import_pivot_cache_records* create_pivot_cache_records(
+        spreadsheet::pivot_cache_id_t cache_id) override;
+    virtual spreadsheet::iface::import_pivot_table_definition* create_pivot_table_definition() override;
+
+    virtual spreadsheet::iface::import_sheet* append_sheet(
+        spreadsheet::sheet_t sheet_index, std::string_view name) override;
+    virtual spreadsheet::iface::import_sheet* get_sheet(std::string_view name) override;
+    virtual spreadsheet::iface::import_sheet* get_sheet(spreadsheet::sheet_t sheet_index) override;
+    virtual void finalize() override;
+};
+
+/**
+ * Replaces the factory pointer of an import filter with a
+ * selective_import_factory instance for the duration of a single import, and
+ * restores the original pointer when it goes out of scope.  It does nothing
+ * when the selection is empty.
+ */
+class selective_import_scope
+{
+    spreadsheet::iface::import_factory*& m_factory;
+    spreadsheet::iface::import_factory* m_original;
+    std::unique_ptr<selective_import_factory> m_selective;
+
+public:
+    selective_import_scope(
+        spreadsheet::iface::import_factory*& factory,
+        const config::sheet_selection& selection, bool stop_past_range);
+
+    ~selective_import_scope();
+
+    /**
+     * @return pointer to the selective factory instance, or a @p nullptr if
+     *         the selection is empty.
+     */
+    const selective_import_factory* get() const;
+};
+
+} // namespace orcus
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
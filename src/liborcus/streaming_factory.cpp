@@ -0,0 +1,748 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <orcus/spreadsheet/streaming_factory.hpp>
+#include <orcus/string_pool.hpp>
+#include <orcus/parser_global.hpp>
+#include <orcus/exception.hpp>
+
+#include "a1_reference.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+namespace orcus { namespace spreadsheet {
+
+streamed_cell_t::streamed_cell_t() = default;
+streamed_cell_t::streamed_cell_t(col_t _column) : column(_column) {}
+streamed_cell_t::streamed_cell_t(const streamed_cell_t& other) = default;
+streamed_cell_t::~streamed_cell_t() = default;
+
+streamed_cell_t& streamed_cell_t::operator=(const streamed_cell_t& other) = default;
+
+streamed_row_t::streamed_row_t() = default;
+streamed_row_t::~streamed_row_t() = default;
+
+namespace {
+
+class streaming_sheet;
+
+class streaming_shared_strings : public iface::import_shared_strings
+{
+    string_pool m_pool;
+    std::vector<std::string_view> m_strings;
+    std::unordered_map<std::string_view, std::size_t> m_string_map;
+    std::string m_segments;
+
+public:
+    virtual std::size_t append(std::string_view s) override
+    {
+        s = m_pool.intern(s).first;
+        std::size_t index = m_strings.size();
+        m_strings.push_back(s);
+        m_string_map.insert({s, index});
+        return index;
+    }
+
+    virtual std::size_t add(std::string_view s) override
+    {
+        if (auto it = m_string_map.find(s); it != m_string_map.end())
+            return it->second;
+
+        return append(s);
+    }
+
+    // Formatting of string segments is not preserved.
+    virtual void set_segment_font(std::size_t) override {}
+    virtual void set_segment_bold(bool) override {}
+    virtual void set_segment_italic(bool) override {}
+    virtual void set_segment_superscript(bool) override {}
+    virtual void set_segment_subscript(bool) override {}
+    virtual void set_segment_font_name(std::string_view) override {}
+    virtual void set_segment_font_size(double) override {}
+    virtual void set_segment_font_color(color_elem_t, color_elem_t, color_elem_t, color_elem_t) override {}
+
+    virtual void append_segment(std::string_view s) override
+    {
+        m_segments.append(s);
+    }
+
+    virtual std::size_t commit_segments() override
+    {
+        std::size_t index = append(m_segments);
+        m_segments.clear();
+        return index;
+    }
+
+    std::string_view get(std::size_t index) const
+    {
+        return index < m_strings.size() ? m_strings[index] : std::string_view{};
+    }
+
+    std::size_t size() const
+    {
+        return m_strings.size();
+    }
+};
+
+/**
+ * Resolves cell and range addresses in A1 notation, optionally prefixed by a
+ * sheet name.
+ */
+class streaming_reference_resolver : public iface::import_reference_resolver
+{
+    const std::unordered_map<std::string, sheet_t>& m_sheet_map;
+
+    sheet_t resolve_sheet(std::string_view& s) const
+    {
+        auto pos = s.rfind('!');
+        if (pos == std::string_view::npos)
+            return 0;
+
+        std::string name{s.substr(0, pos)};
+        s = s.substr(pos + 1);
+
+        if (name.size() >= 2 && name.front() == '\'' && name.back() == '\'')
+        {
+            // unquote, and unescape the doubled single quotes.
+            std::string unquoted;
+            for (std::size_t i = 1; i + 1 < name.size(); ++i)
+            {
+                unquoted.push_back(name[i]);
+                if (name[i] == '\'' && name[i + 1] == '\'')
+                    ++i;
+            }
+            name.swap(unquoted);
+        }
+
+        auto it = m_sheet_map.find(name);
+        if (it == m_sheet_map.end())
+            throw invalid_arg_error("unknown sheet name in a reference.");
+
+        return it->second;
+    }
+
+public:
+    streaming_reference_resolver(const std::unordered_map<std::string, sheet_t>& sheet_map) :
+        m_sheet_map(sheet_map) {}
+
+    virtual src_address_t resolve_address(std::string_view address) override
+    {
+        sheet_t sheet = resolve_sheet(address);
+
+        auto addr = parse_a1_address(address);
+        if (!addr)
+            throw invalid_arg_error("not a valid single cell address.");
+
+        return src_address_t{sheet, addr->row, addr->column};
+    }
+
+    virtual src_range_t resolve_range(std::string_view range) override
+    {
+        sheet_t sheet = resolve_sheet(range);
+
+        auto v = parse_a1_range(range);
+        if (!v)
+            throw invalid_arg_error("not a valid range address.");
+
+        return src_range_t{
+            {sheet, v->first.row, v->first.column},
+            {sheet, v->last.row, v->last.column}
+        };
+    }
+};
+
+struct factory_state
+{
+    streaming_import_factory::row_handler_type handler;
+    streaming_shared_strings shared_strings;
+    std::unordered_map<std::string, sheet_t> sheet_map;
+    streaming_reference_resolver resolver{sheet_map};
+    range_size_t sheet_size{1048576, 16384};
+
+    /** Sheet whose row is currently being populated. */
+    streaming_sheet* active_sheet = nullptr;
+};
+
+class streaming_formula : public iface::import_formula
+{
+    iface::import_sheet& m_sheet;
+
+    row_t m_row = 0;
+    col_t m_col = 0;
+    std::variant<std::monostate, bool, double, std::string> m_result;
+
+public:
+    streaming_formula(iface::import_sheet& sheet) : m_sheet(sheet) {}
+
+    virtual void set_position(row_t row, col_t col) override
+    {
+        m_row = row;
+        m_col = col;
+    }
+
+    virtual void set_formula(formula_grammar_t, std::string_view) override {}
+    virtual void set_shared_formula_index(std::size_t) override {}
+
+    virtual void set_result_string(std::string_view value) override
+    {
+        m_result = std::string{value};
+    }
+
+    virtual void set_result_value(double value) override
+    {
+        m_result = value;
+    }
+
+    virtual void set_result_bool(bool value) override
+    {
+        m_result = value;
+    }
+
+    virtual void set_result_empty() override
+    {
+        m_result = std::monostate{};
+    }
+
+    virtual void commit() override
+    {
+        switch (m_result.index())
+        {
+            case 1:
+                m_sheet.set_bool(m_row, m_col, std::get<bool>(m_result));
+                break;
+            case 2:
+                m_sheet.set_value(m_row, m_col, std::get<double>(m_result));
+                break;
+            case 3:
+                m_sheet.set_string(m_row, m_col, std::get<std::string>(m_result));
+                break;
+            default:
+                break;
+        }
+
+        m_result = std::monostate{};
+    }
+};
+
+class streaming_array_formula : public iface::import_array_formula
+{
+    iface::import_sheet& m_sheet;
+
+public:
+    streaming_array_formula(iface::import_sheet& sheet) : m_sheet(sheet) {}
+
+    virtual void set_range(const range_t&) override {}
+    virtual void set_formula(formula_grammar_t, std::string_view) override {}
+
+    virtual void set_result_string(row_t row, col_t col, std::string_view value) override
+    {
+        m_sheet.set_string(row, col, value);
+    }
+
+    virtual void set_result_value(row_t row, col_t col, double value) override
+    {
+        m_sheet.set_value(row, col, value);
+    }
+
+    virtual void set_result_bool(row_t row, col_t col, bool value) override
+    {
+        m_sheet.set_bool(row, col, value);
+    }
+
+    virtual void set_result_empty(row_t, col_t) override {}
+    virtual void commit() override {}
+};
+
+class streaming_sheet : public iface::import_sheet
+{
+    struct cell_entry
+    {
+        streamed_cell_t cell;
+        bool has_xf = false;
+    };
+
+    /**
+     * Cell to be duplicated down to the rows below its row, as requested via
+     * fill_down_cells().
+     */
+    struct fill_down_entry
+    {
+        streamed_cell_t cell;
+        std::string str; // storage for a string value
+        row_t last_row;
+    };
+
+    factory_state& m_state;
+    streaming_formula m_formula;
+    streaming_array_formula m_array_formula;
+
+    sheet_t m_index;
+    std::string m_name;
+
+    row_t m_row = -1; // row currently being populated
+    row_t m_last_row = -1; // last row delivered so far
+    std::vector<cell_entry> m_cells;
+    std::deque<std::string> m_strings; // storage for the string values of the current row
+
+    /**
+     * Cells pushed to the rows already delivered, such as the formula cells
+     * that the filter pushes after reading all sheets.  They are held until
+     * the end of the import so that each of these rows gets delivered only
+     * once more.
+     */
+    std::map<row_t, std::vector<cell_entry>> m_late_rows;
+    std::deque<std::string> m_late_strings;
+
+    std::vector<fill_down_entry> m_fill_downs;
+    std::map<row_t, std::size_t> m_row_formats;
+    std::vector<std::pair<range_t, std::size_t>> m_range_formats;
+    std::vector<std::pair<range_t, std::size_t>> m_column_formats; // only the column positions are used
+
+    streamed_row_t m_out;
+
+    static cell_entry& find_cell(std::vector<cell_entry>& cells, col_t col)
+    {
+        if (!cells.empty() && cells.back().cell.column == col)
+            return cells.back();
+
+        auto it = std::find_if(cells.begin(), cells.end(),
+            [col](const cell_entry& e) { return e.cell.column == col; });
+
+        if (it != cells.end())
+            return *it;
+
+        cells.emplace_back();
+        cells.back().cell.column = col;
+        return cells.back();
+    }
+
+    bool is_late(row_t row) const
+    {
+        return row != m_row && row <= m_last_row;
+    }
+
+    cell_entry& get_cell(row_t row, col_t col)
+    {
+        if (is_late(row))
+            return find_cell(m_late_rows[row], col);
+
+        prepare_row(row);
+        return find_cell(m_cells, col);
+    }
+
+    /**
+     * Store a string value so that it stays valid until the row it belongs
+     * to gets delivered.
+     */
+    std::string_view store_string(row_t row, std::string_view s)
+    {
+        auto& store = is_late(row) ? m_late_strings : m_strings;
+        return store.emplace_back(s);
+    }
+
+    std::size_t resolve_xf(row_t row, const cell_entry& e) const
+    {
+        if (e.has_xf)
+            return e.cell.xf;
+
+        for (auto it = m_range_formats.rbegin(); it != m_range_formats.rend(); ++it)
+        {
+            const range_t& range = it->first;
+            if (range.first.row <= row && row <= range.last.row &&
+                range.first.column <= e.cell.column && e.cell.column <= range.last.column)
+                return it->second;
+        }
+
+        if (auto it = m_row_formats.find(row); it != m_row_formats.end())
+            return it->second;
+
+        for (auto it = m_column_formats.rbegin(); it != m_column_formats.rend(); ++it)
+        {
+            const range_t& range = it->first;
+            if (range.first.column <= e.cell.column && e.cell.column <= range.last.column)
+                return it->second;
+        }
+
+        return 0;
+    }
+
+    void deliver_row(row_t row, std::vector<cell_entry>& cells)
+    {
+        if (cells.empty())
+            return;
+
+        std::stable_sort(cells.begin(), cells.end(),
+            [](const cell_entry& left, const cell_entry& right)
+            {
+                return left.cell.column < right.cell.column;
+            }
+        );
+
+        m_out.row = row;
+        m_out.cells.clear();
+        m_out.cells.reserve(cells.size());
+
+        for (const cell_entry& e : cells)
+        {
+            m_out.cells.push_back(e.cell);
+            m_out.cells.back().xf = resolve_xf(row, e);
+        }
+
+        m_last_row = std::max(m_last_row, row);
+
+        if (m_state.handler)
+            m_state.handler(m_out);
+    }
+
+    void deliver_current_row()
+    {
+        deliver_row(m_row, m_cells);
+    }
+
+    /**
+     * Deliver the current row, and the rows duplicated from it via
+     * fill_down_cells() that precede the next row to be populated.
+     *
+     * @param next_row next row to be populated.
+     */
+    void flush(row_t next_row)
+    {
+        if (m_row < 0)
+            return;
+
+        deliver_current_row();
+        m_cells.clear();
+        m_strings.clear();
+
+        row_t flushed = m_row;
+
+        if (!m_fill_downs.empty())
+        {
+            row_t end = flushed;
+            for (const auto& fd : m_fill_downs)
+                end = std::max(end, fd.last_row);
+
+            if (next_row > flushed)
+                end = std::min(end, next_row - 1);
+
+            for (row_t row = flushed + 1; row <= end; ++row)
+            {
+                m_row = row;
+                for (const auto& fd : m_fill_downs)
+                {
+                    if (fd.last_row < row)
+                        continue;
+
+                    m_cells.push_back({fd.cell, false});
+                    if (fd.cell.type == streamed_cell_t::cell_type::string)
+                        m_cells.back().cell.value = std::string_view{fd.str};
+                }
+
+                deliver_current_row();
+                m_cells.clear();
+            }
+
+            flushed = end;
+
+            // Drop the fill-down entries that have been exhausted.
+            row_t limit = next_row > flushed ? next_row : std::numeric_limits<row_t>::max();
+            auto it_end = std::remove_if(m_fill_downs.begin(), m_fill_downs.end(),
+                [limit](const fill_down_entry& fd) { return fd.last_row < limit; });
+            m_fill_downs.erase(it_end, m_fill_downs.end());
+        }
+
+        // Drop the formats that only apply to the rows already delivered.
+        m_row_formats.erase(m_row_formats.begin(), m_row_formats.upper_bound(flushed));
+
+        auto it_end = std::remove_if(m_range_formats.begin(), m_range_formats.end(),
+            [flushed](const auto& v) { return v.first.last.row <= flushed; });
+        m_range_formats.erase(it_end, m_range_formats.end());
+
+        m_row = -1;
+    }
+
+    void prepare_row(row_t row)
+    {
+        if (m_state.active_sheet != this)
+        {
+            if (m_state.active_sheet)
+                m_state.active_sheet->flush_all();
+            m_state.active_sheet = this;
+        }
+
+        if (row == m_row)
+            return;
+
+        flush(row);
+        m_row = row;
+
+        // Seed the new row with the cells filled down from the rows above.
+        for (const auto& fd : m_fill_downs)
+        {
+            m_cells.push_back({fd.cell, false});
+            if (fd.cell.type == streamed_cell_t::cell_type::string)
+                m_cells.back().cell.value = std::string_view{m_strings.emplace_back(fd.str)};
+        }
+    }
+
+public:
+    streaming_sheet(factory_state& state, sheet_t index, std::string_view name) :
+        m_state(state), m_formula(*this), m_array_formula(*this),
+        m_index(index), m_name(name)
+    {
+        m_out.sheet = m_index;
+        m_out.sheet_name = m_name;
+    }
+
+    void flush_all()
+    {
+        flush(-1);
+    }
+
+    /**
+     * Deliver the cells pushed to the rows that had already been delivered.
+     */
+    void flush_late_rows()
+    {
+        for (auto& [row, cells] : m_late_rows)
+            deliver_row(row, cells);
+
+        m_late_rows.clear();
+        m_late_strings.clear();
+    }
+
+    virtual iface::import_array_formula* get_array_formula() override
+    {
+        return &m_array_formula;
+    }
+
+    virtual iface::import_formula* get_formula() override
+    {
+        return &m_formula;
+    }
+
+    virtual void set_auto(row_t row, col_t col, std::string_view s) override
+    {
+        if (s.empty())
+            return;
+
+        double val;
+        const char* end = s.data() + s.size();
+        if (parse_numeric(s.data(), end, val) == end)
+            set_value(row, col, val);
+        else
+            set_string(row, col, s);
+    }
+
+    virtual void set_string(row_t row, col_t col, string_id_t sindex) override
+    {
+        cell_entry& e = get_cell(row, col);
+        e.cell.type = streamed_cell_t::cell_type::string;
+        e.cell.value = m_state.shared_strings.get(sindex);
+    }
+
+    virtual void set_string(row_t row, col_t col, std::string_view s) override
+    {
+        cell_entry& e = get_cell(row, col);
+        e.cell.type = streamed_cell_t::cell_type::string;
+        e.cell.value = store_string(row, s);
+    }
+
+    virtual void set_value(row_t row, col_t col, double value) override
+    {
+        cell_entry& e = get_cell(row, col);
+        e.cell.type = streamed_cell_t::cell_type::numeric;
+        e.cell.value = value;
+    }
+
+    virtual void set_bool(row_t row, col_t col, bool value) override
+    {
+        cell_entry& e = get_cell(row, col);
+        e.cell.type = streamed_cell_t::cell_type::boolean;
+        e.cell.value = value;
+    }
+
+    virtual void set_date_time(
+        row_t row, col_t col, int year, int month, int day, int hour, int minute, double second) override
+    {
+        cell_entry& e = get_cell(row, col);
+        e.cell.type = streamed_cell_t::cell_type::date_time;
+        e.cell.value = date_time_t(year, month, day, hour, minute, second);
+    }
+
+    virtual void set_format(row_t row, col_t col, std::size_t xf_index) override
+    {
+        cell_entry& e = get_cell(row, col);
+        e.cell.xf = xf_index;
+        e.has_xf = true;
+    }
+
+    virtual void set_format(
+        row_t row_start, col_t col_start, row_t row_end, col_t col_end, std::size_t xf_index) override
+    {
+        range_t range{{row_start, col_start}, {row_end, col_end}};
+        m_range_formats.emplace_back(range, xf_index);
+    }
+
+    virtual void set_column_format(col_t col, col_t col_span, std::size_t xf_index) override
+    {
+        range_t range{{0, col}, {0, col + col_span - 1}};
+        m_column_formats.emplace_back(range, xf_index);
+    }
+
+    virtual void set_row_format(row_t row, std::size_t xf_index) override
+    {
+        m_row_formats.insert_or_assign(row, xf_index);
+    }
+
+    virtual void fill_down_cells(row_t src_row, col_t src_col, row_t range_size) override
+    {
+        if (range_size <= 0)
+            return;
+
+        if (auto it = m_late_rows.find(src_row); it != m_late_rows.end())
+        {
+            // The source cell belongs to a row already delivered, which is
+            // the case for a formula cell.  Its copies get delivered with it.
+            auto it_src = std::find_if(it->second.begin(), it->second.end(),
+                [src_col](const cell_entry& e) { return e.cell.column == src_col; });
+
+            if (it_src == it->second.end())
+                return;
+
+            cell_entry src = *it_src;
+            src.cell.xf = 0;
+            src.has_xf = false;
+
+            for (row_t row = src_row + 1; row <= src_row + range_size; ++row)
+                find_cell(m_late_rows[row], src_col) = src;
+
+            return;
+        }
+
+        if (src_row != m_row)
+            // The source cell has already been delivered.
+            return;
+
+        auto it = std::find_if(m_cells.begin(), m_cells.end(),
+            [src_col](const cell_entry& e) { return e.cell.column == src_col; });
+
+        if (it == m_cells.end())
+            return;
+
+        fill_down_entry fd{it->cell, std::string{}, src_row + range_size};
+        fd.cell.xf = 0;
+        if (fd.cell.type == streamed_cell_t::cell_type::string)
+            fd.str = std::get<std::string_view>(fd.cell.value);
+
+        m_fill_downs.push_back(std::move(fd));
+    }
+
+    virtual void end_row(row_t row) override
+    {
+        if (m_row >= 0 && m_row <= row)
+            flush_all();
+    }
+
+    virtual range_size_t get_sheet_size() const override
+    {
+        return m_state.sheet_size;
+    }
+};
+
+} // anonymous namespace
+
+struct streaming_import_factory::impl
+{
+    factory_state state;
+    std::vector<std::unique_ptr<streaming_sheet>> sheets;
+};
+
+streaming_import_factory::streaming_import_factory(row_handler_type handler) :
+    mp_impl(std::make_unique<impl>())
+{
+    mp_impl->state.handler = std::move(handler);
+}
+
+streaming_import_factory::~streaming_import_factory() = default;
+
+iface::import_shared_strings* streaming_import_factory::get_shared_strings()
+{
+    return &mp_impl->state.shared_strings;
+}
+
+iface::import_reference_resolver* streaming_import_factory::get_reference_resolver(formula_ref_context_t cxt)
+{
+    // Only the references in the A1 notation are supported.
+    return cxt == formula_ref_context_t::global ? &mp_impl->state.resolver : nullptr;
+}
+
+iface::import_sheet* streaming_import_factory::append_sheet(sheet_t sheet_index, std::string_view name)
+{
+    if (sheet_index != static_cast<sheet_t>(mp_impl->sheets.size()))
+        return nullptr;
+
+    mp_impl->sheets.push_back(
+        std::make_unique<streaming_sheet>(mp_impl->state, sheet_index, name));
+    mp_impl->state.sheet_map.insert({std::string{name}, sheet_index});
+    return mp_impl->sheets.back().get();
+}
+
+iface::import_sheet* streaming_import_factory::get_sheet(std::string_view name)
+{
+    auto it = mp_impl->state.sheet_map.find(std::string{name});
+    return it == mp_impl->state.sheet_map.end() ? nullptr : mp_impl->sheets[it->second].get();
+}
+
+iface::import_sheet* streaming_import_factory::get_sheet(sheet_t sheet_index)
+{
+    if (sheet_index < 0 || std::size_t(sheet_index) >= mp_impl->sheets.size())
+        return nullptr;
+
+    return mp_impl->sheets[sheet_index].get();
+}
+
+void streaming_import_factory::finalize()
+{
+    if (mp_impl->state.active_sheet)
+    {
+        mp_impl->state.active_sheet->flush_all();
+        mp_impl->state.active_sheet = nullptr;
+    }
+
+    for (auto& sheet : mp_impl->sheets)
+        sheet->flush_late_rows();
+}
+
+void streaming_import_factory::set_default_row_size(row_t row_size)
+{
+    mp_impl->state.sheet_size.rows = row_size;
+}
+
+void streaming_import_factory::set_default_column_size(col_t col_size)
+{
+    mp_impl->state.sheet_size.columns = col_size;
+}
+
+std::string_view streaming_import_factory::get_shared_string(string_id_t sindex) const
+{
+    return mp_impl->state.shared_strings.get(sindex);
+}
+
+std::size_t streaming_import_factory::get_shared_string_count() const
+{
+    return mp_impl->state.shared_strings.size();
+}
+
+}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,271 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "test_global.hpp"
+#include "filter_env.hpp"
+#include <orcus/spreadsheet/streaming_factory.hpp>
+#include <orcus/orcus_csv.hpp>
+
+#if XLSX_ENABLED
+#include <orcus/orcus_xlsx.hpp>
+#endif
+#if ODS_ENABLED
+#include <orcus/orcus_ods.hpp>
+#endif
+#if GNUMERIC_ENABLED
+#include <orcus/orcus_gnumeric.hpp>
+#endif
+
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace orcus;
+namespace ss = orcus::spreadsheet;
+
+namespace {
+
+/**
+ * Convert each delivered row into a single line of text, for easy
+ * comparison.
+ */
+class row_recorder
+{
+    std::vector<std::string> m_rows;
+
+public:
+    void operator()(const ss::streamed_row_t& row)
+    {
+        std::ostringstream os;
+        os << row.sheet_name << '/' << row.row << ':';
+
+        for (const auto& cell : row.cells)
+        {
+            os << ' ' << cell.column << '=';
+
+            switch (cell.type)
+            {
+                case ss::streamed_cell_t::cell_type::empty:
+                    os << "(empty)";
+                    break;
+                case ss::streamed_cell_t::cell_type::boolean:
+                    os << (std::get<bool>(cell.value) ? "true" : "false");
+                    break;
+                case ss::streamed_cell_t::cell_type::numeric:
+                    os << std::get<double>(cell.value);
+                    break;
+                case ss::streamed_cell_t::cell_type::string:
+                    os << '"' << std::get<std::string_view>(cell.value) << '"';
+                    break;
+                case ss::streamed_cell_t::cell_type::date_time:
+                    os << std::get<date_time_t>(cell.value).to_string();
+                    break;
+            }
+
+            if (cell.xf)
+                os << "@" << cell.xf;
+        }
+
+        m_rows.push_back(os.str());
+    }
+
+    const std::vector<std::string>& get() const { return m_rows; }
+};
+
+} // anonymous namespace
+
+void test_streaming_csv()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    row_recorder rec;
+    ss::streaming_import_factory factory([&rec](const ss::streamed_row_t& row) { rec(row); });
+
+    orcus_csv app(&factory);
+    app.read_stream("a,1\n,2.5\n\nlast,x\n");
+
+    const std::vector<std::string> expected = {
+        "data/0: 0=\"a\" 1=1",
+        "data/1: 1=2.5",
+        "data/3: 0=\"last\" 1=\"x\"",
+    };
+
+    for (const auto& row : rec.get())
+        std::cout << row << std::endl;
+
+    assert(rec.get() == expected);
+}
+
+void test_streaming_row_delivery()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    row_recorder rec;
+    ss::streaming_import_factory factory([&rec](const ss::streamed_row_t& row) { rec(row); });
+
+    auto* ss_strings = factory.get_shared_strings();
+    assert(ss_strings);
+    std::size_t s_foo = ss_strings->add("foo");
+    std::size_t s_bar = ss_strings->add("bar");
+    assert(ss_strings->add("foo") == s_foo);
+    assert(factory.get_shared_string_count() == 2);
+
+    auto* sh1 = factory.append_sheet(0, "One");
+    auto* sh2 = factory.append_sheet(1, "Two");
+    assert(sh1 && sh2);
+    assert(factory.get_sheet("Two") == sh2);
+
+    sh1->set_column_format(0, 2, 7);
+    sh1->set_row_format(1, 3);
+
+    // cells pushed out of column order get sorted.
+    sh1->set_string(0, 2, s_bar);
+    sh1->set_value(0, 0, 1.0);
+    sh1->set_format(0, 0, 5);
+    assert(rec.get().empty()); // row 0 is still open
+
+    sh1->set_bool(1, 1, true);
+    assert(rec.get().size() == 1);
+
+    // row 2 gets repeated twice, with the range format applied to its 2nd repeat.
+    sh1->set_string(2, 0, s_foo);
+    sh1->fill_down_cells(2, 0, 2);
+    sh1->set_format(3, 0, 3, 0, 9);
+
+    // row 4 is still within the filled range, and overwrites the filled value.
+    sh1->set_value(4, 0, 42.0);
+
+    // Moving to another sheet completes the last row of the first sheet.
+    sh2->set_date_time(0, 0, 2024, 2, 29, 12, 30, 0.0);
+    assert(rec.get().size() == 5);
+
+    // The end of a row signaled by the filter completes it.
+    sh2->end_row(0);
+    assert(rec.get().size() == 6);
+
+    // A cell pushed behind the rows already delivered comes as its own row.
+    sh1->get_formula()->set_position(0, 1);
+    sh1->get_formula()->set_result_value(3.0);
+    sh1->get_formula()->commit();
+
+    factory.finalize();
+
+    const std::vector<std::string> expected = {
+        "One/0: 0=1@5 2=\"bar\"",
+        "One/1: 1=true@3",
+        "One/2: 0=\"foo\"@7",
+        "One/3: 0=\"foo\"@9",
+        "One/4: 0=42@7",
+        "Two/0: 0=2024-02-29T12:30:00",
+        "One/0: 1=3@7",
+    };
+
+    for (const auto& row : rec.get())
+        std::cout << row << std::endl;
+
+    assert(rec.get() == expected);
+}
+
+void test_streaming_xlsx()
+{
+#if XLSX_ENABLED
+    ORCUS_TEST_FUNC_SCOPE;
+
+    row_recorder rec;
+    ss::streaming_import_factory factory([&rec](const ss::streamed_row_t& row) { rec(row); });
+
+    orcus_xlsx app(&factory);
+    app.read_file(SRCDIR"/test/xlsx/formula-no-calc-chain/input.xlsx");
+
+    // The formula cells get pushed after all sheets have been read, and come
+    // after the other rows, once for each row.
+    const std::vector<std::string> expected = {
+        "Sheet1/0: 0=1",
+        "Sheet1/1: 0=2",
+        "Sheet1/2: 1=5",
+        "Sheet1/0: 1=10",
+        "Sheet1/1: 1=20",
+        "Sheet1/2: 0=3",
+    };
+
+    for (const auto& row : rec.get())
+        std::cout << row << std::endl;
+
+    assert(rec.get() == expected);
+#endif
+}
+
+void test_streaming_ods()
+{
+#if ODS_ENABLED
+    ORCUS_TEST_FUNC_SCOPE;
+
+    row_recorder rec;
+    ss::streaming_import_factory factory([&rec](const ss::streamed_row_t& row) { rec(row); });
+
+    orcus_ods app(&factory);
+    app.read_file(SRCDIR"/test/ods/sheet-selection/input.ods");
+
+    const std::vector<std::string> expected = {
+        "Data/0: 0=1 1=10",
+        "Data/1: 0=2",
+        "Data/2: 0=3 1=30",
+        "Data/3: 0=4 1=40",
+        "Data/5: 0=\"Name\" 1=\"Value\"",
+        "Data/6: 0=\"A\" 1=700",
+        "Data/7: 0=\"B\" 1=800",
+        "Data/8: 0=\"C\" 1=900",
+        "Data/9: 0=\"D\" 1=1000",
+        "Other/0: 0=5",
+    };
+
+    for (const auto& row : rec.get())
+        std::cout << row << std::endl;
+
+    assert(rec.get() == expected);
+#endif
+}
+
+void test_streaming_gnumeric()
+{
+#if GNUMERIC_ENABLED
+    ORCUS_TEST_FUNC_SCOPE;
+
+    row_recorder rec;
+    ss::streaming_import_factory factory([&rec](const ss::streamed_row_t& row) { rec(row); });
+
+    orcus_gnumeric app(&factory);
+    app.read_file(SRCDIR"/test/gnumeric/values-and-formulas/input.gnumeric");
+
+    // Gnumeric documents store no formula results, so the formula cells at
+    // B1 and A4 have no value to deliver.
+    const std::vector<std::string> expected = {
+        "Sheet1/0: 0=1",
+        "Sheet1/1: 0=2 1=\"two\"",
+        "Sheet1/3: 1=true",
+    };
+
+    for (const auto& row : rec.get())
+        std::cout << row << std::endl;
+
+    assert(rec.get() == expected);
+#endif
+}
+
+int main()
+{
+    test_streaming_csv();
+    test_streaming_row_delivery();
+    test_streaming_xlsx();
+    test_streaming_ods();
+    test_streaming_gnumeric();
+
+    return EXIT_SUCCESS;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -1907,6 +1907,9 @@ void xls_xml_context::end_element_column()
 
 void xls_xml_context::end_element_row()
 {
+    if (mp_cur_sheet)
+        mp_cur_sheet->end_row(m_cur_row);
+
     ++m_cur_row;
 }
 
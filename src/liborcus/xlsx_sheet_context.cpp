@@ -125,6 +125,7 @@ xlsx_sheet_context::xlsx_sheet_context(
     m_cur_col(-1),
     m_cur_cell_type(xlsx_ct_numeric),
     m_cur_cell_xf(0),
+    m_skip_cells(false),
     m_cxt_autofilter(session_cxt, tokens, m_resolver),
     m_cxt_cond_format(session_cxt, tokens, m_sheet.get_conditional_format())
 {
@@ -161,6 +162,10 @@ void xlsx_sheet_context::start_element(xmlns_id_t ns, xml_token_t name, const xm
 {
     xml_token_pair_t parent = push_stack(ns, name);
 
+    if (m_skip_cells)
+        // Anything inside the sheetData element past the selected range.
+        return;
+
     if (ns == NS_ooxml_xlsx)
     {
         switch (name)
@@ -277,6 +282,14 @@ void xlsx_sheet_context::start_element(xmlns_id_t ns, xml_token_t name, const xm
 
 bool xlsx_sheet_context::end_element(xmlns_id_t ns, xml_token_t name)
 {
+    if (m_skip_cells)
+    {
+        if (ns == NS_ooxml_xlsx && name == XML_sheetData)
+            m_skip_cells = false;
+
+        return pop_stack(ns, name);
+    }
+
     if (ns == NS_ooxml_xlsx)
     {
         switch (name)
@@ -284,6 +297,9 @@ bool xlsx_sheet_context::end_element(xmlns_id_t ns, xml_token_t name)
             case XML_c:
                 end_element_cell();
                 break;
+            case XML_row:
+                m_sheet.end_row(m_cur_row);
+                break;
             case XML_t:
                 m_cur_value = m_cur_str;
                 break;
@@ -304,6 +320,9 @@ bool xlsx_sheet_context::end_element(xmlns_id_t ns, xml_token_t name)
 
 void xlsx_sheet_context::characters(std::string_view str, bool transient)
 {
+    if (m_skip_cells)
+        return;
+
     m_cur_str = intern_in_context(str, transient);
 }
 
@@ -664,6 +683,15 @@ void xlsx_sheet_context::start_element_row(const xml_token_attrs_t& attrs)
 
     m_cur_col = -1;
 
+    if (const auto& range = get_config().selection.range; range && m_cur_row > range->last.row)
+    {
+        // The rows are sorted, so the rest of the cell data is all outside
+        // the selected range.  Skip it but keep parsing the elements that
+        // follow it, such as the merged ranges and the table parts.
+        m_skip_cells = true;
+        return;
+    }
+
     if (custom_format && xfid)
         // The specs say we only honor this style id only when the custom format is set.
         m_sheet.set_row_format(m_cur_row, *xfid);
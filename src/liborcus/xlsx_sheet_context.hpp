@@ -121,6 +121,12 @@ private:
     std::string_view m_cur_value;
     formula m_cur_formula;
 
+    /**
+     * When true, the rows are past the last row of the selected range, and
+     * the rest of the cell data gets skipped.
+     */
+    bool m_skip_cells;
+
     array_formula_results_type m_array_formula_results;
 
     /**
@@ -0,0 +1,131 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "xml_map_automaton.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace orcus {
+
+namespace {
+
+template<typename EntryT>
+auto find_entry(const std::vector<EntryT>& entries, xml_map_automaton::token_type token)
+{
+    auto it = std::lower_bound(
+        entries.begin(), entries.end(), token,
+        [](const EntryT& entry, xml_map_automaton::token_type v) { return entry.first < v; }
+    );
+
+    return (it != entries.end() && it->first == token) ? it : entries.end();
+}
+
+} // anonymous namespace
+
+xml_map_automaton::xml_map_automaton(const xml_map_tree& tree)
+{
+    m_states.emplace_back(); // initial state
+
+    xml_map_tree::element* root = tree.get_root_element();
+    if (!root)
+        return;
+
+    token_type token = intern_token(root->name);
+    state_type root_state = compile_element(root);
+    m_states[initial_state].transitions.emplace_back(token, root_state);
+}
+
+xml_map_automaton::token_type xml_map_automaton::get_token(xmlns_id_t ns, std::string_view name) const
+{
+    auto it = m_tokens.find(name);
+    if (it == m_tokens.end())
+        return unknown_token;
+
+    for (const auto& [entry_ns, token] : it->second)
+    {
+        if (entry_ns == ns)
+            return token;
+    }
+
+    return unknown_token;
+}
+
+xml_map_automaton::state_type xml_map_automaton::transition(state_type state, token_type token) const
+{
+    assert(state < m_states.size());
+
+    const auto& transitions = m_states[state].transitions;
+    auto it = find_entry(transitions, token);
+    return it == transitions.end() ? no_state : it->second;
+}
+
+const xml_map_tree::attribute* xml_map_automaton::get_attribute(state_type state, token_type token) const
+{
+    assert(state < m_states.size());
+
+    const auto& attributes = m_states[state].attributes;
+    auto it = find_entry(attributes, token);
+    return it == attributes.end() ? nullptr : it->second;
+}
+
+xml_map_automaton::token_type xml_map_automaton::intern_token(const xml_name_t& name)
+{
+    auto& entries = m_tokens[name.name];
+
+    for (const auto& [ns, token] : entries)
+    {
+        if (ns == name.ns)
+            return token;
+    }
+
+    token_type token = m_token_count++;
+    entries.emplace_back(name.ns, token);
+    return token;
+}
+
+xml_map_automaton::state_type xml_map_automaton::compile_element(xml_map_tree::element* elem)
+{
+    assert(elem);
+
+    state_type state = m_states.size();
+    m_states.emplace_back();
+    m_states[state].element = elem;
+
+    std::vector<attribute_entry_type> attributes;
+    for (const xml_map_tree::attribute* attr : elem->attributes)
+        attributes.emplace_back(intern_token(attr->name), attr);
+
+    std::sort(attributes.begin(), attributes.end(),
+        [](const attribute_entry_type& a, const attribute_entry_type& b) { return a.first < b.first; }
+    );
+
+    m_states[state].attributes = std::move(attributes);
+
+    if (elem->elem_type != xml_map_tree::element_type::unlinked)
+        return state;
+
+    assert(elem->child_elements);
+
+    std::vector<transition_type> transitions;
+    for (xml_map_tree::element* child : *elem->child_elements)
+    {
+        token_type token = intern_token(child->name);
+        transitions.emplace_back(token, compile_element(child));
+    }
+
+    std::sort(transitions.begin(), transitions.end());
+
+    // m_states may have been re-allocated while compiling the child elements.
+    m_states[state].transitions = std::move(transitions);
+
+    return state;
+}
+
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
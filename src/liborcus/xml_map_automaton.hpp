@@ -0,0 +1,143 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "xml_map_tree.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace orcus {
+
+/**
+ * State machine compiled from the element tree of an xml_map_tree.  Each
+ * element in the map tree becomes a state, and the names of all elements and
+ * linked attributes in the tree are mapped to integer tokens.  Each state
+ * stores its transitions to the child states, and its linked attributes,
+ * keyed by tokens.
+ *
+ * The initial state represents the position before the root element, and
+ * its only transition leads to the state of the root element.
+ *
+ * The automaton stores pointers to the elements and attributes of the map
+ * tree, so it must not outlive the tree, and it must be re-compiled when the
+ * tree changes.
+ */
+class xml_map_automaton
+{
+public:
+    using token_type = std::uint32_t;
+    using state_type = std::uint32_t;
+
+    static constexpr token_type unknown_token = std::numeric_limits<token_type>::max();
+    static constexpr state_type no_state = std::numeric_limits<state_type>::max();
+    static constexpr state_type initial_state = 0;
+
+    xml_map_automaton(const xml_map_tree& tree);
+
+    xml_map_automaton(const xml_map_automaton&) = delete;
+    xml_map_automaton& operator=(const xml_map_automaton&) = delete;
+
+    /**
+     * Get the token associated with a name.
+     *
+     * @param ns namespace identifier of the name.
+     * @param name local part of the name.
+     *
+     * @return token of the name, or unknown_token if the name appears nowhere
+     *         in the map tree.
+     */
+    token_type get_token(xmlns_id_t ns, std::string_view name) const;
+
+    /**
+     * Get the state reached by entering a child element from a state.
+     *
+     * @param state state of the parent element.
+     * @param token token of the name of the child element.
+     *
+     * @return state of the child element, or no_state if the child element is
+     *         not part of the map tree.
+     */
+    state_type transition(state_type state, token_type token) const;
+
+    /**
+     * Check whether a state has any transition.  No child element of a state
+     * without transitions can be part of the map tree.
+     */
+    bool has_transitions(state_type state) const
+    {
+        return !m_states[state].transitions.empty();
+    }
+
+    /**
+     * Get the linked attribute of the element associated with a state.
+     *
+     * @param state state of the element.
+     * @param token token of the name of the attribute.
+     *
+     * @return pointer to the linked attribute, or nullptr if the element has
+     *         no linked attribute of that name.
+     */
+    const xml_map_tree::attribute* get_attribute(state_type state, token_type token) const;
+
+    /**
+     * Check whether the element associated with a state has any linked
+     * attribute.
+     */
+    bool has_attributes(state_type state) const
+    {
+        return !m_states[state].attributes.empty();
+    }
+
+    /**
+     * Get the map tree element associated with a state.  The initial state
+     * is not associated with any element.
+     */
+    xml_map_tree::element* get_element(state_type state) const
+    {
+        return m_states[state].element;
+    }
+
+    std::size_t get_state_count() const { return m_states.size(); }
+
+private:
+    token_type intern_token(const xml_name_t& name);
+
+    state_type compile_element(xml_map_tree::element* elem);
+
+private:
+    using transition_type = std::pair<token_type, state_type>;
+    using attribute_entry_type = std::pair<token_type, const xml_map_tree::attribute*>;
+
+    struct state_data
+    {
+        xml_map_tree::element* element = nullptr;
+
+        /** Transitions to the child states, sorted by token. */
+        std::vector<transition_type> transitions;
+
+        /** Linked attributes, sorted by token. */
+        std::vector<attribute_entry_type> attributes;
+    };
+
+    /**
+     * Tokens keyed by local names first, since most names in a document come
+     * with only one namespace.
+     */
+    std::unordered_map<std::string_view, std::vector<std::pair<xmlns_id_t, token_type>>> m_tokens;
+    token_type m_token_count = 0;
+
+    std::vector<state_data> m_states;
+};
+
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -544,6 +544,11 @@ xml_map_tree::walker xml_map_tree::get_tree_walker() const
     return walker(*this);
 }
 
+xml_map_tree::element* xml_map_tree::get_root_element() const
+{
+    return mp_root;
+}
+
 xml_map_tree::range_ref_map_type& xml_map_tree::get_range_references()
 {
     return m_field_refs;
@@ -243,6 +243,11 @@ public:
 
     walker get_tree_walker() const;
 
+    /**
+     * Get the root element of the tree, or nullptr if the tree has no links.
+     */
+    element* get_root_element() const;
+
     range_ref_map_type& get_range_references();
 
     std::string_view intern_string(std::string_view str) const;
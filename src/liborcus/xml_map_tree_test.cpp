@@ -7,6 +7,7 @@
 
 #include "test_global.hpp"
 #include "xml_map_tree.hpp"
+#include "xml_map_automaton.hpp"
 #include "orcus/xml_namespace.hpp"
 
 #include <cstdlib>
@@ -304,6 +305,108 @@ void test_default_namespace()
     assert(child->ref_type == xml_map_tree::reference_type::cell);
 }
 
+void test_automaton()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    xmlns_repository repo;
+    xml_map_tree tree(repo);
+    xml_map_tree::cell_position ref;
+    ref.sheet = std::string_view{"data"};
+    ref.row = 0;
+    ref.col = 0;
+
+    tree.set_namespace_alias("a", "http://some-namespace");
+    tree.set_cell_link("/a:table/a:title", ref);
+    ref.row = 1;
+    tree.set_cell_link("/a:table/@a:id", ref);
+    ref.row = 2;
+    tree.start_range(ref);
+    tree.append_range_field_link("/a:table/a:rows/a:row/@name", std::string_view{});
+    tree.append_range_field_link("/a:table/a:rows/a:row/a:value", std::string_view{});
+    tree.set_range_row_group("/a:table/a:rows/a:row");
+    tree.commit_range();
+
+    xmlns_id_t ns_a = tree.get_namespace("a");
+    assert(ns_a != XMLNS_UNKNOWN_ID);
+
+    using automaton_type = xml_map_automaton;
+
+    automaton_type automaton(tree);
+
+    // initial, table, title, rows, row, value
+    assert(automaton.get_state_count() == 6);
+    assert(!automaton.get_element(automaton_type::initial_state));
+
+    // Names that are not in the map tree have no tokens.
+    assert(automaton.get_token(ns_a, "foo") == automaton_type::unknown_token);
+    assert(automaton.get_token(XMLNS_UNKNOWN_ID, "table") == automaton_type::unknown_token);
+
+    automaton_type::token_type tk_table = automaton.get_token(ns_a, "table");
+    assert(tk_table != automaton_type::unknown_token);
+    automaton_type::token_type tk_title = automaton.get_token(ns_a, "title");
+    assert(tk_title != automaton_type::unknown_token);
+    automaton_type::token_type tk_rows = automaton.get_token(ns_a, "rows");
+    assert(tk_rows != automaton_type::unknown_token);
+    automaton_type::token_type tk_row = automaton.get_token(ns_a, "row");
+    assert(tk_row != automaton_type::unknown_token);
+    automaton_type::token_type tk_value = automaton.get_token(ns_a, "value");
+    assert(tk_value != automaton_type::unknown_token);
+    automaton_type::token_type tk_id = automaton.get_token(ns_a, "id");
+    assert(tk_id != automaton_type::unknown_token);
+    automaton_type::token_type tk_name = automaton.get_token(XMLNS_UNKNOWN_ID, "name");
+    assert(tk_name != automaton_type::unknown_token);
+
+    // Only the root element can be entered from the initial state.
+    assert(automaton.transition(automaton_type::initial_state, tk_title) == automaton_type::no_state);
+    automaton_type::state_type st_table = automaton.transition(automaton_type::initial_state, tk_table);
+    assert(st_table != automaton_type::no_state);
+    const xml_map_tree::element* elem = automaton.get_element(st_table);
+    assert(elem && elem->name.ns == ns_a && elem->name.name == "table");
+
+    // Linked attribute of the root element.
+    assert(automaton.has_attributes(st_table));
+    const xml_map_tree::attribute* attr = automaton.get_attribute(st_table, tk_id);
+    assert(attr && attr->name.name == "id" && attr->ref_type == xml_map_tree::reference_type::cell);
+    assert(!automaton.get_attribute(st_table, tk_name));
+
+    // A linked element has no transitions.
+    automaton_type::state_type st_title = automaton.transition(st_table, tk_title);
+    assert(st_title != automaton_type::no_state);
+    assert(!automaton.has_transitions(st_title));
+    assert(!automaton.has_attributes(st_title));
+    elem = automaton.get_element(st_title);
+    assert(elem && elem->ref_type == xml_map_tree::reference_type::cell);
+
+    automaton_type::state_type st_rows = automaton.transition(st_table, tk_rows);
+    assert(st_rows != automaton_type::no_state);
+    assert(automaton.transition(st_rows, tk_title) == automaton_type::no_state);
+    automaton_type::state_type st_row = automaton.transition(st_rows, tk_row);
+    assert(st_row != automaton_type::no_state);
+    elem = automaton.get_element(st_row);
+    assert(elem && elem->row_group);
+
+    attr = automaton.get_attribute(st_row, tk_name);
+    assert(attr && attr->ref_type == xml_map_tree::reference_type::range_field);
+
+    automaton_type::state_type st_value = automaton.transition(st_row, tk_value);
+    assert(st_value != automaton_type::no_state);
+    elem = automaton.get_element(st_value);
+    assert(elem && elem->ref_type == xml_map_tree::reference_type::range_field);
+}
+
+void test_automaton_empty_tree()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    xmlns_repository repo;
+    xml_map_tree tree(repo);
+    xml_map_automaton automaton(tree);
+
+    assert(automaton.get_state_count() == 1);
+    assert(!automaton.has_transitions(xml_map_automaton::initial_state));
+}
+
 int main()
 {
     test_path_insertion();
@@ -311,6 +414,8 @@ int main()
     test_tree_walk();
     test_tree_walk_namespace();
     test_default_namespace();
+    test_automaton();
+    test_automaton_empty_tree();
 
     return EXIT_SUCCESS;
 }
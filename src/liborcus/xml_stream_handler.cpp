@@ -8,8 +8,10 @@
 #include "xml_stream_handler.hpp"
 #include "xml_context_base.hpp"
 #include "xml_empty_context.hpp"
+#include "session_context.hpp"
 
 #include "orcus/exception.hpp"
+#include "orcus/import_profile.hpp"
 
 #include <iostream>
 
@@ -30,6 +32,8 @@ xml_stream_handler::xml_stream_handler(
 
 xml_stream_handler::~xml_stream_handler()
 {
+    if (m_session_cxt.profiler)
+        m_session_cxt.profiler->add_xml_elements(m_element_count, m_attribute_count);
 }
 
 void xml_stream_handler::start_document()
@@ -50,6 +54,9 @@ void xml_stream_handler::start_element(const xml_token_element_t& elem)
     if (m_context_stack.size() > max_element_nesting)
         throw xml_structure_error("maximum element nesting depth exceeded");
 
+    ++m_element_count;
+    m_attribute_count += elem.attrs.size();
+
     xml_context_base& cur = get_current_context();
     if (cur.evaluate_child_element(elem.ns, elem.name))
     {
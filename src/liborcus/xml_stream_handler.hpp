@@ -35,6 +35,10 @@ class xml_stream_handler
     typedef std::vector<xml_context_base*> context_stack_type;
     context_stack_type m_context_stack;
 
+    /** Numbers of elements and attributes reported to the profiler on destruction. */
+    std::size_t m_element_count = 0;
+    std::size_t m_attribute_count = 0;
+
 public:
     xml_stream_handler() = delete;
     xml_stream_handler(const xml_stream_handler&) = delete;
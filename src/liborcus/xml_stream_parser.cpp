@@ -79,14 +79,25 @@ void threaded_xml_stream_parser::parse()
         return;
 
     threaded_sax_token_parser<xml_stream_handler> sax(m_content, m_size, m_tokens, m_ns_cxt, *mp_handler, 1000);
-    sax.parse();
+
+    try
+    {
+        sax.parse();
+    }
+    catch (...)
+    {
+        // The handler may still reference the strings received before the
+        // parsing got interrupted.
+        sax.swap_string_pool(m_pool);
+        throw;
+    }
 
     sax.swap_string_pool(m_pool);
 }
 
-void threaded_xml_stream_parser::swap_string_pool(string_pool& pool)
+void threaded_xml_stream_parser::merge_string_pool(string_pool& pool)
 {
-    m_pool.swap(pool);
+    pool.merge(m_pool);
 }
 
 }
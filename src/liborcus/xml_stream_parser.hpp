@@ -73,7 +73,14 @@ public:
 
     virtual void parse() override;
 
-    void swap_string_pool(string_pool& pool);
+    /**
+     * Move the strings referenced by the tokens passed to the handler into
+     * another string pool, so that they outlive this parser.  This can also
+     * be called after the parsing has been interrupted by an exception.
+     *
+     * @param pool string pool to move the strings into.
+     */
+    void merge_string_pool(string_pool& pool);
 };
 
 }
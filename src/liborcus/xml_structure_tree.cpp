@@ -10,15 +10,20 @@
 #include <orcus/xml_namespace.hpp>
 #include <orcus/exception.hpp>
 #include <orcus/string_pool.hpp>
+#include <orcus/config.hpp>
+#include <orcus/parser_global.hpp>
 
 #include "string_helper.hpp"
 #include "xml_structure_mapper.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <vector>
 #include <cstdio>
 #include <memory>
+#include <future>
+#include <optional>
 
 #include <unordered_map>
 #include <unordered_set>
@@ -99,6 +104,12 @@ struct callbacks
     xml_structure_tree::callback_handler_type on_repeat = empty_callback;
 };
 
+/**
+ * Thrown by the handler to stop parsing once the scan limit has been
+ * reached.
+ */
+struct scan_stopped {};
+
 class xml_sax_handler : public sax_ns_handler
 {
     string_pool& m_pool;
@@ -107,6 +118,12 @@ class xml_sax_handler : public sax_ns_handler
     elements_type m_stack;
     xml_structure_tree::entity_names_type m_attrs;
 
+    std::size_t m_max_stale_count;
+    std::size_t m_max_bytes;
+
+    /** Number of elements in a row that have not added anything new. */
+    std::size_t m_stale_count = 0;
+
 private:
     void merge_attributes(elem_prop& prop)
     {
@@ -116,46 +133,19 @@ private:
             if (prop.attributes.find(*it) == prop.attributes.end())
             {
                 // New attribute.  Insert it.
-                prop.attributes.insert(*it);
-                prop.attribute_names.push_back(*it);
+                xml_structure_tree::entity_name name(it->ns, m_pool.intern(it->name).first);
+                prop.attributes.insert(name);
+                prop.attribute_names.push_back(name);
+                m_stale_count = 0;
             }
         }
 
         m_attrs.clear();
     }
 
-public:
-    xml_sax_handler(string_pool& pool, callbacks& cbs) :
-        m_pool(pool), m_callbacks(cbs), mp_root(nullptr) {}
-
-    void doctype(const sax::doctype_declaration&) {}
-
-    void end_declaration()
-    {
-        m_attrs.clear();
-    }
-
-    void end_processing_instruction(std::string_view /*target*/)
-    {
-        m_attrs.clear();
-    }
-
-    void start_element(const sax_ns_parser_element& elem)
+    void start_child_element(const sax_ns_parser_element& elem)
     {
-        if (!mp_root)
-        {
-            // This is a root element.
-            mp_root.reset(new root);
-            mp_root->name.ns = elem.ns;
-            mp_root->name.name = m_pool.intern(elem.name).first;
-            element_ref ref(mp_root->name, &mp_root->prop);
-            merge_attributes(mp_root->prop);
-            m_stack.push_back(ref);
-            return;
-        }
-
         // See if the current element already has a child element of the same name.
-        assert(!m_stack.empty());
         element_ref& current = m_stack.back();
         xml_structure_tree::entity_name key(elem.ns, elem.name);
         auto it = current.prop->child_elements.find(key);
@@ -186,6 +176,7 @@ public:
             throw general_error("Insertion failed");
 
         current.prop->child_element_names.push_back(key);
+        m_stale_count = 0;
 
         it = r.first;
         element_ref ref(it->first, it->second.get());
@@ -193,6 +184,57 @@ public:
         m_stack.push_back(ref);
     }
 
+public:
+    xml_sax_handler(string_pool& pool, callbacks& cbs, std::size_t max_stale_count = 0, std::size_t max_bytes = 0) :
+        m_pool(pool), m_callbacks(cbs), mp_root(nullptr),
+        m_max_stale_count(max_stale_count), m_max_bytes(max_bytes) {}
+
+    void doctype(const sax::doctype_declaration&) {}
+
+    void end_declaration()
+    {
+        m_attrs.clear();
+    }
+
+    void end_processing_instruction(std::string_view /*target*/)
+    {
+        m_attrs.clear();
+    }
+
+    void start_element(const sax_ns_parser_element& elem)
+    {
+        if (!mp_root)
+        {
+            // This is a root element.
+            mp_root.reset(new root);
+            mp_root->name.ns = elem.ns;
+            mp_root->name.name = m_pool.intern(elem.name).first;
+            element_ref ref(mp_root->name, &mp_root->prop);
+            merge_attributes(mp_root->prop);
+            m_stack.push_back(ref);
+            return;
+        }
+
+        if (m_stack.empty())
+        {
+            // Root element of another chunk of the same stream.  Re-enter
+            // the existing root.
+            element_ref ref(mp_root->name, &mp_root->prop);
+            merge_attributes(mp_root->prop);
+            m_stack.push_back(ref);
+            return;
+        }
+
+        if (m_max_bytes && std::size_t(elem.begin_pos) >= m_max_bytes)
+            throw scan_stopped();
+
+        ++m_stale_count;
+        start_child_element(elem);
+
+        if (m_max_stale_count && m_stale_count >= m_max_stale_count)
+            throw scan_stopped();
+    }
+
     void end_element(const sax_ns_parser_element& /*elem*/)
     {
         if (m_stack.empty())
@@ -201,9 +243,14 @@ public:
         const element_ref& current = m_stack.back();
 
         // Reset the in-scope count of all child elements to 0 before ending
-        // the current scope.
-        for (auto& [name, p] : current.prop->child_elements)
-            p->in_scope_count = 0;
+        // the current scope.  The root element gets re-entered for each
+        // chunk of a stream scanned in chunks, so its child elements keep
+        // their counts.
+        if (m_stack.size() > 1)
+        {
+            for (auto& [name, p] : current.prop->child_elements)
+                p->in_scope_count = 0;
+        }
 
         m_stack.pop_back();
     }
@@ -283,6 +330,432 @@ void print_scope(std::ostream& os, const scopes_type& scopes, const xmlns_contex
     }
 }
 
+/**
+ * Positions of the start and end tags of the root element in an XML stream,
+ * located without parsing the content of the root element.
+ */
+struct root_layout
+{
+    /** Position immediately after the start tag of the root element. */
+    std::size_t open_end = 0;
+
+    /** Position of the end tag of the root element. */
+    std::size_t close_pos = 0;
+
+    /** Qualified name of the root element as it appears in the stream. */
+    std::string_view qname;
+
+    /** Qualified name of the first child element of the root element. */
+    std::string_view child_qname;
+};
+
+/**
+ * Move past the next occurrence of a terminator string.
+ */
+bool skip_past(std::string_view s, std::size_t& pos, std::string_view terminator)
+{
+    std::size_t n = s.find(terminator, pos);
+    if (n == s.npos)
+        return false;
+
+    pos = n + terminator.size();
+    return true;
+}
+
+/**
+ * Move past the end of a tag, skipping over any quoted attribute values.
+ *
+ * @return true if the tag is an empty-element tag, false if it's not, or
+ *         std::nullopt if the end of the tag is not found.
+ */
+std::optional<bool> skip_tag(std::string_view s, std::size_t& pos)
+{
+    for (; pos < s.size(); ++pos)
+    {
+        char c = s[pos];
+        switch (c)
+        {
+            case '"':
+            case '\'':
+            {
+                std::size_t n = s.find(c, pos + 1);
+                if (n == s.npos)
+                    return std::nullopt;
+                pos = n;
+                break;
+            }
+            case '>':
+            {
+                bool empty = s[pos - 1] == '/';
+                ++pos;
+                return empty;
+            }
+            default:
+                ;
+        }
+    }
+
+    return std::nullopt;
+}
+
+/**
+ * Read the qualified name of the element whose start tag begins at the
+ * specified position.
+ */
+std::string_view read_tag_name(std::string_view s, std::size_t pos)
+{
+    std::size_t name_pos = ++pos;
+    while (pos < s.size() && !is_blank(s[pos]) && s[pos] != '/' && s[pos] != '>')
+        ++pos;
+
+    return s.substr(name_pos, pos - name_pos);
+}
+
+/**
+ * Skip the comments, processing instructions and blanks that may follow the
+ * end tag of the root element.
+ *
+ * @return true if nothing else follows, otherwise false.
+ */
+bool skip_trailing_misc(std::string_view s, std::size_t pos)
+{
+    while (true)
+    {
+        while (pos < s.size() && is_blank(s[pos]))
+            ++pos;
+
+        if (pos == s.size())
+            return true;
+
+        std::string_view rest = s.substr(pos);
+
+        if (rest.starts_with("<!--"))
+        {
+            if (!skip_past(s, pos, "-->"))
+                return false;
+            continue;
+        }
+
+        if (rest.starts_with("<?"))
+        {
+            if (!skip_past(s, pos, "?>"))
+                return false;
+            continue;
+        }
+
+        return false;
+    }
+}
+
+/**
+ * Locate the start and end tags of the root element of an XML stream, and
+ * the name of its first child element.  Only the prolog, the markup up to
+ * the first child element and the markup after the end tag get looked at,
+ * and the full validation of the stream is left to the parser.
+ *
+ * @return layout of the root element, or std::nullopt if the root element
+ *         has no child elements, or the stream contains anything this scan
+ *         does not handle, such as a DOCTYPE declaration with an internal
+ *         subset.
+ */
+std::optional<root_layout> scan_root_layout(std::string_view s)
+{
+    root_layout layout;
+    std::size_t pos = 0;
+
+    // Skip the prolog to reach the start tag of the root element.
+    while (true)
+    {
+        pos = s.find('<', pos);
+        if (pos == s.npos)
+            return std::nullopt;
+
+        std::string_view rest = s.substr(pos);
+
+        if (rest.starts_with("<?"))
+        {
+            if (!skip_past(s, pos, "?>"))
+                return std::nullopt;
+            continue;
+        }
+
+        if (rest.starts_with("<!--"))
+        {
+            if (!skip_past(s, pos, "-->"))
+                return std::nullopt;
+            continue;
+        }
+
+        if (rest.starts_with("<!"))
+        {
+            std::size_t n = s.find('>', pos);
+            if (n == s.npos || s.substr(pos, n - pos).find('[') != s.npos)
+                return std::nullopt;
+            pos = n + 1;
+            continue;
+        }
+
+        break;
+    }
+
+    layout.qname = read_tag_name(s, pos);
+    pos += layout.qname.size() + 1;
+
+    if (auto empty = skip_tag(s, pos); !empty || *empty)
+        return std::nullopt;
+
+    layout.open_end = pos;
+
+    // Skip to the start tag of the first child element.
+    while (true)
+    {
+        pos = s.find('<', pos);
+        if (pos == s.npos)
+            return std::nullopt;
+
+        std::string_view rest = s.substr(pos);
+
+        if (rest.starts_with("<!--"))
+        {
+            if (!skip_past(s, pos, "-->"))
+                return std::nullopt;
+            continue;
+        }
+
+        if (rest.starts_with("<![CDATA["))
+        {
+            if (!skip_past(s, pos, "]]>"))
+                return std::nullopt;
+            continue;
+        }
+
+        if (rest.starts_with("<?"))
+        {
+            if (!skip_past(s, pos, "?>"))
+                return std::nullopt;
+            continue;
+        }
+
+        if (rest.starts_with("<!") || rest.starts_with("</"))
+            return std::nullopt;
+
+        break;
+    }
+
+    layout.child_qname = read_tag_name(s, pos);
+    if (layout.child_qname.empty())
+        return std::nullopt;
+
+    // Locate the end tag of the root element from the end of the stream.
+    std::string end_tag = "</";
+    end_tag.append(layout.qname);
+
+    std::size_t close_pos = s.rfind(end_tag);
+    if (close_pos == s.npos || close_pos <= pos)
+        return std::nullopt;
+
+    pos = close_pos + end_tag.size();
+    while (pos < s.size() && is_blank(s[pos]))
+        ++pos;
+
+    if (pos == s.size() || s[pos] != '>' || !skip_trailing_misc(s, pos + 1))
+        return std::nullopt;
+
+    layout.close_pos = close_pos;
+    return layout;
+}
+
+/**
+ * Find the start tag of a child element of the root element at or after a
+ * position, by looking for the next start tag that has the same name as the
+ * first child element.  The tag found may belong to a deeper element of the
+ * same name, in which case the ranges split at it fail to parse, and the
+ * stream gets scanned sequentially instead.
+ *
+ * @return position of the start tag, or the position of the end tag of the
+ *         root element if there is none.
+ */
+std::size_t find_child_start(std::string_view s, const root_layout& layout, std::size_t pos)
+{
+    const std::string_view name = layout.child_qname;
+
+    for (; pos < layout.close_pos; ++pos)
+    {
+        pos = s.find('<', pos);
+        if (pos >= layout.close_pos)
+            break;
+
+        if (s.substr(pos + 1, name.size()) != name)
+            continue;
+
+        std::size_t next = pos + 1 + name.size();
+        if (next < s.size() && (is_blank(s[next]) || s[next] == '/' || s[next] == '>'))
+            return pos;
+    }
+
+    return layout.close_pos;
+}
+
+/**
+ * Structure tree built from one range of the child elements of the root
+ * element, along with the namespace repository and the string pool its
+ * names belong to.
+ */
+struct chunk_tree
+{
+    xmlns_repository repo;
+    string_pool pool;
+    std::unique_ptr<root> root_elem;
+
+    /** Whether or not the scan stopped before the end of the range. */
+    bool stopped = false;
+};
+
+/**
+ * Maximum size of the content of a chunk that gets parsed at a time when
+ * scanning a range of the child elements of the root element.  It bounds
+ * the memory used to copy the chunks.
+ */
+constexpr std::size_t max_chunk_size = 1024 * 1024;
+
+/**
+ * Build a structure tree from a range of the child elements of the root
+ * element.  The range gets parsed in chunks, each of which gets enclosed in
+ * the start tag of the root element, along with the prolog, and its end tag
+ * to form a complete stream.
+ */
+std::unique_ptr<chunk_tree> scan_chunks(
+    std::string_view s, const root_layout& layout, std::size_t begin_pos, std::size_t end_pos,
+    std::size_t max_stale_count)
+{
+    auto tree = std::make_unique<chunk_tree>();
+    xmlns_context cxt = tree->repo.create_context();
+    callbacks cbs;
+    xml_sax_handler hdl(tree->pool, cbs, max_stale_count);
+
+    std::string_view prefix = s.substr(0, layout.open_end);
+    std::string buf;
+
+    try
+    {
+        for (std::size_t chunk_pos = begin_pos; chunk_pos < end_pos; )
+        {
+            // Take as many child elements as fit in one chunk, but at least one.
+            std::size_t chunk_end = end_pos;
+            if (end_pos - chunk_pos > max_chunk_size)
+                chunk_end = std::min(find_child_start(s, layout, chunk_pos + max_chunk_size), end_pos);
+
+            buf.assign(prefix);
+            buf.append(s.substr(chunk_pos, chunk_end - chunk_pos));
+            buf.append("</");
+            buf.append(layout.qname);
+            buf.push_back('>');
+
+            sax_ns_parser<xml_sax_handler> parser(buf, cxt, hdl);
+            parser.parse();
+
+            chunk_pos = chunk_end;
+        }
+    }
+    catch (const scan_stopped&)
+    {
+        tree->stopped = true;
+    }
+
+    tree->root_elem = hdl.release_root_element();
+    return tree;
+}
+
+/**
+ * Merge the structure trees built from the ranges of the child elements of
+ * the root element into one, in document order.
+ */
+class tree_merger
+{
+    std::unordered_map<xmlns_id_t, xmlns_id_t> m_ns_map;
+
+    xml_structure_tree::entity_name map_name(const xml_structure_tree::entity_name& name) const
+    {
+        auto it = m_ns_map.find(name.ns);
+        return {it == m_ns_map.end() ? name.ns : it->second, name.name};
+    }
+
+    void merge(elem_prop& dst, const elem_prop& src, bool root_scope)
+    {
+        dst.has_content = dst.has_content || src.has_content;
+
+        for (const xml_structure_tree::entity_name& name : src.attribute_names)
+        {
+            xml_structure_tree::entity_name mapped = map_name(name);
+            if (dst.attributes.insert(mapped).second)
+                dst.attribute_names.push_back(mapped);
+        }
+
+        for (const xml_structure_tree::entity_name& name : src.child_element_names)
+        {
+            const elem_prop& src_child = *src.child_elements.find(name)->second;
+            xml_structure_tree::entity_name mapped = map_name(name);
+
+            auto it = dst.child_elements.find(mapped);
+            if (it == dst.child_elements.end())
+            {
+                size_t order = dst.child_elements.size();
+                it = dst.child_elements.insert(
+                    std::make_pair(mapped, std::make_unique<elem_prop>(order))).first;
+                dst.child_element_names.push_back(mapped);
+                it->second->repeat = src_child.repeat;
+            }
+            else
+            {
+                // The child elements of the root element in all ranges share
+                // the same parent.
+                it->second->repeat = it->second->repeat || src_child.repeat || root_scope;
+            }
+
+            merge(*it->second, src_child, false);
+        }
+    }
+
+public:
+    /**
+     * Merge a tree into the destination root.  The namespaces of the source
+     * tree get interned in the destination context in their order of
+     * appearance.
+     */
+    void merge(root& dst, const chunk_tree& src, xmlns_context& cxt)
+    {
+        m_ns_map.clear();
+
+        for (std::size_t i = 0; ; ++i)
+        {
+            xmlns_id_t ns = src.repo.get_identifier(i);
+            if (ns == XMLNS_UNKNOWN_ID)
+                break;
+
+            m_ns_map.insert({ns, cxt.push(std::string_view{}, ns)});
+            cxt.pop(std::string_view{});
+        }
+
+        if (src.root_elem)
+            merge(dst.prop, src.root_elem->prop, true);
+    }
+};
+
+/**
+ * Call the callback for each repeated element in the tree.
+ */
+void notify_repeats(const elem_prop& prop, const callbacks& cbs)
+{
+    for (const xml_structure_tree::entity_name& name : prop.child_element_names)
+    {
+        const elem_prop& child = *prop.child_elements.find(name)->second;
+        if (child.repeat)
+            cbs.on_repeat(name);
+
+        notify_repeats(child, cbs);
+    }
+}
+
 } // anonymous namespace
 
 xml_table_range_t::xml_table_range_t() = default;
@@ -308,6 +781,7 @@ struct xml_structure_tree::impl
     callbacks m_callbacks;
     xmlns_context& m_xmlns_cxt;
     std::unique_ptr<root> mp_root;
+    bool m_exhaustive = false;
 
     impl(const impl&) = delete;
     impl& operator=(const impl&) = delete;
@@ -315,6 +789,118 @@ struct xml_structure_tree::impl
     impl(xmlns_context& xmlns_cxt) : m_xmlns_cxt(xmlns_cxt) {}
     ~impl() {}
 
+    void parse(std::string_view s, const structure_scan_config& config)
+    {
+        xml_sax_handler hdl(m_pool, m_callbacks, config.max_stale_count, config.max_bytes);
+        sax_ns_parser<xml_sax_handler> parser(s, m_xmlns_cxt, hdl);
+        m_exhaustive = false;
+
+        try
+        {
+            parser.parse();
+            m_exhaustive = true;
+        }
+        catch (const scan_stopped&)
+        {
+        }
+
+        mp_root = hdl.release_root_element();
+    }
+
+    /**
+     * Scan the child elements of the root element in contiguous ranges on
+     * multiple threads, and merge the results.  The ranges get split at the
+     * first child element that starts at or after each of the evenly spaced
+     * byte offsets within the stream.
+     *
+     * @return false if the stream cannot be split, or any of its ranges
+     *         fails to parse, in which case the stream should be parsed
+     *         sequentially.
+     */
+    bool parse_parallel(std::string_view s, const structure_scan_config& config)
+    {
+        std::optional<root_layout> layout = scan_root_layout(s);
+        if (!layout)
+            return false;
+
+        // Only scan the child elements that start within the byte limit.
+        std::size_t end_pos = layout->close_pos;
+        if (config.max_bytes && config.max_bytes < end_pos)
+            end_pos = find_child_start(s, *layout, std::max(config.max_bytes, layout->open_end));
+
+        std::vector<std::size_t> split_pos{layout->open_end};
+        const std::size_t range_size = end_pos - layout->open_end;
+
+        for (std::size_t i = 1; i < config.thread_count; ++i)
+        {
+            std::size_t pos = layout->open_end + range_size * i / config.thread_count;
+            pos = find_child_start(s, *layout, std::max(pos, split_pos.back() + 1));
+            if (pos >= end_pos)
+                break;
+
+            split_pos.push_back(pos);
+        }
+
+        split_pos.push_back(end_pos);
+
+        std::vector<std::future<std::unique_ptr<chunk_tree>>> futures;
+
+        for (std::size_t i = 1; i < split_pos.size(); ++i)
+        {
+            futures.push_back(
+                std::async(
+                    std::launch::async, scan_chunks, s, std::cref(*layout), split_pos[i-1],
+                    split_pos[i], config.max_stale_count));
+        }
+
+        // Build the root element from the prolog and the start tag of the
+        // root element while the child elements are being scanned.
+        std::string buf(s.substr(0, layout->open_end));
+        buf.append("</");
+        buf.append(layout->qname);
+        buf.push_back('>');
+
+        callbacks cbs;
+        xml_sax_handler hdl(m_pool, cbs);
+        sax_ns_parser<xml_sax_handler> parser(buf, m_xmlns_cxt, hdl);
+        parser.parse();
+        std::unique_ptr<root> root_elem = hdl.release_root_element();
+
+        std::vector<std::unique_ptr<chunk_tree>> trees;
+        bool failed = false;
+
+        for (auto& f : futures)
+        {
+            try
+            {
+                trees.push_back(f.get());
+            }
+            catch (const std::exception&)
+            {
+                failed = true;
+            }
+        }
+
+        if (failed)
+            return false;
+
+        bool exhaustive = end_pos == layout->close_pos;
+        tree_merger merger;
+
+        for (auto& tree : trees)
+        {
+            merger.merge(*root_elem, *tree, m_xmlns_cxt);
+            m_pool.merge(tree->pool);
+            exhaustive = exhaustive && !tree->stopped;
+        }
+
+        notify_repeats(root_elem->prop, m_callbacks);
+
+        mp_root = std::move(root_elem);
+        m_exhaustive = exhaustive;
+        return true;
+    }
+
     std::string to_string(const xml_structure_tree::entity_name& name) const
     {
         std::ostringstream ss;
@@ -556,10 +1142,20 @@ void xml_structure_tree::set_callback(callback_type type, callback_handler_type
 
 void xml_structure_tree::parse(std::string_view s)
 {
-    xml_sax_handler hdl(mp_impl->m_pool, mp_impl->m_callbacks);
-    sax_ns_parser<xml_sax_handler> parser(s, mp_impl->m_xmlns_cxt, hdl);
-    parser.parse();
-    mp_impl->mp_root = hdl.release_root_element();
+    mp_impl->parse(s, structure_scan_config());
+}
+
+void xml_structure_tree::parse(std::string_view s, const structure_scan_config& config)
+{
+    if (config.thread_count > 1 && mp_impl->parse_parallel(s, config))
+        return;
+
+    mp_impl->parse(s, config);
+}
+
+bool xml_structure_tree::is_exhaustive() const
+{
+    return mp_impl->m_exhaustive;
 }
 
 void xml_structure_tree::dump_compact(std::ostream& os) const
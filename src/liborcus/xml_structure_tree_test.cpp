@@ -10,11 +10,13 @@
 #include <orcus/xml_namespace.hpp>
 #include <orcus/stream.hpp>
 #include <orcus/parser_global.hpp>
+#include <orcus/config.hpp>
 
 #include <cstdlib>
 #include <cassert>
 #include <iostream>
 #include <sstream>
+#include <string>
 #include <vector>
 
 #include <filesystem>
@@ -347,6 +349,116 @@ void test_callback()
     }
 }
 
+std::string dump_structure(std::string_view s, const structure_scan_config& config, bool& exhaustive)
+{
+    xmlns_repository repo;
+    xmlns_context cxt = repo.create_context();
+    xml_structure_tree tree(cxt);
+    tree.parse(s, config);
+    exhaustive = tree.is_exhaustive();
+
+    std::ostringstream os;
+    tree.dump_compact(os);
+    return os.str();
+}
+
+void test_parallel()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    std::vector<std::string> inputs;
+
+    for (const fs::path& base_dir : base_dirs)
+    {
+        file_content strm((base_dir / "input.xml").string());
+        inputs.emplace_back(strm.str());
+    }
+
+    // Namespaces declared below the root, mixed content, and markup that
+    // the split must skip over.
+    inputs.push_back(
+        "<?xml version=\"1.0\"?>\n"
+        "<!-- prolog <comment> -->\n"
+        "<root xmlns=\"http://a\" attr=\"1 > 0\">text"
+        "<row id=\"1\"><a>1</a><![CDATA[<b>not an element</b>]]></row>"
+        "<?pi a='<row>'?>"
+        "<row id='2'><a/><b xmlns:y=\"http://y\" y:k=\"v\"/></row>"
+        "<!-- <row> -->"
+        "<row><c xmlns=\"http://c\"><d/></c></row>"
+        "<other xmlns:z=\"http://z\"><z:e/></other>"
+        "<row id='4'><a/><a/></row>"
+        "more text</root>\n"
+        "<!-- epilog -->\n");
+
+    for (const std::string& input : inputs)
+    {
+        bool exhaustive = false;
+        std::string expected = dump_structure(input, structure_scan_config(), exhaustive);
+        assert(exhaustive);
+
+        for (std::size_t n_threads : {2u, 3u, 8u})
+        {
+            structure_scan_config config;
+            config.thread_count = n_threads;
+            std::string actual = dump_structure(input, config, exhaustive);
+            assert(exhaustive);
+
+            if (actual != expected)
+            {
+                std::cerr << "expected:" << std::endl << expected << std::endl;
+                std::cerr << "actual (threads: " << n_threads << "):" << std::endl << actual << std::endl;
+                assert(!"structure built in parallel differs");
+            }
+        }
+    }
+}
+
+void test_sampling()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    std::string input = "<root>";
+    for (int i = 0; i < 100; ++i)
+        input += "<row><a>1</a><b>2</b></row>";
+    input += "<row><c>3</c></row></root>";
+
+    structure_scan_config config;
+    bool exhaustive = false;
+    std::string full = dump_structure(input, config, exhaustive);
+    assert(exhaustive);
+    assert(full.find("/root/row[*]/c") != full.npos);
+
+    // stop once 10 elements in a row have added nothing new
+    config.max_stale_count = 10;
+    std::string sampled = dump_structure(input, config, exhaustive);
+    assert(!exhaustive);
+    assert(sampled == "/root\n/root/row[*]\n/root/row[*]/a\n/root/row[*]/b\n");
+
+    // a limit that is never reached
+    config.max_stale_count = 1000;
+    sampled = dump_structure(input, config, exhaustive);
+    assert(exhaustive);
+    assert(sampled == full);
+
+    // stop at the first element that starts past the first row
+    config.max_stale_count = 0;
+    config.max_bytes = 30;
+    sampled = dump_structure(input, config, exhaustive);
+    assert(!exhaustive);
+    assert(sampled == "/root\n/root/row\n/root/row/a\n/root/row/b\n");
+
+    config.max_bytes = 30;
+    config.thread_count = 4;
+    sampled = dump_structure(input, config, exhaustive);
+    assert(!exhaustive);
+    assert(sampled == "/root\n/root/row\n/root/row/a\n/root/row/b\n");
+
+    config.max_bytes = 0;
+    sampled = dump_structure(input, config, exhaustive);
+    assert(exhaustive);
+    assert(sampled == full);
+}
+
 int main()
 {
     test_basic();
@@ -354,6 +466,8 @@ int main()
     test_walker_path();
     test_element_contents();
     test_callback();
+    test_parallel();
+    test_sampling();
 
     return EXIT_SUCCESS;
 }
@@ -10,13 +10,17 @@
 
 #include "json_util.hpp"
 
+#include <orcus/string_pool.hpp>
+
 #include <vector>
 #include <memory>
-#include <unordered_map>
+#include <limits>
 #include <algorithm>
+#include <charconv>
 #include <iostream>
 
 #include <boost/current_function.hpp>
+#include <boost/pool/object_pool.hpp>
 
 #define ORCUS_DEBUG_YAML_TREE 0
 
@@ -31,21 +35,65 @@ document_error::document_error(const std::string& msg) :
 
 document_error::~document_error() = default;
 
+/**
+ * Compact record of a single value in the document.  All records are
+ * allocated from the object pool owned by the document.
+ */
 struct yaml_value
 {
-    node_t type;
-    yaml_value* parent;
+    node_t type = node_t::unset;
+
+    /** Whether or not this value is a map key. */
+    bool is_key = false;
 
-    yaml_value() : type(node_t::unset), parent(nullptr) {}
-    yaml_value(node_t _type) : type(_type), parent(nullptr) {}
-    virtual ~yaml_value() {}
+    /** Length of a string value, or the number of children of a container. */
+    std::uint32_t size = 0;
 
-    virtual size_t get_hash() const
+    union
     {
-        return reinterpret_cast<size_t>(this);
+        /** Parent container of a value, which is null for a document root. */
+        yaml_value* parent = nullptr;
+
+        /** Position of a map key within its map.  A map key has no parent. */
+        std::size_t key_index;
+
+    } link;
+
+    union
+    {
+        double numeric = 0.0;
+        const char* str;
+
+        /**
+         * Children of a container.  The children of a map are stored as
+         * alternating keys and values.
+         */
+        yaml_value* const* children;
+
+        /** Position of the first child in the child table during the load. */
+        std::size_t first;
+
+    } value;
+
+    yaml_value() = default;
+    yaml_value(node_t _type) : type(_type) {}
+
+    std::string_view string_value() const
+    {
+        return {value.str, size};
+    }
+
+    const yaml_value* map_key(std::size_t pos) const
+    {
+        return value.children[pos * 2];
     }
 
-    virtual std::string print() const
+    const yaml_value* map_value(std::size_t pos) const
+    {
+        return value.children[pos * 2 + 1];
+    }
+
+    std::string print() const
     {
         std::ostringstream os;
         os << "type: ";
@@ -55,10 +103,10 @@ struct yaml_value
                 os << "unset";
             break;
             case node_t::string:
-                os << "string";
+                os << "string, value: " << string_value();
             break;
             case node_t::number:
-                os << "number";
+                os << "number, value: " << value.numeric;
             break;
             case node_t::map:
                 os << "map";
@@ -78,87 +126,61 @@ struct yaml_value
         }
         return os.str();
     }
-
-    struct hash
-    {
-        size_t operator() (const yaml_value& v) const
-        {
-            return v.get_hash();
-        }
-    };
 };
 
 namespace {
 
-struct yaml_value_string : public yaml_value
-{
-    std::string value_string;
-
-    yaml_value_string() : yaml_value(node_t::string) {}
-    yaml_value_string(std::string_view s) : yaml_value(node_t::string), value_string(s) {}
-    virtual ~yaml_value_string() {}
-
-    virtual std::string print() const
-    {
-        std::ostringstream os;
-        os << "type: string, value: " << value_string;
-        return os.str();
-    }
-};
-
-struct yaml_value_number : public yaml_value
+/**
+ * Arena that owns all values of the loaded documents.
+ */
+struct document_store
 {
-    double value_number;
-
-    yaml_value_number(double num) : yaml_value(node_t::number), value_number(num) {}
-    virtual ~yaml_value_number() {}
+    /**
+     * Maximum number of values allocated in one block of the pool.  The
+     * pool doubles the block size up to this size, which keeps the unused
+     * space at the end of the last block small for a large document.
+     */
+    static constexpr std::size_t max_pool_block_size = 65536;
 
-    virtual std::string print() const
-    {
-        std::ostringstream os;
-        os << "type: number, value: " << value_number;
-        return os.str();
-    }
-};
+    boost::object_pool<yaml_value> m_pool{32, max_pool_block_size};
+    string_pool m_str_pool;
 
-struct yaml_value_sequence : public yaml_value
-{
-    std::vector<std::unique_ptr<yaml_value>> value_sequence;
+    /** Children of all containers, each stored contiguously. */
+    std::vector<yaml_value*> m_children;
 
-    yaml_value_sequence() : yaml_value(node_t::sequence) {}
-    virtual ~yaml_value_sequence() {}
-};
-
-struct yaml_value_map : public yaml_value
-{
-    std::vector<std::unique_ptr<yaml_value>> key_order;  // owns the key instances.
-    std::unordered_map<const yaml_value*, std::unique_ptr<yaml_value>> value_map;
-
-    yaml_value_map() : yaml_value(node_t::map) {}
-    virtual ~yaml_value_map() {}
+    std::vector<const yaml_value*> m_docs;
 };
 
 struct parser_stack
 {
-    std::unique_ptr<yaml_value> key;
+    yaml_value* key = nullptr;
     yaml_value* node;
 
-    parser_stack(yaml_value* _node) : node(_node) {}
-    parser_stack(const parser_stack&) = delete;
-    parser_stack(parser_stack&& r) : key(std::move(r.key)), node(r.node) {}
-};
+    /** Position of the first child of this container in the pending children. */
+    std::size_t first;
 
-typedef std::unique_ptr<yaml_value> document_root_type;
+    parser_stack(yaml_value* _node, std::size_t _first) : node(_node), first(_first) {}
+};
 
 class handler
 {
-    std::vector<document_root_type> m_docs;
+    document_store& m_doc;
 
     std::vector<parser_stack> m_stack;
     std::vector<parser_stack> m_key_stack;
 
-    document_root_type m_root;
-    document_root_type m_key_root;
+    /**
+     * Children of the containers being built.  The children of the innermost
+     * container are always at the end, since a container gets completed
+     * before its parent receives another child.
+     */
+    std::vector<yaml_value*> m_pending;
+
+    /** Containers whose children need to be resolved at the end. */
+    std::vector<yaml_value*> m_containers;
+
+    yaml_value* m_root;
+    yaml_value* m_key_root;
 
     bool m_in_document;
 
@@ -174,7 +196,7 @@ class handler
     }
 #endif
 
-    yaml_value* push_value(std::unique_ptr<yaml_value>&& value)
+    void push_value(yaml_value* value)
     {
         assert(!m_stack.empty());
         parser_stack& cur = m_stack.back();
@@ -183,23 +205,20 @@ class handler
         {
             case node_t::sequence:
             {
-                yaml_value_sequence* yvs = static_cast<yaml_value_sequence*>(cur.node);
-                value->parent = yvs;
-                yvs->value_sequence.push_back(std::move(value));
-                return yvs->value_sequence.back().get();
+                value->link.parent = cur.node;
+                m_pending.push_back(value);
+                return;
             }
             case node_t::map:
             {
-                yaml_value_map* yvm = static_cast<yaml_value_map*>(cur.node);
-                value->parent = yvm;
-
-                yvm->key_order.push_back(std::move(cur.key));
-
-                auto r = yvm->value_map.insert(
-                    std::make_pair(
-                        yvm->key_order.back().get(), std::move(value)));
-
-                return r.first->second.get();
+                assert(cur.key);
+                value->link.parent = cur.node;
+                cur.key->is_key = true;
+                cur.key->link.key_index = (m_pending.size() - cur.first) / 2;
+                m_pending.push_back(cur.key);
+                m_pending.push_back(value);
+                cur.key = nullptr;
+                return;
             }
             default:
                 break;
@@ -210,8 +229,48 @@ class handler
         throw document_error(os.str());
     }
 
+    void add_value(yaml_value* value)
+    {
+        assert(m_in_document);
+
+        if (m_root)
+            push_value(value);
+        else
+            m_root = value;
+    }
+
+    void begin_container(node_t type)
+    {
+        yaml_value* yv = m_doc.m_pool.construct(type);
+        add_value(yv);
+        m_stack.emplace_back(yv, m_pending.size());
+    }
+
+    void end_container()
+    {
+        assert(!m_stack.empty());
+        const parser_stack& cur = m_stack.back();
+
+        std::size_t n = m_pending.size() - cur.first;
+        if (cur.node->type == node_t::map)
+            n /= 2;
+
+        if (n > std::numeric_limits<std::uint32_t>::max())
+            throw document_error("too many child values in a container.");
+
+        // Move the children to the child table of the document.
+        cur.node->size = n;
+        cur.node->value.first = m_doc.m_children.size();
+        m_doc.m_children.insert(m_doc.m_children.end(), m_pending.begin() + cur.first, m_pending.end());
+        m_pending.resize(cur.first);
+
+        m_containers.push_back(cur.node);
+        m_stack.pop_back();
+    }
+
 public:
-    handler() : m_in_document(false) {}
+    handler(document_store& doc) :
+        m_doc(doc), m_root(nullptr), m_key_root(nullptr), m_in_document(false) {}
 
     void begin_parse()
     {
@@ -219,159 +278,107 @@ public:
 
     void end_parse()
     {
+        // The child table no longer grows.  Point the containers directly to
+        // their children.
+        m_doc.m_children.shrink_to_fit();
+
+        for (yaml_value* yv : m_containers)
+            yv->value.children = m_doc.m_children.data() + yv->value.first;
     }
 
     void begin_document()
     {
         assert(!m_in_document);
         m_in_document = true;
-        m_root.reset();
+        m_root = nullptr;
     }
 
     void end_document()
     {
         assert(m_stack.empty());
         m_in_document = false;
-        m_docs.push_back(std::move(m_root));
+        m_doc.m_docs.push_back(m_root);
     }
 
     void begin_sequence()
     {
-        assert(m_in_document);
-
-        if (m_root)
-        {
-            yaml_value* yv = push_value(std::make_unique<yaml_value_sequence>());
-            assert(yv && yv->type == node_t::sequence);
-            m_stack.push_back(parser_stack(yv));
-        }
-        else
-        {
-            m_root = std::make_unique<yaml_value_sequence>();
-            m_stack.push_back(parser_stack(m_root.get()));
-        }
+        begin_container(node_t::sequence);
     }
 
     void end_sequence()
     {
-        assert(!m_stack.empty());
-        m_stack.pop_back();
+        end_container();
     }
 
     void begin_map()
     {
-        assert(m_in_document);
-        if (m_root)
-        {
-            yaml_value* yv = push_value(std::make_unique<yaml_value_map>());
-            assert(yv && yv->type == node_t::map);
-            m_stack.push_back(parser_stack(yv));
-        }
-        else
-        {
-            m_root = std::make_unique<yaml_value_map>();
-            m_stack.push_back(parser_stack(m_root.get()));
-        }
+        begin_container(node_t::map);
     }
 
     void begin_map_key()
     {
         assert(!m_key_root);
         assert(m_key_stack.empty());
-        m_key_root.swap(m_root);
+        std::swap(m_key_root, m_root);
         m_key_stack.swap(m_stack);
     }
 
     void end_map_key()
     {
-        m_key_root.swap(m_root);
+        std::swap(m_key_root, m_root);
         m_key_stack.swap(m_stack);
 
         assert(!m_stack.empty());
         parser_stack& cur = m_stack.back();
-        cur.key.swap(m_key_root);
+        cur.key = m_key_root;
         m_key_stack.clear();
-        m_key_root.reset();
+        m_key_root = nullptr;
     }
 
     void end_map()
     {
-        assert(!m_stack.empty());
-        m_stack.pop_back();
+        end_container();
     }
 
     void string(std::string_view v)
     {
-        assert(m_in_document);
-
-        if (m_root)
-        {
-            yaml_value* yv = push_value(std::make_unique<yaml_value_string>(v));
-            assert(yv && yv->type == node_t::string);
-        }
-        else
-            m_root = std::make_unique<yaml_value_string>(v);
+        if (v.size() > std::numeric_limits<std::uint32_t>::max())
+            throw document_error("string value is too long.");
+
+        yaml_value* yv = m_doc.m_pool.construct(node_t::string);
+        v = m_doc.m_str_pool.intern(v).first;
+        yv->value.str = v.data();
+        yv->size = v.size();
+        add_value(yv);
     }
 
     void number(double val)
     {
-        assert(m_in_document);
-        if (m_root)
-        {
-            yaml_value* yv = push_value(std::make_unique<yaml_value_number>(val));
-            assert(yv && yv->type == node_t::number);
-        }
-        else
-            m_root = std::make_unique<yaml_value_number>(val);
+        yaml_value* yv = m_doc.m_pool.construct(node_t::number);
+        yv->value.numeric = val;
+        add_value(yv);
     }
 
     void boolean_true()
     {
-        assert(m_in_document);
-        if (m_root)
-        {
-            yaml_value* yv = push_value(std::make_unique<yaml_value>(node_t::boolean_true));
-            assert(yv && yv->type == node_t::boolean_true);
-        }
-        else
-            m_root = std::make_unique<yaml_value>(node_t::boolean_true);
+        add_value(m_doc.m_pool.construct(node_t::boolean_true));
     }
 
     void boolean_false()
     {
-        assert(m_in_document);
-        if (m_root)
-        {
-            yaml_value* yv = push_value(std::make_unique<yaml_value>(node_t::boolean_false));
-            assert(yv && yv->type == node_t::boolean_false);
-        }
-        else
-            m_root = std::make_unique<yaml_value>(node_t::boolean_false);
+        add_value(m_doc.m_pool.construct(node_t::boolean_false));
     }
 
     void null()
     {
-        assert(m_in_document);
-        if (m_root)
-        {
-            yaml_value* yv = push_value(std::make_unique<yaml_value>(node_t::null));
-            assert(yv && yv->type == node_t::null);
-        }
-        else
-            m_root = std::make_unique<yaml_value>(node_t::null);
-    }
-
-    void swap(std::vector<document_root_type>& docs)
-    {
-        m_docs.swap(docs);
+        add_value(m_doc.m_pool.construct(node_t::null));
     }
 };
 
 } // anonymous namespace
 
-struct document_tree::impl
+struct document_tree::impl : public document_store
 {
-    std::vector<document_root_type> m_docs;
 };
 
 struct const_node::impl
@@ -411,9 +418,8 @@ size_t const_node::child_count() const
     switch (mp_impl->m_node->type)
     {
         case node_t::map:
-            return static_cast<const yaml_value_map*>(mp_impl->m_node)->value_map.size();
         case node_t::sequence:
-            return static_cast<const yaml_value_sequence*>(mp_impl->m_node)->value_sequence.size();
+            return mp_impl->m_node->size;
         case node_t::string:
         case node_t::number:
         case node_t::boolean_true:
@@ -431,14 +437,12 @@ std::vector<const_node> const_node::keys() const
     if (mp_impl->m_node->type != node_t::map)
         throw document_error("node::keys: this node is not of map type.");
 
-    const yaml_value_map* yvm = static_cast<const yaml_value_map*>(mp_impl->m_node);
+    const yaml_value* yvm = mp_impl->m_node;
     std::vector<const_node> keys;
-    std::for_each(yvm->key_order.begin(), yvm->key_order.end(),
-        [&](const std::unique_ptr<yaml_value>& key)
-        {
-            keys.push_back(const_node(key.get()));
-        }
-    );
+    keys.reserve(yvm->size);
+
+    for (std::size_t i = 0; i < yvm->size; ++i)
+        keys.push_back(const_node(yvm->map_key(i)));
 
     return keys;
 }
@@ -448,11 +452,11 @@ const_node const_node::key(size_t index) const
     if (mp_impl->m_node->type != node_t::map)
         throw document_error("node::key: this node is not of map type.");
 
-    const yaml_value_map* yvm = static_cast<const yaml_value_map*>(mp_impl->m_node);
-    if (index >= yvm->key_order.size())
+    const yaml_value* yvm = mp_impl->m_node;
+    if (index >= yvm->size)
         throw std::out_of_range("node::key: index is out-of-range.");
 
-    return const_node(yvm->key_order[index].get());
+    return const_node(yvm->map_key(index));
 }
 
 const_node const_node::child(size_t index) const
@@ -461,23 +465,20 @@ const_node const_node::child(size_t index) const
     {
         case node_t::map:
         {
-            const yaml_value_map* yvm = static_cast<const yaml_value_map*>(mp_impl->m_node);
-            if (index >= yvm->key_order.size())
+            const yaml_value* yvm = mp_impl->m_node;
+            if (index >= yvm->size)
                 throw std::out_of_range("node::child: index is out-of-range");
 
-            const yaml_value* key = yvm->key_order[index].get();
-            auto it = yvm->value_map.find(key);
-            assert(it != yvm->value_map.end());
-            return const_node(it->second.get());
+            return const_node(yvm->map_value(index));
         }
         break;
         case node_t::sequence:
         {
-            const yaml_value_sequence* yvs = static_cast<const yaml_value_sequence*>(mp_impl->m_node);
-            if (index >= yvs->value_sequence.size())
+            const yaml_value* yvs = mp_impl->m_node;
+            if (index >= yvs->size)
                 throw std::out_of_range("node::child: index is out-of-range");
 
-            return const_node(yvs->value_sequence[index].get());
+            return const_node(yvs->value.children[index]);
         }
         break;
         case node_t::string:
@@ -496,20 +497,22 @@ const_node const_node::child(const const_node& key) const
     if (mp_impl->m_node->type != node_t::map)
         throw document_error("node::child: this node is not of map type.");
 
-    const yaml_value_map* yvm = static_cast<const yaml_value_map*>(mp_impl->m_node);
-    auto it = yvm->value_map.find(key.mp_impl->m_node);
-    if (it == yvm->value_map.end())
+    // A key knows its position in its map, which saves a lookup.
+    const yaml_value* yvm = mp_impl->m_node;
+    const yaml_value* yv_key = key.mp_impl->m_node;
+    if (!yv_key->is_key || yv_key->link.key_index >= yvm->size || yvm->map_key(yv_key->link.key_index) != yv_key)
         throw document_error("node::child: this map does not have the specified key.");
 
-    return const_node(it->second.get());
+    return const_node(yvm->map_value(yv_key->link.key_index));
 }
 
 const_node const_node::parent() const
 {
-    if (!mp_impl->m_node->parent)
+    const yaml_value* yv = mp_impl->m_node;
+    if (yv->is_key || !yv->link.parent)
         throw document_error("node::parent: this node has no parent.");
 
-    return const_node(mp_impl->m_node->parent);
+    return const_node(yv->link.parent);
 }
 
 std::string_view const_node::string_value() const
@@ -517,8 +520,7 @@ std::string_view const_node::string_value() const
     if (mp_impl->m_node->type != node_t::string)
         throw document_error("node::key: current node is not of string type.");
 
-    const yaml_value_string* yvs = static_cast<const yaml_value_string*>(mp_impl->m_node);
-    return yvs->value_string;
+    return mp_impl->m_node->string_value();
 }
 
 double const_node::numeric_value() const
@@ -526,8 +528,7 @@ double const_node::numeric_value() const
     if (mp_impl->m_node->type != node_t::number)
         throw document_error("node::key: current node is not of numeric type.");
 
-    const yaml_value_number* yvn = static_cast<const yaml_value_number*>(mp_impl->m_node);
-    return yvn->value_number;
+    return mp_impl->m_node->value.numeric;
 }
 
 document_tree::document_tree() :
@@ -540,10 +541,13 @@ document_tree::~document_tree() {}
 
 void document_tree::load(std::string_view s)
 {
-    handler hdl;
+    // Build the documents in a new store, to keep the current content in
+    // case of a failure.
+    auto store = std::make_unique<impl>();
+    handler hdl(*store);
     yaml_parser<handler> parser(s, hdl);
     parser.parse();
-    hdl.swap(mp_impl->m_docs);
+    mp_impl = std::move(store);
 }
 
 size_t document_tree::get_document_count() const
@@ -553,7 +557,7 @@ size_t document_tree::get_document_count() const
 
 const_node document_tree::get_document_root(size_t index) const
 {
-    return const_node(mp_impl->m_docs[index].get());
+    return const_node(mp_impl->m_docs[index]);
 }
 
 namespace {
@@ -572,7 +576,19 @@ void dump_indent(std::ostringstream& os, size_t scope)
         os << indent;
 }
 
-bool needs_quoting(const std::string& s)
+/**
+ * Write a numeric value the same way the stream's default formatting does,
+ * but without going through the stream's locale.
+ */
+void dump_number(std::ostringstream& os, double v)
+{
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::general, 6);
+    assert(res.ec == std::errc{});
+    os.write(buf, res.ptr - buf);
+}
+
+bool needs_quoting(std::string_view s)
 {
     // See if it contains certain characters...
     for (auto it = s.begin(), ite = s.end(); it != ite; ++it)
@@ -590,7 +606,7 @@ bool needs_quoting(const std::string& s)
     return false;
 }
 
-void dump_yaml_string(std::ostringstream& os, const std::string& s)
+void dump_yaml_string(std::ostringstream& os, std::string_view s)
 {
     if (needs_quoting(s))
         os << quote << s << quote;
@@ -613,24 +629,25 @@ void dump_yaml_node(std::ostringstream& os, const yaml_value& node, size_t scope
         break;
         case node_t::boolean_true:
             dump_indent(os, scope);
-            os << kw_true << std::endl;
+            os << kw_true << '\n';
         break;
         case node_t::boolean_false:
             dump_indent(os, scope);
-            os << kw_false << std::endl;
+            os << kw_false << '\n';
         break;
         case node_t::null:
             dump_indent(os, scope);
-            os << kw_tilde << std::endl;
+            os << kw_tilde << '\n';
         break;
         case node_t::number:
             dump_indent(os, scope);
-            os << static_cast<const yaml_value_number&>(node).value_number << std::endl;
+            dump_number(os, node.value.numeric);
+            os << '\n';
         break;
         case node_t::string:
             dump_indent(os, scope);
-            dump_yaml_string(os, static_cast<const yaml_value_string&>(node).value_string);
-            os << std::endl;
+            dump_yaml_string(os, node.string_value());
+            os << '\n';
         break;
         case node_t::unset:
         default:
@@ -645,7 +662,7 @@ void dump_yaml_container_item(std::ostringstream& os, const yaml_value& node, si
         case node_t::map:
         case node_t::sequence:
             // End the line and dump this child container in the next scope.
-            os << std::endl;
+            os << '\n';
             dump_yaml_node(os, node, scope+1);
         break;
         default:
@@ -657,89 +674,77 @@ void dump_yaml_container_item(std::ostringstream& os, const yaml_value& node, si
 
 void dump_yaml_map(std::ostringstream& os, const yaml_value& node, size_t scope)
 {
-    const yaml_value_map& yvm = static_cast<const yaml_value_map&>(node);
+    for (std::size_t i = 0; i < node.size; ++i)
+    {
+        const yaml_value* key = node.map_key(i);
 
-    std::for_each(yvm.key_order.begin(), yvm.key_order.end(),
-        [&](const std::unique_ptr<yaml_value>& pkey)
+        switch (key->type)
         {
-            const yaml_value* key = pkey.get();
-
-            switch (key->type)
-            {
-                case node_t::map:
-                    // TODO
-                break;
-                case node_t::sequence:
-                    // TODO
-                break;
-                case node_t::boolean_true:
-                    dump_indent(os, scope);
-                    os << kw_true;
-                break;
-                case node_t::boolean_false:
-                    dump_indent(os, scope);
-                    os << kw_false;
-                break;
-                case node_t::null:
-                    dump_indent(os, scope);
-                    os << kw_tilde;
-                break;
-                case node_t::number:
-                    dump_indent(os, scope);
-                    os << static_cast<const yaml_value_number*>(key)->value_number;
-                break;
-                case node_t::string:
-                    dump_indent(os, scope);
-                    dump_yaml_string(os, static_cast<const yaml_value_string*>(key)->value_string);
-                break;
-                case node_t::unset:
-                default:
-                    ;
-            }
-
-            os << ":";
-            auto it = yvm.value_map.find(key);
-            assert(it != yvm.value_map.end());
-            const yaml_value& value = *it->second;
-            dump_yaml_container_item(os, value, scope);
+            case node_t::map:
+                // TODO
+            break;
+            case node_t::sequence:
+                // TODO
+            break;
+            case node_t::boolean_true:
+                dump_indent(os, scope);
+                os << kw_true;
+            break;
+            case node_t::boolean_false:
+                dump_indent(os, scope);
+                os << kw_false;
+            break;
+            case node_t::null:
+                dump_indent(os, scope);
+                os << kw_tilde;
+            break;
+            case node_t::number:
+                dump_indent(os, scope);
+                dump_number(os, key->value.numeric);
+            break;
+            case node_t::string:
+                dump_indent(os, scope);
+                dump_yaml_string(os, key->string_value());
+            break;
+            case node_t::unset:
+            default:
+                ;
         }
-    );
+
+        os << ":";
+        dump_yaml_container_item(os, *node.map_value(i), scope);
+    }
 }
 
 void dump_yaml_sequence(std::ostringstream& os, const yaml_value& node, size_t scope)
 {
-    const yaml_value_sequence& yvs = static_cast<const yaml_value_sequence&>(node);
-
-    std::for_each(yvs.value_sequence.begin(), yvs.value_sequence.end(),
-        [&](const std::unique_ptr<yaml_value>& p)
-        {
-            const yaml_value& child = *p;
-            dump_indent(os, scope);
-            os << "-";
-            dump_yaml_container_item(os, child, scope);
-        }
-    );
+    for (std::size_t i = 0; i < node.size; ++i)
+    {
+        dump_indent(os, scope);
+        os << "-";
+        dump_yaml_container_item(os, *node.value.children[i], scope);
+    }
 }
 
 void dump_yaml_document(std::ostringstream& os, const yaml_value& root)
 {
-    os << "---" << std::endl;
+    os << "---" << '\n';
     dump_yaml_node(os, root, 0);
 }
 
-void dump_json_node(std::ostringstream& os, const yaml_value& node, size_t scope, const std::string* key);
+void dump_json_node(std::ostringstream& os, const yaml_value& node, size_t scope, const std::string_view* key);
 
 void dump_json_item(
-    std::ostringstream& os, const std::string* key, const yaml_value& val,
+    std::ostringstream& os, const std::string_view* key, const yaml_value& val,
     size_t scope, bool sep)
 {
     dump_json_node(os, val, scope+1, key);
     if (sep)
         os << ",";
-    os << std::endl;
+    os << '\n';
 }
 
-void dump_json_node(std::ostringstream& os, const yaml_value& node, size_t scope, const std::string* key = nullptr)
+void dump_json_node(std::ostringstream& os, const yaml_value& node, size_t scope, const std::string_view* key = nullptr)
 {
     dump_indent(os, scope);
 
@@ -752,26 +757,18 @@ void dump_json_node(std::ostringstream& os, const yaml_value& node, size_t scope
     {
         case node_t::map:
         {
-            auto& key_order = static_cast<const yaml_value_map&>(node).key_order;
-            auto& vals = static_cast<const yaml_value_map&>(node).value_map;
-            os << "{" << std::endl;
-            size_t n = vals.size();
+            os << "{" << '\n';
+            size_t n = node.size;
 
             // Dump them based on key's original ordering.
-            size_t pos = 0;
-            for (auto it = key_order.begin(), ite = key_order.end(); it != ite; ++it, ++pos)
+            for (size_t pos = 0; pos < n; ++pos)
             {
-                const yaml_value* this_key = it->get();
+                const yaml_value* this_key = node.map_key(pos);
                 if (this_key->type != node_t::string)
                     throw document_error("JSON doesn't support non-string key.");
 
-                auto val_pos = vals.find(this_key);
-                assert(val_pos != vals.end());
-
-                dump_json_item(
-                    os,
-                    &static_cast<const yaml_value_string*>(this_key)->value_string,
-                    *val_pos->second, scope, pos < (n-1));
+                std::string_view sv_key = this_key->string_value();
+                dump_json_item(os, &sv_key, *node.map_value(pos), scope, pos < (n-1));
             }
 
             dump_indent(os, scope);
@@ -780,12 +777,10 @@ void dump_json_node(std::ostringstream& os, const yaml_value& node, size_t scope
         break;
         case node_t::sequence:
         {
-            auto& vals = static_cast<const yaml_value_sequence&>(node).value_sequence;
-            os << "[" << std::endl;
-            size_t n = vals.size();
-            size_t pos = 0;
-            for (auto it = vals.begin(), ite = vals.end(); it != ite; ++it, ++pos)
-                dump_json_item(os, nullptr, **it, scope, pos < (n-1));
+            os << "[" << '\n';
+            size_t n = node.size;
+            for (size_t pos = 0; pos < n; ++pos)
+                dump_json_item(os, nullptr, *node.value.children[pos], scope, pos < (n-1));
 
             dump_indent(os, scope);
             os << "]";
@@ -801,10 +796,10 @@ void dump_json_node(std::ostringstream& os, const yaml_value& node, size_t scope
             os << kw_null;
         break;
         case node_t::number:
-            os << static_cast<const yaml_value_number&>(node).value_number;
+            dump_number(os, node.value.numeric);
         break;
         case node_t::string:
-            json::dump_string(os, static_cast<const yaml_value_string&>(node).value_string);
+            json::dump_string(os, node.string_value());
         break;
         case node_t::unset:
         default:
@@ -822,13 +817,8 @@ std::string document_tree::dump_yaml() const
 {
     std::ostringstream os;
 
-    std::for_each(
-        mp_impl->m_docs.begin(), mp_impl->m_docs.end(),
-        [&](const document_root_type& root)
-        {
-            dump_yaml_document(os, *root);
-        }
-    );
+    for (const yaml_value* root : mp_impl->m_docs)
+        dump_yaml_document(os, *root);
 
     return os.str();
 }
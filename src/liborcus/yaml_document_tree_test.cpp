@@ -614,6 +614,55 @@ void test_yaml_map_key_1()
     assert(string_expected(node.child(1), "value"));
 }
 
+void test_yaml_map_key_lookup()
+{
+    yaml::document_tree doc;
+    doc.load("a:\n  x: 1\n  y: 2\nb:\n  x: 3\n");
+
+    yaml::const_node root = doc.get_document_root(0);
+    assert(root.child_count() == 2);
+
+    yaml::const_node a = root.child(root.key(0));
+    yaml::const_node b = root.child(root.key(1));
+    assert(a.parent().identity() == root.identity());
+    assert(number_expected(a.child(a.key(1)), 2.0));
+    assert(number_expected(b.child(b.key(0)), 3.0));
+
+    // A key of another map is not found, even with the same value.
+    try
+    {
+        b.child(a.key(0));
+        assert(!"document_error was expected to be thrown");
+    }
+    catch (const yaml::document_error&)
+    {
+        // expected
+    }
+
+    // A map key has no parent.
+    try
+    {
+        root.key(0).parent();
+        assert(!"document_error was expected to be thrown");
+    }
+    catch (const yaml::document_error&)
+    {
+        // expected
+    }
+
+    // A failed load leaves the current content intact.
+    try
+    {
+        doc.load("a: \"unclosed\n");
+    }
+    catch (const parse_error&)
+    {
+    }
+
+    assert(doc.get_document_count() == 1);
+    assert(doc.get_document_root(0).child_count() == 2);
+}
+
 int main()
 {
     test_yaml_invalids();
@@ -633,6 +682,7 @@ int main()
     test_yaml_parse_empty_value_sequence_1();
     test_yaml_parse_empty_value_sequence_2();
     test_yaml_map_key_1();
+    test_yaml_map_key_lookup();
 
     return EXIT_SUCCESS;
 }
@@ -231,6 +231,42 @@ void test_csv_dump_flat_utf8()
     test::verify_content(__FILE__, __LINE__, expected, flat_dump);
 }
 
+void test_csv_dump_flat_sparse()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    // Empty cells and empty rows within the data range are printed blank,
+    // and the column widths only account for the non-empty cells.
+    constexpr std::string_view src =
+        "1,,x\n"
+        ",,\n"
+        ",2.5,\n";
+
+    constexpr std::string_view expected =
+        "rows: 3  cols: 3\n"
+        "+-------+---------+---+\n"
+        "| 1 [v] |         | x |\n"
+        "+-------+---------+---+\n"
+        "|       |         |   |\n"
+        "+-------+---------+---+\n"
+        "|       | 2.5 [v] |   |\n"
+        "+-------+---------+---+\n";
+
+    ss::range_size_t ss{1048576, 16384};
+    ss::document doc{ss};
+    ss::import_factory factory(doc);
+    orcus_csv app(&factory);
+    app.read_stream(src);
+
+    const ss::sheet* sh = doc.get_sheet(0);
+    assert(sh);
+    std::ostringstream os;
+    sh->dump_flat(os);
+    std::string flat_dump = os.str();
+
+    test::verify_content(__FILE__, __LINE__, expected, flat_dump);
+}
+
 void test_different_seperators()
 {
     ORCUS_TEST_FUNC_SCOPE;
@@ -380,6 +416,7 @@ int main()
         test_csv_import();
         test_csv_import_split_sheet();
         test_csv_dump_flat_utf8();
+        test_csv_dump_flat_sparse();
         test_different_seperators();
     }
     catch (const std::exception& e)
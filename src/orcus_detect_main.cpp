@@ -11,6 +11,7 @@
 
 #include "cli_global.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 using namespace orcus;
@@ -19,10 +20,22 @@ int ORCUS_CLI_MAIN(int argc, arg_char_t** argv) try
 {
     bootstrap_program();
 
-    if (argc != 2)
+    // usage: orcus-detect [--info] FILE
+    bool show_info = false;
+
+    if (argc == 3)
+    {
+        std::basic_string_view<arg_char_t> opt = argv[1];
+        const std::string_view info_opt = "--info";
+
+        show_info = std::equal(opt.begin(), opt.end(), info_opt.begin(), info_opt.end());
+        if (!show_info)
+            return EXIT_FAILURE;
+    }
+    else if (argc != 2)
         return EXIT_FAILURE;
 
-    auto content = to_file_content(argv[1]);
+    auto content = to_file_content(argv[argc-1]);
 
     if (content.empty())
     {
@@ -30,6 +43,12 @@ int ORCUS_CLI_MAIN(int argc, arg_char_t** argv) try
         return EXIT_FAILURE;
     }
 
+    if (show_info)
+    {
+        std::cout << probe(content.str());
+        return EXIT_SUCCESS;
+    }
+
     format_t detected_type = detect(content.str());
 
     std::cout << "type: ";
@@ -11,14 +11,17 @@
 
 #include <orcus/stream.hpp>
 #include <orcus/format_detection.hpp>
+#include <orcus/exception.hpp>
 #include <orcus/orcus_json.hpp>
 #include <orcus/orcus_xml.hpp>
+#include <algorithm>
 #include <iostream>
 #include <unordered_map>
 #include <unordered_set>
 #include <filesystem>
 
 namespace fs = std::filesystem;
+namespace ss = orcus::spreadsheet;
 
 const fs::path test_base_dir(SRCDIR"/test");
 
@@ -299,6 +302,130 @@ void test_xml_detect_negative()
     }
 }
 
+void test_probe()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+#if XLSX_ENABLED
+    {
+        auto input = test_base_dir / "xlsx" / "raw-values-1" / "input.xlsx";
+        orcus::test::print_path(input.native());
+
+        auto fc = orcus::test::to_file_content(input.native());
+        orcus::document_info info = orcus::probe(fc.str());
+        std::cout << info;
+
+        assert(info.format == orcus::format_t::xlsx);
+        assert(info.sheets.size() == 2);
+        assert(info.sheets[0].name == "Num");
+        assert(info.sheets[1].name == "Text");
+
+        // each sheet part must be listed among the package parts.
+        for (const auto& sheet : info.sheets)
+        {
+            auto it = std::find_if(info.parts.begin(), info.parts.end(),
+                [&sheet](const auto& part) { return part.name == sheet.part; });
+            assert(it != info.parts.end());
+            assert(it->size > 0);
+        }
+    }
+
+    {
+        auto input = test_base_dir / "xlsx" / "sheet-selection" / "input.xlsx";
+        orcus::test::print_path(input.native());
+
+        auto fc = orcus::test::to_file_content(input.native());
+        orcus::document_info info = orcus::probe(fc.str());
+        std::cout << info;
+
+        assert(info.format == orcus::format_t::xlsx);
+        assert(info.sheets.size() == 2);
+        assert(info.sheets[0].name == "Data");
+        assert(info.sheets[0].dimension);
+        assert(*info.sheets[0].dimension == (ss::range_t{{0, 0}, {9, 1}})); // A1:B10
+        assert(info.sheets[1].name == "Other");
+        assert(!info.sheets[1].dimension); // no dimension element
+        assert(info.shared_string_count == 7u);
+
+        // Both sheet parts fit in the head, and have no formula cells.
+        assert(info.has_formulas == false);
+    }
+
+    {
+        // formula cells without a calc chain part.
+        auto input = test_base_dir / "xlsx" / "formula-no-calc-chain" / "input.xlsx";
+        orcus::test::print_path(input.native());
+
+        auto fc = orcus::test::to_file_content(input.native());
+        orcus::document_info info = orcus::probe(fc.str());
+        std::cout << info;
+
+        assert(info.sheets.size() == 1);
+        assert(info.sheets[0].dimension);
+        assert(*info.sheets[0].dimension == (ss::range_t{{0, 0}, {2, 1}})); // A1:B3
+        assert(info.has_formulas == true);
+    }
+
+    {
+        // The workbook part is read in full, so a parse error in it must not
+        // be ignored as a truncated part would be.
+        auto input = test_base_dir / "xlsx" / "corrupt-workbook" / "input.xlsx";
+        orcus::test::print_path(input.native());
+
+        auto fc = orcus::test::to_file_content(input.native());
+        assert(orcus::detect(fc.str()) == orcus::format_t::xlsx);
+
+        try
+        {
+            orcus::probe(fc.str());
+            assert(!"parse_error was not thrown");
+        }
+        catch (const orcus::parse_error&)
+        {
+            // expected
+        }
+    }
+#endif
+
+#if ODS_ENABLED
+    {
+        // This document has no settings.xml, so the sheet names come from
+        // content.xml.
+        auto input = test_base_dir / "ods" / "sheet-selection" / "input.ods";
+        orcus::test::print_path(input.native());
+
+        auto fc = orcus::test::to_file_content(input.native());
+        orcus::document_info info = orcus::probe(fc.str());
+        std::cout << info;
+
+        assert(info.format == orcus::format_t::ods);
+        assert(info.sheets.size() == 2);
+        assert(info.sheets[0].name == "Data");
+        assert(info.sheets[0].part == "content.xml");
+        assert(info.sheets[0].dimension);
+        assert(*info.sheets[0].dimension == (ss::range_t{{0, 0}, {9, 1}})); // A1:B10
+        assert(info.sheets[1].name == "Other");
+        assert(info.sheets[1].dimension);
+        assert(*info.sheets[1].dimension == (ss::range_t{{0, 0}, {0, 0}})); // A1
+        assert(!info.shared_string_count);
+        assert(info.has_formulas == false);
+    }
+#endif
+
+    {
+        // formats without a package only get their format detected.
+        auto input = test_base_dir / "csv" / "double-quotes" / "input.csv";
+        orcus::test::print_path(input.native());
+
+        auto fc = orcus::test::to_file_content(input.native());
+        orcus::document_info info = orcus::probe(fc.str());
+        assert(info.sheets.empty());
+        assert(info.parts.empty());
+        assert(!info.shared_string_count);
+        assert(!info.has_formulas);
+    }
+}
+
 int main()
 {
     orcus::bootstrap_program();
@@ -307,6 +434,7 @@ int main()
     test_json_detect_negative();
     test_xml_detect_positive();
     test_xml_detect_negative();
+    test_probe();
 
     return EXIT_SUCCESS;
 }
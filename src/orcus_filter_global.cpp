@@ -31,6 +31,7 @@ const std::map<dump_format_t, std::string_view> descriptions =
     std::make_pair(dump_format_t::flat,  "Flat text format that displays document content in grid."),
     std::make_pair(dump_format_t::html,  "HTML format."),
     std::make_pair(dump_format_t::json,  "JSON format."),
+    std::make_pair(dump_format_t::parquet, "Apache Parquet format.  The first row of each sheet provides the column names."),
     std::make_pair(dump_format_t::xml,   "This format is currently unsupported."),
     std::make_pair(dump_format_t::yaml,  "This format is currently unsupported."),
     std::make_pair(dump_format_t::debug_state, "This format dumps the internal state of the document in detail, useful for debugging."),
@@ -11,11 +11,18 @@
 
 #include <orcus/config.hpp>
 #include <orcus/interface.hpp>
+#include <orcus/import_profile.hpp>
 #include <orcus/spreadsheet/types.hpp>
 #include <orcus/spreadsheet/factory.hpp>
+#include <orcus/spreadsheet/document.hpp>
+#include <orcus/spreadsheet/config.hpp>
 
 #include <iostream>
+#include <filesystem>
 #include <fstream>
+#include <limits>
+#include <optional>
+#include <vector>
 #include <boost/program_options.hpp>
 
 namespace orcus {
@@ -31,7 +38,6 @@ class import_factory;
 namespace iface {
 
 class import_filter;
-class document_dumper;
 
 }
 
@@ -102,6 +108,20 @@ class import_filter_arg_parser
     "Dump the content to stdout in a special format used for content verification "
     "in automated tests.";
 
+    static constexpr const char* help_memory_usage =
+    "Print the estimated memory usage of the loaded document to stderr, broken down "
+    "by its components.  When no output format is specified, the content is not dumped.";
+
+    static constexpr const char* help_profile =
+    "Print the time spent in each stage of the import along with the element, cell "
+    "and string counts to stderr.  When no output format is specified, the content "
+    "is not dumped.";
+
+    static constexpr const char* help_profile_trace =
+    "Write the timings of the import stages to the specified file in the Chrome "
+    "trace event format.  When no output format is specified, the content is not "
+    "dumped.";
+
     static constexpr const char* help_debug =
     "Turn on a debug mode and optionally specify a debug level in order to generate run-time debug outputs.";
 
@@ -115,17 +135,59 @@ class import_filter_arg_parser
     static constexpr const char* help_row_size =
     "Specify the number of maximum rows in each sheet.";
 
+    static constexpr const char* help_sheet =
+    "Name of a sheet to import.  This option can be specified multiple times.  When "
+    "omitted, all sheets get imported.";
+
+    static constexpr const char* help_rows =
+    "Import only the specified number of rows from the top of each sheet.";
+
+    static constexpr const char* help_jobs =
+    "Number of sheets to dump concurrently when the output is a directory with "
+    "one file per sheet.";
+
     static constexpr const char* err_no_input_file = "No input file.";
 
+    /**
+     * Attaches a profiler to the import filter and the factory for the
+     * duration of the scope.
+     */
+    class profiler_scope
+    {
+        spreadsheet::import_factory& m_fact;
+        iface::import_filter& m_app;
+        bool m_attached;
+
+    public:
+        profiler_scope(spreadsheet::import_factory& fact, iface::import_filter& app, import_profiler* profiler) :
+            m_fact(fact), m_app(app), m_attached(profiler != nullptr)
+        {
+            if (m_attached)
+            {
+                m_app.set_profiler(profiler);
+                m_fact.set_profiler(profiler);
+            }
+        }
+
+        ~profiler_scope()
+        {
+            if (m_attached)
+            {
+                m_app.set_profiler(nullptr);
+                m_fact.set_profiler(nullptr);
+            }
+        }
+    };
+
     spreadsheet::import_factory& m_fact;
     iface::import_filter& m_app;
-    iface::document_dumper& m_doc;
+    spreadsheet::document& m_doc;
 
 public:
     import_filter_arg_parser(
         spreadsheet::import_factory& fact,
         iface::import_filter& app,
-        iface::document_dumper& doc
+        spreadsheet::document& doc
     ) : m_fact(fact), m_app(app), m_doc(doc) {}
 
     bool parse(int argc, ArgCharT** argv, extra_args_handler* args_handler = nullptr) const
@@ -142,9 +204,15 @@ public:
             ("recalc,r", po::bool_switch(&recalc_formula_cells), help_recalc)
             ("error-policy,e", po::value<std::string>()->default_value("fail"), help_formula_error_policy)
             ("dump-check", help_dump_check)
+            ("memory-usage", help_memory_usage)
+            ("profile", help_profile)
+            ("profile-trace", traits::path_value(), help_profile_trace)
             ("output,o", traits::path_value(), help_output)
             ("output-format,f", po::value<std::string>(), gen_help_output_format().data())
-            ("row-size", po::value<spreadsheet::row_t>(), help_row_size);
+            ("row-size", po::value<spreadsheet::row_t>(), help_row_size)
+            ("sheet", po::value<std::vector<std::string>>(), help_sheet)
+            ("rows", po::value<spreadsheet::row_t>(), help_rows)
+            ("jobs,j", po::value<std::size_t>(), help_jobs);
 
         if (args_handler)
             args_handler->add_options(desc);
@@ -211,6 +279,20 @@ public:
 
         m_fact.set_formula_error_policy(error_policy);
 
+        if (vm.count("jobs"))
+        {
+            std::size_t jobs = vm["jobs"].as<std::size_t>();
+            if (!jobs)
+            {
+                std::cerr << "The number of jobs must be greater than zero." << std::endl;
+                return false;
+            }
+
+            spreadsheet::document_config doc_config = m_doc.get_config();
+            doc_config.dump_threads = jobs;
+            m_doc.set_config(doc_config);
+        }
+
         if (infile.empty())
         {
             std::cerr << err_no_input_file << std::endl;
@@ -220,6 +302,22 @@ public:
         config opt = m_app.get_config();
         opt.debug = debug;
 
+        if (vm.count("sheet"))
+            opt.selection.names = vm["sheet"].as<std::vector<std::string>>();
+
+        if (vm.count("rows"))
+        {
+            spreadsheet::row_t rows = vm["rows"].as<spreadsheet::row_t>();
+            if (rows <= 0)
+            {
+                std::cerr << "The number of rows to import must be greater than zero." << std::endl;
+                return false;
+            }
+
+            opt.selection.range = spreadsheet::range_t{
+                {0, 0}, {rows - 1, std::numeric_limits<spreadsheet::col_t>::max()}};
+        }
+
         if (args_handler)
             args_handler->map_to_config(opt, vm);
 
@@ -229,16 +327,56 @@ public:
         if (vm.count("dump-check"))
             outformat = dump_format_t::check;
 
+        bool memory_usage = vm.count("memory-usage") > 0;
+        if (memory_usage && outformat == dump_format_t::unknown)
+            outformat = dump_format_t::none;
+
+        bool profile = vm.count("profile") > 0;
+        if (profile && outformat == dump_format_t::unknown)
+            outformat = dump_format_t::none;
+
+        std::optional<typename traits::path_str_type> profile_trace;
+        if (vm.count("profile-trace"))
+        {
+            profile_trace = vm["profile-trace"].as<typename traits::path_str_type>();
+            if (outformat == dump_format_t::unknown)
+                outformat = dump_format_t::none;
+        }
+
         if (outformat == dump_format_t::unknown)
         {
             std::cerr << "You must specify one of the supported output formats." << std::endl;
             return false;
         }
 
+        import_profiler profiler;
+        profiler_scope profiler_attached(m_fact, m_app, (profile || profile_trace) ? &profiler : nullptr);
+
         try
         {
             m_app.read_file(traits::string_view(infile));
             m_doc.dump(outformat, outdir);
+
+            // The reports go to stderr so as not to mix with the content
+            // dumped to stdout.
+            if (memory_usage)
+                std::cerr << m_doc.get_memory_usage();
+
+            if (profile)
+                std::cerr << profiler.get_profile();
+
+            if (profile_trace)
+            {
+                std::filesystem::path trace_path{*profile_trace};
+                std::ofstream of{trace_path};
+                if (!of)
+                {
+                    std::cerr << "Failed to open " << trace_path << " for writing." << std::endl;
+                    return false;
+                }
+
+                profiler.get_profile().write_chrome_trace(of);
+            }
         }
         catch (const std::exception& e)
         {
@@ -7,6 +7,9 @@
 
 #include "orcus_gnumeric_test.hpp"
 
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+
 using namespace orcus;
 namespace ss = orcus::spreadsheet;
 
@@ -21,6 +24,17 @@ std::vector<fs::path> dirs = {
     SRCDIR"/test/gnumeric/named-expression-sheet-local/",
 };
 
+std::string compress_gzip(std::string_view s)
+{
+    std::string compressed;
+    boost::iostreams::filtering_ostream os;
+    os.push(boost::iostreams::gzip_compressor());
+    os.push(boost::iostreams::back_inserter(compressed));
+    os.write(s.data(), s.size());
+    os.reset();
+    return compressed;
+}
+
 } // anonymous namespace
 
 std::unique_ptr<ss::document> load_doc(const fs::path& filepath)
@@ -52,6 +66,39 @@ void test_gnumeric_detection()
     }
 }
 
+void test_gnumeric_detection_long_head()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    // Only the head of the stream gets decompressed for detection.  Make
+    // sure that the format is still detected when the element needed to
+    // reach a verdict comes well after the initial head.
+    std::ostringstream os;
+    os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+       << "<gnm:Workbook xmlns:gnm=\"http://www.gnumeric.org/v10.dtd\">\n"
+       << "<gnm:Attributes>\n";
+
+    for (int i = 0; i < 2000; ++i)
+        os << "<gnm:Attribute><gnm:name>attr" << i << "</gnm:name><gnm:value>" << i << "</gnm:value></gnm:Attribute>\n";
+
+    os << "</gnm:Attributes>\n"
+       << "<gnm:Sheets><gnm:Sheet><gnm:Name>Sheet1</gnm:Name></gnm:Sheet></gnm:Sheets>\n"
+       << "</gnm:Workbook>\n";
+
+    std::string content = os.str();
+    assert(content.size() > 64 * 1024);
+
+    std::string compressed = compress_gzip(content);
+    assert(orcus_gnumeric::detect(compressed));
+
+    // A gzip-compressed stream that is not a gnumeric document.
+    compressed = compress_gzip("<?xml version=\"1.0\"?><root><child/></root>");
+    assert(!orcus_gnumeric::detect(compressed));
+
+    // Uncompressed gnumeric content.
+    assert(!orcus_gnumeric::detect(content));
+}
+
 void test_gnumeric_create_filter()
 {
     ORCUS_TEST_FUNC_SCOPE;
@@ -1528,6 +1575,7 @@ void test_gnumeric_number_format()
 int main()
 {
     test_gnumeric_detection();
+    test_gnumeric_detection_long_head();
     test_gnumeric_create_filter();
     test_gnumeric_import();
     test_gnumeric_column_widths_row_heights();
@@ -31,6 +31,7 @@ namespace fs = std::filesystem;
 std::unique_ptr<orcus::spreadsheet::document> load_doc(const fs::path& filepath);
 
 void test_gnumeric_detection();
+void test_gnumeric_detection_long_head();
 void test_gnumeric_create_filter();
 void test_gnumeric_import();
 void test_gnumeric_column_widths_row_heights();
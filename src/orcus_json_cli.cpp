@@ -15,6 +15,7 @@
 #include "orcus/xml_namespace.hpp"
 #include "orcus/dom_tree.hpp"
 
+#include <chrono>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -83,6 +84,12 @@ const char* help_json_map =
 "required in that mode."
 ;
 
+const char* help_json_lines =
+"Read the input file as JSON Lines, where each line contains a complete JSON "
+"value.  The lines get mapped as the elements of one array enclosing the whole "
+"file.  This option is only used in map mode, and requires a map file."
+;
+
 const char* help_indent =
 "Number of whitespace characters to use for one indent level.  This is applicable "
 "when the command generates output in JSON format."
@@ -93,6 +100,41 @@ const char* help_json_path =
 "in subtree mode."
 ;
 
+const char* help_threads =
+"Tokenize the input file on a separate thread while the document tree gets "
+"built.  It is used in convert, lint and subtree modes."
+;
+
+const char* help_min_token_size =
+"Number of tokens the parser thread accumulates before handing them over.  It "
+"is only used with the --threads option."
+;
+
+const char* help_max_token_size =
+"Maximum number of tokens the parser thread accumulates before waiting for them "
+"to be taken.  It is only used with the --threads option."
+;
+
+const char* help_profile =
+"Print the time spent loading the document tree, along with the statistics of "
+"the parser thread, to stderr.  It is used in convert, lint and subtree modes."
+;
+
+const char* help_max_stale_count =
+"Stop scanning the input file once this many nodes in a row have added nothing "
+"new to the structure.  It is only used in structure mode."
+;
+
+const char* help_max_bytes =
+"Stop scanning the input file at the first node that starts at or past this many "
+"bytes.  It is only used in structure mode."
+;
+
+const char* help_scan_threads =
+"Number of threads to scan the members of the root array with.  It is only used "
+"in structure mode."
+;
+
 const char* err_no_input_file = "No input file.";
 
 void print_json_usage(std::ostream& os, const po::options_description& desc)
@@ -188,6 +230,18 @@ void parse_args_for_map(
         // Auto-mapping mode
     }
 
+    if (vm.count("lines"))
+    {
+        if (params.map_file.empty())
+        {
+            std::cerr << "JSON Lines input requires a map file." << std::endl;
+            params.config.reset();
+            return;
+        }
+
+        params.json_lines = true;
+    }
+
     parse_args_for_convert(params, desc, vm);
 }
 
@@ -207,8 +261,16 @@ detail::cmd_params parse_json_args(int argc, char** argv)
         ("output,o", po::value<std::string>(), help_json_output)
         ("output-format,f", po::value<std::string>(), help_json_output_format)
         ("map,m", po::value<std::string>(), help_json_map)
+        ("lines", help_json_lines)
         ("indent,i", po::value<std::size_t>(), help_indent)
         ("path,p", po::value<std::string>(), help_json_path)
+        ("threads", help_threads)
+        ("min-token-size", po::value<std::size_t>(), help_min_token_size)
+        ("max-token-size", po::value<std::size_t>(), help_max_token_size)
+        ("profile", help_profile)
+        ("max-stale-count", po::value<std::size_t>(), help_max_stale_count)
+        ("max-bytes", po::value<std::size_t>(), help_max_bytes)
+        ("scan-threads", po::value<std::size_t>(), help_scan_threads)
     ;
 
     po::options_description hidden("Hidden options");
@@ -277,6 +339,26 @@ detail::cmd_params parse_json_args(int argc, char** argv)
     if (vm.count("output"))
         params.output_path = vm["output"].as<std::string>();
 
+    if (vm.count("threads"))
+        params.config->use_threads = true;
+
+    if (vm.count("min-token-size"))
+        params.config->min_token_size = vm["min-token-size"].as<std::size_t>();
+
+    if (vm.count("max-token-size"))
+        params.config->max_token_size = vm["max-token-size"].as<std::size_t>();
+
+    params.profile = vm.count("profile") > 0;
+
+    if (vm.count("max-stale-count"))
+        params.scan_config.max_stale_count = vm["max-stale-count"].as<std::size_t>();
+
+    if (vm.count("max-bytes"))
+        params.scan_config.max_bytes = vm["max-bytes"].as<std::size_t>();
+
+    if (vm.count("scan-threads"))
+        params.scan_config.thread_count = vm["scan-threads"].as<std::size_t>();
+
     switch (params.mode)
     {
         case detail::mode_t::map_gen:
@@ -306,16 +388,28 @@ detail::cmd_params parse_json_args(int argc, char** argv)
     return params;
 }
 
-std::unique_ptr<json::document_tree> load_doc(const orcus::file_content& content, const json_config& config)
+std::unique_ptr<json::document_tree> load_doc(const orcus::file_content& content, const detail::cmd_params& params)
 {
+    auto start = std::chrono::steady_clock::now();
+
     std::unique_ptr<json::document_tree> doc(std::make_unique<json::document_tree>());
-    doc->load(content.str(), config);
+    doc->load(content.str(), *params.config);
+
+    if (params.profile)
+    {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        std::cerr << "load: " << elapsed.count() << " ms" << std::endl;
+
+        if (auto stats = doc->get_parser_stats(); stats)
+            std::cerr << "token-buffer-size-threshold: " << stats->token_buffer_size_threshold << std::endl;
+    }
+
     return doc;
 }
 
 void build_doc_and_dump(const orcus::file_content& content, detail::cmd_params& params)
 {
-    std::unique_ptr<json::document_tree> doc = load_doc(content, *params.config);
+    std::unique_ptr<json::document_tree> doc = load_doc(content, params);
     std::ostream& os = params.os->get();
 
     switch (params.output_format)
@@ -377,8 +471,12 @@ int main(int argc, char** argv)
             case detail::mode_t::structure:
             {
                 json::structure_tree tree;
-                tree.parse(content.str());
+                tree.parse(content.str(), params.scan_config);
                 tree.normalize_tree();
+
+                if (!tree.is_exhaustive())
+                    std::cerr << "The scan stopped before the end of the input file.  The structure may be incomplete." << std::endl;
+
                 tree.dump_compact(params.os->get());
                 break;
             }
@@ -399,14 +497,14 @@ int main(int argc, char** argv)
             }
             case detail::mode_t::lint:
             {
-                auto doc = load_doc(content, *params.config);
+                auto doc = load_doc(content, params);
                 std::ostream& os = params.os->get();
                 os << doc->dump(params.indent);
                 break;
             }
             case detail::mode_t::subtree:
             {
-                auto doc = load_doc(content, *params.config);
+                auto doc = load_doc(content, params);
                 std::ostream& os = params.os->get();
                 auto sub = json::subtree(*doc, params.json_path);
                 os << sub.dump(params.indent);
@@ -9,14 +9,13 @@
 
 #include <orcus/stream.hpp>
 #include <orcus/types.hpp>
+#include <orcus/config.hpp>
 #include "cli_global.hpp"
 
 #include <ostream>
 
 namespace orcus {
 
-struct json_config;
-
 namespace detail {
 
 enum class mode_t
@@ -38,8 +37,11 @@ struct cmd_params
     std::unique_ptr<output_stream> os;
     mode_t mode = mode_t::convert;
     file_content map_file;
+    bool json_lines = false; //< whether the input is in JSON Lines format.
     std::size_t indent = 4;
     std::string json_path;
+    bool profile = false; //< whether to print the load time and the parser statistics.
+    structure_scan_config scan_config; //< how much of the input to scan in structure mode.
 
     cmd_params(const cmd_params&) = delete;
     cmd_params& operator= (const cmd_params&) = delete;
@@ -36,7 +36,11 @@ void map_to_sheets_and_dump(const file_content& content, cmd_params& params)
     else
         app.read_map_definition(params.map_file.str());
 
-    app.read_stream(content.str());
+    if (params.json_lines)
+        app.read_lines(content.str());
+    else
+        app.read_stream(content.str());
+
     doc.dump(params.output_format, params.output_path);
 }
 
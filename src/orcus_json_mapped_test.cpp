@@ -218,10 +218,152 @@ void test_has_range()
     }
 }
 
+void test_mapped_json_lines_import()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    const fs::path base_dir{SRCDIR"/test/json-mapped/json-lines"};
+
+    file_content content((base_dir / "input.jsonl").string());
+    file_content map_content((base_dir / "map.json").string());
+    file_content check_content((base_dir / "check.txt").string());
+
+    // Run with and without parsing the lines on worker threads.
+    for (const char* use_threads : { "true", "false" })
+    {
+        setenv("ORCUS_JSON_USE_THREADS", use_threads, 1);
+        std::cout << "use threads: " << use_threads << std::endl;
+
+        spreadsheet::range_size_t ss{1048576, 16384};
+        spreadsheet::document doc{ss};
+        spreadsheet::import_factory import_fact(doc);
+
+        orcus_json app(&import_fact);
+        app.read_map_definition(map_content.str());
+        app.read_lines(content.str());
+
+        std::ostringstream os;
+        doc.dump_check(os);
+
+        std::string actual_strm = os.str();
+        std::string_view actual(actual_strm);
+        std::string_view expected = check_content.str();
+        actual = trim(actual);
+        expected = trim(expected);
+        assert(actual == expected);
+    }
+}
+
+void test_mapped_json_lines_import_large()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    // Large enough to be split into multiple blocks of lines.
+    constexpr std::size_t n_records = 20000;
+
+    std::ostringstream os_lines, os_array;
+    os_array << '[';
+
+    for (std::size_t i = 0; i < n_records; ++i)
+    {
+        std::ostringstream os;
+        os << "{\"id\":" << i << ",\"name\":\"item \\\"" << i << "\\\"\",\"valid\":" << (i % 3 ? "true" : "false")
+            << ",\"tags\":[" << i % 7 << ',' << i % 11 << "]}";
+
+        os_lines << os.str() << '\n';
+        if (i)
+            os_array << ',';
+        os_array << os.str();
+    }
+
+    os_array << ']';
+
+    auto _import = [](std::string_view stream, bool lines)
+    {
+        spreadsheet::range_size_t ss{1048576, 16384};
+        spreadsheet::document doc{ss};
+        spreadsheet::import_factory import_fact(doc);
+
+        orcus_json app(&import_fact);
+        app.append_sheet("data");
+        app.start_range("data", 0, 0, true);
+        app.append_field_link("$[]['id']", "ID");
+        app.append_field_link("$[]['name']", "Name");
+        app.append_field_link("$[]['valid']", "Valid");
+        app.append_field_link("$[]['tags'][]", "Tag");
+        app.set_range_row_group("$");
+        app.set_range_row_group("$[]['tags']");
+        app.commit_range();
+
+        if (lines)
+            app.read_lines(stream);
+        else
+            app.read_stream(stream);
+
+        std::ostringstream os;
+        doc.dump_check(os);
+        return os.str();
+    };
+
+    // The lines must map the same as the array of the same records.
+    std::string expected = _import(os_array.str(), false);
+
+    for (const char* use_threads : { "true", "false" })
+    {
+        setenv("ORCUS_JSON_USE_THREADS", use_threads, 1);
+        std::cout << "use threads: " << use_threads << std::endl;
+
+        std::string actual = _import(os_lines.str(), true);
+        assert(actual == expected);
+    }
+}
+
+void test_mapped_json_lines_import_invalid()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    const std::string_view stream =
+        "{\"id\":1}\n"
+        "{\"id\":2}\n"
+        "{\"id\":}\n"
+        "{\"id\":4}\n";
+
+    spreadsheet::range_size_t ss{1048576, 16384};
+    spreadsheet::document doc{ss};
+    spreadsheet::import_factory import_fact(doc);
+
+    orcus_json app(&import_fact);
+    app.append_sheet("data");
+    app.start_range("data", 0, 0, false);
+    app.append_field_link("$[]['id']", std::string_view{});
+    app.set_range_row_group("$");
+    app.commit_range();
+
+    try
+    {
+        app.read_lines(stream);
+        assert(!"exception was expected but was not thrown.");
+    }
+    catch (const parse_error& e)
+    {
+        // The offset must point to the failed position in the whole stream.
+        assert(e.offset() == std::ptrdiff_t(stream.find("}\n{\"id\":4")));
+    }
+
+    // The lines that precede the invalid line are still imported.
+    std::ostringstream os;
+    doc.dump_check(os);
+    std::string actual = os.str();
+    assert(trim(actual) == "data/0/0:numeric:1\ndata/1/0:numeric:2");
+}
+
 int main()
 {
     test_mapped_json_import();
     test_mapped_json_import_auto_mapping();
+    test_mapped_json_lines_import();
+    test_mapped_json_lines_import_large();
+    test_mapped_json_lines_import_invalid();
     test_invalid_map_definition();
     test_write_map_definition();
     test_has_range();
@@ -6,8 +6,12 @@
  */
 
 #include "orcus_ods_test.hpp"
+#include <orcus/spreadsheet/tables.hpp>
+#include <orcus/spreadsheet/table.hpp>
 #include <mdds/flat_segment_tree.hpp>
 
+#include <limits>
+
 using namespace orcus;
 using namespace orcus::spreadsheet;
 
@@ -35,6 +39,7 @@ std::vector<fs::path> dirs = {
     SRCDIR"/test/ods/named-range/",
     SRCDIR"/test/ods/named-expression/",
     SRCDIR"/test/ods/named-expression-sheet-local/",
+    SRCDIR"/test/ods/repeated-cells/",
 };
 
 void test_ods_detection()
@@ -936,6 +941,79 @@ void test_ods_import_styles_text_underlines()
     assert(*font->underline.spacing == ss::underline_spacing_t::skip_white_space);
 }
 
+void test_ods_import_sheet_selection()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    fs::path filepath{SRCDIR"/test/ods/raw-values-1/input.ods"};
+
+    ss::range_size_t ssize{1048576, 16384};
+    ss::document doc{ssize};
+    ss::import_factory factory(doc);
+    orcus_ods app(&factory);
+
+    // Only import the range A1:C3 of the second sheet.
+    config opt = app.get_config();
+    opt.selection.indices.push_back(1);
+    opt.selection.range = ss::range_t{{0, 0}, {2, 2}};
+    app.set_config(opt);
+    app.read_file(filepath);
+
+    assert(doc.get_sheet_count() == 2);
+
+    std::ostringstream os;
+    doc.dump_check(os);
+
+    constexpr std::string_view expected =
+        "Text/0/0:string:\"A\"\n"
+        "Text/1/0:string:\"B\"\n"
+        "Text/1/1:string:\"D\"\n"
+        "Text/2/0:string:\"C\"\n"
+        "Text/2/1:string:\"E\"\n"
+        "Text/2/2:string:\"G\"\n";
+
+    test::verify_content(__FILE__, __LINE__, expected, os.str());
+}
+
+void test_ods_import_sheet_selection_metadata()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    // The 'Data' sheet has a database range below the selected rows.
+    fs::path filepath{SRCDIR"/test/ods/sheet-selection/input.ods"};
+
+    ss::range_size_t ssize{1048576, 16384};
+    ss::document doc{ssize};
+    ss::import_factory factory(doc);
+    orcus_ods app(&factory);
+
+    config opt = app.get_config();
+    opt.selection.names.push_back("Data");
+    opt.selection.range = ss::range_t{{0, 0}, {2, std::numeric_limits<ss::col_t>::max()}};
+    app.set_config(opt);
+    app.read_file(filepath);
+
+    std::ostringstream os;
+    doc.dump_check(os);
+
+    constexpr std::string_view expected =
+        "Data/0/0:numeric:1\n"
+        "Data/0/1:numeric:10\n"
+        "Data/1/0:numeric:2\n"
+        "Data/2/0:numeric:3\n"
+        "Data/2/1:numeric:30\n";
+
+    test::verify_content(__FILE__, __LINE__, expected, os.str());
+
+    // Table1 is at A6:B10.
+    auto table = doc.get_tables().get("Table1").lock();
+    assert(table);
+    assert(table->range.first.row == 5);
+    assert(table->range.first.column == 0);
+    assert(table->range.last.row == 9);
+    assert(table->range.last.column == 1);
+}
+
 int main()
 {
     test_ods_detection();
@@ -954,6 +1032,9 @@ int main()
     test_ods_autofilter_text_comparisons();
     test_ods_autofilter_largest_smallest();
 
+    test_ods_import_sheet_selection();
+    test_ods_import_sheet_selection_metadata();
+
     return EXIT_SUCCESS;
 }
 
@@ -12,6 +12,7 @@
 #include <orcus/format_detection.hpp>
 #include <orcus/stream.hpp>
 #include <orcus/parser_global.hpp>
+#include <orcus/config.hpp>
 #include <orcus/spreadsheet/factory.hpp>
 #include <orcus/spreadsheet/document.hpp>
 #include <orcus/spreadsheet/sheet.hpp>
@@ -12,7 +12,9 @@
 #include <orcus/format_detection.hpp>
 #include <orcus/spreadsheet/document.hpp>
 #include <orcus/spreadsheet/factory.hpp>
+#include <orcus/spreadsheet/sheet.hpp>
 
+#include <cstdlib>
 #include <iostream>
 #include <sstream>
 #include <filesystem>
@@ -67,33 +69,40 @@ void test_parquet_basic()
 {
     ORCUS_TEST_FUNC_SCOPE;
 
-    for (auto test_doc : BASIC_TEST_DOCS)
+    // Run with and without decoding the row groups on worker threads.
+    for (const char* use_threads : { "true", "false" })
     {
-        const auto docpath = BASIC_TEST_DOC_DIR / std::string{test_doc};
-        std::cout << docpath << std::endl;
-        assert(fs::is_regular_file(docpath));
-
-        // Test the file import.
-        auto cxt = std::make_unique<doc_context>();
-        cxt->app.read_file(docpath);
-        assert(cxt->doc.get_sheet_count() == 1);
-
-        // Check the content vs control
-        const fs::path check_path = BASIC_TEST_DOC_DIR / (docpath.filename().string() + ".check");
-        file_content control{check_path.string()};
-
-        test::verify_content(__FILE__, __LINE__, control.str(), cxt->get_check_string());
-
-        // Test the stream import.  Manually change the sheet name to the stem
-        // of the input file since the sheet name is set to 'Data' for stream
-        // imports.
-        cxt = std::make_unique<doc_context>();
-        file_content fc(docpath.string());
-        cxt->app.read_stream(fc.str());
-        cxt->doc.set_sheet_name(0, docpath.stem().string());
-
-        // Check the content vs control
-        test::verify_content(__FILE__, __LINE__, control.str(), cxt->get_check_string());
+        setenv("ORCUS_PARQUET_USE_THREADS", use_threads, 1);
+        std::cout << "use threads: " << use_threads << std::endl;
+
+        for (auto test_doc : BASIC_TEST_DOCS)
+        {
+            const auto docpath = BASIC_TEST_DOC_DIR / std::string{test_doc};
+            std::cout << docpath << std::endl;
+            assert(fs::is_regular_file(docpath));
+
+            // Test the file import.
+            auto cxt = std::make_unique<doc_context>();
+            cxt->app.read_file(docpath);
+            assert(cxt->doc.get_sheet_count() == 1);
+
+            // Check the content vs control
+            const fs::path check_path = BASIC_TEST_DOC_DIR / (docpath.filename().string() + ".check");
+            file_content control{check_path.string()};
+
+            test::verify_content(__FILE__, __LINE__, control.str(), cxt->get_check_string());
+
+            // Test the stream import.  Manually change the sheet name to the
+            // stem of the input file since the sheet name is set to 'Data' for
+            // stream imports.
+            cxt = std::make_unique<doc_context>();
+            file_content fc(docpath.string());
+            cxt->app.read_stream(fc.str());
+            cxt->doc.set_sheet_name(0, docpath.stem().string());
+
+            // Check the content vs control
+            test::verify_content(__FILE__, __LINE__, control.str(), cxt->get_check_string());
+        }
     }
 }
 
@@ -112,6 +121,76 @@ void test_parquet_detection()
     }
 }
 
+void test_parquet_export_round_trip()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    ss::document src_doc{ss::range_size_t{1048576, 16384}};
+    auto* sh = src_doc.append_sheet("Data");
+    assert(sh);
+
+    // The first row provides the column names.  The 5th column has no name.
+    sh->set_string(0, 0, "id");
+    sh->set_string(0, 1, "flag");
+    sh->set_string(0, 2, "label");
+    sh->set_string(0, 3, "mixed");
+
+    sh->set_value(1, 0, 1.0);
+    sh->set_bool(1, 1, true);
+    sh->set_string(1, 2, "a");
+    sh->set_value(1, 3, 1.5);
+    sh->set_value(1, 4, 7.0);
+
+    sh->set_value(2, 0, 2.0);
+    sh->set_bool(2, 1, false);
+    sh->set_string(2, 3, "x");
+    sh->set_value(2, 4, 8.0);
+
+    sh->set_value(3, 0, 3.0);
+    sh->set_string(3, 2, "c");
+    sh->set_bool(3, 3, true);
+    sh->set_value(3, 4, 9.0);
+
+    fs::path outdir = fs::temp_directory_path() / "orcus_parquet_export_test";
+    fs::remove_all(outdir);
+    src_doc.dump(dump_format_t::parquet, outdir);
+
+    const fs::path outpath = outdir / "Data.parquet";
+    assert(fs::is_regular_file(outpath));
+    file_content content{outpath.string()};
+    assert(orcus_parquet::detect(content.str()));
+
+    // Import it back.  Empty cells are stored as nulls, and the column with
+    // mixed value types is stored as a string column.
+    auto cxt = std::make_unique<doc_context>();
+    cxt->app.read_stream(content.str());
+    assert(cxt->doc.get_sheet_count() == 1);
+
+    constexpr std::string_view expected =
+        "Data/0/0:string:\"id\"\n"
+        "Data/0/1:string:\"flag\"\n"
+        "Data/0/2:string:\"label\"\n"
+        "Data/0/3:string:\"mixed\"\n"
+        "Data/0/4:string:\"E\"\n"
+        "Data/1/0:numeric:1\n"
+        "Data/1/1:boolean:true\n"
+        "Data/1/2:string:\"a\"\n"
+        "Data/1/3:string:\"1.5\"\n"
+        "Data/1/4:numeric:7\n"
+        "Data/2/0:numeric:2\n"
+        "Data/2/1:boolean:false\n"
+        "Data/2/3:string:\"x\"\n"
+        "Data/2/4:numeric:8\n"
+        "Data/3/0:numeric:3\n"
+        "Data/3/2:string:\"c\"\n"
+        "Data/3/3:string:\"true\"\n"
+        "Data/3/4:numeric:9\n";
+
+    test::verify_content(__FILE__, __LINE__, expected, cxt->get_check_string());
+
+    fs::remove_all(outdir);
+}
+
 int main()
 {
     try
@@ -119,6 +198,7 @@ int main()
         test_parquet_create_filter();
         test_parquet_basic();
         test_parquet_detection();
+        test_parquet_export_round_trip();
     }
     catch (const std::exception& e)
     {
@@ -16,6 +16,8 @@
 #include <vector>
 #include <iostream>
 #include <filesystem>
+#include <limits>
+#include <algorithm>
 
 using namespace orcus;
 namespace ss = orcus::spreadsheet;
@@ -2482,6 +2484,162 @@ void test_xlsx_doc_structure_unordered_sheet_positions()
     }
 }
 
+void test_xlsx_sheet_selection()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    fs::path path{SRCDIR"/test/xlsx/raw-values-1/input.xlsx"};
+
+    ss::range_size_t ssize{1048576, 16384};
+    ss::document doc{ssize};
+    ss::import_factory factory(doc);
+    orcus_xlsx app(&factory);
+
+    // Only import the first 3 rows of the 'Text' sheet.
+    config opt = test_config;
+    opt.selection.names.push_back("Text");
+    opt.selection.range = ss::range_t{{0, 0}, {2, std::numeric_limits<ss::col_t>::max()}};
+    app.set_config(opt);
+    app.read_file(path);
+
+    // The unselected sheet should still exist, but be empty.
+    assert(doc.get_sheet_count() == 2);
+    assert(doc.get_sheet_name(0) == "Num");
+    assert(doc.get_sheet_name(1) == "Text");
+
+    std::ostringstream os;
+    doc.dump_check(os);
+
+    constexpr std::string_view expected =
+        "Text/0/0:string:\"A\"\n"
+        "Text/1/0:string:\"B\"\n"
+        "Text/1/1:string:\"D\"\n"
+        "Text/2/0:string:\"C\"\n"
+        "Text/2/1:string:\"E\"\n"
+        "Text/2/2:string:\"G\"\n";
+
+    test::verify_content(__FILE__, __LINE__, expected, os.str());
+}
+
+void test_xlsx_sheet_selection_metadata()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    // The 'Data' sheet has a merged range and a table below the selected
+    // rows, which are stored after the cell data in the sheet stream.
+    fs::path path{SRCDIR"/test/xlsx/sheet-selection/input.xlsx"};
+
+    ss::range_size_t ssize{1048576, 16384};
+    ss::document doc{ssize};
+    ss::import_factory factory(doc);
+    orcus_xlsx app(&factory);
+
+    config opt = test_config;
+    opt.selection.names.push_back("Data");
+    opt.selection.range = ss::range_t{{0, 0}, {2, std::numeric_limits<ss::col_t>::max()}};
+    app.set_config(opt);
+    app.read_file(path);
+
+    std::ostringstream os;
+    doc.dump_check(os);
+
+    constexpr std::string_view expected =
+        "Data/0/0:numeric:1\n"
+        "Data/0/1:numeric:10\n"
+        "Data/1/0:numeric:2\n"
+        "Data/2/0:numeric:3\n"
+        "Data/2/1:numeric:30\n";
+
+    test::verify_content(__FILE__, __LINE__, expected, os.str());
+
+    const ss::sheet* sh = doc.get_sheet("Data");
+    assert(sh);
+
+    // A2:B2 is inside the selected rows, and C7:D8 is below them.
+    ss::range_t merged = sh->get_merge_cell_range(1, 0);
+    assert(merged == (ss::range_t{{1, 0}, {1, 1}}));
+    merged = sh->get_merge_cell_range(6, 2);
+    assert(merged == (ss::range_t{{6, 2}, {7, 3}}));
+
+    // Table1 is at A6:B10.
+    auto table = doc.get_tables().get("Table1").lock();
+    assert(table);
+    assert(table->range.first.row == 5);
+    assert(table->range.first.column == 0);
+    assert(table->range.last.row == 9);
+    assert(table->range.last.column == 1);
+    assert(table->columns.size() == 2);
+}
+
+void test_xlsx_import_profile()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    fs::path path{SRCDIR"/test/xlsx/raw-values-1/input.xlsx"};
+
+    ss::range_size_t ssize{1048576, 16384};
+    ss::document doc{ssize};
+    ss::import_factory factory(doc);
+    orcus_xlsx app(&factory);
+    app.set_config(test_config);
+
+    import_profiler profiler;
+    app.set_profiler(&profiler);
+    factory.set_profiler(&profiler);
+    app.read_file(path);
+
+    import_profile_t profile = profiler.get_profile();
+
+    auto has_stage = [&profile](std::string_view name)
+    {
+        return std::any_of(profile.stages.begin(), profile.stages.end(),
+            [name](const auto& stage) { return stage.name == name; });
+    };
+
+    assert(has_stage("xlsx import"));
+    assert(has_stage("workbook"));
+    assert(has_stage("sheet: Num"));
+    assert(has_stage("sheet: Text"));
+    assert(has_stage("shared strings"));
+    assert(has_stage("finalize_import"));
+    assert(!has_stage("recalc"));
+
+    // The outermost stage completes last, and covers all the other stages.
+    assert(profile.stages.back().name == "xlsx import");
+    assert(profile.total >= profile.stages.back().duration);
+
+    for (const auto& stage : profile.stages)
+        assert(stage.start + stage.duration <= profile.total);
+
+    assert(!profile.parts.empty());
+    for (const auto& part : profile.parts)
+        assert(part.inflated_size > 0);
+
+    assert(profile.xml_elements > 0);
+    assert(profile.xml_attributes > 0);
+    assert(profile.cells == 25);
+    assert(profile.formulas == 0);
+    assert(profile.strings > 0);
+
+    std::ostringstream os;
+    profile.write_chrome_trace(os);
+    std::string trace = os.str();
+    assert(trace.starts_with("{\"traceEvents\":["));
+    assert(trace.find("\"name\":\"sheet: Text\"") != std::string::npos);
+    assert(trace.find("\"cells\":25") != std::string::npos);
+
+    // Without a profiler attached, nothing gets recorded.  The re-import
+    // reads a workbook without any sheets, since the document already has
+    // the sheets of the first one.
+    app.set_profiler(nullptr);
+    factory.set_profiler(nullptr);
+    assert(!app.get_profiler());
+    app.read_file(SRCDIR"/test/xlsx/no-sheets/input.xlsx");
+
+    assert(doc.get_sheet_count() == 2);
+    assert(profiler.get_profile().stages.size() == profile.stages.size());
+}
+
 int main()
 {
     test_config.debug = false;
@@ -2527,6 +2685,13 @@ int main()
     // document structure
     test_xlsx_doc_structure_unordered_sheet_positions();
 
+    // selective import
+    test_xlsx_sheet_selection();
+    test_xlsx_sheet_selection_metadata();
+
+    // profiling
+    test_xlsx_import_profile();
+
     return EXIT_SUCCESS;
 }
 
@@ -13,6 +13,7 @@
 #include <orcus/format_detection.hpp>
 #include <orcus/stream.hpp>
 #include <orcus/config.hpp>
+#include <orcus/import_profile.hpp>
 #include <orcus/spreadsheet/factory.hpp>
 #include <orcus/spreadsheet/document.hpp>
 #include <orcus/spreadsheet/view.hpp>
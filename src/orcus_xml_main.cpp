@@ -6,6 +6,7 @@
  */
 
 #include "orcus/orcus_xml.hpp"
+#include "orcus/config.hpp"
 #include "orcus/xml_namespace.hpp"
 #include "orcus/xml_structure_tree.hpp"
 #include "orcus/dom_tree.hpp"
@@ -110,12 +111,28 @@ const char* help_indent =
 "Number of spaces per indent level for XML output when lint mode is specified. "
 "0 produces compact single-line output.";
 
-bool parse_and_dump_structure(const file_content& content, const std::string& output)
+const char* help_max_stale_count =
+"Stop scanning the input file once this many elements in a row have added "
+"nothing new to the structure.  It is only used in structure mode.";
+
+const char* help_max_bytes =
+"Stop scanning the input file at the first element that starts at or past this "
+"many bytes.  It is only used in structure mode.";
+
+const char* help_scan_threads =
+"Number of threads to scan the child elements of the root element with.  It is "
+"only used in structure mode.";
+
+bool parse_and_dump_structure(
+    const file_content& content, const std::string& output, const structure_scan_config& config)
 {
     xmlns_repository repo;
     xmlns_context cxt = repo.create_context();
     xml_structure_tree tree(cxt);
-    tree.parse(content.str());
+    tree.parse(content.str(), config);
+
+    if (!tree.is_exhaustive())
+        std::cerr << "The scan stopped before the end of the input file.  The structure may be incomplete." << std::endl;
 
     if (output.empty())
     {
@@ -165,6 +182,9 @@ int main(int argc, char** argv) try
         ("output,o", po::value<std::string>(), build_output_help_text().data())
         ("output-format,f", po::value<std::string>(), gen_help_output_format().data())
         ("indent", po::value<std::size_t>(), help_indent)
+        ("max-stale-count", po::value<std::size_t>(), help_max_stale_count)
+        ("max-bytes", po::value<std::size_t>(), help_max_bytes)
+        ("scan-threads", po::value<std::size_t>(), help_scan_threads)
     ;
 
     po::options_description hidden("");
@@ -254,7 +274,15 @@ int main(int argc, char** argv) try
         {
             case output_mode::type::structure:
             {
-                bool success = parse_and_dump_structure(content, output);
+                structure_scan_config config;
+                if (vm.count("max-stale-count"))
+                    config.max_stale_count = vm["max-stale-count"].as<std::size_t>();
+                if (vm.count("max-bytes"))
+                    config.max_bytes = vm["max-bytes"].as<std::size_t>();
+                if (vm.count("scan-threads"))
+                    config.thread_count = vm["scan-threads"].as<std::size_t>();
+
+                bool success = parse_and_dump_structure(content, output, config);
                 return success ? EXIT_SUCCESS : EXIT_FAILURE;
             }
             case output_mode::type::dump:
@@ -76,16 +76,28 @@ struct parser_thread::impl
     {
         try
         {
-            json_parser<parser_thread::impl> parser({mp_char, m_size}, *this);
-            parser.parse();
+            try
+            {
+                json_parser<parser_thread::impl> parser({mp_char, m_size}, *this);
+                parser.parse();
+            }
+            catch (const parse_error& e)
+            {
+                std::string_view s = m_pool.intern(e.what()).first;
+                m_parser_tokens.emplace_back(s, e.offset());
+            }
+
+            notify_and_finish();
         }
-        catch (const parse_error& e)
+        catch (const orcus::detail::parsing_aborted_error&)
         {
-            std::string_view s = m_pool.intern(e.what()).first;
-            m_parser_tokens.emplace_back(s, e.offset());
+            // This is used only to abort the parsing thread prematurely.
         }
+    }
 
-        notify_and_finish();
+    void abort()
+    {
+        m_token_buffer.abort();
     }
 
     void begin_parse()
@@ -289,6 +301,11 @@ void parser_thread::swap_string_pool(string_pool& pool)
     mp_impl->swap_string_pool(pool);
 }
 
+void parser_thread::abort()
+{
+    mp_impl->abort();
+}
+
 }}
 
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -630,6 +630,9 @@ const char* parse_to_closing_double_quote(const char* p, size_t max_length)
 
             if (get_string_escape_char_type(c) == string_escape_char_t::invalid)
                 return nullptr;
+
+            // An escaped quote or backslash is part of the string.
+            continue;
         }
 
         switch (*p)
@@ -207,6 +207,38 @@ void test_parse_double_quoted_strings()
 
 }
 
+void test_parse_to_closing_double_quote()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    struct test_case
+    {
+        std::string input;
+        std::ptrdiff_t expected_length; // -1 if no closing quote is expected
+    };
+
+    std::vector<test_case> test_cases = {
+        { "\"", -1 },
+        { "\"\"", 2 },
+        { "\"abc\" def", 5 },
+        { "\"abc\\\"def\"", 10 },
+        { "\"\\\\\" rest", 4 },
+        { "\"\\\"", -1 },
+        { "\"\\x\"", -1 },
+    };
+
+    for (const test_case& tc : test_cases)
+    {
+        const char* p = tc.input.data();
+        const char* p_end = orcus::parse_to_closing_double_quote(p, tc.input.size());
+
+        if (tc.expected_length < 0)
+            assert(!p_end);
+        else
+            assert(p_end && p_end - p == tc.expected_length);
+    }
+}
+
 void test_trim()
 {
     ORCUS_TEST_FUNC_SCOPE;
@@ -235,6 +267,7 @@ int main()
     test_parse_numbers();
     test_parse_integers();
     test_parse_double_quoted_strings();
+    test_parse_to_closing_double_quote();
     test_trim();
 
     return 0;
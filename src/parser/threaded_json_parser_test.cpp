@@ -176,10 +176,42 @@ void test_threaded_json_parser_invalid()
     }
 }
 
+void test_threaded_json_parser_handler_throw()
+{
+    class throwing_handler : public handler
+    {
+    public:
+        void number(double)
+        {
+            throw std::runtime_error("stop");
+        }
+    };
+
+    // Make the stream long enough for the parser thread to still be waiting
+    // for the tokens to get used up when the handler throws.
+    std::string src = "[";
+    for (int i = 0; i < 1000; ++i)
+        src += "1,";
+    src += "1]";
+
+    try
+    {
+        throwing_handler hdl;
+        threaded_json_parser<throwing_handler> parser(src, hdl, 1, 2);
+        parser.parse();
+        assert(false);
+    }
+    catch (const std::runtime_error&)
+    {
+        // The parser thread has been stopped without hanging.
+    }
+}
+
 int main()
 {
     test_threaded_json_parser_basic();
     test_threaded_json_parser_invalid();
+    test_threaded_json_parser_handler_throw();
     return EXIT_SUCCESS;
 }
 
@@ -178,6 +178,43 @@ void test_sax_token_parser_1()
             // expected.
         }
     }
+
+    {
+        // The handler may throw something that is not derived from
+        // std::exception to stop the parsing.
+        const char* content = "<?xml version=\"1.0\"?><root><andy/><bruce/><charlie/><david/><edward/><frank/></root>";
+        size_t content_size = strlen(content);
+
+        struct stop_parsing {};
+
+        class handler
+        {
+        public:
+            handler() {}
+
+            void start_element(const orcus::xml_token_element_t& /*elem*/)
+            {
+                throw stop_parsing();
+            }
+
+            void end_element(const orcus::xml_token_element_t& /*elem*/) {}
+
+            void characters(std::string_view /*val*/, bool /*transient*/) {}
+        };
+
+        handler hdl;
+        threaded_sax_token_parser<handler> parser(content, content_size, token_map, ns_cxt, hdl, 1, 2);
+
+        try
+        {
+            parser.parse();
+            assert(!"An exception was expected but not thrown.");
+        }
+        catch (const stop_parsing&)
+        {
+            // expected.
+        }
+    }
 }
 
 int main()
@@ -452,6 +452,7 @@ constexpr map_type::entry_type entries[] = {
     { "html",        dump_format_t::html        },
     { "json",        dump_format_t::json        },
     { "none",        dump_format_t::none        },
+    { "parquet",     dump_format_t::parquet     },
     { "xml",         dump_format_t::xml         },
     { "yaml",        dump_format_t::yaml        },
 };
@@ -9,10 +9,12 @@
 #include <orcus/zip_archive_stream.hpp>
 #include <orcus/string_pool.hpp>
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <mutex>
 #include <unordered_map>
 #include <format>
 #include <string_view>
@@ -128,6 +130,62 @@ public:
     }
 };
 
+/**
+ * Inflates only the leading part of a deflated entry, feeding the compressed
+ * data in chunks so that only as much of it gets read from the stream as is
+ * needed to fill the destination buffer.
+ */
+class zip_partial_inflater
+{
+    z_stream m_zlib_cxt;
+
+public:
+    zip_partial_inflater() = delete;
+    zip_partial_inflater(char* dest, std::size_t dest_size)
+    {
+        memset(&m_zlib_cxt, 0, sizeof(m_zlib_cxt));
+        m_zlib_cxt.next_out = reinterpret_cast<Bytef*>(dest);
+        m_zlib_cxt.avail_out = dest_size;
+    }
+
+    ~zip_partial_inflater()
+    {
+        inflateEnd(&m_zlib_cxt);
+    }
+
+    bool init()
+    {
+        int err = inflateInit2(&m_zlib_cxt, -MAX_WBITS);
+        return err == Z_OK;
+    }
+
+    /**
+     * Inflate the next chunk of compressed data.
+     *
+     * @return true if the destination buffer has been filled, false if more
+     *         input is needed.
+     */
+    bool inflate(const uint8_t* p, std::size_t n)
+    {
+        m_zlib_cxt.next_in = const_cast<Bytef*>(p);
+        m_zlib_cxt.avail_in = n;
+
+        int err = ::inflate(&m_zlib_cxt, Z_SYNC_FLUSH);
+        if (m_zlib_cxt.avail_out == 0)
+            return true;
+
+        if (err == Z_STREAM_END)
+            // The stream ended before filling the buffer, which contradicts
+            // the uncompressed size recorded in the central directory.
+            throw zip_error("deflate stream ended prematurely.");
+
+        if (err != Z_OK && err != Z_BUF_ERROR)
+            throw zip_error("error during inflate.");
+
+        return false;
+    }
+};
+
 /**
  * Stream doesn't know its size; only its starting offset position (head
  * position) within the file stream.
@@ -280,6 +338,12 @@ class zip_archive::impl
     filename_map_type m_filenames;
     unnamed_buffer_store_t m_buffer_type = unnamed_buffer_store_t::uninitialized;
 
+    /**
+     * Serializes access to the stream so that file entries can be read from
+     * multiple threads.  Inflation of the data runs outside of this lock.
+     */
+    mutable std::mutex m_stream_mutex;
+
 public:
     impl(zip_archive_stream* stream);
     impl(zip_archive_stream* stream, unnamed_buffer_store_t buffer_type);
@@ -294,9 +358,21 @@ public:
         return m_file_params.size();
     }
 
+    std::size_t get_file_entry_size(std::size_t index) const;
+    std::size_t get_file_entry_compressed_size(std::size_t index) const;
+
     unnamed_buffer read_file_entry(std::string_view entry_name) const;
+    unnamed_buffer read_file_entry(std::string_view entry_name, std::size_t max_size) const;
 
 private:
+    const zip_file_param& get_file_param(std::string_view entry_name) const;
+
+    /**
+     * Move the stream position to the start of the data section of a file
+     * entry.
+     */
+    void seek_file_data(const zip_file_param& param) const;
+
 
     /**
      * Find the central directory of a zip file, located toward the end before
@@ -499,7 +575,23 @@ std::string_view zip_archive::impl::get_file_entry_name(std::size_t pos) const
     return m_file_params[pos].filename;
 }
 
-unnamed_buffer zip_archive::impl::read_file_entry(std::string_view entry_name) const
+std::size_t zip_archive::impl::get_file_entry_size(std::size_t index) const
+{
+    if (index >= m_file_params.size())
+        throw zip_error("invalid file entry index.");
+
+    return m_file_params[index].size_uncompressed;
+}
+
+std::size_t zip_archive::impl::get_file_entry_compressed_size(std::size_t index) const
+{
+    if (index >= m_file_params.size())
+        throw zip_error("invalid file entry index.");
+
+    return m_file_params[index].size_compressed;
+}
+
+const zip_file_param& zip_archive::impl::get_file_param(std::string_view entry_name) const
 {
     filename_map_type::const_iterator it = m_filenames.find(entry_name);
     if (it == m_filenames.end())
@@ -512,8 +604,11 @@ unnamed_buffer zip_archive::impl::read_file_entry(std::string_view entry_name) c
     if (index >= m_file_params.size())
         throw zip_error("entry index is out-of-bound");
 
-    const zip_file_param& param = m_file_params[index];
+    return m_file_params[index];
+}
 
+void zip_archive::impl::seek_file_data(const zip_file_param& param) const
+{
     // Skip the file header section.
     zip_stream_parser file_header(m_stream, param.offset_file_header);
     file_header.skip_bytes(4);
@@ -532,9 +627,18 @@ unnamed_buffer zip_archive::impl::read_file_entry(std::string_view entry_name) c
 
     // Data section is immediately followed by the header section.
     m_stream->seek(file_header.tell());
+}
+
+unnamed_buffer zip_archive::impl::read_file_entry(std::string_view entry_name) const
+{
+    const zip_file_param& param = get_file_param(entry_name);
 
     unnamed_buffer raw_buf(param.size_compressed+1, m_buffer_type); // null-terminated
-    m_stream->read({reinterpret_cast<uint8_t*>(raw_buf.data()), param.size_compressed});
+    {
+        std::lock_guard lock(m_stream_mutex);
+        seek_file_data(param);
+        m_stream->read({reinterpret_cast<uint8_t*>(raw_buf.data()), param.size_compressed});
+    }
 
     switch (param.compress_method)
     {
@@ -561,6 +665,62 @@ unnamed_buffer zip_archive::impl::read_file_entry(std::string_view entry_name) c
     throw std::logic_error("compress method can be either 'stored' or 'deflated', but neither has happened");
 }
 
+unnamed_buffer zip_archive::impl::read_file_entry(std::string_view entry_name, std::size_t max_size) const
+{
+    const zip_file_param& param = get_file_param(entry_name);
+
+    // The compressed data gets read in chunks as the inflation progresses, so
+    // the stream stays locked for the duration.
+    std::lock_guard lock(m_stream_mutex);
+    seek_file_data(param);
+
+    const std::size_t n_out = std::min(max_size, param.size_uncompressed);
+
+    switch (param.compress_method)
+    {
+        case zip_file_param::stored:
+        {
+            unnamed_buffer buf(n_out+1, m_buffer_type); // null-terminated
+            m_stream->read({reinterpret_cast<uint8_t*>(buf.data()), n_out});
+            return buf;
+        }
+        case zip_file_param::deflated:
+        {
+            unnamed_buffer buf(n_out+1, m_buffer_type); // null-terminated
+            if (!n_out)
+                return buf;
+
+            zip_partial_inflater inflater(buf.data(), n_out);
+            if (!inflater.init())
+                throw zip_error("error during initialization of inflater");
+
+            // Deflate rarely compresses XML content by more than a factor of
+            // 10 or so, which makes this a reasonable first guess for the
+            // amount of compressed data to read per chunk.
+            constexpr std::size_t min_chunk_size = 4096;
+            const std::size_t chunk_size = std::max(min_chunk_size, n_out / 4);
+            std::vector<uint8_t> chunk(std::min(chunk_size, param.size_compressed));
+
+            for (std::size_t remaining = param.size_compressed; ; )
+            {
+                if (!remaining)
+                    throw zip_error("compressed data ended prematurely.");
+
+                std::size_t n_in = std::min(chunk.size(), remaining);
+                m_stream->read({chunk.data(), n_in});
+                remaining -= n_in;
+
+                if (inflater.inflate(chunk.data(), n_in))
+                    break;
+            }
+
+            return buf;
+        }
+    }
+
+    throw std::logic_error("compress method can be either 'stored' or 'deflated', but neither has happened");
+}
+
 size_t zip_archive::impl::seek_central_dir()
 {
     // Search for the position of 0x06054b50 (read in little endian order - so
@@ -699,10 +859,25 @@ size_t zip_archive::get_file_entry_count() const
     return mp_impl->get_file_entry_count();
 }
 
+std::size_t zip_archive::get_file_entry_size(std::size_t index) const
+{
+    return mp_impl->get_file_entry_size(index);
+}
+
+std::size_t zip_archive::get_file_entry_compressed_size(std::size_t index) const
+{
+    return mp_impl->get_file_entry_compressed_size(index);
+}
+
 unnamed_buffer zip_archive::read_file_entry(std::string_view entry_name) const
 {
     return mp_impl->read_file_entry(entry_name);
 }
 
+unnamed_buffer zip_archive::read_file_entry(std::string_view entry_name, std::size_t max_size) const
+{
+    return mp_impl->read_file_entry(entry_name, max_size);
+}
+
 }
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -7,7 +7,9 @@
 
 #include "test_global.hpp"
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <thread>
 #include <vector>
 
 #include <orcus/zip_archive_stream.hpp>
@@ -594,6 +596,102 @@ void test_zip_rejects_truncated_deflate()
     }
 }
 
+void test_zip_read_partial_entry()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    const std::string_view name = "a";
+
+    // A single final stored block holding the 8 bytes 'ABCDEFGH'.
+    const std::vector<uint8_t> raw_deflate =
+        { 0x01, 0x08, 0x00, 0xf7, 0xff, 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H' };
+
+    auto blob = make_zip_with_deflated_entry(name, raw_deflate, 8);
+    zip_archive_stream_blob strm(std::span{blob.data(), blob.size()});
+    zip_archive archive(&strm);
+    archive.load();
+
+    assert(archive.get_file_entry_count() == 1);
+    assert(archive.get_file_entry_size(0) == 8);
+    assert(archive.get_file_entry_compressed_size(0) == raw_deflate.size());
+
+    // Only the requested leading bytes get returned, null-terminated.
+    unnamed_buffer ub = archive.read_file_entry(name, 3);
+    assert(ub.size() == 4);
+    assert(std::string_view(ub.data(), 3) == "ABC");
+    assert(ub.data()[3] == '\0');
+
+    // A request larger than the entry returns the entire entry.
+    ub = archive.read_file_entry(name, 100);
+    assert(ub.size() == 9);
+    assert(std::string_view(ub.data(), 8) == "ABCDEFGH");
+
+    // Truncated stream that can't fill the requested size must be refused.
+    {
+        std::vector<uint8_t> cut(raw_deflate.begin(), raw_deflate.end() - 4);
+        auto blob_cut = make_zip_with_deflated_entry(name, cut, 8);
+        zip_archive_stream_blob strm_cut(std::span{blob_cut.data(), blob_cut.size()});
+        zip_archive archive_cut(&strm_cut);
+        archive_cut.load();
+
+        // The part that is present can still be peeked at.
+        ub = archive_cut.read_file_entry(name, 4);
+        assert(std::string_view(ub.data(), 4) == "ABCD");
+
+        bool threw = false;
+        try
+        {
+            archive_cut.read_file_entry(name, 6);
+        }
+        catch (const zip_error&)
+        {
+            threw = true;
+        }
+        assert(threw);
+    }
+}
+
+void test_zip_read_concurrent()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    const std::string_view name = "a";
+
+    // A single final stored block holding the 8 bytes 'ABCDEFGH'.
+    const std::vector<uint8_t> raw_deflate =
+        { 0x01, 0x08, 0x00, 0xf7, 0xff, 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H' };
+
+    auto blob = make_zip_with_deflated_entry(name, raw_deflate, 8);
+    zip_archive_stream_blob strm(std::span{blob.data(), blob.size()});
+    zip_archive archive(&strm);
+    archive.load();
+
+    // Entries may be read from multiple threads at the same time.
+    std::vector<std::thread> threads;
+    std::atomic<std::size_t> n_matched = 0;
+    constexpr std::size_t n_threads = 4;
+    constexpr std::size_t n_reads = 100;
+
+    for (std::size_t i = 0; i < n_threads; ++i)
+    {
+        threads.emplace_back([&]
+        {
+            for (std::size_t j = 0; j < n_reads; ++j)
+            {
+                unnamed_buffer ub = j % 2 ? archive.read_file_entry(name) : archive.read_file_entry(name, 5);
+                std::string_view expected = j % 2 ? "ABCDEFGH" : "ABCDE";
+                if (std::string_view(ub.data(), ub.size() - 1) == expected)
+                    ++n_matched;
+            }
+        });
+    }
+
+    for (auto& t : threads)
+        t.join();
+
+    assert(n_matched == n_threads * n_reads);
+}
+
 void test_seek_central_dir_window()
 {
     ORCUS_TEST_FUNC_SCOPE;
@@ -633,6 +731,8 @@ int main()
     test_zip_rejects_encrypted_and_multidisk();
     test_zip_rejects_unsafe_local_header_name();
     test_zip_rejects_truncated_deflate();
+    test_zip_read_partial_entry();
+    test_zip_read_concurrent();
     test_seek_central_dir_window();
 
     return EXIT_SUCCESS;
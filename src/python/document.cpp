@@ -74,9 +74,68 @@ PyObject* doc_get_named_expressions(PyObject* self, PyObject* /*args*/, PyObject
     return create_named_expressions_object(-1, doc, cxt.get_named_expressions_iterator());
 }
 
+py_scoped_ref create_sheet_memory_usage_object(const ss::sheet_memory_usage_t& usage)
+{
+    py_scoped_ref dict = PyDict_New();
+    if (!dict)
+        return nullptr;
+
+    bool success =
+        set_dict_item_new(dict.get(), "name", from_string(usage.name)) &&
+        set_dict_item_new(dict.get(), "cells", PyLong_FromSize_t(usage.cells)) &&
+        set_dict_item_new(dict.get(), "cell_formats", PyLong_FromSize_t(usage.cell_formats)) &&
+        set_dict_item_new(dict.get(), "column_formats", PyLong_FromSize_t(usage.column_formats)) &&
+        set_dict_item_new(dict.get(), "row_formats", PyLong_FromSize_t(usage.row_formats)) &&
+        set_dict_item_new(dict.get(), "properties", PyLong_FromSize_t(usage.properties)) &&
+        set_dict_item_new(dict.get(), "total", PyLong_FromSize_t(usage.total()));
+
+    if (!success)
+        return nullptr;
+
+    return dict;
+}
+
+PyObject* doc_get_memory_usage(PyObject* self, PyObject* /*args*/, PyObject* /*kwargs*/)
+{
+    const ss::document& doc = *t(self)->data->m_doc;
+    ss::document_memory_usage_t usage = doc.get_memory_usage();
+
+    py_scoped_ref sheets = PyTuple_New(usage.sheets.size());
+    if (!sheets)
+        return nullptr;
+
+    for (std::size_t i = 0; i < usage.sheets.size(); ++i)
+    {
+        if (!set_tuple_item_new(sheets.get(), i, create_sheet_memory_usage_object(usage.sheets[i])))
+            return nullptr;
+    }
+
+    py_scoped_ref dict = PyDict_New();
+    if (!dict)
+        return nullptr;
+
+    bool success =
+        set_dict_item_new(dict.get(), "sheets", std::move(sheets)) &&
+        set_dict_item_new(dict.get(), "cell_strings", PyLong_FromSize_t(usage.cell_strings)) &&
+        set_dict_item_new(dict.get(), "shared_strings", PyLong_FromSize_t(usage.shared_strings)) &&
+        set_dict_item_new(dict.get(), "string_pool", PyLong_FromSize_t(usage.string_pool)) &&
+        set_dict_item_new(dict.get(), "styles", PyLong_FromSize_t(usage.styles)) &&
+        set_dict_item_new(dict.get(), "pivot_caches", PyLong_FromSize_t(usage.pivot_caches)) &&
+        set_dict_item_new(dict.get(), "formula_tokens", PyLong_FromSize_t(usage.formula_tokens)) &&
+        set_dict_item_new(dict.get(), "tables", PyLong_FromSize_t(usage.tables)) &&
+        set_dict_item_new(dict.get(), "import_session", PyLong_FromSize_t(usage.import_session)) &&
+        set_dict_item_new(dict.get(), "total", PyLong_FromSize_t(usage.total()));
+
+    if (!success)
+        return nullptr;
+
+    return dict.release();
+}
+
 PyMethodDef tp_methods[] =
 {
     { "get_named_expressions", (PyCFunction)doc_get_named_expressions, METH_NOARGS, "Get a named expressions iterator." },
+    { "get_memory_usage", (PyCFunction)doc_get_memory_usage, METH_NOARGS, "Get the estimated memory usage of the document." },
     { nullptr }
 };
 
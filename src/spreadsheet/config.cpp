@@ -10,16 +10,17 @@
 namespace orcus { namespace spreadsheet {
 
 document_config::document_config() :
-    output_precision(-1) {}
+    output_precision(-1), dump_threads(1) {}
 
 document_config::document_config(const document_config& r) :
-    output_precision(r.output_precision) {}
+    output_precision(r.output_precision), dump_threads(r.dump_threads) {}
 
 document_config::~document_config() {}
 
 document_config& document_config::operator= (const document_config& r)
 {
     output_precision = r.output_precision;
+    dump_threads = r.dump_threads;
     return *this;
 }
 
@@ -22,33 +22,32 @@ namespace orcus { namespace spreadsheet { namespace detail {
 
 namespace {
 
-void dump_string(std::ostream& os, std::string_view s)
+void dump_string(buffered_writer& out, std::string_view s)
 {
     // Scan for any special characters that necessitate quoting.
     bool outer_quotes = s.find_first_of(",\"\n") != std::string_view::npos;
 
-    if (outer_quotes)
-        os << '"';
+    if (!outer_quotes)
+    {
+        out.write(s);
+        return;
+    }
 
-    for (const char c : s)
+    out.put('"');
+
+    // Double each quote, writing the segments between them as-is.
+    for (auto pos = s.find('"'); pos != std::string_view::npos; pos = s.find('"'))
     {
-        switch (c)
-        {
-            case '"':
-            {
-                os << c << c;
-                break;
-            }
-            default:
-                os << c;
-        }
+        out.write(s.substr(0, pos + 1));
+        out.put('"');
+        s = s.substr(pos + 1);
     }
 
-    if (outer_quotes)
-        os << '"';
+    out.write(s);
+    out.put('"');
 }
 
-void dump_empty(std::ostream& /*os*/)
+void dump_empty(buffered_writer& /*out*/)
 {
     // Do nothing.
 }
@@ -76,15 +75,22 @@ void csv_dumper::dump(std::ostream& os, ixion::sheet_t sheet_id) const
     auto cell_range = cxt.iterate_cells(
         sheet_id, ixion::rc_direction_t::horizontal, iter_range);
 
+    buffered_writer out(os);
+    const func_str_handler str_handler = dump_string;
+    const func_empty_handler empty_handler = dump_empty;
+
     for (const auto& cell : cell_range)
     {
         if (cell.col == 0 && cell.row > 0)
-            os << std::endl;
+        {
+            out.put('\n');
+            out.commit();
+        }
 
         if (cell.col > 0)
-            os << m_sep;
+            out.put(m_sep);
 
-        dump_cell_value(os, cell, dump_string, dump_empty);
+        dump_cell_value(out, cell, str_handler, empty_handler);
     }
 }
 
@@ -6,9 +6,14 @@
  */
 
 #include "document_impl.hpp"
+#include "document_snapshot.hpp"
+#include "document_memory.hpp"
 #include "debug_state_dumper.hpp"
 #include "debug_state_context.hpp"
 
+#include <orcus/exception.hpp>
+#include <orcus/stream.hpp>
+
 #include <filesystem>
 #include <iostream>
 #include <fstream>
@@ -194,6 +199,62 @@ void document::dump_check(std::ostream& os) const
     mp_impl->dump_check(os);
 }
 
+void document::save_snapshot(const fs::path& filepath) const
+{
+    std::ofstream of{filepath, std::ios::binary};
+    if (!of)
+    {
+        std::ostringstream os;
+        os << "failed to open " << filepath << " for writing.";
+        throw general_error(os.str());
+    }
+
+    save_snapshot(of);
+}
+
+void document::save_snapshot(std::ostream& os) const
+{
+    detail::snapshot_output out{os};
+    detail::document_snapshot_writer writer{*mp_impl, out};
+    writer.write();
+}
+
+void document::load_snapshot(const fs::path& filepath)
+{
+    file_content content{filepath};
+    load_snapshot_stream(content.str());
+}
+
+void document::load_snapshot_stream(std::string_view content)
+{
+    detail::snapshot_input in{content};
+    range_size_t sheet_size = detail::document_snapshot_reader::read_header(in);
+
+    document_config cfg = mp_impl->doc_config;
+    mp_impl = std::make_unique<detail::document_impl>(*this, sheet_size);
+    mp_impl->doc_config = cfg;
+
+    try
+    {
+        detail::document_snapshot_reader reader{*mp_impl, in};
+        reader.read();
+    }
+    catch (...)
+    {
+        mp_impl = std::make_unique<detail::document_impl>(*this, sheet_size);
+        mp_impl->doc_config = cfg;
+        throw;
+    }
+
+    finalize_import();
+}
+
+document_memory_usage_t document::get_memory_usage() const
+{
+    detail::document_memory_counter counter{*mp_impl};
+    return counter.count();
+}
+
 sheet_t document::get_sheet_index(std::string_view name) const
 {
     auto it = std::find_if(
@@ -10,10 +10,14 @@
 #include "debug_state_context.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <fstream>
 #include <exception>
+#include <limits>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 namespace orcus { namespace spreadsheet { namespace detail {
 
@@ -104,6 +108,9 @@ void document_impl::dump(dump_format_t format, const fs::path& outpath) const
         case dump_format_t::json:
             dump_json(outpath);
             break;
+        case dump_format_t::parquet:
+            dump_parquet(outpath);
+            break;
         case dump_format_t::debug_state:
             dump_debug_state(outpath);
             break;
@@ -125,104 +132,104 @@ void document_impl::dump_flat(const fs::path& outdir) const
 
     std::cout << "number of sheets: " << sheets.size() << std::endl;
 
-    for (const std::unique_ptr<detail::sheet_item>& sheet : sheets)
+    for_each_dump_sheet([&outdir](const sheet_item& sheet)
     {
-        if (is_unsafe_dump_sheet_name(sheet->name))
-        {
-            std::cerr << "skipping sheet with unsafe name: " << sheet->name << std::endl;
-            continue;
-        }
-
         fs::path outpath{outdir};
-        outpath /= std::string{sheet->name};
+        outpath /= std::string{sheet.name};
         outpath.replace_extension(".txt");
 
         std::ofstream file(outpath);
         if (!file)
         {
             std::cerr << "failed to create file: " << outpath << std::endl;
-            return;
+            return false;
         }
 
         file << "---" << std::endl;
-        file << "Sheet name: " << sheet->name << std::endl;
-        sheet->data.dump_flat(file);
-    }
+        file << "Sheet name: " << sheet.name << std::endl;
+        sheet.data.dump_flat(file);
+        return true;
+    });
 }
 
 void document_impl::dump_html(const fs::path& outdir) const
 {
-    for (const std::unique_ptr<detail::sheet_item>& sheet : sheets)
+    for_each_dump_sheet([&outdir](const sheet_item& sheet)
     {
-        if (is_unsafe_dump_sheet_name(sheet->name))
-        {
-            std::cerr << "skipping sheet with unsafe name: " << sheet->name << std::endl;
-            continue;
-        }
-
         fs::path outpath{outdir};
-        outpath /= std::string{sheet->name};
+        outpath /= std::string{sheet.name};
         outpath.replace_extension(".html");
 
         std::ofstream file(outpath);
         if (!file)
         {
             std::cerr << "failed to create file: " << outpath << std::endl;
-            return;
+            return false;
         }
 
-        sheet->data.dump_html(file);
-    }
+        sheet.data.dump_html(file);
+        return true;
+    });
 }
 
 void document_impl::dump_json(const fs::path& outdir) const
 {
-    for (const std::unique_ptr<detail::sheet_item>& sheet : sheets)
+    for_each_dump_sheet([&outdir](const sheet_item& sheet)
     {
-        if (is_unsafe_dump_sheet_name(sheet->name))
-        {
-            std::cerr << "skipping sheet with unsafe name: " << sheet->name << std::endl;
-            continue;
-        }
-
         fs::path outpath{outdir};
-        outpath /= std::string{sheet->name};
+        outpath /= std::string{sheet.name};
         outpath.replace_extension(".json");
 
         std::ofstream file(outpath);
         if (!file)
         {
             std::cerr << "failed to create file: " << outpath << std::endl;
-            return;
+            return false;
         }
 
-        sheet->data.dump_json(file);
-    }
+        sheet.data.dump_json(file);
+        return true;
+    });
 }
 
 void document_impl::dump_csv(const fs::path& outdir) const
 {
-    for (const std::unique_ptr<detail::sheet_item>& sheet : sheets)
+    for_each_dump_sheet([&outdir](const sheet_item& sheet)
     {
-        if (is_unsafe_dump_sheet_name(sheet->name))
+        fs::path outpath{outdir};
+        outpath /= std::string{sheet.name};
+        outpath.replace_extension(".csv");
+
+        std::ofstream file(outpath.c_str());
+        if (!file)
         {
-            std::cerr << "skipping sheet with unsafe name: " << sheet->name << std::endl;
-            continue;
+            std::cerr << "failed to create file: " << outpath << std::endl;
+            return false;
         }
 
+        sheet.data.dump_csv(file);
+        return true;
+    });
+}
+
+void document_impl::dump_parquet(const fs::path& outdir) const
+{
+    for_each_dump_sheet([&outdir](const sheet_item& sheet)
+    {
         fs::path outpath{outdir};
-        outpath /= std::string{sheet->name};
-        outpath.replace_extension(".csv");
+        outpath /= std::string{sheet.name};
+        outpath.replace_extension(".parquet");
 
-        std::ofstream file(outpath.c_str());
+        std::ofstream file(outpath, std::ios::binary);
         if (!file)
         {
             std::cerr << "failed to create file: " << outpath << std::endl;
-            return;
+            return false;
         }
 
-        sheet->data.dump_csv(file);
-    }
+        sheet.data.dump_parquet(file);
+        return true;
+    });
 }
 
 void document_impl::dump_debug_state(const fs::path& outdir) const
@@ -231,20 +238,19 @@ void document_impl::dump_debug_state(const fs::path& outdir) const
     detail::doc_debug_state_dumper dumper{cxt, *this};
     dumper.dump(outdir);
 
-    for (const std::unique_ptr<detail::sheet_item>& sheet : sheets)
-    {
-        if (is_unsafe_dump_sheet_name(sheet->name))
-        {
-            std::cerr << "skipping sheet with unsafe name: " << sheet->name << std::endl;
-            continue;
-        }
+    // Create the parent directory up front, so that the sheets being dumped
+    // concurrently don't race to create it.
+    fs::create_directories(outdir / "sheets");
 
+    for_each_dump_sheet([&outdir](const sheet_item& sheet)
+    {
         fs::path outpath = outdir;
         outpath /= "sheets";
-        outpath /= sheet->name;
+        outpath /= sheet.name;
         fs::create_directories(outpath);
-        sheet->data.dump_debug_state(outpath, sheet->name);
-    }
+        sheet.data.dump_debug_state(outpath, sheet.name);
+        return true;
+    });
 
     pivots.dump_debug_state(outdir);
 }
@@ -255,6 +261,96 @@ void document_impl::dump_check(std::ostream& os) const
         sheet->data.dump_check(os, sheet->name);
 }
 
+void document_impl::for_each_dump_sheet(const std::function<bool(const sheet_item&)>& func) const
+{
+    std::size_t n_threads = std::min<std::size_t>(doc_config.dump_threads, sheets.size());
+
+    if (n_threads <= 1)
+    {
+        for (const std::unique_ptr<detail::sheet_item>& sheet : sheets)
+        {
+            if (is_unsafe_dump_sheet_name(sheet->name))
+            {
+                std::cerr << "skipping sheet with unsafe name: " << sheet->name << std::endl;
+                continue;
+            }
+
+            if (!func(*sheet))
+                return;
+        }
+
+        return;
+    }
+
+    // The formula name resolvers get created on demand.  Create them all
+    // before the worker threads start requesting them.
+    for (const auto& [cxt, resolver_type] : formula_context_to_resolver)
+        doc.get_formula_name_resolver(cxt);
+
+    constexpr std::size_t none = std::numeric_limits<std::size_t>::max();
+
+    std::atomic<std::size_t> next_pos = 0;
+    // Position of the first sheet that asked to stop the processing.  The
+    // sheets after it don't get picked up.
+    std::atomic<std::size_t> stop_pos = none;
+
+    std::mutex mtx; // protects the error states below
+    std::size_t error_pos = none;
+    std::exception_ptr error;
+
+    auto worker = [&]
+    {
+        for (std::size_t pos = next_pos++; pos < sheets.size() && pos < stop_pos; pos = next_pos++)
+        {
+            const sheet_item& sheet = *sheets[pos];
+
+            if (is_unsafe_dump_sheet_name(sheet.name))
+            {
+                std::lock_guard lock(mtx);
+                std::cerr << "skipping sheet with unsafe name: " << sheet.name << std::endl;
+                continue;
+            }
+
+            bool proceed = false;
+
+            try
+            {
+                proceed = func(sheet);
+            }
+            catch (...)
+            {
+                std::lock_guard lock(mtx);
+                if (pos < error_pos)
+                {
+                    error_pos = pos;
+                    error = std::current_exception();
+                }
+            }
+
+            if (proceed)
+                continue;
+
+            // Stop processing the sheets after this one.
+            std::size_t cur = stop_pos.load();
+            while (pos < cur && !stop_pos.compare_exchange_weak(cur, pos))
+                ;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(n_threads);
+    for (std::size_t i = 0; i < n_threads; ++i)
+        threads.emplace_back(worker);
+
+    for (auto& t : threads)
+        t.join();
+
+    // Report the error that would have been reported first when processing
+    // the sheets in order.
+    if (error)
+        std::rethrow_exception(error);
+}
+
 }}}
 
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
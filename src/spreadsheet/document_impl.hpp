@@ -27,6 +27,7 @@
 #include <ixion/model_context.hpp>
 
 #include <filesystem>
+#include <functional>
 #include <ostream>
 
 namespace fs = std::filesystem;
@@ -86,8 +87,19 @@ struct document_impl
     void dump_html(const fs::path& outdir) const;
     void dump_json(const fs::path& outdir) const;
     void dump_csv(const fs::path& outdir) const;
+    void dump_parquet(const fs::path& outdir) const;
     void dump_debug_state(const fs::path& outdir) const;
     void dump_check(std::ostream& os) const;
+
+    /**
+     * Run a function on each sheet that has a name safe to use as a file
+     * name, concurrently on up to the number of threads specified in the
+     * document config.  The function returns false to signal that the
+     * sheets after the current one should not be processed.
+     *
+     * @param func function to run on each sheet.
+     */
+    void for_each_dump_sheet(const std::function<bool(const sheet_item&)>& func) const;
 };
 
 }}}
@@ -0,0 +1,310 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "document_memory.hpp"
+#include "document_impl.hpp"
+#include "sheet_impl.hpp"
+#include "pivot_impl.hpp"
+
+#include <ixion/address.hpp>
+#include <ixion/cell.hpp>
+#include <ixion/formula_result.hpp>
+#include <ixion/formula_tokens.hpp>
+#include <ixion/model_context.hpp>
+#include <ixion/types.hpp>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace orcus { namespace spreadsheet { namespace detail {
+
+namespace {
+
+/**
+ * Per-entry overhead of a node-based hash container, which consists of the
+ * pointer to the next node and the cached hash value.
+ */
+constexpr std::size_t hash_node_overhead = sizeof(void*) * 2;
+
+/**
+ * Estimated size of the private state of a formula cell held by ixion.  It
+ * is made up of the references to its token store and to its calculation
+ * status, and its position within its group.  The calculation status in
+ * turn holds a mutex and a condition variable guarding the cached result,
+ * the result itself, the group size and a reference count.  The layout
+ * mirrors that of ixion's implementation, which is not public, and needs to
+ * be revisited when that changes.
+ */
+constexpr std::size_t formula_cell_state_size =
+    sizeof(ixion::formula_tokens_store_ptr_t) + sizeof(void*) + sizeof(ixion::rc_address_t)
+    + sizeof(std::mutex) + sizeof(std::condition_variable)
+    + sizeof(std::unique_ptr<ixion::formula_result>) + sizeof(ixion::formula_result)
+    + sizeof(ixion::rc_size_t) + sizeof(std::size_t);
+
+std::size_t string_bytes(const std::string& s)
+{
+    // Short strings are stored inside the string object itself.
+    std::size_t n = sizeof(std::string);
+    if (s.capacity() >= sizeof(std::string))
+        n += s.capacity() + 1;
+
+    return n;
+}
+
+template<typename TreeT>
+std::size_t segment_tree_bytes(const TreeT& tree)
+{
+    std::size_t n = tree.leaf_size();
+    std::size_t bytes = sizeof(TreeT) + n * sizeof(typename TreeT::node);
+
+    if (tree.valid_tree())
+        bytes += n * sizeof(typename TreeT::nonleaf_node);
+
+    return bytes;
+}
+
+std::size_t pivot_items_bytes(const pivot_cache_items_t& items)
+{
+    return sizeof(items) + items.capacity() * sizeof(pivot_cache_item_t);
+}
+
+} // anonymous namespace
+
+document_memory_counter::document_memory_counter(const document_impl& doc) : m_doc(doc) {}
+
+document_memory_usage_t document_memory_counter::count()
+{
+    document_memory_usage_t usage;
+    m_token_stores.clear();
+
+    for (const auto& sh : m_doc.sheets)
+    {
+        sheet_memory_usage_t sheet_usage = count_sheet(*sh->data.mp_impl, usage.formula_tokens);
+        sheet_usage.name = std::string{sh->name};
+        usage.sheets.push_back(std::move(sheet_usage));
+    }
+
+    usage.cell_strings = count_cell_strings();
+    usage.shared_strings = count_shared_strings();
+    usage.string_pool = count_string_pool();
+    usage.styles = count_styles();
+    usage.pivot_caches = count_pivot_caches();
+    usage.tables = count_tables();
+    usage.import_session = count_import_session();
+
+    return usage;
+}
+
+sheet_memory_usage_t document_memory_counter::count_sheet(const sheet_impl& sheet, std::size_t& formula_tokens)
+{
+    sheet_memory_usage_t usage;
+
+    const ixion::model_context& cxt = m_doc.context;
+    ixion::abs_range_t data_range = cxt.get_data_range(sheet.sheet_id);
+
+    if (data_range.valid())
+    {
+        ixion::abs_rc_range_t walk_range;
+        walk_range.first.column = 0;
+        walk_range.first.row = 0;
+        walk_range.last.column = data_range.last.column;
+        walk_range.last.row = data_range.last.row;
+
+        // Walk the cell blocks of each column, so that a run of cells of the
+        // same type is counted in one step and the empty runs are skipped.
+        auto func = [&](ixion::col_t col, ixion::row_t row1, ixion::row_t row2, const ixion::column_block_shape_t& block)
+        {
+            std::size_t n = row2 - row1 + 1;
+
+            switch (block.type)
+            {
+                case ixion::column_block_t::numeric:
+                    usage.cells += n * sizeof(double);
+                    break;
+                case ixion::column_block_t::boolean:
+                    usage.cells += n * sizeof(bool);
+                    break;
+                case ixion::column_block_t::string:
+                    usage.cells += n * sizeof(ixion::string_id_t);
+                    break;
+                case ixion::column_block_t::formula:
+                {
+                    usage.cells += n * (sizeof(ixion::formula_cell*) + sizeof(ixion::formula_cell) + formula_cell_state_size);
+
+                    // Each formula cell may refer to its own token store.
+                    for (ixion::row_t row = row1; row <= row2; ++row)
+                    {
+                        const ixion::formula_cell* fc = cxt.get_formula_cell(ixion::abs_address_t(sheet.sheet_id, row, col));
+                        const ixion::formula_tokens_store_ptr_t& ts = fc->get_tokens();
+                        if (!ts || !m_token_stores.insert(ts.get()).second)
+                            continue;
+
+                        formula_tokens += sizeof(ixion::formula_tokens_store);
+                        formula_tokens += ts->get().capacity() * sizeof(ixion::formula_token);
+                    }
+                    break;
+                }
+                default:
+                    ;
+            }
+
+            return true;
+        };
+
+        cxt.walk(sheet.sheet_id, walk_range, func);
+    }
+
+    for (const auto& [col, tree] : sheet.cell_formats)
+    {
+        (void)col;
+        usage.cell_formats += hash_node_overhead + sizeof(col_t) + sizeof(tree);
+        usage.cell_formats += segment_tree_bytes(*tree);
+    }
+
+    usage.column_formats = segment_tree_bytes(sheet.column_formats);
+    usage.row_formats = segment_tree_bytes(sheet.row_formats);
+
+    usage.properties += segment_tree_bytes(sheet.col_widths);
+    usage.properties += segment_tree_bytes(sheet.row_heights);
+    usage.properties += segment_tree_bytes(sheet.col_hidden);
+    usage.properties += segment_tree_bytes(sheet.row_hidden);
+
+    for (const auto& [col, merge_map] : sheet.merge_ranges)
+    {
+        (void)col;
+        usage.properties += hash_node_overhead + sizeof(col_t) + sizeof(merge_map) + sizeof(merge_size_type);
+        usage.properties += merge_map->size() * (hash_node_overhead + sizeof(row_t) + sizeof(merge_size));
+    }
+
+    if (sheet.auto_filter)
+        usage.properties += sizeof(auto_filter_t);
+
+    return usage;
+}
+
+std::size_t document_memory_counter::count_cell_strings() const
+{
+    const ixion::model_context& cxt = m_doc.context;
+
+    // Each string is also referenced from the hash map that is used to look
+    // up the ID of an existing string.
+    std::size_t n = 0;
+    for (std::size_t i = 0, count = cxt.get_string_count(); i < count; ++i)
+    {
+        const std::string* s = cxt.get_string(ixion::string_id_t{std::uint32_t(i)});
+        if (!s)
+            continue;
+
+        n += string_bytes(*s) + sizeof(std::string*);
+        n += hash_node_overhead + sizeof(std::string_view) + sizeof(ixion::string_id_t);
+    }
+
+    return n;
+}
+
+std::size_t document_memory_counter::count_shared_strings() const
+{
+    std::size_t n = 0;
+    for (std::size_t i = 0, count = m_doc.context.get_string_count(); i < count; ++i)
+    {
+        const format_runs_t* runs = m_doc.ss_store.get_format_runs(i);
+        if (!runs)
+            continue;
+
+        n += hash_node_overhead + sizeof(std::size_t) + sizeof(std::unique_ptr<format_runs_t>);
+        n += sizeof(format_runs_t) + runs->capacity() * sizeof(format_run_t);
+    }
+
+    return n;
+}
+
+std::size_t document_memory_counter::count_string_pool() const
+{
+    std::size_t n = 0;
+    for (std::string_view s : m_doc.string_pool_store.get_interned_strings())
+        n += s.size() + hash_node_overhead + sizeof(std::string_view);
+
+    return n;
+}
+
+std::size_t document_memory_counter::count_styles() const
+{
+    const styles& st = m_doc.styles_store;
+
+    return st.get_font_count() * sizeof(font_t)
+        + st.get_fill_count() * sizeof(fill_t)
+        + st.get_border_count() * sizeof(border_t)
+        + st.get_protection_count() * sizeof(protection_t)
+        + st.get_number_format_count() * sizeof(number_format_t)
+        + st.get_cell_formats_count() * sizeof(cell_format_t)
+        + st.get_cell_style_formats_count() * sizeof(cell_format_t)
+        + st.get_dxf_count() * sizeof(cell_format_t)
+        + st.get_cell_styles_count() * sizeof(cell_style_t);
+}
+
+std::size_t document_memory_counter::count_pivot_caches() const
+{
+    std::size_t n = 0;
+
+    for (const auto& [id, cache] : m_doc.pivots.mp_impl->caches)
+    {
+        (void)id;
+        n += hash_node_overhead + sizeof(pivot_cache_id_t) + sizeof(cache) + sizeof(pivot_cache);
+
+        for (std::size_t i = 0, count = cache->get_field_count(); i < count; ++i)
+        {
+            const pivot_cache_field_t& field = *cache->get_field(i);
+            n += sizeof(field) + pivot_items_bytes(field.items);
+
+            if (field.group_data)
+            {
+                const pivot_cache_group_data_t& gd = *field.group_data;
+                n += sizeof(gd);
+                n += gd.base_to_group_indices.capacity() * sizeof(std::size_t);
+                n += pivot_items_bytes(gd.items);
+            }
+        }
+
+        const pivot_cache::records_type& records = cache->get_all_records();
+        n += records.capacity() * sizeof(pivot_cache_record_t);
+
+        for (const auto& record : records)
+            n += record.capacity() * sizeof(pivot_cache_record_value_t);
+    }
+
+    return n;
+}
+
+std::size_t document_memory_counter::count_tables() const
+{
+    std::size_t n = 0;
+
+    for (std::size_t i = 0; i < m_doc.sheets.size(); ++i)
+    {
+        for (const auto& [name, p] : m_doc.table_store.get_by_sheet(i))
+        {
+            (void)name;
+            auto tab = p.lock();
+            if (!tab)
+                continue;
+
+            n += sizeof(table_t) + tab->columns.capacity() * sizeof(table_column_t);
+        }
+    }
+
+    return n;
+}
+
+std::size_t document_memory_counter::count_import_session() const
+{
+    return m_doc.dirty_cells.size() * (hash_node_overhead + sizeof(ixion::abs_range_t));
+}
+
+}}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,54 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <orcus/spreadsheet/document_types.hpp>
+
+#include <unordered_set>
+
+namespace ixion {
+
+class formula_tokens_store;
+
+}
+
+namespace orcus { namespace spreadsheet { namespace detail {
+
+struct document_impl;
+struct sheet_impl;
+
+/**
+ * Estimates the amount of memory used by each component of a document from
+ * the numbers of its stored elements and the sizes of their data structures.
+ */
+class document_memory_counter
+{
+    const document_impl& m_doc;
+
+    /** Token stores already counted, as they can be shared between cells. */
+    std::unordered_set<const ixion::formula_tokens_store*> m_token_stores;
+
+public:
+    document_memory_counter(const document_impl& doc);
+
+    document_memory_usage_t count();
+
+private:
+    sheet_memory_usage_t count_sheet(const sheet_impl& sheet, std::size_t& formula_tokens);
+    std::size_t count_cell_strings() const;
+    std::size_t count_shared_strings() const;
+    std::size_t count_string_pool() const;
+    std::size_t count_styles() const;
+    std::size_t count_pivot_caches() const;
+    std::size_t count_tables() const;
+    std::size_t count_import_session() const;
+};
+
+}}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
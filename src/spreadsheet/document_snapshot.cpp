@@ -0,0 +1,1939 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "document_snapshot.hpp"
+#include "document_impl.hpp"
+#include "sheet_impl.hpp"
+#include "pivot_impl.hpp"
+
+#include <orcus/exception.hpp>
+
+#include <ixion/cell.hpp>
+#include <ixion/formula.hpp>
+#include <ixion/formula_result.hpp>
+#include <ixion/matrix.hpp>
+#include <ixion/model_context.hpp>
+#include <ixion/named_expressions_iterator.hpp>
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+
+namespace orcus { namespace spreadsheet { namespace detail {
+
+namespace {
+
+constexpr std::array<char, 8> snapshot_magic = { 'O', 'R', 'C', 'U', 'S', 'N', 'A', 'P' };
+constexpr std::uint32_t snapshot_version = 1;
+constexpr std::uint32_t byte_order_mark = 0x01020304;
+
+/** Type of the cells stored in a run of consecutive cells in a column. */
+enum class cell_block_t : std::uint8_t { numeric, boolean, string, formula };
+
+/** Type of a cached formula result. */
+enum class result_t : std::uint8_t { none, value, string, error };
+
+/** Type of a child of an auto filter node. */
+enum class filter_child_t : std::uint8_t { node, item, item_set };
+
+/** Type of the source data of a pivot cache. */
+enum class pivot_source_t : std::uint8_t { none, worksheet, table };
+
+[[noreturn]] void throw_corrupt()
+{
+    throw general_error("document snapshot is corrupt.");
+}
+
+// Writers for the individual value types.  Note that the strings get
+// interned with the string pool of the document when read back.
+
+template<typename T>
+void write_value(snapshot_output& out, T v)
+{
+    out.write(v);
+}
+
+void write_value(snapshot_output& out, std::string_view s)
+{
+    out.write(s);
+}
+
+void write_value(snapshot_output& out, const color_t& v)
+{
+    out.write(v.alpha);
+    out.write(v.red);
+    out.write(v.green);
+    out.write(v.blue);
+}
+
+void write_value(snapshot_output& out, const length_t& v)
+{
+    out.write(v.unit);
+    out.write(v.value);
+}
+
+void write_value(snapshot_output& out, const date_time_t& v)
+{
+    out.write<std::int32_t>(v.year);
+    out.write<std::int32_t>(v.month);
+    out.write<std::int32_t>(v.day);
+    out.write<std::int32_t>(v.hour);
+    out.write<std::int32_t>(v.minute);
+    out.write(v.second);
+}
+
+void write_value(snapshot_output& out, const ixion::abs_address_t& v)
+{
+    out.write<std::int32_t>(v.sheet);
+    out.write<std::int32_t>(v.row);
+    out.write<std::int32_t>(v.column);
+}
+
+void write_value(snapshot_output& out, const ixion::abs_range_t& v)
+{
+    write_value(out, v.first);
+    write_value(out, v.last);
+}
+
+void write_value(snapshot_output& out, const ixion::abs_rc_range_t& v)
+{
+    out.write<std::int32_t>(v.first.row);
+    out.write<std::int32_t>(v.first.column);
+    out.write<std::int32_t>(v.last.row);
+    out.write<std::int32_t>(v.last.column);
+}
+
+void write_value(snapshot_output& out, const pivot_cache_group_data_t::range_grouping_type& v);
+void read_value(snapshot_input& in, string_pool& pool, pivot_cache_group_data_t::range_grouping_type& v);
+
+template<typename T>
+void write_value(snapshot_output& out, const std::optional<T>& v)
+{
+    out.write(v.has_value());
+    if (v)
+        write_value(out, *v);
+}
+
+template<typename T>
+void read_value(snapshot_input& in, string_pool& /*pool*/, T& v)
+{
+    v = in.read<T>();
+}
+
+void read_value(snapshot_input& in, string_pool& pool, std::string_view& v)
+{
+    v = pool.intern(in.read_string()).first;
+}
+
+void read_value(snapshot_input& in, string_pool& /*pool*/, color_t& v)
+{
+    v.alpha = in.read<color_elem_t>();
+    v.red = in.read<color_elem_t>();
+    v.green = in.read<color_elem_t>();
+    v.blue = in.read<color_elem_t>();
+}
+
+void read_value(snapshot_input& in, string_pool& /*pool*/, length_t& v)
+{
+    v.unit = in.read<length_unit_t>();
+    v.value = in.read<double>();
+}
+
+void read_value(snapshot_input& in, string_pool& /*pool*/, date_time_t& v)
+{
+    v.year = in.read<std::int32_t>();
+    v.month = in.read<std::int32_t>();
+    v.day = in.read<std::int32_t>();
+    v.hour = in.read<std::int32_t>();
+    v.minute = in.read<std::int32_t>();
+    v.second = in.read<double>();
+}
+
+void read_value(snapshot_input& in, string_pool& /*pool*/, ixion::abs_address_t& v)
+{
+    v.sheet = in.read<std::int32_t>();
+    v.row = in.read<std::int32_t>();
+    v.column = in.read<std::int32_t>();
+}
+
+void read_value(snapshot_input& in, string_pool& pool, ixion::abs_range_t& v)
+{
+    read_value(in, pool, v.first);
+    read_value(in, pool, v.last);
+}
+
+void read_value(snapshot_input& in, string_pool& /*pool*/, ixion::abs_rc_range_t& v)
+{
+    v.first.row = in.read<std::int32_t>();
+    v.first.column = in.read<std::int32_t>();
+    v.last.row = in.read<std::int32_t>();
+    v.last.column = in.read<std::int32_t>();
+}
+
+template<typename T>
+void read_value(snapshot_input& in, string_pool& pool, std::optional<T>& v)
+{
+    v.reset();
+
+    if (!in.read<bool>())
+        return;
+
+    T value{};
+    read_value(in, pool, value);
+    v = value;
+}
+
+void write_value(snapshot_output& out, const underline_t& v)
+{
+    write_value(out, v.style);
+    write_value(out, v.thickness);
+    write_value(out, v.spacing);
+    write_value(out, v.count);
+    write_value(out, v.color);
+}
+
+void read_value(snapshot_input& in, string_pool& pool, underline_t& v)
+{
+    read_value(in, pool, v.style);
+    read_value(in, pool, v.thickness);
+    read_value(in, pool, v.spacing);
+    read_value(in, pool, v.count);
+    read_value(in, pool, v.color);
+}
+
+void write_value(snapshot_output& out, const strikethrough_t& v)
+{
+    write_value(out, v.style);
+    write_value(out, v.type);
+    write_value(out, v.width);
+    write_value(out, v.text);
+}
+
+void read_value(snapshot_input& in, string_pool& pool, strikethrough_t& v)
+{
+    read_value(in, pool, v.style);
+    read_value(in, pool, v.type);
+    read_value(in, pool, v.width);
+    read_value(in, pool, v.text);
+}
+
+void write_value(snapshot_output& out, const format_run_t& v)
+{
+    out.write<std::uint64_t>(v.pos);
+    out.write<std::uint64_t>(v.size);
+    write_value(out, v.font);
+    write_value(out, v.font_size);
+    write_value(out, v.color);
+    write_value(out, v.bold);
+    write_value(out, v.italic);
+    write_value(out, v.superscript);
+    write_value(out, v.subscript);
+    write_value(out, v.strikethrough);
+    write_value(out, v.underline);
+}
+
+void read_value(snapshot_input& in, string_pool& pool, format_run_t& v)
+{
+    v.pos = in.read<std::uint64_t>();
+    v.size = in.read<std::uint64_t>();
+    read_value(in, pool, v.font);
+    read_value(in, pool, v.font_size);
+    read_value(in, pool, v.color);
+    read_value(in, pool, v.bold);
+    read_value(in, pool, v.italic);
+    read_value(in, pool, v.superscript);
+    read_value(in, pool, v.subscript);
+    read_value(in, pool, v.strikethrough);
+    read_value(in, pool, v.underline);
+}
+
+void write_value(snapshot_output& out, const font_t& v)
+{
+    write_value(out, v.name);
+    write_value(out, v.name_asian);
+    write_value(out, v.name_complex);
+    write_value(out, v.size);
+    write_value(out, v.size_asian);
+    write_value(out, v.size_complex);
+    write_value(out, v.bold);
+    write_value(out, v.bold_asian);
+    write_value(out, v.bold_complex);
+    write_value(out, v.italic);
+    write_value(out, v.italic_asian);
+    write_value(out, v.italic_complex);
+    write_value(out, v.color);
+    write_value(out, v.underline);
+    write_value(out, v.strikethrough);
+}
+
+void read_value(snapshot_input& in, string_pool& pool, font_t& v)
+{
+    read_value(in, pool, v.name);
+    read_value(in, pool, v.name_asian);
+    read_value(in, pool, v.name_complex);
+    read_value(in, pool, v.size);
+    read_value(in, pool, v.size_asian);
+    read_value(in, pool, v.size_complex);
+    read_value(in, pool, v.bold);
+    read_value(in, pool, v.bold_asian);
+    read_value(in, pool, v.bold_complex);
+    read_value(in, pool, v.italic);
+    read_value(in, pool, v.italic_asian);
+    read_value(in, pool, v.italic_complex);
+    read_value(in, pool, v.color);
+    read_value(in, pool, v.underline);
+    read_value(in, pool, v.strikethrough);
+}
+
+void write_value(snapshot_output& out, const fill_t& v)
+{
+    write_value(out, v.pattern_type);
+    write_value(out, v.fg_color);
+    write_value(out, v.bg_color);
+}
+
+void read_value(snapshot_input& in, string_pool& pool, fill_t& v)
+{
+    read_value(in, pool, v.pattern_type);
+    read_value(in, pool, v.fg_color);
+    read_value(in, pool, v.bg_color);
+}
+
+void write_value(snapshot_output& out, const border_attrs_t& v)
+{
+    write_value(out, v.style);
+    write_value(out, v.border_color);
+    write_value(out, v.border_width);
+}
+
+void read_value(snapshot_input& in, string_pool& pool, border_attrs_t& v)
+{
+    read_value(in, pool, v.style);
+    read_value(in, pool, v.border_color);
+    read_value(in, pool, v.border_width);
+}
+
+void write_value(snapshot_output& out, const border_t& v)
+{
+    for (const border_attrs_t* attrs : { &v.top, &v.bottom, &v.left, &v.right, &v.diagonal, &v.diagonal_bl_tr, &v.diagonal_tl_br })
+        write_value(out, *attrs);
+}
+
+void read_value(snapshot_input& in, string_pool& pool, border_t& v)
+{
+    for (border_attrs_t* attrs : { &v.top, &v.bottom, &v.left, &v.right, &v.diagonal, &v.diagonal_bl_tr, &v.diagonal_tl_br })
+        read_value(in, pool, *attrs);
+}
+
+void write_value(snapshot_output& out, const protection_t& v)
+{
+    write_value(out, v.locked);
+    write_value(out, v.hidden);
+    write_value(out, v.print_content);
+    write_value(out, v.formula_hidden);
+}
+
+void read_value(snapshot_input& in, string_pool& pool, protection_t& v)
+{
+    read_value(in, pool, v.locked);
+    read_value(in, pool, v.hidden);
+    read_value(in, pool, v.print_content);
+    read_value(in, pool, v.formula_hidden);
+}
+
+void write_value(snapshot_output& out, const number_format_t& v)
+{
+    write_value(out, v.identifier);
+    write_value(out, v.format_string);
+}
+
+void read_value(snapshot_input& in, string_pool& pool, number_format_t& v)
+{
+    read_value(in, pool, v.identifier);
+    read_value(in, pool, v.format_string);
+}
+
+void write_value(snapshot_output& out, const cell_format_t& v)
+{
+    out.write<std::uint64_t>(v.font);
+    out.write<std::uint64_t>(v.fill);
+    out.write<std::uint64_t>(v.border);
+    out.write<std::uint64_t>(v.protection);
+    out.write<std::uint64_t>(v.number_format);
+    out.write<std::uint64_t>(v.style_xf);
+    out.write(v.hor_align);
+    out.write(v.ver_align);
+    write_value(out, v.wrap_text);
+    write_value(out, v.shrink_to_fit);
+
+    std::uint8_t flags = 0;
+    flags |= v.apply_num_format ? 0x01 : 0x00;
+    flags |= v.apply_font ? 0x02 : 0x00;
+    flags |= v.apply_fill ? 0x04 : 0x00;
+    flags |= v.apply_border ? 0x08 : 0x00;
+    flags |= v.apply_alignment ? 0x10 : 0x00;
+    flags |= v.apply_protection ? 0x20 : 0x00;
+    out.write(flags);
+}
+
+void read_value(snapshot_input& in, string_pool& pool, cell_format_t& v)
+{
+    v.font = in.read<std::uint64_t>();
+    v.fill = in.read<std::uint64_t>();
+    v.border = in.read<std::uint64_t>();
+    v.protection = in.read<std::uint64_t>();
+    v.number_format = in.read<std::uint64_t>();
+    v.style_xf = in.read<std::uint64_t>();
+    v.hor_align = in.read<hor_alignment_t>();
+    v.ver_align = in.read<ver_alignment_t>();
+    read_value(in, pool, v.wrap_text);
+    read_value(in, pool, v.shrink_to_fit);
+
+    auto flags = in.read<std::uint8_t>();
+    v.apply_num_format = (flags & 0x01) != 0;
+    v.apply_font = (flags & 0x02) != 0;
+    v.apply_fill = (flags & 0x04) != 0;
+    v.apply_border = (flags & 0x08) != 0;
+    v.apply_alignment = (flags & 0x10) != 0;
+    v.apply_protection = (flags & 0x20) != 0;
+}
+
+void write_value(snapshot_output& out, const cell_style_t& v)
+{
+    out.write(v.name);
+    out.write(v.display_name);
+    out.write<std::uint64_t>(v.xf);
+    out.write<std::uint64_t>(v.builtin);
+    out.write(v.parent_name);
+}
+
+void read_value(snapshot_input& in, string_pool& pool, cell_style_t& v)
+{
+    read_value(in, pool, v.name);
+    read_value(in, pool, v.display_name);
+    v.xf = in.read<std::uint64_t>();
+    v.builtin = in.read<std::uint64_t>();
+    read_value(in, pool, v.parent_name);
+}
+
+void write_value(snapshot_output& out, const filter_node_t& node)
+{
+    out.write(node.op());
+    out.write<std::uint64_t>(node.size());
+
+    for (std::size_t i = 0; i < node.size(); ++i)
+    {
+        const filterable* child = node.at(i);
+
+        if (const auto* p = dynamic_cast<const filter_node_t*>(child); p)
+        {
+            out.write(filter_child_t::node);
+            write_value(out, *p);
+        }
+        else if (const auto* p = dynamic_cast<const filter_item_t*>(child); p)
+        {
+            out.write(filter_child_t::item);
+            out.write<std::int32_t>(p->field());
+            out.write(p->op());
+
+            filter_value_t v = p->value();
+            out.write(v.type());
+
+            switch (v.type())
+            {
+                case filter_value_t::value_type::numeric:
+                    out.write(v.numeric());
+                    break;
+                case filter_value_t::value_type::string:
+                    out.write(v.string());
+                    break;
+                case filter_value_t::value_type::empty:
+                    break;
+            }
+
+            out.write(p->regex());
+        }
+        else if (const auto* p = dynamic_cast<const filter_item_set_t*>(child); p)
+        {
+            out.write(filter_child_t::item_set);
+            out.write<std::int32_t>(p->field());
+
+            // sort the values for a stable output.
+            std::vector<std::string_view> values(p->values().begin(), p->values().end());
+            std::sort(values.begin(), values.end());
+
+            out.write<std::uint64_t>(values.size());
+            for (std::string_view v : values)
+                out.write(v);
+        }
+        else
+            throw general_error("unknown auto filter node type in a document snapshot.");
+    }
+}
+
+void read_value(snapshot_input& in, string_pool& pool, filter_node_t& node)
+{
+    node = filter_node_t(in.read<auto_filter_node_op_t>());
+
+    auto n = in.read<std::uint64_t>();
+
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        switch (in.read<filter_child_t>())
+        {
+            case filter_child_t::node:
+            {
+                filter_node_t child;
+                read_value(in, pool, child);
+                node.append(std::move(child));
+                break;
+            }
+            case filter_child_t::item:
+            {
+                auto field = in.read<std::int32_t>();
+                auto op = in.read<auto_filter_op_t>();
+
+                switch (in.read<filter_value_t::value_type>())
+                {
+                    case filter_value_t::value_type::numeric:
+                    {
+                        double v = in.read<double>();
+                        in.read<bool>(); // regex flag
+                        node.append(filter_item_t(field, op, v));
+                        break;
+                    }
+                    case filter_value_t::value_type::string:
+                    {
+                        std::string_view v;
+                        read_value(in, pool, v);
+                        bool regex = in.read<bool>();
+                        node.append(filter_item_t(field, op, v, regex));
+                        break;
+                    }
+                    case filter_value_t::value_type::empty:
+                    {
+                        in.read<bool>(); // regex flag
+                        node.append(filter_item_t(field, op));
+                        break;
+                    }
+                    default:
+                        throw_corrupt();
+                }
+                break;
+            }
+            case filter_child_t::item_set:
+            {
+                filter_item_set_t item(in.read<std::int32_t>());
+                auto n_values = in.read<std::uint64_t>();
+
+                for (std::uint64_t j = 0; j < n_values; ++j)
+                {
+                    std::string_view v;
+                    read_value(in, pool, v);
+                    item.insert(v);
+                }
+
+                node.append(std::move(item));
+                break;
+            }
+            default:
+                throw_corrupt();
+        }
+    }
+}
+
+void write_value(snapshot_output& out, const auto_filter_t& v)
+{
+    write_value(out, v.range);
+    write_value(out, v.root);
+}
+
+void read_value(snapshot_input& in, string_pool& pool, auto_filter_t& v)
+{
+    read_value(in, pool, v.range);
+    read_value(in, pool, v.root);
+}
+
+void write_value(snapshot_output& out, const table_t& v)
+{
+    out.write<std::uint64_t>(v.identifier);
+    out.write(v.name);
+    out.write(v.display_name);
+    write_value(out, v.range);
+    out.write<std::uint64_t>(v.totals_row_count);
+    write_value(out, v.filter);
+
+    out.write<std::uint64_t>(v.columns.size());
+    for (const table_column_t& col : v.columns)
+    {
+        out.write<std::uint64_t>(col.identifier);
+        out.write(col.name);
+        out.write(col.totals_row_label);
+        out.write(col.totals_row_function);
+    }
+
+    out.write(v.style.name);
+    out.write<bool>(v.style.show_first_column);
+    out.write<bool>(v.style.show_last_column);
+    out.write<bool>(v.style.show_row_stripes);
+    out.write<bool>(v.style.show_column_stripes);
+}
+
+void read_value(snapshot_input& in, string_pool& pool, table_t& v)
+{
+    v.identifier = in.read<std::uint64_t>();
+    read_value(in, pool, v.name);
+    read_value(in, pool, v.display_name);
+    read_value(in, pool, v.range);
+    v.totals_row_count = in.read<std::uint64_t>();
+    read_value(in, pool, v.filter);
+
+    auto n = in.read<std::uint64_t>();
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        table_column_t col;
+        col.identifier = in.read<std::uint64_t>();
+        read_value(in, pool, col.name);
+        read_value(in, pool, col.totals_row_label);
+        col.totals_row_function = in.read<totals_row_function_t>();
+        v.columns.push_back(col);
+    }
+
+    read_value(in, pool, v.style.name);
+    v.style.show_first_column = in.read<bool>();
+    v.style.show_last_column = in.read<bool>();
+    v.style.show_row_stripes = in.read<bool>();
+    v.style.show_column_stripes = in.read<bool>();
+}
+
+void write_value(snapshot_output& out, const pivot_cache_item_t& v)
+{
+    out.write(v.type);
+
+    switch (v.type)
+    {
+        case pivot_cache_item_t::item_type::boolean:
+            out.write(std::get<bool>(v.value));
+            break;
+        case pivot_cache_item_t::item_type::date_time:
+            write_value(out, std::get<date_time_t>(v.value));
+            break;
+        case pivot_cache_item_t::item_type::character:
+            out.write(std::get<std::string_view>(v.value));
+            break;
+        case pivot_cache_item_t::item_type::numeric:
+            out.write(std::get<double>(v.value));
+            break;
+        case pivot_cache_item_t::item_type::error:
+            out.write(std::get<error_value_t>(v.value));
+            break;
+        case pivot_cache_item_t::item_type::blank:
+        case pivot_cache_item_t::item_type::unknown:
+            break;
+    }
+}
+
+void read_value(snapshot_input& in, string_pool& pool, pivot_cache_item_t& v)
+{
+    v.type = in.read<pivot_cache_item_t::item_type>();
+
+    switch (v.type)
+    {
+        case pivot_cache_item_t::item_type::boolean:
+            v.value = in.read<bool>();
+            break;
+        case pivot_cache_item_t::item_type::date_time:
+        {
+            date_time_t dt;
+            read_value(in, pool, dt);
+            v.value = dt;
+            break;
+        }
+        case pivot_cache_item_t::item_type::character:
+        {
+            std::string_view s;
+            read_value(in, pool, s);
+            v.value = s;
+            break;
+        }
+        case pivot_cache_item_t::item_type::numeric:
+            v.value = in.read<double>();
+            break;
+        case pivot_cache_item_t::item_type::error:
+            v.value = in.read<error_value_t>();
+            break;
+        case pivot_cache_item_t::item_type::blank:
+        case pivot_cache_item_t::item_type::unknown:
+            break;
+        default:
+            throw_corrupt();
+    }
+}
+
+void write_value(snapshot_output& out, const pivot_cache_items_t& items)
+{
+    out.write<std::uint64_t>(items.size());
+    for (const auto& item : items)
+        write_value(out, item);
+}
+
+void read_value(snapshot_input& in, string_pool& pool, pivot_cache_items_t& items)
+{
+    items.resize(in.read<std::uint64_t>());
+    for (auto& item : items)
+        read_value(in, pool, item);
+}
+
+void write_value(snapshot_output& out, const pivot_cache_group_data_t::range_grouping_type& v)
+{
+    out.write(v.group_by);
+    out.write(v.auto_start);
+    out.write(v.auto_end);
+    out.write(v.start);
+    out.write(v.end);
+    out.write(v.interval);
+    write_value(out, v.start_date);
+    write_value(out, v.end_date);
+}
+
+void read_value(snapshot_input& in, string_pool& pool, pivot_cache_group_data_t::range_grouping_type& v)
+{
+    v.group_by = in.read<pivot_cache_group_by_t>();
+    v.auto_start = in.read<bool>();
+    v.auto_end = in.read<bool>();
+    v.start = in.read<double>();
+    v.end = in.read<double>();
+    v.interval = in.read<double>();
+    read_value(in, pool, v.start_date);
+    read_value(in, pool, v.end_date);
+}
+
+void write_value(snapshot_output& out, const pivot_cache_field_t& v)
+{
+    out.write(v.name);
+    write_value(out, v.items);
+    write_value(out, v.min_value);
+    write_value(out, v.max_value);
+    write_value(out, v.min_date);
+    write_value(out, v.max_date);
+
+    out.write(bool(v.group_data));
+    if (!v.group_data)
+        return;
+
+    const pivot_cache_group_data_t& gd = *v.group_data;
+    out.write<std::uint64_t>(gd.base_field);
+
+    std::vector<std::uint64_t> indices(gd.base_to_group_indices.begin(), gd.base_to_group_indices.end());
+    out.write_array(indices);
+
+    write_value(out, gd.range_grouping);
+    write_value(out, gd.items);
+}
+
+void read_value(snapshot_input& in, string_pool& pool, pivot_cache_field_t& v)
+{
+    read_value(in, pool, v.name);
+    read_value(in, pool, v.items);
+    read_value(in, pool, v.min_value);
+    read_value(in, pool, v.max_value);
+    read_value(in, pool, v.min_date);
+    read_value(in, pool, v.max_date);
+
+    v.group_data.reset();
+    if (!in.read<bool>())
+        return;
+
+    auto gd = std::make_unique<pivot_cache_group_data_t>(in.read<std::uint64_t>());
+
+    std::vector<std::uint64_t> scratch;
+    auto indices = in.read_array(scratch);
+    gd->base_to_group_indices.assign(indices.begin(), indices.end());
+
+    read_value(in, pool, gd->range_grouping);
+    read_value(in, pool, gd->items);
+
+    v.group_data = std::move(gd);
+}
+
+void write_value(snapshot_output& out, const pivot_cache_record_value_t& v)
+{
+    out.write(v.type);
+
+    switch (v.type)
+    {
+        case pivot_cache_record_value_t::record_type::boolean:
+            out.write(std::get<bool>(v.value));
+            break;
+        case pivot_cache_record_value_t::record_type::date_time:
+            write_value(out, std::get<date_time_t>(v.value));
+            break;
+        case pivot_cache_record_value_t::record_type::character:
+            out.write(std::get<std::string_view>(v.value));
+            break;
+        case pivot_cache_record_value_t::record_type::numeric:
+            out.write(std::get<double>(v.value));
+            break;
+        case pivot_cache_record_value_t::record_type::error:
+            out.write(std::get<error_value_t>(v.value));
+            break;
+        case pivot_cache_record_value_t::record_type::shared_item_index:
+            out.write<std::uint64_t>(std::get<std::size_t>(v.value));
+            break;
+        case pivot_cache_record_value_t::record_type::blank:
+        case pivot_cache_record_value_t::record_type::unknown:
+            break;
+    }
+}
+
+void read_value(snapshot_input& in, string_pool& pool, pivot_cache_record_value_t& v)
+{
+    v.type = in.read<pivot_cache_record_value_t::record_type>();
+
+    switch (v.type)
+    {
+        case pivot_cache_record_value_t::record_type::boolean:
+            v.value = in.read<bool>();
+            break;
+        case pivot_cache_record_value_t::record_type::date_time:
+        {
+            date_time_t dt;
+            read_value(in, pool, dt);
+            v.value = dt;
+            break;
+        }
+        case pivot_cache_record_value_t::record_type::character:
+        {
+            std::string_view s;
+            read_value(in, pool, s);
+            v.value = s;
+            break;
+        }
+        case pivot_cache_record_value_t::record_type::numeric:
+            v.value = in.read<double>();
+            break;
+        case pivot_cache_record_value_t::record_type::error:
+            v.value = in.read<error_value_t>();
+            break;
+        case pivot_cache_record_value_t::record_type::shared_item_index:
+            v.value = std::size_t(in.read<std::uint64_t>());
+            break;
+        case pivot_cache_record_value_t::record_type::blank:
+        case pivot_cache_record_value_t::record_type::unknown:
+            break;
+        default:
+            throw_corrupt();
+    }
+}
+
+/**
+ * Write the segments of a flat segment tree as three parallel arrays of
+ * start positions, end positions and values.
+ */
+template<typename TreeT>
+void write_segments(snapshot_output& out, const TreeT& tree)
+{
+    using key_type = typename TreeT::key_type;
+    using value_type = typename TreeT::value_type;
+    using stored_type = std::conditional_t<std::is_same_v<value_type, bool>, std::uint8_t, value_type>;
+
+    std::vector<key_type> starts;
+    std::vector<key_type> ends;
+    std::vector<stored_type> values;
+
+    for (const auto& seg : tree.segment_range())
+    {
+        starts.push_back(seg.start);
+        ends.push_back(seg.end);
+        values.push_back(seg.value);
+    }
+
+    out.write_array(starts);
+    out.write_array(ends);
+    out.write_array(values);
+}
+
+template<typename TreeT>
+void read_segments(snapshot_input& in, TreeT& tree)
+{
+    using key_type = typename TreeT::key_type;
+    using value_type = typename TreeT::value_type;
+    using stored_type = std::conditional_t<std::is_same_v<value_type, bool>, std::uint8_t, value_type>;
+
+    std::vector<key_type> starts_buf;
+    std::vector<key_type> ends_buf;
+    std::vector<stored_type> values_buf;
+
+    auto starts = in.read_array(starts_buf);
+    auto ends = in.read_array(ends_buf);
+    auto values = in.read_array(values_buf);
+
+    if (starts.size() != ends.size() || starts.size() != values.size())
+        throw_corrupt();
+
+    for (std::size_t i = 0; i < starts.size(); ++i)
+    {
+        if (starts[i] >= ends[i] || starts[i] < tree.min_key() || tree.max_key() < ends[i])
+            throw_corrupt();
+
+        tree.insert_back(starts[i], ends[i], static_cast<value_type>(values[i]));
+    }
+}
+
+void write_formula_result(snapshot_output& out, const ixion::formula_cell* fc)
+{
+    if (!fc)
+    {
+        out.write(result_t::none);
+        return;
+    }
+
+    ixion::formula_result res;
+
+    try
+    {
+        res = fc->get_result_cache(ixion::formula_result_wait_policy_t::throw_exception);
+    }
+    catch (const std::exception&)
+    {
+        out.write(result_t::none);
+        return;
+    }
+
+    switch (res.get_type())
+    {
+        case ixion::formula_result::result_type::value:
+            out.write(result_t::value);
+            out.write(res.get_value());
+            break;
+        case ixion::formula_result::result_type::string:
+            out.write(result_t::string);
+            out.write(std::string_view{res.get_string()});
+            break;
+        case ixion::formula_result::result_type::error:
+            out.write(result_t::error);
+            out.write(res.get_error());
+            break;
+        default:
+            out.write(result_t::none);
+    }
+}
+
+std::optional<ixion::formula_result> read_formula_result(snapshot_input& in)
+{
+    switch (in.read<result_t>())
+    {
+        case result_t::none:
+            return std::nullopt;
+        case result_t::value:
+            return ixion::formula_result(in.read<double>());
+        case result_t::string:
+            return ixion::formula_result(std::string{in.read_string()});
+        case result_t::error:
+            return ixion::formula_result(in.read<ixion::formula_error_t>());
+    }
+
+    throw_corrupt();
+}
+
+/** Formula expression shared by one or more formula cells. */
+struct formula_store_entry
+{
+    ixion::abs_address_t origin;
+    std::string expression;
+};
+
+} // anonymous namespace
+
+snapshot_output::snapshot_output(std::ostream& os) : m_os(os) {}
+
+void snapshot_output::write(std::string_view s)
+{
+    write<std::uint32_t>(s.size());
+    write_bytes(s.data(), s.size());
+}
+
+void snapshot_output::write_bytes(const void* p, std::size_t n)
+{
+    m_os.write(static_cast<const char*>(p), n);
+    m_pos += n;
+}
+
+void snapshot_output::align()
+{
+    constexpr std::array<char, 8> padding{};
+    std::size_t n = (8 - m_pos % 8) % 8;
+    write_bytes(padding.data(), n);
+}
+
+snapshot_input::snapshot_input(std::string_view content) : m_content(content) {}
+
+std::string_view snapshot_input::read_string()
+{
+    auto n = read<std::uint32_t>();
+    return { read_bytes(n), n };
+}
+
+bool snapshot_input::at_end() const
+{
+    return m_pos == m_content.size();
+}
+
+const char* snapshot_input::read_bytes(std::size_t n)
+{
+    if (n > m_content.size() - m_pos)
+        throw_truncated();
+
+    const char* p = m_content.data() + m_pos;
+    m_pos += n;
+    return p;
+}
+
+void snapshot_input::align()
+{
+    std::size_t n = (8 - m_pos % 8) % 8;
+    read_bytes(n);
+}
+
+void snapshot_input::throw_truncated() const
+{
+    throw general_error("document snapshot is truncated.");
+}
+
+document_snapshot_writer::document_snapshot_writer(const document_impl& doc, snapshot_output& out) :
+    m_doc(doc), m_out(out),
+    m_resolver(ixion::formula_name_resolver::get(ixion::formula_name_resolver_t::excel_a1, &doc.context))
+{
+}
+
+void document_snapshot_writer::write()
+{
+    const range_size_t ss = m_doc.doc.get_sheet_size();
+
+    m_out.write(snapshot_magic);
+    m_out.write(snapshot_version);
+    m_out.write(byte_order_mark);
+    m_out.write<std::uint8_t>(sizeof(std::size_t));
+    m_out.write<std::int32_t>(ss.rows);
+    m_out.write<std::int32_t>(ss.columns);
+
+    m_out.write<std::int32_t>(m_doc.origin_date.year);
+    m_out.write<std::int32_t>(m_doc.origin_date.month);
+    m_out.write<std::int32_t>(m_doc.origin_date.day);
+    m_out.write(m_doc.grammar);
+
+    write_strings();
+    write_styles();
+
+    // Sheets get created before anything that may reference them.
+    m_out.write<std::uint64_t>(m_doc.sheets.size());
+    for (const auto& sh : m_doc.sheets)
+        m_out.write(sh->name);
+
+    write_named_expressions();
+    write_tables();
+
+    for (const auto& sh : m_doc.sheets)
+        write_sheet(*sh->data.mp_impl);
+
+    write_pivot_caches();
+}
+
+std::string document_snapshot_writer::print_formula(
+    const ixion::abs_address_t& pos, const ixion::formula_tokens_t& tokens) const
+{
+    return ixion::print_formula_tokens(m_doc.context, pos, *m_resolver, tokens);
+}
+
+void document_snapshot_writer::write_strings()
+{
+    const ixion::model_context& cxt = m_doc.context;
+    const std::size_t n = cxt.get_string_count();
+
+    // String pool as one block of characters and an array of end offsets.
+    std::vector<std::uint64_t> ends;
+    ends.reserve(n);
+    std::string block;
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const std::string* p = cxt.get_string(ixion::string_id_t{static_cast<ixion::string_id_t::value_type>(i)});
+        if (p)
+            block.append(*p);
+
+        ends.push_back(block.size());
+    }
+
+    m_out.write_array(ends);
+    m_out.write_array(block.data(), block.size());
+
+    // format runs of the rich-text strings
+    std::vector<std::size_t> formatted;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (m_doc.ss_store.get_format_runs(i))
+            formatted.push_back(i);
+    }
+
+    m_out.write<std::uint64_t>(formatted.size());
+    for (std::size_t i : formatted)
+    {
+        const format_runs_t* runs = m_doc.ss_store.get_format_runs(i);
+        m_out.write<std::uint64_t>(i);
+        m_out.write<std::uint64_t>(runs->size());
+
+        for (const auto& run : *runs)
+            write_value(m_out, run);
+    }
+}
+
+void document_snapshot_writer::write_styles()
+{
+    const styles& st = m_doc.styles_store;
+
+    m_out.write<std::uint64_t>(st.get_font_count());
+    for (std::size_t i = 0; i < st.get_font_count(); ++i)
+        write_value(m_out, *st.get_font(i));
+
+    m_out.write<std::uint64_t>(st.get_fill_count());
+    for (std::size_t i = 0; i < st.get_fill_count(); ++i)
+        write_value(m_out, *st.get_fill(i));
+
+    m_out.write<std::uint64_t>(st.get_border_count());
+    for (std::size_t i = 0; i < st.get_border_count(); ++i)
+        write_value(m_out, *st.get_border(i));
+
+    m_out.write<std::uint64_t>(st.get_protection_count());
+    for (std::size_t i = 0; i < st.get_protection_count(); ++i)
+        write_value(m_out, *st.get_protection(i));
+
+    m_out.write<std::uint64_t>(st.get_number_format_count());
+    for (std::size_t i = 0; i < st.get_number_format_count(); ++i)
+        write_value(m_out, *st.get_number_format(i));
+
+    m_out.write<std::uint64_t>(st.get_cell_formats_count());
+    for (std::size_t i = 0; i < st.get_cell_formats_count(); ++i)
+        write_value(m_out, *st.get_cell_format(i));
+
+    m_out.write<std::uint64_t>(st.get_cell_style_formats_count());
+    for (std::size_t i = 0; i < st.get_cell_style_formats_count(); ++i)
+        write_value(m_out, *st.get_cell_style_format(i));
+
+    m_out.write<std::uint64_t>(st.get_dxf_count());
+    for (std::size_t i = 0; i < st.get_dxf_count(); ++i)
+        write_value(m_out, *st.get_dxf_format(i));
+
+    m_out.write<std::uint64_t>(st.get_cell_styles_count());
+    for (std::size_t i = 0; i < st.get_cell_styles_count(); ++i)
+        write_value(m_out, *st.get_cell_style(i));
+}
+
+void document_snapshot_writer::write_named_expressions()
+{
+    auto write_names = [this](ixion::named_expressions_iterator iter)
+    {
+        std::vector<decltype(iter.get())> names;
+        for (; iter.has(); iter.next())
+            names.push_back(iter.get());
+
+        m_out.write<std::uint64_t>(names.size());
+
+        for (const auto& name : names)
+        {
+            m_out.write(std::string_view{*name.name});
+            write_value(m_out, name.expression->origin);
+            m_out.write(std::string_view{print_formula(name.expression->origin, name.expression->tokens)});
+        }
+    };
+
+    const ixion::model_context& cxt = m_doc.context;
+    write_names(cxt.get_named_expressions_iterator());
+
+    for (std::size_t i = 0; i < m_doc.sheets.size(); ++i)
+        write_names(cxt.get_named_expressions_iterator(i));
+}
+
+void document_snapshot_writer::write_tables()
+{
+    std::vector<std::shared_ptr<const table_t>> all_tables;
+
+    for (std::size_t i = 0; i < m_doc.sheets.size(); ++i)
+    {
+        for (const auto& [name, p] : m_doc.table_store.get_by_sheet(i))
+        {
+            if (auto tab = p.lock(); tab)
+                all_tables.push_back(std::move(tab));
+        }
+    }
+
+    m_out.write<std::uint64_t>(all_tables.size());
+    for (const auto& tab : all_tables)
+        write_value(m_out, *tab);
+}
+
+void document_snapshot_writer::write_sheet(const sheet_impl& sheet)
+{
+    write_cells(sheet);
+
+    std::vector<col_t> columns;
+    for (const auto& node : sheet.cell_formats)
+        columns.push_back(node.first);
+
+    std::sort(columns.begin(), columns.end());
+
+    m_out.write<std::uint64_t>(columns.size());
+    for (col_t col : columns)
+    {
+        m_out.write<std::int32_t>(col);
+        write_segments(m_out, *sheet.cell_formats.find(col)->second);
+    }
+
+    write_segments(m_out, sheet.column_formats);
+    write_segments(m_out, sheet.row_formats);
+    write_segments(m_out, sheet.col_widths);
+    write_segments(m_out, sheet.row_heights);
+    write_segments(m_out, sheet.col_hidden);
+    write_segments(m_out, sheet.row_hidden);
+
+    // merged cell ranges as quadruplets of column, row, width and height.
+    std::vector<std::int32_t> merges;
+
+    for (const auto& [col, rows] : sheet.merge_ranges)
+    {
+        for (const auto& [row, size] : *rows)
+        {
+            merges.push_back(col);
+            merges.push_back(row);
+            merges.push_back(size.width);
+            merges.push_back(size.height);
+        }
+    }
+
+    m_out.write_array(merges);
+
+    m_out.write(bool(sheet.auto_filter));
+    if (sheet.auto_filter)
+        write_value(m_out, *sheet.auto_filter);
+}
+
+void document_snapshot_writer::write_cells(const sheet_impl& sheet)
+{
+    const ixion::model_context& cxt = m_doc.context;
+
+    // Runs of consecutive cells of the same type in each column, stored as
+    // quadruplets of column, first row, cell count and cell block type.
+    std::vector<std::uint32_t> runs;
+
+    std::vector<double> numbers;
+    std::vector<std::uint8_t> bools;
+    std::vector<std::uint32_t> strings;
+    std::vector<std::uint32_t> formulas; // index into the formula store entries
+
+    std::vector<formula_store_entry> formula_stores;
+    std::unordered_map<const ixion::formula_tokens_store*, std::uint32_t> formula_store_map;
+
+    std::ostringstream results_buf;
+    snapshot_output results{results_buf};
+
+    std::ostringstream grouped_buf;
+    snapshot_output grouped{grouped_buf};
+    std::uint64_t grouped_count = 0;
+
+    auto push_cell = [&runs](col_t col, row_t row, cell_block_t type)
+    {
+        const std::size_t n = runs.size();
+
+        if (n && runs[n-4] == std::uint32_t(col) && runs[n-1] == std::uint32_t(type)
+            && runs[n-3] + runs[n-2] == std::uint32_t(row))
+        {
+            ++runs[n-2];
+            return;
+        }
+
+        runs.push_back(col);
+        runs.push_back(row);
+        runs.push_back(1);
+        runs.push_back(std::uint32_t(type));
+    };
+
+    ixion::abs_range_t data_range = cxt.get_data_range(sheet.sheet_id);
+
+    if (data_range.valid())
+    {
+        ixion::abs_rc_range_t iter_range;
+        iter_range.first.column = 0;
+        iter_range.first.row = 0;
+        iter_range.last.column = data_range.last.column;
+        iter_range.last.row = data_range.last.row;
+
+        for (const auto& cell : cxt.iterate_cells(sheet.sheet_id, ixion::rc_direction_t::vertical, iter_range))
+        {
+            switch (cell.type)
+            {
+                case ixion::cell_t::numeric:
+                    push_cell(cell.col, cell.row, cell_block_t::numeric);
+                    numbers.push_back(std::get<double>(cell.value));
+                    break;
+                case ixion::cell_t::boolean:
+                    push_cell(cell.col, cell.row, cell_block_t::boolean);
+                    bools.push_back(std::get<bool>(cell.value));
+                    break;
+                case ixion::cell_t::string:
+                {
+                    ixion::abs_address_t pos(sheet.sheet_id, cell.row, cell.col);
+                    push_cell(cell.col, cell.row, cell_block_t::string);
+                    strings.push_back(cxt.get_string_identifier(pos).value);
+                    break;
+                }
+                case ixion::cell_t::formula:
+                {
+                    const ixion::formula_cell* fc = std::get<const ixion::formula_cell*>(cell.value);
+                    const ixion::formula_tokens_store_ptr_t& ts = fc->get_tokens();
+                    if (!ts)
+                        break;
+
+                    ixion::abs_address_t pos(sheet.sheet_id, cell.row, cell.col);
+                    ixion::formula_group_t group = fc->get_group_properties();
+
+                    if (group.grouped)
+                    {
+                        // Grouped formula is stored once for the whole
+                        // range, together with the results of all its
+                        // member cells.
+                        if (fc->get_parent_position(pos) != pos)
+                            break;
+
+                        ixion::abs_range_t range(pos, group.size.row, group.size.column);
+                        write_value(grouped, range);
+                        grouped.write(std::string_view{print_formula(pos, ts->get())});
+
+                        for (ixion::row_t r = range.first.row; r <= range.last.row; ++r)
+                        {
+                            for (ixion::col_t c = range.first.column; c <= range.last.column; ++c)
+                                write_formula_result(grouped, cxt.get_formula_cell(ixion::abs_address_t(sheet.sheet_id, r, c)));
+                        }
+
+                        ++grouped_count;
+                        break;
+                    }
+
+                    // Cells sharing the same token store keep sharing it
+                    // when loaded back.
+                    auto it = formula_store_map.find(ts.get());
+                    if (it == formula_store_map.end())
+                    {
+                        formula_stores.push_back({pos, print_formula(pos, ts->get())});
+                        it = formula_store_map.emplace(ts.get(), formula_stores.size() - 1).first;
+                    }
+
+                    push_cell(cell.col, cell.row, cell_block_t::formula);
+                    formulas.push_back(it->second);
+                    write_formula_result(results, fc);
+                    break;
+                }
+                default:
+                    ;
+            }
+        }
+    }
+
+    m_out.write<std::uint64_t>(formula_stores.size());
+    for (const auto& entry : formula_stores)
+    {
+        write_value(m_out, entry.origin);
+        m_out.write(std::string_view{entry.expression});
+    }
+
+    m_out.write_array(runs);
+    m_out.write_array(numbers);
+    m_out.write_array(bools);
+    m_out.write_array(strings);
+    m_out.write_array(formulas);
+
+    std::string buf = results_buf.str();
+    m_out.write_array(buf.data(), buf.size());
+
+    m_out.write(grouped_count);
+    buf = grouped_buf.str();
+    m_out.write_array(buf.data(), buf.size());
+}
+
+void document_snapshot_writer::write_pivot_caches()
+{
+    const pivot_collection::impl& pc = *m_doc.pivots.mp_impl;
+
+    std::unordered_map<pivot_cache_id_t, const worksheet_range*> range_sources;
+    for (const auto& [src, ids] : pc.worksheet_range_map)
+    {
+        for (pivot_cache_id_t id : ids)
+            range_sources.insert_or_assign(id, &src);
+    }
+
+    std::unordered_map<pivot_cache_id_t, std::string_view> table_sources;
+    for (const auto& [name, ids] : pc.table_map)
+    {
+        for (pivot_cache_id_t id : ids)
+            table_sources.insert_or_assign(id, name);
+    }
+
+    std::map<pivot_cache_id_t, const pivot_cache*> caches;
+    for (const auto& [id, cache] : pc.caches)
+        caches.emplace(id, cache.get());
+
+    m_out.write<std::uint64_t>(caches.size());
+
+    for (const auto& [id, cache] : caches)
+    {
+        m_out.write(id);
+
+        if (auto it = range_sources.find(id); it != range_sources.end())
+        {
+            m_out.write(pivot_source_t::worksheet);
+            m_out.write(it->second->sheet);
+            write_value(m_out, it->second->range);
+        }
+        else if (auto it = table_sources.find(id); it != table_sources.end())
+        {
+            m_out.write(pivot_source_t::table);
+            m_out.write(it->second);
+        }
+        else
+            m_out.write(pivot_source_t::none);
+
+        m_out.write<std::uint64_t>(cache->get_field_count());
+        for (std::size_t i = 0; i < cache->get_field_count(); ++i)
+            write_value(m_out, *cache->get_field(i));
+
+        const pivot_cache::records_type& records = cache->get_all_records();
+        m_out.write<std::uint64_t>(records.size());
+
+        for (const pivot_cache_record_t& record : records)
+        {
+            m_out.write<std::uint64_t>(record.size());
+            for (const auto& v : record)
+                write_value(m_out, v);
+        }
+    }
+}
+
+document_snapshot_reader::document_snapshot_reader(document_impl& doc, snapshot_input& in) :
+    m_doc(doc), m_in(in),
+    m_resolver(ixion::formula_name_resolver::get(ixion::formula_name_resolver_t::excel_a1, &doc.context))
+{
+}
+
+range_size_t document_snapshot_reader::read_header(snapshot_input& in)
+{
+    if (in.read<std::array<char, 8>>() != snapshot_magic)
+        throw general_error("stream is not a document snapshot.");
+
+    if (in.read<std::uint32_t>() != snapshot_version)
+        throw general_error("unsupported document snapshot version.");
+
+    if (in.read<std::uint32_t>() != byte_order_mark || in.read<std::uint8_t>() != sizeof(std::size_t))
+        throw general_error("document snapshot was saved on an incompatible platform.");
+
+    range_size_t ss;
+    ss.rows = in.read<std::int32_t>();
+    ss.columns = in.read<std::int32_t>();
+
+    if (ss.rows <= 0 || ss.columns <= 0)
+        throw_corrupt();
+
+    return ss;
+}
+
+void document_snapshot_reader::read()
+{
+    int year = m_in.read<std::int32_t>();
+    int month = m_in.read<std::int32_t>();
+    int day = m_in.read<std::int32_t>();
+    m_doc.doc.set_origin_date(year, month, day);
+    m_doc.doc.set_formula_grammar(m_in.read<formula_grammar_t>());
+
+    read_strings();
+    read_styles();
+
+    auto n_sheets = m_in.read<std::uint64_t>();
+    for (std::uint64_t i = 0; i < n_sheets; ++i)
+        m_doc.doc.append_sheet(m_in.read_string());
+
+    read_named_expressions();
+    read_tables();
+
+    for (auto& sh : m_doc.sheets)
+        read_sheet(*sh->data.mp_impl);
+
+    read_pivot_caches();
+
+    if (!m_in.at_end())
+        throw_corrupt();
+}
+
+std::string_view document_snapshot_reader::read_interned_string()
+{
+    return m_doc.string_pool_store.intern(m_in.read_string()).first;
+}
+
+ixion::formula_tokens_t document_snapshot_reader::parse_formula(
+    const ixion::abs_address_t& pos, std::string_view expression)
+{
+    ixion::model_context& cxt = m_doc.context;
+
+    try
+    {
+        return ixion::parse_formula_string(cxt, pos, *m_resolver, expression);
+    }
+    catch (const std::exception& e)
+    {
+        // The formula was originally imported as an invalid formula.
+        return ixion::create_formula_error_tokens(cxt, expression, e.what());
+    }
+}
+
+void document_snapshot_reader::read_strings()
+{
+    ixion::model_context& cxt = m_doc.context;
+
+    std::vector<std::uint64_t> ends_buf;
+    std::vector<char> block_buf;
+    auto ends = m_in.read_array(ends_buf);
+    auto block = m_in.read_array(block_buf);
+
+    m_string_ids.clear();
+    m_string_ids.reserve(ends.size());
+
+    std::uint64_t start = 0;
+    for (std::uint64_t end : ends)
+    {
+        if (end < start || block.size() < end)
+            throw_corrupt();
+
+        std::string_view s{block.data() + start, end - start};
+        m_string_ids.push_back(cxt.append_string(s));
+        start = end;
+    }
+
+    auto n = m_in.read<std::uint64_t>();
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        auto index = m_in.read<std::uint64_t>();
+        if (index >= m_string_ids.size())
+            throw_corrupt();
+
+        auto runs = std::make_unique<format_runs_t>(m_in.read<std::uint64_t>());
+        for (auto& run : *runs)
+            read_value(m_in, m_doc.string_pool_store, run);
+
+        m_doc.ss_store.set_format_runs(m_string_ids[index].value, std::move(runs));
+    }
+}
+
+void document_snapshot_reader::read_styles()
+{
+    styles& st = m_doc.styles_store;
+    string_pool& pool = m_doc.string_pool_store;
+
+    auto n = m_in.read<std::uint64_t>();
+    st.reserve_font_store(n);
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        font_t v;
+        read_value(m_in, pool, v);
+        st.append_font(v);
+    }
+
+    n = m_in.read<std::uint64_t>();
+    st.reserve_fill_store(n);
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        fill_t v;
+        read_value(m_in, pool, v);
+        st.append_fill(v);
+    }
+
+    n = m_in.read<std::uint64_t>();
+    st.reserve_border_store(n);
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        border_t v;
+        read_value(m_in, pool, v);
+        st.append_border(v);
+    }
+
+    n = m_in.read<std::uint64_t>();
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        protection_t v;
+        read_value(m_in, pool, v);
+        st.append_protection(v);
+    }
+
+    n = m_in.read<std::uint64_t>();
+    st.reserve_number_format_store(n);
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        number_format_t v;
+        read_value(m_in, pool, v);
+        st.append_number_format(v);
+    }
+
+    n = m_in.read<std::uint64_t>();
+    st.reserve_cell_format_store(n);
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        cell_format_t v;
+        read_value(m_in, pool, v);
+        st.append_cell_format(v);
+    }
+
+    n = m_in.read<std::uint64_t>();
+    st.reserve_cell_style_format_store(n);
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        cell_format_t v;
+        read_value(m_in, pool, v);
+        st.append_cell_style_format(v);
+    }
+
+    n = m_in.read<std::uint64_t>();
+    st.reserve_diff_cell_format_store(n);
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        cell_format_t v;
+        read_value(m_in, pool, v);
+        st.append_diff_cell_format(v);
+    }
+
+    n = m_in.read<std::uint64_t>();
+    st.reserve_cell_style_store(n);
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        cell_style_t v;
+        read_value(m_in, pool, v);
+        st.append_cell_style(v);
+    }
+}
+
+void document_snapshot_reader::read_named_expressions()
+{
+    ixion::model_context& cxt = m_doc.context;
+
+    // global names first, followed by the sheet-local names of each sheet.
+    for (std::size_t i = 0; i <= m_doc.sheets.size(); ++i)
+    {
+        auto n = m_in.read<std::uint64_t>();
+
+        for (std::uint64_t j = 0; j < n; ++j)
+        {
+            std::string name{m_in.read_string()};
+            ixion::abs_address_t origin;
+            read_value(m_in, m_doc.string_pool_store, origin);
+            ixion::formula_tokens_t tokens = parse_formula(origin, m_in.read_string());
+
+            if (i == 0)
+                cxt.set_named_expression(std::move(name), origin, std::move(tokens));
+            else
+                cxt.set_named_expression(i - 1, std::move(name), origin, std::move(tokens));
+        }
+    }
+}
+
+void document_snapshot_reader::read_tables()
+{
+    auto n = m_in.read<std::uint64_t>();
+
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        auto tab = std::make_unique<table_t>();
+        read_value(m_in, m_doc.string_pool_store, *tab);
+        m_doc.table_store.insert(std::move(tab));
+    }
+}
+
+void document_snapshot_reader::read_sheet(sheet_impl& sheet)
+{
+    read_cells(sheet);
+
+    const range_size_t ss = m_doc.doc.get_sheet_size();
+
+    auto n = m_in.read<std::uint64_t>();
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        auto col = m_in.read<std::int32_t>();
+        auto tree = std::make_unique<segment_row_index_type>(0, ss.rows, 0);
+        read_segments(m_in, *tree);
+        sheet.cell_formats.insert_or_assign(col, std::move(tree));
+    }
+
+    read_segments(m_in, sheet.column_formats);
+    read_segments(m_in, sheet.row_formats);
+    read_segments(m_in, sheet.col_widths);
+    read_segments(m_in, sheet.row_heights);
+    read_segments(m_in, sheet.col_hidden);
+    read_segments(m_in, sheet.row_hidden);
+
+    sheet.col_width_pos = sheet.col_widths.begin();
+    sheet.row_height_pos = sheet.row_heights.begin();
+    sheet.col_hidden_pos = sheet.col_hidden.begin();
+    sheet.row_hidden_pos = sheet.row_hidden.begin();
+
+    std::vector<std::int32_t> merges_buf;
+    auto merges = m_in.read_array(merges_buf);
+    if (merges.size() % 4)
+        throw_corrupt();
+
+    spreadsheet::sheet& sh = *m_doc.doc.get_sheet(sheet.sheet_id);
+
+    for (std::size_t i = 0; i < merges.size(); i += 4)
+    {
+        range_t range;
+        range.first.column = merges[i];
+        range.first.row = merges[i+1];
+        range.last.column = merges[i] + merges[i+2] - 1;
+        range.last.row = merges[i+1] + merges[i+3] - 1;
+        sh.set_merge_cell_range(range);
+    }
+
+    if (m_in.read<bool>())
+    {
+        auto filter = std::make_unique<auto_filter_t>();
+        read_value(m_in, m_doc.string_pool_store, *filter);
+        sheet.auto_filter = std::move(filter);
+    }
+}
+
+void document_snapshot_reader::read_cells(sheet_impl& sheet)
+{
+    spreadsheet::sheet& sh = *m_doc.doc.get_sheet(sheet.sheet_id);
+    const range_size_t ss = m_doc.doc.get_sheet_size();
+
+    std::vector<ixion::formula_tokens_store_ptr_t> formula_stores(m_in.read<std::uint64_t>());
+    for (auto& ts : formula_stores)
+    {
+        ixion::abs_address_t origin;
+        read_value(m_in, m_doc.string_pool_store, origin);
+
+        ts = ixion::formula_tokens_store::create();
+        ts->get() = parse_formula(origin, m_in.read_string());
+    }
+
+    std::vector<std::uint32_t> runs_buf;
+    std::vector<double> numbers_buf;
+    std::vector<std::uint8_t> bools_buf;
+    std::vector<std::uint32_t> strings_buf;
+    std::vector<std::uint32_t> formulas_buf;
+    std::vector<char> results_buf;
+
+    auto runs = m_in.read_array(runs_buf);
+    auto numbers = m_in.read_array(numbers_buf);
+    auto bools = m_in.read_array(bools_buf);
+    auto strings = m_in.read_array(strings_buf);
+    auto formulas = m_in.read_array(formulas_buf);
+    auto results_block = m_in.read_array(results_buf);
+
+    if (runs.size() % 4)
+        throw_corrupt();
+
+    auto numbers_it = numbers.begin();
+    auto bools_it = bools.begin();
+    auto strings_it = strings.begin();
+    auto formulas_it = formulas.begin();
+    snapshot_input results{{results_block.data(), results_block.size()}};
+
+    auto check_remaining = [](auto it, auto end, std::uint32_t n)
+    {
+        if (std::uint32_t(std::distance(it, end)) < n)
+            throw_corrupt();
+    };
+
+    for (std::size_t i = 0; i < runs.size(); i += 4)
+    {
+        const col_t col = runs[i];
+        const row_t row_start = runs[i+1];
+        const std::uint32_t size = runs[i+2];
+
+        if (col < 0 || ss.columns <= col || row_start < 0 || ss.rows < row_start || std::uint32_t(ss.rows - row_start) < size)
+            throw_corrupt();
+
+        const row_t row_end = row_start + row_t(size);
+
+        switch (cell_block_t(runs[i+3]))
+        {
+            case cell_block_t::numeric:
+            {
+                check_remaining(numbers_it, numbers.end(), size);
+                for (row_t row = row_start; row < row_end; ++row)
+                    sh.set_value(row, col, *numbers_it++);
+                break;
+            }
+            case cell_block_t::boolean:
+            {
+                check_remaining(bools_it, bools.end(), size);
+                for (row_t row = row_start; row < row_end; ++row)
+                    sh.set_bool(row, col, *bools_it++ != 0);
+                break;
+            }
+            case cell_block_t::string:
+            {
+                check_remaining(strings_it, strings.end(), size);
+                for (row_t row = row_start; row < row_end; ++row)
+                {
+                    std::uint32_t sid = *strings_it++;
+                    if (sid >= m_string_ids.size())
+                        throw_corrupt();
+
+                    sh.set_string(row, col, m_string_ids[sid].value);
+                }
+                break;
+            }
+            case cell_block_t::formula:
+            {
+                check_remaining(formulas_it, formulas.end(), size);
+                for (row_t row = row_start; row < row_end; ++row)
+                {
+                    std::uint32_t index = *formulas_it++;
+                    if (index >= formula_stores.size())
+                        throw_corrupt();
+
+                    if (auto res = read_formula_result(results); res)
+                        sh.set_formula(row, col, formula_stores[index], std::move(*res));
+                    else
+                        sh.set_formula(row, col, formula_stores[index]);
+                }
+                break;
+            }
+            default:
+                throw_corrupt();
+        }
+    }
+
+    auto grouped_count = m_in.read<std::uint64_t>();
+    std::vector<char> grouped_buf;
+    auto grouped_block = m_in.read_array(grouped_buf);
+    snapshot_input grouped{{grouped_block.data(), grouped_block.size()}};
+
+    for (std::uint64_t i = 0; i < grouped_count; ++i)
+    {
+        ixion::abs_range_t range;
+        read_value(grouped, m_doc.string_pool_store, range);
+
+        if (!range.valid() || range.first.sheet != sheet.sheet_id || ss.rows <= range.last.row || ss.columns <= range.last.column)
+            throw_corrupt();
+
+        ixion::formula_tokens_t tokens = parse_formula(range.first, grouped.read_string());
+
+        const std::size_t rows = range.last.row - range.first.row + 1;
+        const std::size_t cols = range.last.column - range.first.column + 1;
+        ixion::matrix mtx(rows, cols);
+        bool has_result = false;
+
+        for (std::size_t r = 0; r < rows; ++r)
+        {
+            for (std::size_t c = 0; c < cols; ++c)
+            {
+                auto res = read_formula_result(grouped);
+                if (!res)
+                    continue;
+
+                has_result = true;
+
+                switch (res->get_type())
+                {
+                    case ixion::formula_result::result_type::value:
+                        mtx.set(r, c, res->get_value());
+                        break;
+                    case ixion::formula_result::result_type::string:
+                        mtx.set(r, c, res->get_string());
+                        break;
+                    case ixion::formula_result::result_type::error:
+                        mtx.set(r, c, res->get_error());
+                        break;
+                    default:
+                        ;
+                }
+            }
+        }
+
+        range_t dest;
+        dest.first.row = range.first.row;
+        dest.first.column = range.first.column;
+        dest.last.row = range.last.row;
+        dest.last.column = range.last.column;
+
+        if (has_result)
+            sh.set_grouped_formula(dest, std::move(tokens), ixion::formula_result(std::move(mtx)));
+        else
+            sh.set_grouped_formula(dest, std::move(tokens));
+    }
+}
+
+void document_snapshot_reader::read_pivot_caches()
+{
+    string_pool& pool = m_doc.string_pool_store;
+
+    auto n = m_in.read<std::uint64_t>();
+
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        auto id = m_in.read<pivot_cache_id_t>();
+        auto source = m_in.read<pivot_source_t>();
+
+        std::string_view source_name;
+        ixion::abs_range_t source_range;
+
+        switch (source)
+        {
+            case pivot_source_t::worksheet:
+                read_value(m_in, pool, source_name);
+                read_value(m_in, pool, source_range);
+                break;
+            case pivot_source_t::table:
+                read_value(m_in, pool, source_name);
+                break;
+            case pivot_source_t::none:
+                break;
+            default:
+                throw_corrupt();
+        }
+
+        pivot_cache::fields_type fields(m_in.read<std::uint64_t>());
+        for (auto& field : fields)
+            read_value(m_in, pool, field);
+
+        pivot_cache::records_type records(m_in.read<std::uint64_t>());
+        for (auto& record : records)
+        {
+            record.resize(m_in.read<std::uint64_t>());
+            for (auto& v : record)
+                read_value(m_in, pool, v);
+        }
+
+        auto cache = std::make_unique<pivot_cache>(id, pool);
+        cache->insert_fields(std::move(fields));
+        cache->insert_records(std::move(records));
+
+        switch (source)
+        {
+            case pivot_source_t::worksheet:
+                m_doc.pivots.insert_worksheet_cache(source_name, source_range, std::move(cache));
+                break;
+            case pivot_source_t::table:
+                m_doc.pivots.insert_worksheet_cache(source_name, std::move(cache));
+                break;
+            default:
+                // A cache without a source cannot be stored.
+                ;
+        }
+    }
+}
+
+}}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -0,0 +1,207 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <orcus/spreadsheet/types.hpp>
+
+#include <ixion/address.hpp>
+#include <ixion/formula_name_resolver.hpp>
+#include <ixion/formula_tokens.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace orcus { namespace spreadsheet { namespace detail {
+
+struct document_impl;
+struct sheet_impl;
+
+/**
+ * Writes the fixed-width values, the strings and the arrays that make up a
+ * document snapshot.  All values are written in the native byte order, and
+ * each array is aligned to an 8-byte boundary so that it can be used
+ * directly from a memory-mapped snapshot.
+ */
+class snapshot_output
+{
+    std::ostream& m_os;
+    std::uint64_t m_pos = 0;
+
+public:
+    snapshot_output(std::ostream& os);
+
+    template<typename T>
+    void write(T v)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        if constexpr (std::is_enum_v<T>)
+            write(static_cast<std::uint32_t>(v));
+        else
+            write_bytes(&v, sizeof(v));
+    }
+
+    void write(std::string_view s);
+
+    template<typename T>
+    void write_array(const T* p, std::size_t n)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        write<std::uint64_t>(n);
+        align();
+        write_bytes(p, sizeof(T) * n);
+    }
+
+    template<typename T>
+    void write_array(const std::vector<T>& array)
+    {
+        write_array(array.data(), array.size());
+    }
+
+private:
+    void write_bytes(const void* p, std::size_t n);
+    void align();
+};
+
+/**
+ * Reads the values written by snapshot_output back from a snapshot stream,
+ * and throws general_error when the stream ends prematurely.
+ */
+class snapshot_input
+{
+    std::string_view m_content;
+    std::size_t m_pos = 0;
+
+public:
+    snapshot_input(std::string_view content);
+
+    template<typename T>
+    T read()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        if constexpr (std::is_enum_v<T>)
+            return static_cast<T>(read<std::uint32_t>());
+        else
+        {
+            T v;
+            std::memcpy(&v, read_bytes(sizeof(v)), sizeof(v));
+            return v;
+        }
+    }
+
+    std::string_view read_string();
+
+    /**
+     * Read an array.  The returned span points directly into the snapshot
+     * stream when the array is suitably aligned in memory, and into the
+     * scratch buffer otherwise.
+     */
+    template<typename T>
+    std::span<const T> read_array(std::vector<T>& scratch)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        std::uint64_t n = read<std::uint64_t>();
+        align();
+
+        if (n > (m_content.size() - m_pos) / sizeof(T))
+            throw_truncated();
+
+        const char* p = read_bytes(sizeof(T) * n);
+
+        if (reinterpret_cast<std::uintptr_t>(p) % alignof(T) == 0)
+            return { reinterpret_cast<const T*>(p), n };
+
+        scratch.resize(n);
+        std::memcpy(scratch.data(), p, sizeof(T) * n);
+        return { scratch.data(), n };
+    }
+
+    bool at_end() const;
+
+private:
+    const char* read_bytes(std::size_t n);
+    void align();
+    [[noreturn]] void throw_truncated() const;
+};
+
+/**
+ * Writes the whole content of a document as a snapshot.
+ */
+class document_snapshot_writer
+{
+    const document_impl& m_doc;
+    snapshot_output& m_out;
+    std::unique_ptr<ixion::formula_name_resolver> m_resolver;
+
+public:
+    document_snapshot_writer(const document_impl& doc, snapshot_output& out);
+
+    void write();
+
+private:
+    std::string print_formula(const ixion::abs_address_t& pos, const ixion::formula_tokens_t& tokens) const;
+
+    void write_strings();
+    void write_styles();
+    void write_named_expressions();
+    void write_tables();
+    void write_sheet(const sheet_impl& sheet);
+    void write_cells(const sheet_impl& sheet);
+    void write_pivot_caches();
+};
+
+/**
+ * Rebuilds the content of an empty document from a snapshot.
+ */
+class document_snapshot_reader
+{
+    document_impl& m_doc;
+    snapshot_input& m_in;
+    std::unique_ptr<ixion::formula_name_resolver> m_resolver;
+
+    /** Mapping of the string IDs stored in the snapshot to the document's. */
+    std::vector<ixion::string_id_t> m_string_ids;
+
+public:
+    document_snapshot_reader(document_impl& doc, snapshot_input& in);
+
+    /**
+     * Verify the header of a snapshot, and read the sheet size stored in it.
+     * This needs to be called before the document to load the snapshot into
+     * gets constructed.
+     */
+    static range_size_t read_header(snapshot_input& in);
+
+    void read();
+
+private:
+    std::string_view read_interned_string();
+    ixion::formula_tokens_t parse_formula(const ixion::abs_address_t& pos, std::string_view expression);
+
+    void read_strings();
+    void read_styles();
+    void read_named_expressions();
+    void read_tables();
+    void read_sheet(sheet_impl& sheet);
+    void read_cells(sheet_impl& sheet);
+    void read_pivot_caches();
+};
+
+}}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -11,6 +11,11 @@
 #include <orcus/spreadsheet/factory.hpp>
 #include <orcus/spreadsheet/sheet.hpp>
 #include <orcus/spreadsheet/shared_strings.hpp>
+#include <orcus/spreadsheet/config.hpp>
+#include <orcus/spreadsheet/styles.hpp>
+#include <orcus/exception.hpp>
+#include <orcus/stream.hpp>
+#include <orcus/string_pool.hpp>
 
 #include <ixion/model_context.hpp>
 #include <ixion/address.hpp>
@@ -20,6 +25,7 @@
 #include <cmath>
 #include <filesystem>
 #include <limits>
+#include <sstream>
 
 namespace ss = orcus::spreadsheet;
 namespace fs = std::filesystem;
@@ -224,6 +230,109 @@ void test_dump_unsafe_sheet_name()
     fs::remove_all(base);
 }
 
+void test_dump_concurrent()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    fs::path base = fs::temp_directory_path() / "orcus_dump_concurrent_test";
+    fs::remove_all(base);
+    fs::create_directories(base);
+
+    ss::range_size_t ssize{200, 10};
+    ss::document doc{ssize};
+
+    for (int i = 0; i < 8; ++i)
+    {
+        auto* sh = doc.append_sheet("Sheet" + std::to_string(i));
+        assert(sh);
+
+        for (ss::row_t row = 0; row < 20 * (i + 1); ++row)
+        {
+            sh->set_value(row, 0, row * i);
+            sh->set_string(row, 1, "row " + std::to_string(row));
+        }
+    }
+
+    doc.append_sheet("../unsafe");
+
+    // The sheets dumped concurrently must produce the same files as those
+    // dumped sequentially.
+    const orcus::dump_format_t formats[] = {
+        orcus::dump_format_t::csv,
+        orcus::dump_format_t::flat,
+        orcus::dump_format_t::json,
+        orcus::dump_format_t::html,
+    };
+
+    for (auto format : formats)
+    {
+        fs::path outdir_seq = base / "seq";
+        fs::path outdir_par = base / "par";
+
+        ss::document_config cfg = doc.get_config();
+        cfg.dump_threads = 1;
+        doc.set_config(cfg);
+        doc.dump(format, outdir_seq);
+
+        cfg.dump_threads = 4;
+        doc.set_config(cfg);
+        doc.dump(format, outdir_par);
+
+        std::size_t n_files = 0;
+        for (const auto& entry : fs::directory_iterator(outdir_seq))
+        {
+            fs::path other = outdir_par / entry.path().filename();
+            assert(fs::exists(other));
+
+            orcus::file_content expected(entry.path().string());
+            orcus::file_content actual(other.string());
+            assert(expected.str() == actual.str());
+            ++n_files;
+        }
+
+        assert(n_files == 8);
+
+        fs::remove_all(outdir_seq);
+        fs::remove_all(outdir_par);
+    }
+
+    fs::remove_all(base);
+}
+
+void test_dump_csv_values()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    fs::path base = fs::temp_directory_path() / "orcus_dump_csv_values_test";
+    fs::remove_all(base);
+
+    ss::range_size_t ssize{200, 10};
+    ss::document doc{ssize};
+    auto* sh = doc.append_sheet("Values");
+    assert(sh);
+
+    sh->set_value(0, 0, 0.1 + 0.2);
+    sh->set_string(0, 1, "a\"b");
+    sh->set_bool(0, 2, true);
+    sh->set_value(1, 0, 1e-5);
+    sh->set_string(1, 2, "x,y");
+    sh->set_value(2, 0, 1.0 / 3.0);
+    sh->set_value(2, 1, 123456789.125);
+    sh->set_string(2, 2, "plain");
+
+    doc.dump(orcus::dump_format_t::csv, base);
+
+    constexpr std::string_view expected =
+        "0.3,\"a\"\"b\",true\n"
+        "1e-05,,\"x,y\"\n"
+        "0.3333333333333333,123456789.125,plain";
+
+    orcus::file_content content((base / "Values.csv").string());
+    assert(content.str() == expected);
+
+    fs::remove_all(base);
+}
+
 void test_date_time_out_of_range_second()
 {
     ORCUS_TEST_FUNC_SCOPE;
@@ -272,6 +381,148 @@ void test_set_auto_numeric_bounds()
     assert(cxt.get_numeric_value(pos) == 12.0);
 }
 
+void test_snapshot_round_trip()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    ss::range_size_t ssize{200, 10};
+    ss::document doc{ssize};
+    doc.set_formula_grammar(ss::formula_grammar_t::xlsx);
+    ss::import_factory factory{doc};
+
+    auto* import_sh = factory.append_sheet(0, "Data");
+    assert(import_sh);
+    auto* import_sh2 = factory.append_sheet(1, "Other Sheet");
+    assert(import_sh2);
+
+    for (ss::row_t row = 0; row < 10; ++row)
+    {
+        import_sh->set_value(row, 0, row * 1.5);
+        import_sh->set_bool(row, 2, row % 2 == 0);
+    }
+
+    import_sh->set_string(0, 1, factory.get_shared_strings()->add("first"));
+    import_sh->set_string(3, 1, factory.get_shared_strings()->add("second"));
+
+    for (ss::row_t row = 0; row < 5; ++row)
+    {
+        auto* formula = import_sh->get_formula();
+        assert(formula);
+        formula->set_position(row, 3);
+        formula->set_formula(ss::formula_grammar_t::xlsx, "A1*2+'Other Sheet'!A1");
+        formula->set_result_value(row * 3.0 + 7.0);
+        formula->commit();
+    }
+
+    import_sh2->set_value(0, 0, 7.0);
+
+    factory.finalize();
+
+    ss::font_t font;
+    font.name = doc.get_string_pool().intern("Liberation Sans").first;
+    font.bold = true;
+    std::size_t font_id = doc.get_styles().append_font(font);
+
+    ss::sheet* sh = doc.get_sheet(0);
+    sh->set_merge_cell_range(ss::range_t{{5, 4}, {6, 5}});
+    sh->set_col_width(1, 2, 1440);
+    sh->set_format(2, 0, 4, 0, 1);
+
+    std::ostringstream os_expected;
+    doc.dump_check(os_expected);
+
+    std::ostringstream os_snapshot;
+    doc.save_snapshot(os_snapshot);
+    std::string snapshot = os_snapshot.str();
+
+    ss::document loaded{ss::range_size_t{100, 5}};
+    loaded.load_snapshot_stream(snapshot);
+
+    std::ostringstream os_actual;
+    loaded.dump_check(os_actual);
+    assert(os_expected.str() == os_actual.str());
+
+    assert(loaded.get_sheet_size().rows == ssize.rows);
+    assert(loaded.get_sheet_size().columns == ssize.columns);
+    assert(loaded.get_formula_grammar() == ss::formula_grammar_t::xlsx);
+
+    const ss::font_t* loaded_font = loaded.get_styles().get_font(font_id);
+    assert(loaded_font);
+    assert(loaded_font->name == "Liberation Sans");
+    assert(loaded_font->bold == true);
+
+    const ss::sheet* loaded_sh = loaded.get_sheet(0);
+    assert(loaded_sh->get_merge_cell_range(5, 4) == (ss::range_t{{5, 4}, {6, 5}}));
+    assert(loaded_sh->get_col_width(2, nullptr, nullptr) == 1440);
+    assert(loaded_sh->get_cell_format(3, 0) == 1);
+
+    // A truncated snapshot must be rejected, and leave the document empty.
+    try
+    {
+        loaded.load_snapshot_stream(std::string_view{snapshot}.substr(0, snapshot.size() / 2));
+        assert(!"exception was expected");
+    }
+    catch (const orcus::general_error&)
+    {
+        assert(loaded.get_sheet_count() == 0);
+    }
+}
+
+void test_memory_usage()
+{
+    ORCUS_TEST_FUNC_SCOPE;
+
+    ss::document doc{ss::range_size_t{1000, 10}};
+    doc.set_formula_grammar(ss::formula_grammar_t::xlsx);
+    ss::import_factory factory{doc};
+
+    auto* import_sh = factory.append_sheet(0, "Data");
+    assert(import_sh);
+    auto* import_sh2 = factory.append_sheet(1, "Empty");
+    assert(import_sh2);
+
+    for (ss::row_t row = 0; row < 100; ++row)
+        import_sh->set_value(row, 0, row);
+
+    import_sh->set_string(0, 1, factory.get_shared_strings()->add("some text that does not fit in a short string"));
+
+    auto* formula = import_sh->get_formula();
+    assert(formula);
+    formula->set_position(0, 2);
+    formula->set_formula(ss::formula_grammar_t::xlsx, "SUM(A1:A100)");
+    formula->commit();
+
+    factory.finalize();
+
+    ss::document_memory_usage_t usage = doc.get_memory_usage();
+    assert(usage.sheets.size() == 2);
+    assert(usage.sheets[0].name == "Data");
+    assert(usage.sheets[1].name == "Empty");
+    assert(usage.sheets[0].cells >= 100 * sizeof(double));
+    assert(usage.sheets[1].cells == 0);
+    assert(usage.cell_strings > 0);
+    assert(usage.formula_tokens > 0);
+    assert(usage.pivot_caches == 0);
+    assert(usage.tables == 0);
+
+    std::size_t total = usage.cell_strings + usage.shared_strings + usage.string_pool
+        + usage.styles + usage.pivot_caches + usage.formula_tokens + usage.tables
+        + usage.import_session + usage.sheets[0].total() + usage.sheets[1].total();
+    assert(usage.total() == total);
+
+    // Cell formats of a column are stored in their own segment tree.
+    ss::sheet* sh = doc.get_sheet(0);
+    sh->set_format(0, 5, 99, 5, 1);
+
+    ss::document_memory_usage_t usage2 = doc.get_memory_usage();
+    assert(usage2.sheets[0].cell_formats > usage.sheets[0].cell_formats);
+    assert(usage2.sheets[0].cells == usage.sheets[0].cells);
+
+    std::ostringstream os;
+    os << usage2;
+    assert(os.str().find("  - name: \"Data\"") != std::string::npos);
+}
+
 int main()
 {
     test_sheet();
@@ -281,8 +532,12 @@ int main()
     test_clamp_range();
     test_dimensions_of();
     test_dump_unsafe_sheet_name();
+    test_dump_concurrent();
+    test_dump_csv_values();
     test_date_time_out_of_range_second();
     test_set_auto_numeric_bounds();
+    test_snapshot_round_trip();
+    test_memory_usage();
 
     return EXIT_SUCCESS;
 }
@@ -7,6 +7,8 @@
 
 #include <orcus/spreadsheet/document_types.hpp>
 
+#include <iomanip>
+
 namespace orcus { namespace spreadsheet {
 
 color_t::color_t() :
@@ -172,6 +174,55 @@ bool format_run_t::formatted() const
         || subscript.has_value() || strikethrough.has_value() || underline.has_value();
 }
 
+std::size_t sheet_memory_usage_t::total() const
+{
+    return cells + cell_formats + column_formats + row_formats + properties;
+}
+
+std::size_t document_memory_usage_t::total() const
+{
+    std::size_t n = cell_strings + shared_strings + string_pool + styles
+        + pivot_caches + formula_tokens + tables + import_session;
+
+    for (const auto& sheet : sheets)
+        n += sheet.total();
+
+    return n;
+}
+
+std::ostream& operator<<(std::ostream& os, const document_memory_usage_t& v)
+{
+    auto print = [&os](int indent, std::string_view name, std::size_t bytes)
+    {
+        os << std::string(indent, ' ') << name << ": " << bytes << std::endl;
+    };
+
+    os << "sheets:" << std::endl;
+
+    for (const auto& sheet : v.sheets)
+    {
+        os << "  - name: " << std::quoted(sheet.name) << std::endl;
+        print(4, "cells", sheet.cells);
+        print(4, "cell-formats", sheet.cell_formats);
+        print(4, "column-formats", sheet.column_formats);
+        print(4, "row-formats", sheet.row_formats);
+        print(4, "properties", sheet.properties);
+        print(4, "total", sheet.total());
+    }
+
+    print(0, "cell-strings", v.cell_strings);
+    print(0, "shared-strings", v.shared_strings);
+    print(0, "string-pool", v.string_pool);
+    print(0, "styles", v.styles);
+    print(0, "pivot-caches", v.pivot_caches);
+    print(0, "formula-tokens", v.formula_tokens);
+    print(0, "tables", v.tables);
+    print(0, "import-session", v.import_session);
+    print(0, "total", v.total());
+
+    return os;
+}
+
 }} // namespace orcus::spreadsheet
 
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -41,28 +41,49 @@ void dump_formula_expression(
         os << formula;
 }
 
+buffered_writer::buffered_writer(std::ostream& os) : m_os(os)
+{
+    m_buf.reserve(flush_threshold + flush_threshold / 4);
+}
+
+buffered_writer::~buffered_writer()
+{
+    flush();
+}
+
+void buffered_writer::write_number(double v)
+{
+    format_to_file_output(m_buf, v);
+}
+
+void buffered_writer::flush()
+{
+    m_os.write(m_buf.data(), m_buf.size());
+    m_buf.clear();
+}
+
 void dump_cell_value(
-    std::ostream& os, const ixion::model_cell_range::cell& cell,
-    func_str_handler str_handler, func_empty_handler empty_handler)
+    buffered_writer& out, const ixion::model_cell_range::cell& cell,
+    const func_str_handler& str_handler, const func_empty_handler& empty_handler)
 {
     switch (cell.type)
     {
         case ixion::cell_t::empty:
-            empty_handler(os);
+            empty_handler(out);
             break;
         case ixion::cell_t::boolean:
         {
-            os << (std::get<bool>(cell.value) ? "true" : "false");
+            out.write(std::get<bool>(cell.value) ? "true" : "false");
             break;
         }
         case ixion::cell_t::numeric:
         {
-            format_to_file_output(os, std::get<double>(cell.value));
+            out.write_number(std::get<double>(cell.value));
             break;
         }
         case ixion::cell_t::string:
         {
-            str_handler(os, std::get<std::string_view>(cell.value));
+            str_handler(out, std::get<std::string_view>(cell.value));
             break;
         }
         case ixion::cell_t::formula:
@@ -78,23 +99,23 @@ void dump_cell_value(
             }
             catch (const std::exception&)
             {
-                os << "\"#RES!\"";
+                out.write("\"#RES!\"");
                 break;
             }
 
             switch (res.get_type())
             {
                 case ixion::formula_result::result_type::value:
-                    format_to_file_output(os, res.get_value());
+                    out.write_number(res.get_value());
                 break;
                 case ixion::formula_result::result_type::string:
                 {
                     const std::string& s = res.get_string();
-                    str_handler(os, s);
+                    str_handler(out, s);
                 }
                 break;
                 case ixion::formula_result::result_type::error:
-                    os << "\"#ERR!\"";
+                    out.write("\"#ERR!\"");
                 break;
                 default:
                     ;
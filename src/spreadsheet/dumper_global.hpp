@@ -13,6 +13,7 @@
 #include <ostream>
 #include <functional>
 #include <string>
+#include <string_view>
 
 namespace ixion {
     class formula_cell;
@@ -21,8 +22,56 @@ namespace ixion {
 
 namespace orcus { namespace spreadsheet { namespace detail {
 
-using func_str_handler = std::function<void(std::ostream&, std::string_view)>;
-using func_empty_handler = std::function<void(std::ostream&)>;
+/**
+ * Accumulates output in a memory buffer, and writes it to the output stream
+ * in large blocks.  The remaining content gets written on destruction.
+ */
+class buffered_writer
+{
+    static constexpr std::size_t flush_threshold = 256 * 1024;
+
+    std::ostream& m_os;
+    std::string m_buf;
+
+public:
+    buffered_writer(const buffered_writer&) = delete;
+    buffered_writer& operator=(const buffered_writer&) = delete;
+
+    buffered_writer(std::ostream& os);
+    ~buffered_writer();
+
+    void put(char c)
+    {
+        m_buf.push_back(c);
+    }
+
+    void write(std::string_view s)
+    {
+        m_buf.append(s);
+    }
+
+    /**
+     * Write a numeric value in the same representation as
+     * format_to_file_output().
+     */
+    void write_number(double v);
+
+    /**
+     * Write the buffered content to the output stream if the buffer has grown
+     * past its threshold.  Call this at a regular interval such as at the end
+     * of each row.
+     */
+    void commit()
+    {
+        if (m_buf.size() >= flush_threshold)
+            flush();
+    }
+
+    void flush();
+};
+
+using func_str_handler = std::function<void(buffered_writer&, std::string_view)>;
+using func_empty_handler = std::function<void(buffered_writer&)>;
 
 /**
  * Dump a formula cell's expression to an output stream, wrapping it in
@@ -43,8 +92,8 @@ void dump_formula_expression(
     const ixion::formula_cell& cell);
 
 void dump_cell_value(
-    std::ostream& os, const ixion::model_cell_range::cell& cell,
-    func_str_handler str_handler, func_empty_handler empty_handler);
+    buffered_writer& out, const ixion::model_cell_range::cell& cell,
+    const func_str_handler& str_handler, const func_empty_handler& empty_handler);
 
 }}}
 
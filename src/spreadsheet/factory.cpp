@@ -14,6 +14,7 @@
 #include <orcus/spreadsheet/view.hpp>
 #include <orcus/exception.hpp>
 #include <orcus/string_pool.hpp>
+#include <orcus/import_profile.hpp>
 
 #include "factory_pivot.hpp"
 #include "factory_pivot_table_def.hpp"
@@ -191,6 +192,7 @@ struct import_factory::impl
 
     bool m_recalc_formula_cells;
     formula_error_policy_t m_error_policy;
+    import_profiler* mp_profiler = nullptr;
 
     impl(import_factory& envelope, document& doc) :
         m_config(std::make_shared<import_factory_config>()),
@@ -317,10 +319,30 @@ iface::import_sheet* import_factory::get_sheet(sheet_t sheet_index)
 
 void import_factory::finalize()
 {
-    mp_impl->m_doc.finalize_import();
+    import_profiler* profiler = mp_impl->mp_profiler;
+
+    if (profiler)
+    {
+        for (std::unique_ptr<import_sheet>& sheet : mp_impl->m_sheets)
+        {
+            profiler->add_cells(sheet->get_cell_count());
+            profiler->add_formulas(sheet->get_formula_count());
+            sheet->reset_counts();
+        }
+
+        profiler->add_strings(mp_impl->m_doc.get_model_context().get_string_count());
+    }
+
+    {
+        import_profiler::scope profile_scope(profiler, "finalize_import");
+        mp_impl->m_doc.finalize_import();
+    }
 
     if (mp_impl->m_recalc_formula_cells)
+    {
+        import_profiler::scope profile_scope(profiler, "recalc");
         mp_impl->m_doc.recalc_formula_cells();
+    }
 }
 
 void import_factory::set_config(const import_factory_config& config)
@@ -366,6 +388,11 @@ void import_factory::set_formula_error_policy(formula_error_policy_t policy)
     mp_impl->m_error_policy = policy;
 }
 
+void import_factory::set_profiler(import_profiler* profiler)
+{
+    mp_impl->mp_profiler = profiler;
+}
+
 struct export_factory::impl
 {
     const document& m_doc;
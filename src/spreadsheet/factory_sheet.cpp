@@ -208,6 +208,7 @@ void import_array_formula::commit()
 
     ixion::formula_result cached_results(std::move(m_result_mtx));
     m_sheet.set_grouped_formula(m_range, std::move(m_tokens), std::move(cached_results));
+    ++m_commit_count;
 }
 
 void import_array_formula::set_missing_formula_result(ixion::formula_result result)
@@ -230,6 +231,16 @@ void import_array_formula::reset()
     m_range.last.column = -1;
 }
 
+std::size_t import_array_formula::get_commit_count() const
+{
+    return m_commit_count;
+}
+
+void import_array_formula::reset_commit_count()
+{
+    m_commit_count = 0;
+}
+
 import_formula::import_formula(document& doc, sheet& sheet, shared_formula_pool& pool) :
     m_doc(doc),
     m_sheet(sheet),
@@ -304,6 +315,8 @@ void import_formula::commit()
     if (m_row < 0 || m_col < 0)
         return;
 
+    ++m_commit_count;
+
     if (m_shared)
     {
         if (m_tokens_store)
@@ -355,6 +368,16 @@ void import_formula::reset()
     m_shared = false;
 }
 
+std::size_t import_formula::get_commit_count() const
+{
+    return m_commit_count;
+}
+
+void import_formula::reset_commit_count()
+{
+    m_commit_count = 0;
+}
+
 import_sheet::import_sheet(document& doc, sheet& sh, sheet_view* view) :
     m_doc(doc),
     m_sheet(sh),
@@ -447,16 +470,19 @@ iface::import_array_formula* import_sheet::get_array_formula()
 void import_sheet::set_auto(row_t row, col_t col, std::string_view s)
 {
     m_sheet.set_auto(row, col, s);
+    ++m_cell_count;
 }
 
 void import_sheet::set_bool(row_t row, col_t col, bool value)
 {
     m_sheet.set_bool(row, col, value);
+    ++m_cell_count;
 }
 
 void import_sheet::set_date_time(row_t row, col_t col, int year, int month, int day, int hour, int minute, double second)
 {
     m_sheet.set_date_time(row, col, year, month, day, hour, minute, second);
+    ++m_cell_count;
 }
 
 void import_sheet::set_format(row_t row, col_t col, size_t xf_index)
@@ -483,16 +509,19 @@ void import_sheet::set_row_format(row_t row, std::size_t xf_index)
 void import_sheet::set_string(row_t row, col_t col, string_id_t sindex)
 {
     m_sheet.set_string(row, col, sindex);
+    ++m_cell_count;
 }
 
 void import_sheet::set_value(row_t row, col_t col, double value)
 {
     m_sheet.set_value(row, col, value);
+    ++m_cell_count;
 }
 
 void import_sheet::fill_down_cells(row_t src_row, col_t src_col, row_t range_size)
 {
     m_sheet.fill_down_cells(src_row, src_col, range_size);
+    m_cell_count += range_size;
 }
 
 range_size_t import_sheet::get_sheet_size() const
@@ -516,6 +545,23 @@ void import_sheet::set_formula_error_policy(formula_error_policy_t policy)
     m_array_formula.set_formula_error_policy(policy);
 }
 
+std::size_t import_sheet::get_cell_count() const
+{
+    return m_cell_count + m_formula.get_commit_count();
+}
+
+std::size_t import_sheet::get_formula_count() const
+{
+    return m_formula.get_commit_count() + m_array_formula.get_commit_count();
+}
+
+void import_sheet::reset_counts()
+{
+    m_cell_count = 0;
+    m_formula.reset_commit_count();
+    m_array_formula.reset_commit_count();
+}
+
 import_sheet_view::import_sheet_view(sheet_view& view, sheet_t si) :
     m_view(view), m_sheet_index(si) {}
 
@@ -107,6 +107,7 @@ class import_array_formula : public iface::import_array_formula
     ixion::formula_result m_missing_formula_result;
     ixion::matrix m_result_mtx;
     formula_error_policy_t m_error_policy;
+    std::size_t m_commit_count = 0;
 
 public:
     import_array_formula() = delete;
@@ -132,6 +133,10 @@ public:
     void set_formula_error_policy(formula_error_policy_t policy);
 
     void reset();
+
+    /** Number of array formulas committed since the last reset_commit_count() call. */
+    std::size_t get_commit_count() const;
+    void reset_commit_count();
 };
 
 class import_formula : public iface::import_formula
@@ -148,6 +153,7 @@ class import_formula : public iface::import_formula
     ixion::formula_tokens_store_ptr_t m_tokens_store;
     std::optional<ixion::formula_result> m_result;
     formula_error_policy_t m_error_policy;
+    std::size_t m_commit_count = 0;
 
 public:
     import_formula() = delete;
@@ -167,6 +173,10 @@ public:
     void set_formula_error_policy(formula_error_policy_t policy);
 
     void reset();
+
+    /** Number of formula cells committed since the last reset_commit_count() call. */
+    std::size_t get_commit_count() const;
+    void reset_commit_count();
 };
 
 class import_sheet : public iface::import_sheet
@@ -187,6 +197,9 @@ class import_sheet : public iface::import_sheet
 
     bool m_fill_missing_formula_results;
 
+    /** Number of cell values set since the last reset_counts() call. */
+    std::size_t m_cell_count = 0;
+
 public:
     import_sheet() = delete;
     import_sheet(document& doc, sheet& sh, sheet_view* view);
@@ -216,6 +229,20 @@ public:
     void set_character_set(character_set_t charset);
     void set_fill_missing_formula_results(bool b);
     void set_formula_error_policy(formula_error_policy_t policy);
+
+    /**
+     * Get the number of cells set since the last reset_counts() call,
+     * including the formula cells.
+     */
+    std::size_t get_cell_count() const;
+
+    /**
+     * Get the number of formula cells and array formulas committed since the
+     * last reset_counts() call.
+     */
+    std::size_t get_formula_count() const;
+
+    void reset_counts();
 };
 
 class import_sheet_view : public iface::import_sheet_view
@@ -18,6 +18,8 @@
 #include <ixion/formula_result.hpp>
 #include <ixion/cell.hpp>
 
+#include <algorithm>
+#include <cassert>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -28,6 +30,82 @@ using std::endl;
 
 namespace orcus { namespace spreadsheet { namespace detail {
 
+namespace {
+
+/**
+ * Formats the content of each cell into a reusable buffer, so that no new
+ * string gets allocated per cell.
+ */
+class cell_formatter
+{
+    const ixion::model_context& m_cxt;
+    const ixion::formula_name_resolver* mp_resolver;
+    ixion::sheet_t m_sheet_id;
+    std::ostringstream m_buf;
+
+public:
+    cell_formatter(
+        const ixion::model_context& cxt, const ixion::formula_name_resolver* resolver,
+        ixion::sheet_t sheet_id) :
+        m_cxt(cxt), mp_resolver(resolver), m_sheet_id(sheet_id) {}
+
+    /**
+     * Format the content of a cell.
+     *
+     * @return formatted content of the cell, or an empty string if the cell
+     *         has nothing to print.  The returned string is only valid until
+     *         the next call.
+     */
+    std::string_view format(const ixion::model_cell_range::cell& c)
+    {
+        switch (c.type)
+        {
+            case ixion::cell_t::string:
+                return std::get<std::string_view>(c.value);
+            case ixion::cell_t::numeric:
+            {
+                m_buf.str(std::string{});
+                format_to_file_output(m_buf, std::get<double>(c.value));
+                m_buf << " [v]";
+                return m_buf.view();
+            }
+            case ixion::cell_t::boolean:
+                return std::get<bool>(c.value) ? "true [b]" : "false [b]";
+            case ixion::cell_t::formula:
+            {
+                // print the formula and the formula result.
+                const ixion::formula_cell* cell = std::get<const ixion::formula_cell*>(c.value);
+                assert(cell);
+                if (!cell->get_tokens())
+                    return {};
+
+                m_buf.str(std::string{});
+                ixion::abs_address_t pos(m_sheet_id, c.row, c.col);
+                detail::dump_formula_expression(m_buf, m_cxt, pos, mp_resolver, *cell);
+
+                try
+                {
+                    ixion::formula_result res = cell->get_result_cache(
+                        ixion::formula_result_wait_policy_t::throw_exception);
+                    m_buf << " (" << res.str(m_cxt) << ")";
+                }
+                catch (const std::exception&)
+                {
+                    m_buf << "(#RES!)";
+                }
+
+                return m_buf.view();
+            }
+            default:
+                ;
+        }
+
+        return {};
+    }
+};
+
+} // anonymous namespace
+
 flat_dumper::flat_dumper(const document& doc) : m_doc(doc) {}
 
 void flat_dumper::dump(std::ostream& os, ixion::sheet_t sheet_id) const
@@ -50,136 +128,60 @@ void flat_dumper::dump(std::ostream& os, ixion::sheet_t sheet_id) const
     // Always start at the top-left corner.
     range.first.row = 0;
     range.first.column = 0;
-    auto cell_range = cxt.iterate_cells(
-        sheet_id, ixion::rc_direction_t::vertical, range);
-
-    std::vector<std::string> mx(row_count*col_count);
 
-    auto to_pos = [col_count](size_t row, size_t col) -> size_t
-    {
-        return col_count * row + col;
-    };
+    cell_formatter formatter(cxt, resolver, sheet_id);
 
-    // Calculate column widths as we iterate.
+    // The cells get formatted twice, once to calculate the column widths and
+    // once to print them, so that only the column widths need to be stored
+    // rather than the formatted content of the entire range.
     std::vector<size_t> col_widths(col_count, 0);
-    auto it_colwidth = col_widths.begin();
-    col_t current_col = 0;
 
-    for (const auto& c : cell_range)
+    for (const auto& c : cxt.iterate_cells(sheet_id, ixion::rc_direction_t::vertical, range))
     {
-        if (c.col > current_col)
-        {
-            ++current_col;
-            ++it_colwidth;
-            assert(current_col == c.col);
-        }
-
-        size_t cell_str_width = 0;
+        if (c.type == ixion::cell_t::empty)
+            continue;
 
-        switch (c.type)
-        {
-            case ixion::cell_t::string:
-            {
-                std::string_view sv = std::get<std::string_view>(c.value);
-                cell_str_width = calc_logical_string_length(sv);
-                mx[to_pos(c.row, c.col)] = std::string{sv};
-                break;
-            }
-            case ixion::cell_t::numeric:
-            {
-                std::ostringstream os2;
-                format_to_file_output(os2, std::get<double>(c.value));
-                os2 << " [v]";
-                std::string s = os2.str();
-                cell_str_width = calc_logical_string_length(s);
-                mx[to_pos(c.row, c.col)] = std::move(s);
-                break;
-            }
-            case ixion::cell_t::boolean:
-            {
-                std::ostringstream os2;
-                os2 << (std::get<bool>(c.value) ? "true" : "false") << " [b]";
-                std::string s = os2.str();
-                cell_str_width = calc_logical_string_length(s);
-                mx[to_pos(c.row, c.col)] = std::move(s);
-                break;
-            }
-            case ixion::cell_t::formula:
-            {
-                // print the formula and the formula result.
-                const ixion::formula_cell* cell = std::get<const ixion::formula_cell*>(c.value);
-                assert(cell);
-                if (cell->get_tokens())
-                {
-                    ixion::abs_address_t pos(sheet_id, c.row, c.col);
-                    std::ostringstream os2;
-                    detail::dump_formula_expression(os2, cxt, pos, resolver, *cell);
-
-                    try
-                    {
-                        ixion::formula_result res = cell->get_result_cache(
-                            ixion::formula_result_wait_policy_t::throw_exception);
-                        os2 << " (" << res.str(cxt) << ")";
-                    }
-                    catch (const std::exception&)
-                    {
-                        os2 << "(#RES!)";
-                    }
-
-                    std::string s = os2.str();
-                    cell_str_width = calc_logical_string_length(s);
-                    mx[to_pos(c.row, c.col)] = std::move(s);
-                }
-                break;
-            }
-            default:
-                ;
-        }
-
-        if (*it_colwidth < cell_str_width)
-            *it_colwidth = cell_str_width;
+        size_t cell_str_width = calc_logical_string_length(formatter.format(c));
+        size_t& cw = col_widths[c.col];
+        if (cw < cell_str_width)
+            cw = cell_str_width;
     }
 
     // Create a row separator string;
-    std::ostringstream os2;
-    os2 << '+';
-    for (size_t i = 0; i < col_widths.size(); ++i)
+    std::string sep = "+";
+    for (size_t cw : col_widths)
     {
-        os2 << '-';
-        size_t cw = col_widths[i];
-        for (size_t j = 0; j < cw; ++j)
-            os2 << '-';
-        os2 << "-+";
+        sep.append(cw + 2, '-');
+        sep += '+';
     }
+    sep += '\n';
 
-    std::string sep = os2.str();
+    // Padding to write in one go.
+    const std::string spaces(*std::max_element(col_widths.begin(), col_widths.end()) + 2, ' ');
 
-    // Now print to stdout.
-    os << sep << endl;
-    for (size_t r = 0; r < row_count; ++r)
+    os << sep;
+    for (const auto& c : cxt.iterate_cells(sheet_id, ixion::rc_direction_t::horizontal, range))
     {
-        os << "|";
-        for (size_t c = 0; c < col_count; ++c)
+        if (c.col == 0)
+            os << '|';
+
+        size_t cw = col_widths[c.col]; // column width
+        std::string_view s = formatter.format(c);
+        if (s.empty())
         {
-            size_t cw = col_widths[c]; // column width
-            const std::string& s = mx[to_pos(r, c)];
-            if (s.empty())
-            {
-                for (size_t i = 0; i < cw; ++i)
-                    os << ' ';
-                os << "  |";
-            }
-            else
-            {
-                os << ' ' << s;
-                cw -= calc_logical_string_length(s);
-                for (size_t i = 0; i < cw; ++i)
-                    os << ' ';
-                os << " |";
-            }
+            os.write(spaces.data(), cw + 2);
+            os << '|';
+        }
+        else
+        {
+            os << ' ' << s;
+            cw -= calc_logical_string_length(s);
+            os.write(spaces.data(), cw + 1);
+            os << '|';
         }
-        os << endl;
-        os << sep << endl;
+
+        if (size_t(c.col) == col_count - 1)
+            os << '\n' << sep;
     }
 }
 
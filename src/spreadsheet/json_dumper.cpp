@@ -46,14 +46,21 @@ void json_dumper::dump(std::ostream& os, ixion::sheet_t sheet_id) const
     for (ixion::col_t i = 0; i <= data_range.last.column; ++i)
         column_labels.emplace_back(resolver->get_column_name(i));
 
-    os << "[" << std::endl;
+    // Pre-build the key part of each cell entry.
+    for (std::string& label : column_labels)
+        label = '"' + label + "\": ";
 
-    func_str_handler str_handler = [](std::ostream& _os, std::string_view s)
+    buffered_writer out(os);
+    out.write("[\n");
+
+    func_str_handler str_handler = [](buffered_writer& _out, std::string_view s)
     {
-        _os << '"' << json::escape_string(s) << '"';
+        _out.put('"');
+        _out.write(json::escape_string(s));
+        _out.put('"');
     };
 
-    func_empty_handler empty_handler = [](std::ostream& _os) { _os << "null"; };
+    func_empty_handler empty_handler = [](buffered_writer& _out) { _out.write("null"); };
 
     bool first = true;
     ixion::row_t last_row = 0;
@@ -64,21 +71,24 @@ void json_dumper::dump(std::ostream& os, ixion::sheet_t sheet_id) const
         ixion::col_t this_col = cell.col;
 
         if (!first && this_row > last_row)
-            os << "}," << std::endl;
+        {
+            out.write("},\n");
+            out.commit();
+        }
 
         if (this_col == 0)
-            os << "    {";
+            out.write("    {");
         else
-            os << ", ";
+            out.write(", ");
 
-        os << "\"" << column_labels.at(this_col) << "\": ";
+        out.write(column_labels.at(this_col));
 
-        dump_cell_value(os, cell, str_handler, empty_handler);
+        dump_cell_value(out, cell, str_handler, empty_handler);
         last_row = this_row;
         first = false;
     }
 
-    os << "}" << std::endl << "]" << std::endl;
+    out.write("}\n]\n");
 }
 
 }}}
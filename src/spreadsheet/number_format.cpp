@@ -8,6 +8,7 @@
 #include "number_format.hpp"
 #include "ostream_utils.hpp"
 
+#include <charconv>
 #include <ostream>
 #include <iomanip>
 #include <limits>
@@ -20,6 +21,17 @@ void format_to_file_output(std::ostream& os, double v)
     os << std::setprecision(std::numeric_limits<double>::digits10 + 1) << v;
 }
 
+void format_to_file_output(std::string& buf, double v)
+{
+    // Same as the default floating-point stream output with the above
+    // precision, i.e. printf's %.*g.
+    char tmp[32];
+    auto res = std::to_chars(
+        tmp, tmp + sizeof(tmp), v, std::chars_format::general,
+        std::numeric_limits<double>::digits10 + 1);
+    buf.append(tmp, res.ptr);
+}
+
 }}}
 
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
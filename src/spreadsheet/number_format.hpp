@@ -8,6 +8,7 @@
 #pragma once
 
 #include <iosfwd>
+#include <string>
 
 namespace orcus { namespace spreadsheet { namespace detail {
 
@@ -20,6 +21,16 @@ namespace orcus { namespace spreadsheet { namespace detail {
  */
 void format_to_file_output(std::ostream& os, double v);
 
+/**
+ * Format a numeric value to a lossless string representation appropriate
+ * for file output, and append it to a string buffer.  The appended string
+ * is identical to what the stream-based variant writes.
+ *
+ * @param buf string buffer to append the string representation to.
+ * @param v source numeric value to format.
+ */
+void format_to_file_output(std::string& buf, double v);
+
 }}}
 
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
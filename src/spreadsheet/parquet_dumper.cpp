@@ -0,0 +1,462 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "parquet_dumper.hpp"
+#include "number_format.hpp"
+
+#include "orcus/spreadsheet/document.hpp"
+
+#include <ixion/model_context.hpp>
+#include <ixion/model_cell_range.hpp>
+#include <ixion/formula_name_resolver.hpp>
+#include <ixion/formula_result.hpp>
+#include <ixion/cell.hpp>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wshadow"
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include <arrow/io/interfaces.h>
+#include <arrow/result.h>
+#include <arrow/status.h>
+#include <parquet/column_writer.h>
+#include <parquet/file_writer.h>
+#include <parquet/schema.h>
+#pragma GCC diagnostic pop
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace orcus { namespace spreadsheet { namespace detail {
+
+namespace {
+
+/**
+ * Maximum number of records per row group.  This is smaller than Arrow's
+ * default, so that the row groups of a large sheet can be decoded in
+ * parallel when imported back via orcus_parquet.
+ */
+constexpr ixion::row_t rows_per_group = 131072;
+
+/**
+ * Kinds of cell values, used as bit flags to record which kinds of values
+ * each column contains.
+ */
+enum value_kind : unsigned
+{
+    kind_empty   = 0x00,
+    kind_boolean = 0x01,
+    kind_numeric = 0x02,
+    kind_string  = 0x04,
+};
+
+enum class column_type_t { boolean, numeric, string };
+
+column_type_t to_column_type(unsigned kinds)
+{
+    if (kinds == kind_boolean)
+        return column_type_t::boolean;
+
+    if (kinds == kind_numeric)
+        return column_type_t::numeric;
+
+    // Mixed, string-only, and empty columns are all stored as strings.
+    return column_type_t::string;
+}
+
+/**
+ * Value of a single cell.  The value of a formula cell is its cached result.
+ * The string value either points to the shared string store, or to the
+ * internal buffer when the string is a formula result.
+ */
+struct cell_value
+{
+    value_kind kind = kind_empty;
+    bool boolean = false;
+    double numeric = 0.0;
+    std::string_view str;
+    std::string buffer;
+
+    void set_string(std::string_view s)
+    {
+        kind = kind_string;
+        str = s;
+    }
+
+    void set_owned_string(std::string_view s)
+    {
+        kind = kind_string;
+        buffer = s;
+        str = buffer;
+    }
+};
+
+void resolve_value(const ixion::model_cell_range::cell& cell, cell_value& cv)
+{
+    cv.kind = kind_empty;
+
+    switch (cell.type)
+    {
+        case ixion::cell_t::boolean:
+            cv.kind = kind_boolean;
+            cv.boolean = std::get<bool>(cell.value);
+            break;
+        case ixion::cell_t::numeric:
+            cv.kind = kind_numeric;
+            cv.numeric = std::get<double>(cell.value);
+            break;
+        case ixion::cell_t::string:
+            cv.set_string(std::get<std::string_view>(cell.value));
+            break;
+        case ixion::cell_t::formula:
+        {
+            const ixion::formula_cell* fc = std::get<const ixion::formula_cell*>(cell.value);
+            assert(fc);
+            ixion::formula_result res;
+
+            try
+            {
+                res = fc->get_result_cache(
+                    ixion::formula_result_wait_policy_t::throw_exception);
+            }
+            catch (const std::exception&)
+            {
+                cv.set_string("#RES!");
+                break;
+            }
+
+            switch (res.get_type())
+            {
+                case ixion::formula_result::result_type::value:
+                    cv.kind = kind_numeric;
+                    cv.numeric = res.get_value();
+                    break;
+                case ixion::formula_result::result_type::string:
+                    cv.set_owned_string(res.get_string());
+                    break;
+                case ixion::formula_result::result_type::error:
+                    cv.set_string("#ERR!");
+                    break;
+                default:
+                    ;
+            }
+            break;
+        }
+        default:
+            ;
+    }
+}
+
+/**
+ * Values of a column within a single row group, in the layout expected by
+ * the typed column writers.
+ */
+struct column_buffer
+{
+    std::vector<std::int16_t> def_levels;
+    std::vector<std::uint8_t> booleans;
+    std::vector<double> numerics;
+    std::string str_buffer;
+    std::vector<std::size_t> str_ends;
+
+    void clear()
+    {
+        def_levels.clear();
+        booleans.clear();
+        numerics.clear();
+        str_buffer.clear();
+        str_ends.clear();
+    }
+
+    void append(column_type_t type, const cell_value& cv)
+    {
+        if (cv.kind == kind_empty)
+        {
+            def_levels.push_back(0);
+            return;
+        }
+
+        def_levels.push_back(1);
+
+        switch (type)
+        {
+            case column_type_t::boolean:
+                booleans.push_back(cv.boolean);
+                break;
+            case column_type_t::numeric:
+                numerics.push_back(cv.numeric);
+                break;
+            case column_type_t::string:
+            {
+                switch (cv.kind)
+                {
+                    case kind_boolean:
+                        str_buffer.append(cv.boolean ? "true" : "false");
+                        break;
+                    case kind_numeric:
+                        format_to_file_output(str_buffer, cv.numeric);
+                        break;
+                    case kind_string:
+                        str_buffer.append(cv.str);
+                        break;
+                    case kind_empty:
+                        ;
+                }
+
+                str_ends.push_back(str_buffer.size());
+                break;
+            }
+        }
+    }
+
+    void write(parquet::RowGroupWriter& rg_writer, column_type_t type) const
+    {
+        const auto n = static_cast<std::int64_t>(def_levels.size());
+
+        switch (type)
+        {
+            case column_type_t::boolean:
+            {
+                std::unique_ptr<bool[]> values(new bool[booleans.size()]);
+                std::copy(booleans.begin(), booleans.end(), values.get());
+
+                auto* writer = static_cast<parquet::BoolWriter*>(rg_writer.NextColumn());
+                writer->WriteBatch(n, def_levels.data(), nullptr, values.get());
+                break;
+            }
+            case column_type_t::numeric:
+            {
+                auto* writer = static_cast<parquet::DoubleWriter*>(rg_writer.NextColumn());
+                writer->WriteBatch(n, def_levels.data(), nullptr, numerics.data());
+                break;
+            }
+            case column_type_t::string:
+            {
+                std::vector<parquet::ByteArray> values;
+                values.reserve(str_ends.size());
+
+                const auto* p = reinterpret_cast<const std::uint8_t*>(str_buffer.data());
+                std::size_t start = 0;
+
+                for (std::size_t end : str_ends)
+                {
+                    values.emplace_back(static_cast<std::uint32_t>(end - start), p + start);
+                    start = end;
+                }
+
+                auto* writer = static_cast<parquet::ByteArrayWriter*>(rg_writer.NextColumn());
+                writer->WriteBatch(n, def_levels.data(), nullptr, values.data());
+                break;
+            }
+        }
+    }
+};
+
+/**
+ * Arrow output stream that writes to a std::ostream.
+ */
+class ostream_output_stream : public arrow::io::OutputStream
+{
+    std::ostream& m_os;
+    std::int64_t m_pos = 0;
+    bool m_closed = false;
+
+public:
+    ostream_output_stream(std::ostream& os) : m_os(os) {}
+
+    arrow::Status Close() override
+    {
+        m_closed = true;
+        m_os.flush();
+        return arrow::Status::OK();
+    }
+
+    bool closed() const override
+    {
+        return m_closed;
+    }
+
+    arrow::Result<std::int64_t> Tell() const override
+    {
+        return m_pos;
+    }
+
+    using arrow::io::OutputStream::Write;
+
+    arrow::Status Write(const void* data, std::int64_t nbytes) override
+    {
+        m_os.write(static_cast<const char*>(data), nbytes);
+        if (!m_os)
+            return arrow::Status::IOError("failed to write to the output stream.");
+
+        m_pos += nbytes;
+        return arrow::Status::OK();
+    }
+};
+
+std::string to_column_name(const cell_value& cv)
+{
+    std::string name;
+
+    switch (cv.kind)
+    {
+        case kind_boolean:
+            name = cv.boolean ? "true" : "false";
+            break;
+        case kind_numeric:
+            format_to_file_output(name, cv.numeric);
+            break;
+        case kind_string:
+            name = cv.str;
+            break;
+        case kind_empty:
+            ;
+    }
+
+    return name;
+}
+
+} // anonymous namespace
+
+parquet_dumper::parquet_dumper(const document& doc) : m_doc(doc) {}
+
+void parquet_dumper::dump(std::ostream& os, ixion::sheet_t sheet_id) const
+{
+    const ixion::model_context& cxt = m_doc.get_model_context();
+    ixion::abs_range_t data_range = cxt.get_data_range(sheet_id);
+    if (!data_range.valid())
+        return;
+
+    const ixion::col_t n_cols = data_range.last.column + 1;
+    const ixion::row_t last_row = data_range.last.row;
+
+    // Pass 1: pick up the column names from the first row, and record the
+    // kinds of values stored in each column in the remaining rows.
+
+    std::vector<std::string> names(n_cols);
+    std::vector<unsigned> kinds(n_cols, kind_empty);
+
+    ixion::abs_rc_range_t iter_range;
+    iter_range.first.column = 0;
+    iter_range.first.row = 0;
+    iter_range.last.column = data_range.last.column;
+    iter_range.last.row = last_row;
+
+    cell_value cv;
+
+    for (const auto& cell : cxt.iterate_cells(sheet_id, ixion::rc_direction_t::vertical, iter_range))
+    {
+        resolve_value(cell, cv);
+
+        if (cell.row == 0)
+            names[cell.col] = to_column_name(cv);
+        else
+            kinds[cell.col] |= cv.kind;
+    }
+
+    // Fall back to the column labels for the columns with no names, and make
+    // sure that all column names are unique.
+    auto resolver = ixion::formula_name_resolver::get(ixion::formula_name_resolver_t::excel_a1, &cxt);
+    std::unordered_set<std::string> used_names;
+
+    for (ixion::col_t col = 0; col < n_cols; ++col)
+    {
+        std::string& name = names[col];
+        if (name.empty())
+            name = resolver->get_column_name(col);
+
+        while (!used_names.insert(name).second)
+        {
+            name.push_back('_');
+            name.append(resolver->get_column_name(col));
+        }
+    }
+
+    std::vector<column_type_t> types;
+    types.reserve(n_cols);
+    parquet::schema::NodeVector fields;
+    fields.reserve(n_cols);
+
+    for (ixion::col_t col = 0; col < n_cols; ++col)
+    {
+        column_type_t type = to_column_type(kinds[col]);
+        types.push_back(type);
+
+        switch (type)
+        {
+            case column_type_t::boolean:
+                fields.push_back(
+                    parquet::schema::PrimitiveNode::Make(
+                        names[col], parquet::Repetition::OPTIONAL,
+                        parquet::Type::BOOLEAN, parquet::ConvertedType::NONE));
+                break;
+            case column_type_t::numeric:
+                fields.push_back(
+                    parquet::schema::PrimitiveNode::Make(
+                        names[col], parquet::Repetition::OPTIONAL,
+                        parquet::Type::DOUBLE, parquet::ConvertedType::NONE));
+                break;
+            case column_type_t::string:
+                fields.push_back(
+                    parquet::schema::PrimitiveNode::Make(
+                        names[col], parquet::Repetition::OPTIONAL,
+                        parquet::Type::BYTE_ARRAY, parquet::ConvertedType::UTF8));
+                break;
+        }
+    }
+
+    auto schema = std::static_pointer_cast<parquet::schema::GroupNode>(
+        parquet::schema::GroupNode::Make("schema", parquet::Repetition::REQUIRED, fields));
+
+    auto sink = std::make_shared<ostream_output_stream>(os);
+    std::unique_ptr<parquet::ParquetFileWriter> writer = parquet::ParquetFileWriter::Open(sink, schema);
+
+    // Pass 2: write the records one row group at a time.  Within each row
+    // group the cells are visited column by column, which is the order in
+    // which the column chunks get written.
+
+    column_buffer buf;
+
+    for (ixion::row_t row_start = 1; row_start <= last_row; row_start += rows_per_group)
+    {
+        iter_range.first.row = row_start;
+        iter_range.last.row = std::min<ixion::row_t>(last_row, row_start + rows_per_group - 1);
+
+        parquet::RowGroupWriter* rg_writer = writer->AppendRowGroup();
+        ixion::col_t cur_col = -1;
+
+        for (const auto& cell : cxt.iterate_cells(sheet_id, ixion::rc_direction_t::vertical, iter_range))
+        {
+            if (cell.col != cur_col)
+            {
+                if (cur_col >= 0)
+                    buf.write(*rg_writer, types[cur_col]);
+
+                buf.clear();
+                cur_col = cell.col;
+            }
+
+            resolve_value(cell, cv);
+            buf.append(types[cell.col], cv);
+        }
+
+        if (cur_col >= 0)
+            buf.write(*rg_writer, types[cur_col]);
+
+        buf.clear();
+    }
+
+    writer->Close();
+}
+
+}}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
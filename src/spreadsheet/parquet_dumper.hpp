@@ -0,0 +1,40 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <ostream>
+
+#include <ixion/types.hpp>
+
+namespace orcus { namespace spreadsheet {
+
+class document;
+
+namespace detail {
+
+/**
+ * Writes the content of a sheet as an Apache Parquet file.  The first row of
+ * the sheet provides the column names, and each of the remaining rows becomes
+ * a record.  The type of each column is inferred from its values: a column
+ * that only contains numeric values becomes a DOUBLE column, one that only
+ * contains boolean values becomes a BOOLEAN column, and any other column
+ * becomes a UTF-8 string column.  Empty cells are stored as nulls.
+ */
+class parquet_dumper
+{
+    const document& m_doc;
+
+public:
+    parquet_dumper(const document& doc);
+
+    void dump(std::ostream& os, ixion::sheet_t sheet_id) const;
+};
+
+}}}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
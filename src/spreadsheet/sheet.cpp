@@ -15,6 +15,7 @@
 #include "csv_dumper.hpp"
 #include "flat_dumper.hpp"
 #include "html_dumper.hpp"
+#include "parquet_dumper.hpp"
 #include "sheet_impl.hpp"
 #include "debug_state_context.hpp"
 #include "debug_state_dumper.hpp"
@@ -26,9 +27,12 @@
 #include <cmath>
 #include <cstdlib>
 #include <filesystem>
+#include <optional>
 
+#include <ixion/cell.hpp>
 #include <ixion/exceptions.hpp>
 #include <ixion/formula.hpp>
+#include <ixion/formula_result.hpp>
 #include <ixion/model_context.hpp>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
@@ -375,7 +379,37 @@ void sheet::fill_down_cells(row_t src_row, col_t src_col, row_t range_size)
 {
     ixion::model_context& cxt = mp_impl->doc.get_model_context();
     ixion::abs_address_t src_pos(mp_impl->sheet_id, src_row, src_col);
-    cxt.fill_down_cells(src_pos, range_size);
+
+    const ixion::formula_cell* fc = cxt.get_formula_cell(src_pos);
+    if (!fc)
+    {
+        cxt.fill_down_cells(src_pos, range_size);
+        return;
+    }
+
+    // The copies of a formula cell share its tokens and its cached result,
+    // but each of them is still inserted as a separate formula cell.  A
+    // grouped formula is not used here since ixion treats it as an array
+    // formula.
+    ixion::formula_tokens_store_ptr_t tokens = fc->get_tokens();
+    std::optional<ixion::formula_result> result;
+
+    try
+    {
+        result = fc->get_result_cache(ixion::formula_result_wait_policy_t::throw_exception);
+    }
+    catch (const std::exception&)
+    {
+        // No cached result.
+    }
+
+    for (row_t row = src_row + 1; row <= src_row + range_size; ++row)
+    {
+        if (result)
+            set_formula(row, src_col, tokens, *result);
+        else
+            set_formula(row, src_col, tokens);
+    }
 }
 
 range_t sheet::get_merge_cell_range(row_t row, col_t col) const
@@ -521,6 +555,17 @@ void sheet::dump_csv(std::ostream& os) const
     dumper.dump(os, mp_impl->sheet_id);
 }
 
+void sheet::dump_parquet(std::ostream& os) const
+{
+#ifdef __ORCUS_PARQUET
+    detail::parquet_dumper dumper(mp_impl->doc);
+    dumper.dump(os, mp_impl->sheet_id);
+#else
+    (void)os;
+    throw general_error("orcus is built without Apache Parquet support.");
+#endif
+}
+
 void sheet::dump_debug_state(const fs::path& output_dir, std::string_view sheet_name) const
 {
     detail::debug_state_context cxt;
@@ -205,5 +205,28 @@ def test_named_expressions_refcount_balance():
         f"transient named-expression objects; the factory leaks a reference")
 
 
+def test_memory_usage():
+    filepath = TESTDIR / "formula-cells" / "input.xlsx"
+    with filepath.open("rb") as f:
+        doc = xlsx.read(f)
+
+    usage = doc.get_memory_usage()
+    assert len(usage["sheets"]) == len(doc.sheets)
+
+    for sheet, sheet_usage in zip(doc.sheets, usage["sheets"]):
+        assert sheet_usage["name"] == sheet.name
+        assert sheet_usage["total"] == sum(
+            sheet_usage[key] for key in ("cells", "cell_formats", "column_formats", "row_formats", "properties"))
+
+    assert usage["sheets"][0]["cells"] > 0
+    assert usage["formula_tokens"] > 0
+
+    keys = (
+        "cell_strings", "shared_strings", "string_pool", "styles", "pivot_caches",
+        "formula_tokens", "tables", "import_session")
+    expected = sum(usage[key] for key in keys) + sum(s["total"] for s in usage["sheets"])
+    assert usage["total"] == expected
+
+
 if __name__ == "__main__":
     sys.exit(pytest.main([__file__]))